@@ -0,0 +1,451 @@
+#include "AABBTree.h"
+
+#include <algorithm>
+#include <cmath>
+
+const int AABBTree::s_kNullNode;
+
+bool AABB::contains(const AABB& other) const
+{
+	return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+	    && max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+}
+
+bool AABB::overlaps(const AABB& other) const
+{
+	return min.x <= other.max.x && min.y <= other.max.y && min.z <= other.max.z
+	    && max.x >= other.min.x && max.y >= other.min.y && max.z >= other.min.z;
+}
+
+float AABB::getSurfaceArea() const
+{
+	glm::vec3 size = max - min;
+	return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+AABB AABB::combine(const AABB& lhs, const AABB& rhs)
+{
+	return { glm::min(lhs.min, rhs.min), glm::max(lhs.max, rhs.max) };
+}
+
+AABBTree::AABBTree(float margin, float displacementMultiplier)
+	: m_margin{ margin }
+	, m_displacementMultiplier{ displacementMultiplier }
+{
+}
+
+int AABBTree::createProxy(const AABB& aabb, size_t userData)
+{
+	int proxyID = allocateNode();
+	m_nodes[proxyID].aabb = fatten(aabb, m_margin);
+	m_nodes[proxyID].userData = userData;
+	insertLeaf(proxyID);
+	++m_numProxies;
+	return proxyID;
+}
+
+void AABBTree::destroyProxy(int proxyID)
+{
+	assert(m_nodes[proxyID].isLeaf());
+	removeLeaf(proxyID);
+	freeNode(proxyID);
+	--m_numProxies;
+}
+
+bool AABBTree::moveProxy(int proxyID, const AABB& aabb, const glm::vec3& displacement)
+{
+	assert(m_nodes[proxyID].isLeaf());
+	if (m_nodes[proxyID].aabb.contains(aabb))
+		return false;
+
+	// Stretch the fat AABB in the direction the proxy is moving, so it
+	// can keep moving that way for a while without being reinserted
+	AABB fatAABB = fatten(aabb, m_margin);
+	glm::vec3 predictedDisplacement = displacement * m_displacementMultiplier;
+	for (int i = 0; i < 3; ++i) {
+		if (predictedDisplacement[i] < 0)
+			fatAABB.min[i] += predictedDisplacement[i];
+		else
+			fatAABB.max[i] += predictedDisplacement[i];
+	}
+
+	removeLeaf(proxyID);
+	m_nodes[proxyID].aabb = fatAABB;
+	insertLeaf(proxyID);
+	return true;
+}
+
+void AABBTree::setProxyAABB(int proxyID, const AABB& aabb)
+{
+	assert(m_nodes[proxyID].isLeaf());
+	m_nodes[proxyID].aabb = fatten(aabb, m_margin);
+}
+
+void AABBTree::refit()
+{
+	if (m_root == s_kNullNode)
+		return;
+
+	// Parents come before their children in a depth first order, so
+	// walking it backwards visits children first
+	m_scratchNodes.clear();
+	m_scratchNodes.push_back(m_root);
+	for (size_t i = 0; i < m_scratchNodes.size(); ++i) {
+		const Node& node = m_nodes[m_scratchNodes[i]];
+		if (!node.isLeaf()) {
+			m_scratchNodes.push_back(node.child1);
+			m_scratchNodes.push_back(node.child2);
+		}
+	}
+
+	for (size_t i = m_scratchNodes.size(); i-- > 0;) {
+		Node& node = m_nodes[m_scratchNodes[i]];
+		if (node.isLeaf())
+			continue;
+
+		const Node& child1 = m_nodes[node.child1];
+		const Node& child2 = m_nodes[node.child2];
+		node.aabb = AABB::combine(child1.aabb, child2.aabb);
+		node.height = 1 + std::max(child1.height, child2.height);
+	}
+}
+
+void AABBTree::rebuild()
+{
+	// Keep the leaves and free every internal node
+	m_scratchNodes.clear();
+	for (size_t i = 0; i < m_nodes.size(); ++i) {
+		if (m_nodes[i].height < 0)
+			continue;
+
+		if (m_nodes[i].isLeaf()) {
+			m_nodes[i].parent = s_kNullNode;
+			m_scratchNodes.push_back(static_cast<int>(i));
+		} else {
+			freeNode(static_cast<int>(i));
+		}
+	}
+
+	m_root = s_kNullNode;
+	if (!m_scratchNodes.empty()) {
+		m_root = buildTopDown(m_scratchNodes.data(), m_scratchNodes.size());
+		m_nodes[m_root].parent = s_kNullNode;
+	}
+}
+
+void AABBTree::clear()
+{
+	m_nodes.clear();
+	m_root = s_kNullNode;
+	m_freeList = s_kNullNode;
+	m_numProxies = 0;
+}
+
+size_t AABBTree::getUserData(int proxyID) const
+{
+	return m_nodes[proxyID].userData;
+}
+
+const AABB& AABBTree::getFatAABB(int proxyID) const
+{
+	return m_nodes[proxyID].aabb;
+}
+
+size_t AABBTree::size() const
+{
+	return m_numProxies;
+}
+
+int AABBTree::getHeight() const
+{
+	return m_root == s_kNullNode ? 0 : m_nodes[m_root].height;
+}
+
+float AABBTree::getAreaRatio() const
+{
+	if (m_root == s_kNullNode)
+		return 0;
+
+	float totalArea = 0;
+	for (const Node& node : m_nodes) {
+		if (node.height > 0)
+			totalArea += node.aabb.getSurfaceArea();
+	}
+
+	float rootArea = m_nodes[m_root].aabb.getSurfaceArea();
+	return rootArea > 0 ? totalArea / rootArea : 0;
+}
+
+int AABBTree::allocateNode()
+{
+	int nodeIdx;
+	if (m_freeList != s_kNullNode) {
+		nodeIdx = m_freeList;
+		m_freeList = m_nodes[nodeIdx].parent;
+	} else {
+		nodeIdx = static_cast<int>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+
+	Node& node = m_nodes[nodeIdx];
+	node.userData = 0;
+	node.parent = s_kNullNode;
+	node.child1 = s_kNullNode;
+	node.child2 = s_kNullNode;
+	node.height = 0;
+	return nodeIdx;
+}
+
+void AABBTree::freeNode(int nodeIdx)
+{
+	m_nodes[nodeIdx].parent = m_freeList;
+	m_nodes[nodeIdx].height = -1;
+	m_freeList = nodeIdx;
+}
+
+void AABBTree::insertLeaf(int leaf)
+{
+	if (m_root == s_kNullNode) {
+		m_root = leaf;
+		m_nodes[leaf].parent = s_kNullNode;
+		return;
+	}
+
+	// Walk down to the sibling that adds the least surface area.
+	// Every node above the new leaf grows to fit it, that growth is
+	// inherited by each step down.
+	AABB leafAABB = m_nodes[leaf].aabb;
+	int sibling = m_root;
+	while (!m_nodes[sibling].isLeaf()) {
+		const Node& node = m_nodes[sibling];
+		float area = node.aabb.getSurfaceArea();
+		float combinedArea = AABB::combine(node.aabb, leafAABB).getSurfaceArea();
+
+		// Cost of pairing the leaf with this node
+		float cost = 2 * combinedArea;
+		float inheritanceCost = 2 * (combinedArea - area);
+
+		// Cost of descending into each child
+		float childCosts[2];
+		int children[2] = { node.child1, node.child2 };
+		for (int i = 0; i < 2; ++i) {
+			const Node& child = m_nodes[children[i]];
+			float childCombinedArea = AABB::combine(child.aabb, leafAABB).getSurfaceArea();
+			if (child.isLeaf())
+				childCosts[i] = childCombinedArea + inheritanceCost;
+			else
+				childCosts[i] = childCombinedArea - child.aabb.getSurfaceArea() + inheritanceCost;
+		}
+
+		if (cost < childCosts[0] && cost < childCosts[1])
+			break;
+
+		sibling = childCosts[0] < childCosts[1] ? children[0] : children[1];
+	}
+
+	// Replace the sibling with a new parent of it and the leaf
+	int oldParent = m_nodes[sibling].parent;
+	int newParent = allocateNode();
+	Node& parentNode = m_nodes[newParent];
+	parentNode.parent = oldParent;
+	parentNode.aabb = AABB::combine(leafAABB, m_nodes[sibling].aabb);
+	parentNode.height = m_nodes[sibling].height + 1;
+	parentNode.child1 = sibling;
+	parentNode.child2 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent == s_kNullNode) {
+		m_root = newParent;
+	} else if (m_nodes[oldParent].child1 == sibling) {
+		m_nodes[oldParent].child1 = newParent;
+	} else {
+		m_nodes[oldParent].child2 = newParent;
+	}
+
+	fixUpwards(newParent);
+}
+
+void AABBTree::removeLeaf(int leaf)
+{
+	if (leaf == m_root) {
+		m_root = s_kNullNode;
+		return;
+	}
+
+	// The leafs sibling takes the place of their parent
+	int parent = m_nodes[leaf].parent;
+	int grandParent = m_nodes[parent].parent;
+	int sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+	freeNode(parent);
+
+	m_nodes[sibling].parent = grandParent;
+	if (grandParent == s_kNullNode) {
+		m_root = sibling;
+		return;
+	}
+
+	if (m_nodes[grandParent].child1 == parent)
+		m_nodes[grandParent].child1 = sibling;
+	else
+		m_nodes[grandParent].child2 = sibling;
+	fixUpwards(grandParent);
+}
+
+int AABBTree::balance(int a)
+{
+	// Rotates the taller child of a up into its place, if the childrens
+	// heights differ by more than one.
+	// With b and c as the children of a, c the taller, and f and g as the
+	// children of c, g the shorter:
+	// - c takes the place of a, with a and f as its children
+	// - a keeps b, and takes g in place of c
+	Node& nodeA = m_nodes[a];
+	if (nodeA.isLeaf() || nodeA.height < 2)
+		return a;
+
+	int b = nodeA.child1;
+	int c = nodeA.child2;
+	int heightDifference = m_nodes[c].height - m_nodes[b].height;
+	if (heightDifference >= -1 && heightDifference <= 1)
+		return a;
+
+	// Work out which child rises, and which side of a it's replaced on
+	bool isRaisingSecondChild = heightDifference > 1;
+	int raised = isRaisingSecondChild ? c : b;
+	int kept = isRaisingSecondChild ? b : c;
+	Node& raisedNode = m_nodes[raised];
+	int f = raisedNode.child1;
+	int g = raisedNode.child2;
+	if (m_nodes[g].height > m_nodes[f].height)
+		std::swap(f, g);
+
+	// The raised node replaces a under its parent
+	raisedNode.child1 = a;
+	raisedNode.child2 = f;
+	raisedNode.parent = nodeA.parent;
+	nodeA.parent = raised;
+	if (raisedNode.parent == s_kNullNode) {
+		m_root = raised;
+	} else if (m_nodes[raisedNode.parent].child1 == a) {
+		m_nodes[raisedNode.parent].child1 = raised;
+	} else {
+		m_nodes[raisedNode.parent].child2 = raised;
+	}
+
+	// a keeps its other child and adopts the shorter grandchild
+	if (isRaisingSecondChild)
+		nodeA.child2 = g;
+	else
+		nodeA.child1 = g;
+	m_nodes[g].parent = a;
+
+	nodeA.aabb = AABB::combine(m_nodes[kept].aabb, m_nodes[g].aabb);
+	nodeA.height = 1 + std::max(m_nodes[kept].height, m_nodes[g].height);
+	raisedNode.aabb = AABB::combine(nodeA.aabb, m_nodes[f].aabb);
+	raisedNode.height = 1 + std::max(nodeA.height, m_nodes[f].height);
+	return raised;
+}
+
+void AABBTree::fixUpwards(int nodeIdx)
+{
+	while (nodeIdx != s_kNullNode) {
+		nodeIdx = balance(nodeIdx);
+
+		Node& node = m_nodes[nodeIdx];
+		const Node& child1 = m_nodes[node.child1];
+		const Node& child2 = m_nodes[node.child2];
+		node.aabb = AABB::combine(child1.aabb, child2.aabb);
+		node.height = 1 + std::max(child1.height, child2.height);
+
+		nodeIdx = node.parent;
+	}
+}
+
+int AABBTree::buildTopDown(int* leaves, size_t numLeaves)
+{
+	if (numLeaves == 1)
+		return leaves[0];
+
+	// Split at the median centre along the longest axis of the centres
+	glm::vec3 centerMin = (m_nodes[leaves[0]].aabb.min + m_nodes[leaves[0]].aabb.max) * 0.5f;
+	glm::vec3 centerMax = centerMin;
+	for (size_t i = 1; i < numLeaves; ++i) {
+		const AABB& aabb = m_nodes[leaves[i]].aabb;
+		glm::vec3 center = (aabb.min + aabb.max) * 0.5f;
+		centerMin = glm::min(centerMin, center);
+		centerMax = glm::max(centerMax, center);
+	}
+
+	glm::vec3 extent = centerMax - centerMin;
+	int axis = 0;
+	if (extent.y > extent[axis])
+		axis = 1;
+	if (extent.z > extent[axis])
+		axis = 2;
+
+	size_t numLeft = numLeaves / 2;
+	std::nth_element(leaves, leaves + numLeft, leaves + numLeaves, [this, axis](int lhs, int rhs) {
+		return m_nodes[lhs].aabb.min[axis] + m_nodes[lhs].aabb.max[axis] < m_nodes[rhs].aabb.min[axis] + m_nodes[rhs].aabb.max[axis];
+	});
+
+	int child1 = buildTopDown(leaves, numLeft);
+	int child2 = buildTopDown(leaves + numLeft, numLeaves - numLeft);
+
+	int parent = allocateNode();
+	Node& parentNode = m_nodes[parent];
+	parentNode.child1 = child1;
+	parentNode.child2 = child2;
+	parentNode.aabb = AABB::combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+	parentNode.height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
+	m_nodes[child1].parent = parent;
+	m_nodes[child2].parent = parent;
+	return parent;
+}
+
+AABB AABBTree::fatten(const AABB& aabb, float margin)
+{
+	return { aabb.min - margin, aabb.max + margin };
+}
+
+float AABBTree::rayHitDistance(const AABB& aabb, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+{
+	// Clip the ray against each pair of slabs
+	float entry = 0;
+	float exit = maxDistance;
+	for (int i = 0; i < 3; ++i) {
+		if (std::isinf(inverseDirection[i])) {
+			// Parallel to the slabs, so only hits if it starts between them
+			if (origin[i] < aabb.min[i] || origin[i] > aabb.max[i])
+				return -1;
+			continue;
+		}
+
+		float distance1 = (aabb.min[i] - origin[i]) * inverseDirection[i];
+		float distance2 = (aabb.max[i] - origin[i]) * inverseDirection[i];
+		entry = std::max(entry, std::min(distance1, distance2));
+		exit = std::min(exit, std::max(distance1, distance2));
+		if (entry > exit)
+			return -1;
+	}
+
+	return entry;
+}
+
+bool AABBTree::isOutsidePlane(const AABB& aabb, const glm::vec4& plane)
+{
+	// Test the corner furthest along the planes normal
+	glm::vec3 corner(plane.x >= 0 ? aabb.max.x : aabb.min.x,
+	                 plane.y >= 0 ? aabb.max.y : aabb.min.y,
+	                 plane.z >= 0 ? aabb.max.z : aabb.min.z);
+	return glm::dot(glm::vec3(plane), corner) + plane.w < 0;
+}
+
+bool AABBTree::isInsidePlane(const AABB& aabb, const glm::vec4& plane)
+{
+	// Test the corner furthest against the planes normal
+	glm::vec3 corner(plane.x >= 0 ? aabb.min.x : aabb.max.x,
+	                 plane.y >= 0 ? aabb.min.y : aabb.max.y,
+	                 plane.z >= 0 ? aabb.min.z : aabb.max.z);
+	return glm::dot(glm::vec3(plane), corner) + plane.w >= 0;
+}
@@ -0,0 +1,320 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : A dynamic bounding volume tree of axis aligned
+//                bounding boxes, for fast spatial queries.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include "FrustumCulling.h"
+
+#include <glm\glm.hpp>
+
+#include <cassert>
+#include <vector>
+
+struct AABB {
+	glm::vec3 min;
+	glm::vec3 max;
+
+	bool contains(const AABB&) const;
+	bool overlaps(const AABB&) const;
+	float getSurfaceArea() const;
+	static AABB combine(const AABB&, const AABB&);
+};
+
+// Leaves are proxies for the objects in the tree, which each hold a
+// fattened AABB so small movements don't need the tree to change.
+// Proxies are inserted where they add the least surface area, and
+// the tree is kept balanced with rotations as proxies are added and
+// removed.
+// Nodes are stored in a pool and referenced by index, so proxy ids stay
+// valid until the proxy is destroyed.
+class AABBTree {
+public:
+	static const int s_kNullNode = -1;
+
+	// margin is how far each proxies AABB is fattened on every side.
+	// Moved proxies are also fattened in the direction they moved, by
+	// their displacement scaled by displacementMultiplier.
+	AABBTree(float margin = 0.1f, float displacementMultiplier = 2);
+
+	// Adds a proxy and returns its id
+	int createProxy(const AABB&, size_t userData);
+	void destroyProxy(int proxyID);
+
+	// Moves a proxy to its new tight AABB.
+	// The proxy is only reinserted if the AABB has left its fat AABB,
+	// returns true if it was.
+	bool moveProxy(int proxyID, const AABB&, const glm::vec3& displacement);
+
+	// Sets a proxies AABB, fattened by the margin, without changing the
+	// tree.
+	// The tree must be refit before it is queried again.
+	void setProxyAABB(int proxyID, const AABB&);
+
+	// Brings every internal nodes AABB up to date with its children,
+	// keeping the trees structure.
+	// Cheaper than reinserting when many proxies have moved a little,
+	// but the tree gets less efficient the further they move.
+	void refit();
+
+	// Rebuilds the tree top down from its current proxies, splitting
+	// them at the median of their longest axis.
+	// Proxy ids are kept.
+	void rebuild();
+
+	void clear();
+
+	size_t getUserData(int proxyID) const;
+	const AABB& getFatAABB(int proxyID) const;
+	size_t size() const;
+
+	// Returns the height of the tree, 0 for a single proxy
+	int getHeight() const;
+
+	// Returns the total surface area of the internal nodes divided by the
+	// surface area of the root, lower is better
+	float getAreaRatio() const;
+
+	// Calls callback(userData) for each proxy whose fat AABB overlaps
+	// the AABB
+	template <typename CallbackT>
+	void queryAABB(const AABB&, CallbackT callback) const;
+
+	// Calls callback(userData) for each proxy whose fat AABB overlaps
+	// the sphere
+	template <typename CallbackT>
+	void querySphere(const glm::vec3& center, float radius, CallbackT callback) const;
+
+	// Calls callback(userData) for each proxy whose fat AABB is at least
+	// partly inside the frustum.
+	// Subtrees entirely inside the frustum are reported without testing
+	// their proxies.
+	template <typename CallbackT>
+	void queryFrustum(const FrustumCulling::Frustum&, CallbackT callback) const;
+
+	// Calls callback(userData, distance) for each proxy whose fat AABB
+	// the ray hits within maxDistance, where distance is how far along
+	// the ray it enters the AABB.
+	// The callback returns the new max distance, so it can return the
+	// distance to its own hit to only visit closer proxies, or a
+	// negative number to stop.
+	// direction doesn't need to be normalized, distances are in
+	// multiples of it.
+	template <typename CallbackT>
+	void rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, CallbackT callback) const;
+
+private:
+	struct Node {
+		bool isLeaf() const;
+
+		AABB aabb;
+		size_t userData;
+		int parent; // Next free node while in the free list
+		int child1;
+		int child2;
+		int height; // 0 for leaves, -1 while in the free list
+	};
+
+	// A depth first traversal stack that only allocates once the tree is
+	// too deep for the fixed array
+	class NodeStack {
+	public:
+		void push(int node);
+		int pop();
+		bool isEmpty() const;
+
+	private:
+		static const size_t s_kFixedSize = 64;
+
+		int m_fixed[s_kFixedSize];
+		size_t m_size = 0;
+		std::vector<int> m_overflow;
+	};
+
+	int allocateNode();
+	void freeNode(int node);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int balance(int node);
+	void fixUpwards(int node);
+	int buildTopDown(int* leaves, size_t numLeaves);
+	static AABB fatten(const AABB&, float margin);
+	static float rayHitDistance(const AABB&, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance);
+	static bool isOutsidePlane(const AABB&, const glm::vec4& plane);
+	static bool isInsidePlane(const AABB&, const glm::vec4& plane);
+
+	std::vector<Node> m_nodes;
+	int m_root = s_kNullNode;
+	int m_freeList = s_kNullNode;
+	size_t m_numProxies = 0;
+	float m_margin;
+	float m_displacementMultiplier;
+	std::vector<int> m_scratchNodes;
+};
+
+inline bool AABBTree::Node::isLeaf() const
+{
+	return child1 == s_kNullNode;
+}
+
+inline void AABBTree::NodeStack::push(int node)
+{
+	if (m_size < s_kFixedSize)
+		m_fixed[m_size] = node;
+	else
+		m_overflow.push_back(node);
+	++m_size;
+}
+
+inline int AABBTree::NodeStack::pop()
+{
+	assert(m_size > 0);
+	--m_size;
+	if (m_size < s_kFixedSize)
+		return m_fixed[m_size];
+
+	int node = m_overflow.back();
+	m_overflow.pop_back();
+	return node;
+}
+
+inline bool AABBTree::NodeStack::isEmpty() const
+{
+	return m_size == 0;
+}
+
+template <typename CallbackT>
+inline void AABBTree::queryAABB(const AABB& aabb, CallbackT callback) const
+{
+	NodeStack stack;
+	if (m_root != s_kNullNode)
+		stack.push(m_root);
+
+	while (!stack.isEmpty()) {
+		const Node& node = m_nodes[stack.pop()];
+		if (!node.aabb.overlaps(aabb))
+			continue;
+
+		if (node.isLeaf()) {
+			callback(node.userData);
+		} else {
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
+
+template <typename CallbackT>
+inline void AABBTree::querySphere(const glm::vec3& center, float radius, CallbackT callback) const
+{
+	NodeStack stack;
+	if (m_root != s_kNullNode)
+		stack.push(m_root);
+
+	float radiusSquared = radius * radius;
+	while (!stack.isEmpty()) {
+		const Node& node = m_nodes[stack.pop()];
+		glm::vec3 closestPoint = glm::clamp(center, node.aabb.min, node.aabb.max);
+		glm::vec3 offset = closestPoint - center;
+		if (glm::dot(offset, offset) > radiusSquared)
+			continue;
+
+		if (node.isLeaf()) {
+			callback(node.userData);
+		} else {
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
+
+template <typename CallbackT>
+inline void AABBTree::queryFrustum(const FrustumCulling::Frustum& frustum, CallbackT callback) const
+{
+	// Nodes are pushed with the planes they still need testing against.
+	// Once a node is inside a plane, so are all of its children.
+	const unsigned int kAllPlanes = (1 << 6) - 1;
+	NodeStack stack;
+	NodeStack planeMasks;
+	if (m_root != s_kNullNode) {
+		stack.push(m_root);
+		planeMasks.push(kAllPlanes);
+	}
+
+	while (!stack.isEmpty()) {
+		int nodeIdx = stack.pop();
+		unsigned int planeMask = static_cast<unsigned int>(planeMasks.pop());
+		const Node& node = m_nodes[nodeIdx];
+
+		bool isOutside = false;
+		for (int i = 0; i < 6 && !isOutside; ++i) {
+			if (!(planeMask & (1 << i)))
+				continue;
+
+			if (isOutsidePlane(node.aabb, frustum.planes[i]))
+				isOutside = true;
+			else if (isInsidePlane(node.aabb, frustum.planes[i]))
+				planeMask &= ~(1 << i);
+		}
+		if (isOutside)
+			continue;
+
+		if (node.isLeaf()) {
+			callback(node.userData);
+		} else if (planeMask == 0) {
+			// The whole subtree is visible, so just collect its leaves
+			NodeStack subtree;
+			subtree.push(nodeIdx);
+			while (!subtree.isEmpty()) {
+				const Node& subNode = m_nodes[subtree.pop()];
+				if (subNode.isLeaf()) {
+					callback(subNode.userData);
+				} else {
+					subtree.push(subNode.child1);
+					subtree.push(subNode.child2);
+				}
+			}
+		} else {
+			stack.push(node.child1);
+			planeMasks.push(planeMask);
+			stack.push(node.child2);
+			planeMasks.push(planeMask);
+		}
+	}
+}
+
+template <typename CallbackT>
+inline void AABBTree::rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, CallbackT callback) const
+{
+	// Division by zero gives infinities, which the slab test handles
+	glm::vec3 inverseDirection = 1.0f / direction;
+	NodeStack stack;
+	if (m_root != s_kNullNode)
+		stack.push(m_root);
+
+	while (!stack.isEmpty()) {
+		const Node& node = m_nodes[stack.pop()];
+		float distance = rayHitDistance(node.aabb, origin, inverseDirection, maxDistance);
+		if (distance < 0)
+			continue;
+
+		if (node.isLeaf()) {
+			maxDistance = callback(node.userData, distance);
+			if (maxDistance < 0)
+				return;
+		} else {
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
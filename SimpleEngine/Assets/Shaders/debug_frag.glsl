@@ -9,33 +9,35 @@ in VertexData {
 
 out vec4 outColor;
 
-layout (std140) uniform UniformBlock {
-    mat4 model;
+layout (std140) uniform FrameUniforms {
     mat4 view;
     mat4 projection;
 	vec4 cameraPos;
-	vec4 spotlightPositions[8];
-	vec4 spotlightDirections[8];
-	vec4 spotlightColors[8];
-	uint numSpotlights;
+	vec4 clusterScale;
+	uvec4 clusterGridSize;
+	float time;
+} frame;
+
+layout (std140) uniform MaterialUniforms {
 	float metallicness;
 	float glossiness;
 	float specBias;
-	float time;
 	bool discardTransparent;
-} u;
+} material;
 
 uniform vec3 debugColor;
 
 uniform sampler2D texSampler0;
 uniform samplerCube radianceSampler;
 uniform samplerCube irradianceSampler;
+uniform samplerBuffer lightDataSampler;
+uniform usamplerBuffer lightClusterSampler;
+uniform usamplerBuffer lightIndexSampler;
 
 vec3 lightDir = vec3(1, 1, -1);
 const vec3 LiDirect = vec3(0.64, 0.39, 0.31);
 const int pmremMipCount = 11;
-const float spotlightCuttoff = 0.5;
-const float spotPow = 4;
+const float spotlightBlend = 0.25;
 const float attenuationScale = 0.01;
 
 vec3 fresnel(vec3 specColor, vec3 lightDir, vec3 halfVector)
@@ -48,27 +50,55 @@ vec3 fresnelWithGloss(vec3 specColor, vec3 lightDir, vec3 halfVector, float glos
     return specColor + (max(vec3(gloss, gloss, gloss), specColor) - specColor) * pow(1.0f - clamp(dot(lightDir, halfVector), 0, 1), 5);
 }
 
-vec3 calcLrSpotlight(vec3 Cdiff, vec3 Cspec, vec3 normal, vec3 viewDir, vec3 lightPos, vec3 spotlightDir, vec3 lightCol, float specPow, float specNorm) 
+vec3 calcLrLight(vec3 Cdiff, vec3 Cspec, vec3 normal, vec3 viewDir, vec3 lightPos, float lightRange, vec3 lightCol, vec3 spotlightDir, float cosConeAngle, float specPow, float specNorm)
 {
 	vec3 lightDisplacement = lightPos - i.worldPos;
-	vec3 lightDir = normalize(lightDisplacement);
-	spotlightDir = normalize(spotlightDir);
-	float spotEffect = max(dot(-lightDir, spotlightDir), 0.0);
-	if (spotEffect > spotlightCuttoff) {
-		spotEffect = pow(spotEffect, spotPow);
-		float attenuation = 1.0 / (1.0 + attenuationScale * pow(length(lightDisplacement), 2));
-		vec3 halfVector = normalize(lightDir + viewDir);
-		float ndotl = clamp(dot(lightDir, normal), 0, 1);
-		float ndoth = clamp(dot(normal, halfVector), 0, 1);
-
-		vec3 Fspec = fresnel(Cspec, lightDir, halfVector);
-		vec3 Fdiff = Cdiff * (1 - Fspec) / (1.0000001 - Cspec);
-
-		vec3 BRDFspec = specNorm * Fspec * pow(ndoth, specPow);
-		return lightCol * spotEffect * attenuation * (Fdiff + BRDFspec) * ndotl;
-	} else {
+	float lightDistance = length(lightDisplacement);
+	if (lightDistance >= lightRange)
 		return vec3(0, 0, 0);
-	}	
+	vec3 lightDir = lightDisplacement / lightDistance;
+
+	// Spotlights fade out towards the edge of their cone.
+	// Point lights have a cone angle of -1.
+	float spotEffect = 1;
+	if (cosConeAngle > -1)
+		spotEffect = smoothstep(cosConeAngle, mix(cosConeAngle, 1, spotlightBlend), dot(-lightDir, spotlightDir));
+
+	// Fades to nothing at the edge of the lights range
+	float rangeFade = clamp(1 - pow(lightDistance / lightRange, 4), 0, 1);
+	float attenuation = rangeFade * rangeFade / (1.0 + attenuationScale * lightDistance * lightDistance);
+
+	vec3 halfVector = normalize(lightDir + viewDir);
+	float ndotl = clamp(dot(lightDir, normal), 0, 1);
+	float ndoth = clamp(dot(normal, halfVector), 0, 1);
+
+	vec3 Fspec = fresnel(Cspec, lightDir, halfVector);
+	vec3 Fdiff = Cdiff * (1 - Fspec) / (1.0000001 - Cspec);
+
+	vec3 BRDFspec = specNorm * Fspec * pow(ndoth, specPow);
+	return lightCol * spotEffect * attenuation * (Fdiff + BRDFspec) * ndotl;
+}
+
+// Adds up the point and spot lights in the fragments cluster
+vec3 calcLrLights(vec3 Cdiff, vec3 Cspec, vec3 normal, vec3 viewDir, float specPow, float specNorm)
+{
+	float viewDepth = max(-(frame.view * vec4(i.worldPos, 1)).z, 0.0001);
+	uvec3 cluster;
+	cluster.xy = min(uvec2(gl_FragCoord.xy * frame.clusterScale.xy), frame.clusterGridSize.xy - 1u);
+	cluster.z = uint(clamp(floor(log(viewDepth) * frame.clusterScale.z + frame.clusterScale.w), 0, float(frame.clusterGridSize.z - 1u)));
+	uint clusterIndex = (cluster.z * frame.clusterGridSize.y + cluster.y) * frame.clusterGridSize.x + cluster.x;
+	uvec2 clusterLights = texelFetch(lightClusterSampler, int(clusterIndex)).xy;
+
+	// Each light is three texels
+	vec3 Lr = vec3(0, 0, 0);
+	for (uint j = 0; j < clusterLights.y; ++j) {
+		int light = int(texelFetch(lightIndexSampler, int(clusterLights.x + j)).x) * 3;
+		vec4 positionRange = texelFetch(lightDataSampler, light);
+		vec4 colorCone = texelFetch(lightDataSampler, light + 1);
+		vec3 spotlightDir = texelFetch(lightDataSampler, light + 2).xyz;
+		Lr += calcLrLight(Cdiff, Cspec, normal, viewDir, positionRange.xyz, positionRange.w, colorCone.rgb, spotlightDir, colorCone.a, specPow, specNorm);
+	}
+	return Lr;
 }
 
 void main(void)
@@ -89,29 +119,26 @@ void main(void)
 	float ndoth = clamp(dot(normal, halfVector), 0, 1);
 
 	// Reflection variables
-	float specPow = exp2(10 * u.glossiness + 1);
+	float specPow = exp2(10 * material.glossiness + 1);
 	float specNorm = (specPow + 8) / 8;
-	float mipmapIndex = (1 - u.glossiness) * (pmremMipCount - 1); 
+	float mipmapIndex = (1 - material.glossiness) * (pmremMipCount - 1); 
 	vec3 LiReflDir = normalize(reflect(-viewDir, normal)); // The light direction that reflects directly into the camera
 	vec3 LiRefl = textureLod(radianceSampler, LiReflDir, mipmapIndex).rgb;
 	vec3 LiIrr = texture(irradianceSampler, normal).rgb;
 
-	vec3 Cspec = mix(vec3(0.04, 0.04, 0.04) + u.specBias, color, u.metallicness);
-	vec3 Cdiff = mix(vec3(0, 0, 0), color, 1 - u.metallicness);
+	vec3 Cspec = mix(vec3(0.04, 0.04, 0.04) + material.specBias, color, material.metallicness);
+	vec3 Cdiff = mix(vec3(0, 0, 0), color, 1 - material.metallicness);
 	vec3 Fspec = fresnel(Cspec, lightDir, halfVector);
 	vec3 Fdiff = Cdiff * (1 - Fspec) / (1.0000001 - Cspec);
-	vec3 FspecRefl = fresnelWithGloss(Cspec, LiReflDir, normal, u.glossiness);
+	vec3 FspecRefl = fresnelWithGloss(Cspec, LiReflDir, normal, material.glossiness);
 	vec3 FdiffRefl = Cdiff * (1 - FspecRefl) / (1.0000001 - Cspec);
 
 	vec3 BRDFspec = specNorm * Fspec * pow(ndoth, specPow);
 
-	vec3 LrSpotlight = vec3(0, 0, 0);
-	for (uint i = 0; i < u.numSpotlights; ++i) {
-		LrSpotlight += calcLrSpotlight(Cdiff, Cspec, normal, viewDir, u.spotlightPositions[i].xyz, u.spotlightDirections[i].xyz, u.spotlightColors[i].rgb, specPow, specNorm);
-	}
+	vec3 LrLights = calcLrLights(Cdiff, Cspec, normal, viewDir, specPow, specNorm);
 	vec3 LrDirect = LiDirect * (Fdiff + BRDFspec) * ndotl;
 	vec3 LrAmbDiff= LiIrr * FdiffRefl;
 	vec3 LrAmbSpec = LiRefl * FspecRefl;
 
-	outColor = vec4(LrDirect + LrSpotlight + LrAmbDiff + LrAmbSpec, 1);
+	outColor = vec4(LrDirect + LrLights + LrAmbDiff + LrAmbSpec, 1);
 }
@@ -3,6 +3,7 @@
 layout (location = 0) in vec3 inPosition;
 layout (location = 1) in vec3 inNormal;
 layout (location = 2) in vec2 inTexCoord;
+layout (location = 4) in mat4 inModel; // Per instance
 
 out VertexData {
     vec3 normal;
@@ -11,30 +12,30 @@ out VertexData {
 	vec3 worldPos;
 } o;
 
-layout (std140) uniform UniformBlock {
-    mat4 model;
+layout (std140) uniform FrameUniforms {
     mat4 view;
     mat4 projection;
 	vec4 cameraPos;
-	vec4 spotlightPositions[8];
-	vec4 spotlightDirections[8];
-	vec4 spotlightColors[8];
-	uint numSpotlights;
+	vec4 clusterScale;
+	uvec4 clusterGridSize;
+	float time;
+} frame;
+
+layout (std140) uniform MaterialUniforms {
 	float metallicness;
 	float glossiness;
 	float specBias;
-	float time;
 	bool discardTransparent;
-} u;
+} material;
 
 void main()
 {
-	vec3 worldPos = (u.model * vec4(inPosition, 1)).xyz;
+	vec3 worldPos = (inModel * vec4(inPosition, 1)).xyz;
 
-    o.normal = (u.model * vec4(inNormal, 0)).xyz; // TODO: Do inverse transpose
+    o.normal = (inModel * vec4(inNormal, 0)).xyz; // TODO: Do inverse transpose
     o.texCoord = inTexCoord;
-	o.viewDir = (u.cameraPos.xyz - worldPos).xyz;
+	o.viewDir = (frame.cameraPos.xyz - worldPos).xyz;
 	o.worldPos = worldPos;
 
-    gl_Position = u.projection * u.view * vec4(worldPos, 1);
+    gl_Position = frame.projection * frame.view * vec4(worldPos, 1);
 }
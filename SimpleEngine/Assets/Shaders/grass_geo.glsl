@@ -3,21 +3,21 @@
 layout (triangles) in;
 layout (triangle_strip, max_vertices = 8) out;
 
-layout (std140) uniform UniformBlock {
-    mat4 model;
+layout (std140) uniform FrameUniforms {
     mat4 view;
     mat4 projection;
 	vec4 cameraPos;
-	vec4 spotlightPositions[8];
-	vec4 spotlightDirections[8];
-	vec4 spotlightColors[8];
-	uint numSpotlights;
+	vec4 clusterScale;
+	uvec4 clusterGridSize;
+	float time;
+} frame;
+
+layout (std140) uniform MaterialUniforms {
 	float metallicness;
 	float glossiness;
 	float specBias;
-	float time;
 	bool discardTransparent;
-} sh;
+} material;
 
 in VertexData {
     vec3 normal;
@@ -65,7 +65,7 @@ void main() {
 		v = cross(u, n);
 		mat3 tangentSpace = mat3(u, n, v);
 
-		const mat4 vp = sh.projection * sh.view;
+		const mat4 vp = frame.projection * frame.view;
 
 		for (int i = 0; i < 2; ++i) {
 			// Wind
@@ -75,8 +75,8 @@ void main() {
 			vec3 upperRight = grassBase + 0.5f * tangentSpace[0] + vec3(0, 1.0f, 0);
 			float leftWindCoord = -dot(upperLeft, windDir);
 			float rightWindCoord = -dot(upperRight, windDir);
-			vec3 upperLeftOffset = windDir * windMagnitude * (sin(leftWindCoord + sh.time) + 1);
-			vec3 upperRightOffset = windDir * windMagnitude * (sin(rightWindCoord + sh.time) + 1);
+			vec3 upperLeftOffset = windDir * windMagnitude * (sin(leftWindCoord + frame.time) + 1);
+			vec3 upperRightOffset = windDir * windMagnitude * (sin(rightWindCoord + frame.time) + 1);
 			float leftBendability = dot(n, normalize(upperLeft + upperLeftOffset - lowerLeft));
 			float rightBendability = dot(n, normalize(upperRight + upperRightOffset - lowerRight));
 			upperLeft += upperLeftOffset * leftBendability;
@@ -87,7 +87,7 @@ void main() {
 			gs_out.normal = quadNormal;
 			gs_out.texCoord = vec2(0, 1);
 			gs_out.worldPos = lowerLeft;
-			gs_out.viewDir = sh.cameraPos.xyz - gs_out.worldPos;
+			gs_out.viewDir = frame.cameraPos.xyz - gs_out.worldPos;
 			gl_Position = vp * vec4(gs_out.worldPos, 1);
 			EmitVertex();
 
@@ -95,7 +95,7 @@ void main() {
 			gs_out.normal = quadNormal;
 			gs_out.texCoord = vec2(1, 1);
 			gs_out.worldPos = lowerRight;
-			gs_out.viewDir = sh.cameraPos.xyz - gs_out.worldPos;
+			gs_out.viewDir = frame.cameraPos.xyz - gs_out.worldPos;
 			gl_Position = vp * vec4(gs_out.worldPos, 1);
 			EmitVertex();
 
@@ -103,7 +103,7 @@ void main() {
 			gs_out.normal = quadNormal;
 			gs_out.texCoord = vec2(0, 0);
 			gs_out.worldPos = upperLeft;
-			gs_out.viewDir = sh.cameraPos.xyz - gs_out.worldPos;
+			gs_out.viewDir = frame.cameraPos.xyz - gs_out.worldPos;
 			gl_Position = vp * vec4(gs_out.worldPos, 1);
 			EmitVertex();
 
@@ -111,7 +111,7 @@ void main() {
 			gs_out.normal = quadNormal;
 			gs_out.texCoord = vec2(1, 0);
 			gs_out.worldPos = upperRight;
-			gs_out.viewDir = sh.cameraPos.xyz - gs_out.worldPos;
+			gs_out.viewDir = frame.cameraPos.xyz - gs_out.worldPos;
 			gl_Position = vp * vec4(gs_out.worldPos, 1);
 			EmitVertex();
 
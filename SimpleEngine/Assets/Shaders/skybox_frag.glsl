@@ -6,21 +6,21 @@ in VertexData {
 
 out vec4 outColor;
 
-layout (std140) uniform UniformBlock {
-    mat4 model;
+layout (std140) uniform FrameUniforms {
     mat4 view;
     mat4 projection;
 	vec4 cameraPos;
-	vec4 spotlightPositions[8];
-	vec4 spotlightDirections[8];
-	vec4 spotlightColors[8];
-	uint numSpotlights;
+	vec4 clusterScale;
+	uvec4 clusterGridSize;
+	float time;
+} frame;
+
+layout (std140) uniform MaterialUniforms {
 	float metallicness;
 	float glossiness;
 	float specBias;
-	float time;
 	bool discardTransparent;
-} u;
+} material;
 
 uniform samplerCube texSampler0;
 
@@ -28,6 +28,6 @@ void main(void)
 {
     outColor = texture(texSampler0, i.textureDir);
 
-	if (u.discardTransparent && outColor.a < 0.5f)
+	if (material.discardTransparent && outColor.a < 0.5f)
 		discard;
 }
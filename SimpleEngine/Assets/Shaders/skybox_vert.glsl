@@ -6,26 +6,26 @@ out VertexData {
     vec3 textureDir;
 } o;
 
-layout (std140) uniform UniformBlock {
-    mat4 model;
+layout (std140) uniform FrameUniforms {
     mat4 view;
     mat4 projection;
 	vec4 cameraPos;
-	vec4 spotlightPositions[8];
-	vec4 spotlightDirections[8];
-	vec4 spotlightColors[8];
-	uint numSpotlights;
+	vec4 clusterScale;
+	uvec4 clusterGridSize;
+	float time;
+} frame;
+
+layout (std140) uniform MaterialUniforms {
 	float metallicness;
 	float glossiness;
 	float specBias;
-	float time;
 	bool discardTransparent;
-} u;
+} material;
 
 void main()
 {
-	mat4 view = u.view;
+	mat4 view = frame.view;
 	view[3] = vec4(0, 0, 0, 1);
 	o.textureDir = inPosition;
-	gl_Position = (u.projection * view * vec4(inPosition, 1.0)).xyww;
+	gl_Position = (frame.projection * view * vec4(inPosition, 1.0)).xyww;
 }
@@ -2,21 +2,21 @@
 
 layout (vertices = 3) out;
 
-layout (std140) uniform UniformBlock {
-    mat4 model;
+layout (std140) uniform FrameUniforms {
     mat4 view;
     mat4 projection;
 	vec4 cameraPos;
-	vec4 spotlightPositions[8];
-	vec4 spotlightDirections[8];
-	vec4 spotlightColors[8];
-	uint numSpotlights;
+	vec4 clusterScale;
+	uvec4 clusterGridSize;
+	float time;
+} frame;
+
+layout (std140) uniform MaterialUniforms {
 	float metallicness;
 	float glossiness;
 	float specBias;
-	float time;
 	bool discardTransparent;
-} u;
+} material;
 
 in ControlPointData {
     vec3 normal;
@@ -35,7 +35,7 @@ out ControlPointData {
 // Calculate tesselation level for an edge (defined by 2 points) based on the distance of the edge from the camera
 float getTessLevel(vec3 vertA, vec3 vertB) {
 	vec3 edgeCenter = (vertA + vertB) / 2;
-	float distanceFromCamera = distance(u.cameraPos.xyz, edgeCenter);
+	float distanceFromCamera = distance(frame.cameraPos.xyz, edgeCenter);
 	float normalizedDistance = clamp(distanceFromCamera / 250.0f, 0, 1);
 	const float bucketSize = 8;
 	const float maxTess = 64;
@@ -2,21 +2,21 @@
 
 layout (triangles, equal_spacing, ccw) in;
 
-layout (std140) uniform UniformBlock {
-    mat4 model;
+layout (std140) uniform FrameUniforms {
     mat4 view;
     mat4 projection;
 	vec4 cameraPos;
-	vec4 spotlightPositions[8];
-	vec4 spotlightDirections[8];
-	vec4 spotlightColors[8];
-	uint numSpotlights;
+	vec4 clusterScale;
+	uvec4 clusterGridSize;
+	float time;
+} frame;
+
+layout (std140) uniform MaterialUniforms {
 	float metallicness;
 	float glossiness;
 	float specBias;
-	float time;
 	bool discardTransparent;
-} u;
+} material;
 
 in ControlPointData {
     vec3 normal;
@@ -52,7 +52,7 @@ void main()
 	te_out.normal = texture(normalMapSampler, te_out.texCoord).xyz;
 	te_out.worldPos = interpolate3D(te_in[0].worldPos, te_in[1].worldPos, te_in[2].worldPos);
 	te_out.worldPos.y += texture(heightMapSampler, te_out.texCoord).r * heightMapScale;
-	te_out.viewDir = normalize(u.cameraPos.xyz - te_out.worldPos);
+	te_out.viewDir = normalize(frame.cameraPos.xyz - te_out.worldPos);
 
-	gl_Position = u.projection * u.view * vec4(te_out.worldPos, 1);
+	gl_Position = frame.projection * frame.view * vec4(te_out.worldPos, 1);
 }
\ No newline at end of file
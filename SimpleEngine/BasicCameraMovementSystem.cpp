@@ -24,7 +24,7 @@
 #include <glm\gtx\rotate_vector.hpp>
 
 BasicCameraMovementSystem::BasicCameraMovementSystem(Scene& scene)
-	: System(scene)
+	: System(scene, COMPONENT_BASIC_CAMERA_MOVEMENT | COMPONENT_CAMERA)
 {
 }
 
@@ -34,16 +34,17 @@ BasicCameraMovementSystem::~BasicCameraMovementSystem()
 
 void BasicCameraMovementSystem::beginFrame()
 {
-	if (!m_cameraToControl)
+	Entity* cameraToControl = m_scene.getEntity(m_cameraToControl);
+	if (!cameraToControl)
 		return;
 
 	// Filter movable
-	if (!m_cameraToControl->hasComponents(COMPONENT_BASIC_CAMERA_MOVEMENT, COMPONENT_INPUT, COMPONENT_CAMERA))
+	if (!cameraToControl->hasComponents(COMPONENT_BASIC_CAMERA_MOVEMENT, COMPONENT_INPUT, COMPONENT_CAMERA))
 		return;
 
-	CameraComponent& cameraComponent = m_cameraToControl->camera;
-	BasicCameraMovementComponent& movementVars = m_cameraToControl->basicCameraMovement;
-	InputComponent& input = m_cameraToControl->input;
+	CameraComponent& cameraComponent = cameraToControl->camera();
+	BasicCameraMovementComponent& movementVars = cameraToControl->basicCameraMovement();
+	InputComponent& input = cameraToControl->input();
 
 	glm::mat3 coordinateSystem;
 	glm::vec3 pos = cameraComponent.getPosition();
@@ -78,29 +79,30 @@ void BasicCameraMovementSystem::beginFrame()
 
 void BasicCameraMovementSystem::update(Entity& entity)
 {
-	if (entity.hasComponents(COMPONENT_BASIC_CAMERA_MOVEMENT, COMPONENT_CAMERA) && !m_cameraToControl)
-		setCameraToControl(&entity);
+	if (entity.hasComponents(COMPONENT_BASIC_CAMERA_MOVEMENT, COMPONENT_CAMERA) && !m_scene.getEntity(m_cameraToControl))
+		setCameraToControl(entity.getHandle());
 }
 
 void BasicCameraMovementSystem::endFrame()
 {
 }
 
-void BasicCameraMovementSystem::setCameraToControl(Entity* entity)
+void BasicCameraMovementSystem::setCameraToControl(const EntityHandle& cameraHandle)
 {
+	Entity* entity = m_scene.getEntity(cameraHandle);
 	if (entity && !entity->hasComponents(COMPONENT_CAMERA))
 		return;
 
-	m_cameraToControl = entity;
+	m_cameraToControl = cameraHandle;
 
-	if (m_cameraToControl) {
-		if (!m_cameraToControl->hasComponents(COMPONENT_BASIC_CAMERA_MOVEMENT)) {
-			m_cameraToControl->addComponents(COMPONENT_BASIC_CAMERA_MOVEMENT);
-			m_cameraToControl->basicCameraMovement.moveSpeed = 0.2f;
-			m_cameraToControl->basicCameraMovement.orientationSensitivity = 0.01f;
+	if (entity) {
+		if (!entity->hasComponents(COMPONENT_BASIC_CAMERA_MOVEMENT)) {
+			entity->addComponents(COMPONENT_BASIC_CAMERA_MOVEMENT);
+			entity->basicCameraMovement().moveSpeed = 0.2f;
+			entity->basicCameraMovement().orientationSensitivity = 0.01f;
 		}
-		if (!m_cameraToControl->hasComponents(COMPONENT_INPUT_MAP))
-			setDefaultMouseControls(*m_cameraToControl);
+		if (!entity->hasComponents(COMPONENT_INPUT_MAP))
+			setDefaultMouseControls(*entity);
 	}
 }
 
@@ -109,13 +111,13 @@ void BasicCameraMovementSystem::setDefaultMouseControls(Entity& entity)
 	entity.addComponents(COMPONENT_INPUT_MAP);
 	entity.addComponents(COMPONENT_INPUT);
 
-	entity.input = {};
-	entity.inputMap = {};
-	entity.inputMap.mouseInputEnabled = true;
-	entity.inputMap.leftBtnMap = GLFW_KEY_A;
-	entity.inputMap.rightBtnMap = GLFW_KEY_D;
-	entity.inputMap.forwardBtnMap = GLFW_KEY_W;
-	entity.inputMap.backwardBtnMap = GLFW_KEY_S;
-	entity.inputMap.downBtnMap = GLFW_KEY_Q;
-	entity.inputMap.upBtnMap = GLFW_KEY_E;
+	entity.input() = {};
+	entity.inputMap() = {};
+	entity.inputMap().mouseInputEnabled = true;
+	entity.inputMap().leftBtnMap = GLFW_KEY_A;
+	entity.inputMap().rightBtnMap = GLFW_KEY_D;
+	entity.inputMap().forwardBtnMap = GLFW_KEY_W;
+	entity.inputMap().backwardBtnMap = GLFW_KEY_S;
+	entity.inputMap().downBtnMap = GLFW_KEY_Q;
+	entity.inputMap().upBtnMap = GLFW_KEY_E;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "System.h"
+#include "EntityHandle.h"
 
 class BasicCameraMovementSystem : public System {
 public:
@@ -12,9 +13,9 @@ public:
 	virtual void beginFrame() override;
 	virtual void endFrame() override;
 
-	void setCameraToControl(Entity*);
+	void setCameraToControl(const EntityHandle&);
 	void setDefaultMouseControls(Entity&);
 
 private:
-	Entity* m_cameraToControl;
+	EntityHandle m_cameraToControl;
 };
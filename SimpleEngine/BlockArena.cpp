@@ -0,0 +1,43 @@
+#include "BlockArena.h"
+
+void* BlockArena::allocate(size_t size)
+{
+	if (size == 0 || size > s_kMaxSizeClassSize)
+		return ::operator new(size);
+
+	// Reuse a freed allocation of the same size class
+	size_t sizeClass = getSizeClass(size);
+	if (FreeNode* node = m_freeLists[sizeClass]) {
+		m_freeLists[sizeClass] = node->next;
+		return node;
+	}
+
+	// Otherwise bump allocate, starting a new block if this one is full
+	size_t classSize = (sizeClass + 1) * s_kAlignment;
+	if (m_blockOffset + classSize > s_kBlockSize) {
+		m_blocks.emplace_back(new char[s_kBlockSize]);
+		m_blockOffset = 0;
+	}
+
+	void* memory = m_blocks.back().get() + m_blockOffset;
+	m_blockOffset += classSize;
+	return memory;
+}
+
+void BlockArena::deallocate(void* memory, size_t size)
+{
+	if (size == 0 || size > s_kMaxSizeClassSize) {
+		::operator delete(memory);
+		return;
+	}
+
+	size_t sizeClass = getSizeClass(size);
+	FreeNode* node = static_cast<FreeNode*>(memory);
+	node->next = m_freeLists[sizeClass];
+	m_freeLists[sizeClass] = node;
+}
+
+size_t BlockArena::getSizeClass(size_t size)
+{
+	return (size + s_kAlignment - 1) / s_kAlignment - 1;
+}
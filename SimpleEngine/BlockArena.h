@@ -0,0 +1,112 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : A general purpose arena for variable sized component
+//                data, and an allocator to use it with std containers.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Hands out memory bump allocated from fixed size blocks.
+// Freed allocations are kept on a free list per size class and reused by
+// later allocations of the same class.
+// Allocations too large for a size class go to the heap.
+// All the blocks are released together when the arena is destroyed.
+// Not thread safe.
+class BlockArena {
+public:
+	BlockArena() = default;
+	BlockArena(const BlockArena&) = delete;
+	BlockArena& operator=(const BlockArena&) = delete;
+
+	void* allocate(size_t size);
+	void deallocate(void* memory, size_t size);
+
+private:
+	static const size_t s_kBlockSize = 64 * 1024;
+	static const size_t s_kAlignment = alignof(std::max_align_t);
+	static const size_t s_kNumSizeClasses = 64;
+	static const size_t s_kMaxSizeClassSize = s_kNumSizeClasses * s_kAlignment;
+
+	struct FreeNode {
+		FreeNode* next;
+	};
+
+	static size_t getSizeClass(size_t size);
+
+	std::vector<std::unique_ptr<char[]>> m_blocks;
+	size_t m_blockOffset = s_kBlockSize; // Bump offset into the last block
+	std::array<FreeNode*, s_kNumSizeClasses> m_freeLists{};
+};
+
+// Allocates from a BlockArena.
+// A default constructed allocator (no arena) uses the heap.
+// Copies of a container don't inherit its arena, so a copy can safely
+// outlive the arena of the container it was copied from.
+template <typename T>
+class ArenaAllocator {
+public:
+	using value_type = T;
+
+	ArenaAllocator() = default;
+	ArenaAllocator(BlockArena* arena) : m_arena{ arena } {}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : m_arena{ other.getArena() } {}
+
+	T* allocate(size_t n);
+	void deallocate(T* memory, size_t n);
+
+	ArenaAllocator select_on_container_copy_construction() const { return {}; }
+
+	BlockArena* getArena() const { return m_arena; }
+
+private:
+	BlockArena* m_arena = nullptr;
+};
+
+// A vector that can store its elements in a BlockArena
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs)
+{
+	return lhs.getArena() == rhs.getArena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs)
+{
+	return !(lhs == rhs);
+}
+
+template <typename T>
+inline T* ArenaAllocator<T>::allocate(size_t n)
+{
+	if (!m_arena)
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+
+	return static_cast<T*>(m_arena->allocate(n * sizeof(T)));
+}
+
+template <typename T>
+inline void ArenaAllocator<T>::deallocate(T* memory, size_t n)
+{
+	if (!m_arena)
+		::operator delete(memory);
+	else
+		m_arena->deallocate(memory, n * sizeof(T));
+}
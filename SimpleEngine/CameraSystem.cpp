@@ -7,9 +7,11 @@
 using glm::vec3;
 
 CameraSystem::CameraSystem(Scene& scene, std::vector<Entity*>& playerList)
-	: System(scene)
+	: System(scene, COMPONENT_CAMERA)
 	, m_playerList{ playerList }
 {
+	setComponentAccess(COMPONENT_TRANSFORM, COMPONENT_CAMERA);
+	setRequiresMainThread(false);
 }
 
 
@@ -23,12 +25,12 @@ void CameraSystem::update(Entity& entity)
 		return;
 
 	if (m_playerList.size() > 0) {
-		float minX = m_playerList[0]->transform.position.x;
+		float minX = m_playerList[0]->transform().position.x;
 		float maxX = minX;
-		float minZ = m_playerList[0]->transform.position.y;
+		float minZ = m_playerList[0]->transform().position.y;
 		float maxZ = minZ;
 		for (auto player : m_playerList) {
-			const vec3& position = player->transform.position;
+			const vec3& position = player->transform().position;
 			minX = glm::min(minX, position.x);
 			maxX = glm::max(maxX, position.x);
 			minZ = glm::min(minZ, position.z);
@@ -36,7 +38,7 @@ void CameraSystem::update(Entity& entity)
 		}
 		vec3 center = { (minX + maxX) / 2, 0, (minZ + maxZ) / 2 };
 
-		entity.camera.setLookAt(center + vec3{ 0, 100, 10 }, center, vec3{ 0, 1, 0 });
+		entity.camera().setLookAt(center + vec3{ 0, 100, 10 }, center, vec3{ 0, 1, 0 });
 	}
 }
 
@@ -0,0 +1,108 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Stores objects in fixed size blocks so they never
+//                move once created.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// An append only array of objects, bump allocated into fixed size blocks.
+// Objects are stored contiguously within a block and are never moved, so
+// references stay valid for the lifetime of the arena.
+// Reusing freed objects is left to the owner i.e. the scenes entity free
+// list.
+// Trivially destructible objects are released with their block without
+// calling any destructors.
+template <typename T, size_t kBlockSize = 256>
+class ChunkedArena {
+public:
+	ChunkedArena() = default;
+	ChunkedArena(const ChunkedArena&) = delete;
+	ChunkedArena& operator=(const ChunkedArena&) = delete;
+	~ChunkedArena();
+
+	// Constructs a new object at the end of the arena
+	template <typename ...ArgTs>
+	T& emplaceBack(ArgTs&&... args);
+
+	T& operator[](size_t i);
+	const T& operator[](size_t i) const;
+
+	size_t size() const;
+
+private:
+	using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	void destroyAll(std::true_type isTriviallyDestructible);
+	void destroyAll(std::false_type isTriviallyDestructible);
+
+	std::vector<std::unique_ptr<Storage[]>> m_blocks;
+	size_t m_size = 0;
+};
+
+template <typename T, size_t kBlockSize>
+inline ChunkedArena<T, kBlockSize>::~ChunkedArena()
+{
+	destroyAll(std::is_trivially_destructible<T>{});
+}
+
+template <typename T, size_t kBlockSize>
+template <typename ...ArgTs>
+inline T& ChunkedArena<T, kBlockSize>::emplaceBack(ArgTs&&... args)
+{
+	if (m_size == m_blocks.size() * kBlockSize)
+		m_blocks.emplace_back(new Storage[kBlockSize]);
+
+	void* memory = &m_blocks[m_size / kBlockSize][m_size % kBlockSize];
+	T* object = new (memory) T(std::forward<ArgTs>(args)...);
+	++m_size;
+
+	return *object;
+}
+
+template <typename T, size_t kBlockSize>
+inline T& ChunkedArena<T, kBlockSize>::operator[](size_t i)
+{
+	assert(i < m_size);
+	return *reinterpret_cast<T*>(&m_blocks[i / kBlockSize][i % kBlockSize]);
+}
+
+template <typename T, size_t kBlockSize>
+inline const T& ChunkedArena<T, kBlockSize>::operator[](size_t i) const
+{
+	assert(i < m_size);
+	return *reinterpret_cast<const T*>(&m_blocks[i / kBlockSize][i % kBlockSize]);
+}
+
+template <typename T, size_t kBlockSize>
+inline size_t ChunkedArena<T, kBlockSize>::size() const
+{
+	return m_size;
+}
+
+template <typename T, size_t kBlockSize>
+inline void ChunkedArena<T, kBlockSize>::destroyAll(std::true_type)
+{
+	// Nothing to destroy, the blocks are simply freed
+}
+
+template <typename T, size_t kBlockSize>
+inline void ChunkedArena<T, kBlockSize>::destroyAll(std::false_type)
+{
+	for (size_t i = 0; i < m_size; ++i)
+		(*this)[i].~T();
+}
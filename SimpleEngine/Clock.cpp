@@ -16,24 +16,43 @@
 
 #include <GLFW\glfw3.h>
 
+#include <algorithm>
+#include <cmath>
+
+const double g_kFixedDeltaTime = 1.0 / 60.0;
+const double g_kMaxFrameTime = 0.25;    // Longer frames are treated as this long
+const int g_kMaxSimulationStepsPerFrame = 5;
+
 double g_timeDilation = 1;
-double g_deltaTime;
 double g_uiDeltaTime;
+double g_accumulator = 0;
+int g_numSimulationSteps = 0;
 
 void Clock::update()
 {
 	static double s_lastFrameTime = glfwGetTime();
 
 	double frameTime = glfwGetTime();
-	g_deltaTime = frameTime - s_lastFrameTime;
-	g_uiDeltaTime = g_deltaTime;
-	g_deltaTime *= g_timeDilation;
+	g_uiDeltaTime = frameTime - s_lastFrameTime;
 	s_lastFrameTime = frameTime;
+
+	// Clamp hitches i.e. from breakpoints or dragging the window
+	g_accumulator += std::min(g_uiDeltaTime, g_kMaxFrameTime) * g_timeDilation;
+
+	g_numSimulationSteps = static_cast<int>(g_accumulator / g_kFixedDeltaTime);
+	if (g_numSimulationSteps > g_kMaxSimulationStepsPerFrame) {
+		// Drop the time we can't catch up on, otherwise each slow frame
+		// would need more steps than the last (the spiral of death).
+		g_numSimulationSteps = g_kMaxSimulationStepsPerFrame;
+		g_accumulator = std::fmod(g_accumulator, g_kFixedDeltaTime);
+	} else {
+		g_accumulator -= g_numSimulationSteps * g_kFixedDeltaTime;
+	}
 }
 
 float Clock::getDeltaTime()
 {
-	return static_cast<float>(g_deltaTime);
+	return static_cast<float>(g_kFixedDeltaTime);
 }
 
 float Clock::getUIDeltaTime()
@@ -50,3 +69,13 @@ void Clock::setTimeDilation(double timeDilation)
 {
 	g_timeDilation = timeDilation;
 }
+
+int Clock::getNumSimulationSteps()
+{
+	return g_numSimulationSteps;
+}
+
+float Clock::getInterpolationAlpha()
+{
+	return static_cast<float>(g_accumulator / g_kFixedDeltaTime);
+}
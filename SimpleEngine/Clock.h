@@ -14,10 +14,33 @@
 
 #pragma once
 
+// The simulation runs in fixed steps, decoupled from the frame rate.
+// Each frame the time since the last frame is added to an accumulator,
+// and whole steps are taken out of it to find how many simulation steps
+// should run.
 namespace Clock {
+	// Advances the clock to the current time and works out how many
+	// simulation steps to run this frame.
+	// Should be called once at the start of every frame.
 	void update();
+
+	// Returns the fixed time step of the simulation.
+	// Time dilation changes how many steps run, not the step size.
 	float getDeltaTime();
+
+	// Returns the real time since the last frame
 	float getUIDeltaTime();
+
 	float getTime();
 	void setTimeDilation(double timeDilation);
+
+	// Returns the number of simulation steps to run this frame.
+	// Long frames are clamped so a slow frame can't cause more and more
+	// steps to be needed to catch up. The simulation slows down instead.
+	int getNumSimulationSteps();
+
+	// Returns how far the current time is between the last two
+	// simulation steps, from 0 to 1.
+	// Used to interpolate between simulation states when rendering.
+	float getInterpolationAlpha();
 }
@@ -0,0 +1,372 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Packed per component type storage for all the
+//                entities in a scene.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include "BlockArena.h"
+#include "ComponentType.h"
+#include "InputComponent.h"
+#include "ModelComponent.h"
+#include "VehicleMovementComponent.h"
+#include "InputMapComponent.h"
+#include "PhysicsComponent.h"
+#include "TransformComponent.h"
+#include "CameraComponent.h"
+#include "PickupComponent.h"
+#include "PlayerStatsComponent.h"
+#include "SnakeTailComponent.h"
+#include "BasicCameraMovementComponent.h"
+#include "Terrain.h"
+#include "TerrainFollowComponent.h"
+#include "SimpleWorldSpaceMoveComponent.h"
+#include "LightComponent.h"
+
+#include <cassert>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Maps a component struct to its ComponentType bit
+template <typename ComponentT>
+struct ComponentTraits;
+
+template <> struct ComponentTraits<TransformComponent> { static constexpr size_t s_kMask = COMPONENT_TRANSFORM; };
+template <> struct ComponentTraits<PhysicsComponent> { static constexpr size_t s_kMask = COMPONENT_PHYSICS; };
+template <> struct ComponentTraits<ModelComponent> { static constexpr size_t s_kMask = COMPONENT_MODEL; };
+template <> struct ComponentTraits<CameraComponent> { static constexpr size_t s_kMask = COMPONENT_CAMERA; };
+template <> struct ComponentTraits<VehicleMovementComponent> { static constexpr size_t s_kMask = COMPONENT_VEHICLE_MOVEMENT; };
+template <> struct ComponentTraits<InputComponent> { static constexpr size_t s_kMask = COMPONENT_INPUT; };
+template <> struct ComponentTraits<InputMapComponent> { static constexpr size_t s_kMask = COMPONENT_INPUT_MAP; };
+template <> struct ComponentTraits<PickupComponent> { static constexpr size_t s_kMask = COMPONENT_PICKUP; };
+template <> struct ComponentTraits<PlayerStatsComponent> { static constexpr size_t s_kMask = COMPONENT_PLAYERSTATS; };
+template <> struct ComponentTraits<SnakeTailComponent> { static constexpr size_t s_kMask = COMPONENT_SNAKETAIL; };
+template <> struct ComponentTraits<BasicCameraMovementComponent> { static constexpr size_t s_kMask = COMPONENT_BASIC_CAMERA_MOVEMENT; };
+template <> struct ComponentTraits<TerrainComponent> { static constexpr size_t s_kMask = COMPONENT_TERRAIN; };
+template <> struct ComponentTraits<TerrainFollowComponent> { static constexpr size_t s_kMask = COMPONENT_TERRAIN_FOLLOW; };
+template <> struct ComponentTraits<SimpleWorldSpcaeMoveComponent> { static constexpr size_t s_kMask = COMPONENT_SIMPLE_WORLD_SPACE_MOVE_COMPONENT; };
+template <> struct ComponentTraits<LightComponent> { static constexpr size_t s_kMask = COMPONENT_LIGHT; };
+
+// Assembles the component mask for a list of component structs at
+// compile time i.e. ComponentMask<TransformComponent, PhysicsComponent>::s_kValue
+template <typename ...ComponentTs>
+struct ComponentMask;
+
+template <>
+struct ComponentMask<> {
+	static constexpr size_t s_kValue = 0;
+};
+
+template <typename ComponentT, typename ...ComponentTs>
+struct ComponentMask<ComponentT, ComponentTs...> {
+	static constexpr size_t s_kValue = ComponentTraits<ComponentT>::s_kMask | ComponentMask<ComponentTs...>::s_kValue;
+};
+
+// A tightly packed array of all the components of one type.
+// Components are stored contiguously and looked up by entity index
+// through a sparse index.
+// Removing a component moves the last component into the freed slot,
+// so references to components are only valid until the next add or
+// remove on the same pool.
+// Components that can be constructed from a BlockArena* (i.e. models)
+// are given the pools arena for their variable sized data.
+template <typename ComponentT>
+class ComponentPool {
+public:
+	using ValueType = ComponentT;
+
+	static const size_t s_kInvalidIndex = static_cast<size_t>(-1);
+
+	// Sets the arena that new components allocate their data from
+	void setArena(BlockArena*);
+
+	// Adds a value initialized component for the entity.
+	// Does nothing if the entity already has this component.
+	ComponentT& add(size_t entityIndex);
+
+	// Removes the entities component.
+	// Does nothing if the entity doesn't have this component.
+	void remove(size_t entityIndex);
+
+	// Returns true if the entity has a component in this pool
+	bool contains(size_t entityIndex) const;
+
+	// Returns the component belonging to the entity
+	ComponentT& get(size_t entityIndex);
+	const ComponentT& get(size_t entityIndex) const;
+
+	// Returns the number of components in the pool
+	size_t size() const;
+
+	// Returns the component at the packed index
+	ComponentT& operator[](size_t packedIndex);
+	const ComponentT& operator[](size_t packedIndex) const;
+
+	// Returns the index of the entity owning the component at the
+	// packed index.
+	size_t getEntityIndex(size_t packedIndex) const;
+
+	// Fills an empty pool with a packed array of components in one copy.
+	// Used to restore a pool from a scene snapshot, the entities must
+	// already exist in the scene.
+	void restore(const ComponentT* components, const uint32_t* entityIndices, size_t count);
+
+private:
+	void emplaceComponent(std::true_type isArenaConstructible);
+	void emplaceComponent(std::false_type isArenaConstructible);
+
+	BlockArena* m_arena = nullptr;
+	std::vector<ComponentT> m_components;
+	std::vector<size_t> m_entityIndices; // Packed index -> entity index
+	std::vector<size_t> m_packedIndices; // Entity index -> packed index
+};
+
+// Owns one ComponentPool for each component type, and the arena their
+// variable sized data is allocated from.
+class ComponentStorage {
+public:
+	ComponentStorage();
+	ComponentStorage(const ComponentStorage&) = delete;
+	ComponentStorage& operator=(const ComponentStorage&) = delete;
+
+	// Returns the pool storing all components of the specified type
+	template <typename ComponentT>
+	ComponentPool<ComponentT>& getPool();
+	template <typename ComponentT>
+	const ComponentPool<ComponentT>& getPool() const;
+
+	// Returns the entities component of the specified type
+	template <typename ComponentT>
+	ComponentT& get(size_t entityIndex);
+	template <typename ComponentT>
+	const ComponentT& get(size_t entityIndex) const;
+
+	// Adds a value initialized component to the entity for each
+	// component in the mask.
+	void addComponents(size_t entityIndex, size_t componentMask);
+
+	// Removes each component in the mask from the entity.
+	void removeComponents(size_t entityIndex, size_t componentMask);
+
+private:
+	using PoolTuple = std::tuple<
+		ComponentPool<TransformComponent>,
+		ComponentPool<PhysicsComponent>,
+		ComponentPool<ModelComponent>,
+		ComponentPool<CameraComponent>,
+		ComponentPool<VehicleMovementComponent>,
+		ComponentPool<InputComponent>,
+		ComponentPool<InputMapComponent>,
+		ComponentPool<PickupComponent>,
+		ComponentPool<PlayerStatsComponent>,
+		ComponentPool<SnakeTailComponent>,
+		ComponentPool<BasicCameraMovementComponent>,
+		ComponentPool<TerrainComponent>,
+		ComponentPool<TerrainFollowComponent>,
+		ComponentPool<SimpleWorldSpcaeMoveComponent>,
+		ComponentPool<LightComponent>>;
+
+	template <size_t... Is>
+	void setArena(std::index_sequence<Is...>);
+	template <size_t... Is>
+	void addComponents(size_t entityIndex, size_t componentMask, std::index_sequence<Is...>);
+	template <size_t... Is>
+	void removeComponents(size_t entityIndex, size_t componentMask, std::index_sequence<Is...>);
+
+	BlockArena m_arena; // Declared before the pools so it outlives them
+	PoolTuple m_pools;
+};
+
+template <typename ComponentT>
+const size_t ComponentPool<ComponentT>::s_kInvalidIndex;
+
+template <typename ComponentT>
+inline void ComponentPool<ComponentT>::setArena(BlockArena* arena)
+{
+	m_arena = arena;
+}
+
+template <typename ComponentT>
+inline ComponentT& ComponentPool<ComponentT>::add(size_t entityIndex)
+{
+	if (contains(entityIndex))
+		return get(entityIndex);
+
+	if (entityIndex >= m_packedIndices.size())
+		m_packedIndices.resize(entityIndex + 1, s_kInvalidIndex);
+
+	m_packedIndices[entityIndex] = m_components.size();
+	m_entityIndices.push_back(entityIndex);
+	emplaceComponent(std::is_constructible<ComponentT, BlockArena*>{});
+
+	return m_components.back();
+}
+
+template <typename ComponentT>
+inline void ComponentPool<ComponentT>::remove(size_t entityIndex)
+{
+	if (!contains(entityIndex))
+		return;
+
+	// Move the last component into the removed components slot to
+	// keep the array packed.
+	size_t packedIndex = m_packedIndices[entityIndex];
+	size_t lastPackedIndex = m_components.size() - 1;
+	if (packedIndex != lastPackedIndex) {
+		size_t movedEntityIndex = m_entityIndices[lastPackedIndex];
+		m_components[packedIndex] = std::move(m_components[lastPackedIndex]);
+		m_entityIndices[packedIndex] = movedEntityIndex;
+		m_packedIndices[movedEntityIndex] = packedIndex;
+	}
+
+	m_components.pop_back();
+	m_entityIndices.pop_back();
+	m_packedIndices[entityIndex] = s_kInvalidIndex;
+}
+
+template <typename ComponentT>
+inline bool ComponentPool<ComponentT>::contains(size_t entityIndex) const
+{
+	return entityIndex < m_packedIndices.size() && m_packedIndices[entityIndex] != s_kInvalidIndex;
+}
+
+template <typename ComponentT>
+inline ComponentT& ComponentPool<ComponentT>::get(size_t entityIndex)
+{
+	assert(contains(entityIndex));
+	return m_components[m_packedIndices[entityIndex]];
+}
+
+template <typename ComponentT>
+inline const ComponentT& ComponentPool<ComponentT>::get(size_t entityIndex) const
+{
+	assert(contains(entityIndex));
+	return m_components[m_packedIndices[entityIndex]];
+}
+
+template <typename ComponentT>
+inline size_t ComponentPool<ComponentT>::size() const
+{
+	return m_components.size();
+}
+
+template <typename ComponentT>
+inline ComponentT& ComponentPool<ComponentT>::operator[](size_t packedIndex)
+{
+	return m_components[packedIndex];
+}
+
+template <typename ComponentT>
+inline const ComponentT& ComponentPool<ComponentT>::operator[](size_t packedIndex) const
+{
+	return m_components[packedIndex];
+}
+
+template <typename ComponentT>
+inline size_t ComponentPool<ComponentT>::getEntityIndex(size_t packedIndex) const
+{
+	return m_entityIndices[packedIndex];
+}
+
+template <typename ComponentT>
+inline void ComponentPool<ComponentT>::restore(const ComponentT* components, const uint32_t* entityIndices, size_t count)
+{
+	assert(m_components.empty());
+
+	m_components.assign(components, components + count);
+	m_entityIndices.assign(entityIndices, entityIndices + count);
+	for (size_t packedIndex = 0; packedIndex < count; ++packedIndex) {
+		size_t entityIndex = entityIndices[packedIndex];
+		if (entityIndex >= m_packedIndices.size())
+			m_packedIndices.resize(entityIndex + 1, s_kInvalidIndex);
+		m_packedIndices[entityIndex] = packedIndex;
+	}
+}
+
+template <typename ComponentT>
+inline void ComponentPool<ComponentT>::emplaceComponent(std::true_type)
+{
+	m_components.emplace_back(m_arena);
+}
+
+template <typename ComponentT>
+inline void ComponentPool<ComponentT>::emplaceComponent(std::false_type)
+{
+	m_components.emplace_back();
+}
+
+inline ComponentStorage::ComponentStorage()
+{
+	setArena(std::make_index_sequence<std::tuple_size<PoolTuple>::value>{});
+}
+
+template <typename ComponentT>
+inline ComponentPool<ComponentT>& ComponentStorage::getPool()
+{
+	return std::get<ComponentPool<ComponentT>>(m_pools);
+}
+
+template <typename ComponentT>
+inline const ComponentPool<ComponentT>& ComponentStorage::getPool() const
+{
+	return std::get<ComponentPool<ComponentT>>(m_pools);
+}
+
+template <typename ComponentT>
+inline ComponentT& ComponentStorage::get(size_t entityIndex)
+{
+	return getPool<ComponentT>().get(entityIndex);
+}
+
+template <typename ComponentT>
+inline const ComponentT& ComponentStorage::get(size_t entityIndex) const
+{
+	return getPool<ComponentT>().get(entityIndex);
+}
+
+inline void ComponentStorage::addComponents(size_t entityIndex, size_t componentMask)
+{
+	addComponents(entityIndex, componentMask, std::make_index_sequence<std::tuple_size<PoolTuple>::value>{});
+}
+
+inline void ComponentStorage::removeComponents(size_t entityIndex, size_t componentMask)
+{
+	removeComponents(entityIndex, componentMask, std::make_index_sequence<std::tuple_size<PoolTuple>::value>{});
+}
+
+template <size_t... Is>
+inline void ComponentStorage::setArena(std::index_sequence<Is...>)
+{
+	int expand[] = { 0, (std::get<Is>(m_pools).setArena(&m_arena), 0)... };
+	(void)expand;
+}
+
+template <size_t... Is>
+inline void ComponentStorage::addComponents(size_t entityIndex, size_t componentMask, std::index_sequence<Is...>)
+{
+	// Visit each pool, adding a component to the ones in the mask
+	int expand[] = { 0, ((componentMask & ComponentTraits<typename std::tuple_element<Is, PoolTuple>::type::ValueType>::s_kMask)
+		? (std::get<Is>(m_pools).add(entityIndex), 0) : 0)... };
+	(void)expand;
+}
+
+template <size_t... Is>
+inline void ComponentStorage::removeComponents(size_t entityIndex, size_t componentMask, std::index_sequence<Is...>)
+{
+	// Visit each pool, removing the component from the ones in the mask
+	int expand[] = { 0, ((componentMask & ComponentTraits<typename std::tuple_element<Is, PoolTuple>::type::ValueType>::s_kMask)
+		? (std::get<Is>(m_pools).remove(entityIndex), 0) : 0)... };
+	(void)expand;
+}
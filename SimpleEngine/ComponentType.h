@@ -0,0 +1,19 @@
+#pragma once
+
+enum ComponentType {
+	COMPONENT_TRANSFORM = 1 << 0,
+	COMPONENT_PHYSICS = 1 << 1,
+	COMPONENT_MODEL = 1 << 2,
+	COMPONENT_CAMERA = 1 << 3,
+	COMPONENT_VEHICLE_MOVEMENT = 1 << 4,
+	COMPONENT_INPUT = 1 << 5,
+	COMPONENT_INPUT_MAP = 1 << 6,
+	COMPONENT_PICKUP = 1 << 7,
+	COMPONENT_PLAYERSTATS = 1 << 8,
+	COMPONENT_SNAKETAIL = 1 << 9,
+	COMPONENT_BASIC_CAMERA_MOVEMENT = 1 << 10,
+	COMPONENT_TERRAIN = 1 << 11,
+	COMPONENT_TERRAIN_FOLLOW = 1 << 12,
+	COMPONENT_SIMPLE_WORLD_SPACE_MOVE_COMPONENT = 1 << 13,
+	COMPONENT_LIGHT = 1 << 14
+};
@@ -0,0 +1,160 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : A compile time typed view over all the entities in a
+//                scene that have a set of components.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include "ChunkedArena.h"
+#include "ComponentStorage.h"
+#include "Entity.h"
+#include "JobSystem.h"
+
+#include <iterator>
+#include <memory>
+#include <vector>
+
+// Iterates every entity that has all of the view's components.
+// The component types and mask are resolved at compile time, and each()
+// is instantiated for every callable it is given, so the per-entity work
+// can be inlined into the loop.
+// Iteration is driven by the first component's pool, so put the rarest
+// component first.
+template <typename FirstComponentT, typename ...ComponentTs>
+class ComponentView {
+public:
+	static constexpr size_t s_kComponentMask = ComponentMask<FirstComponentT, ComponentTs...>::s_kValue;
+
+	ComponentView(ComponentStorage&, ChunkedArena<Entity>& entities);
+
+	// Calls func(FirstComponentT&, ComponentTs&...) for each matching
+	// entity.
+	template <typename FuncT>
+	void each(FuncT&& func);
+
+	// Calls func(Entity&, FirstComponentT&, ComponentTs&...) for each
+	// matching entity.
+	template <typename FuncT>
+	void eachWithEntity(FuncT&& func);
+
+	// Same as each() but splits the entities into chunks that are
+	// updated in parallel on the job system.
+	// func must only write to the components it is given.
+	template <typename FuncT>
+	void parallelEach(const FuncT& func);
+
+	// Calls func(std::vector<OutputT>&, FirstComponentT&, ComponentTs&...)
+	// for each matching entity in parallel and returns everything func
+	// appended to its output.
+	// Each chunk appends to its own output which are merged in chunk
+	// order, so the result is the same as a serial run.
+	template <typename OutputT, typename FuncT>
+	std::vector<OutputT> parallelCollect(const FuncT& func);
+
+private:
+	// Calls func for every matching entity in the packed range [begin, end)
+	// of the first pool.
+	template <typename FuncT>
+	void eachInRange(size_t begin, size_t end, FuncT&& func);
+
+	// Returns true if the entity has all the view's components
+	bool matches(size_t entityIndex) const;
+
+	ComponentStorage& m_componentStorage;
+	ChunkedArena<Entity>& m_entities;
+};
+
+template <typename FirstComponentT, typename ...ComponentTs>
+inline ComponentView<FirstComponentT, ComponentTs...>::ComponentView(ComponentStorage& componentStorage, ChunkedArena<Entity>& entities)
+	: m_componentStorage{ componentStorage }
+	, m_entities{ entities }
+{
+}
+
+template <typename FirstComponentT, typename ...ComponentTs>
+template <typename FuncT>
+inline void ComponentView<FirstComponentT, ComponentTs...>::each(FuncT&& func)
+{
+	eachInRange(0, m_componentStorage.getPool<FirstComponentT>().size(), func);
+}
+
+template <typename FirstComponentT, typename ...ComponentTs>
+template <typename FuncT>
+inline void ComponentView<FirstComponentT, ComponentTs...>::eachWithEntity(FuncT&& func)
+{
+	ComponentPool<FirstComponentT>& firstPool = m_componentStorage.getPool<FirstComponentT>();
+	for (size_t i = 0; i < firstPool.size(); ++i) {
+		size_t entityIndex = firstPool.getEntityIndex(i);
+		if (!matches(entityIndex))
+			continue;
+
+		func(m_entities[entityIndex], firstPool[i], m_componentStorage.getPool<ComponentTs>().get(entityIndex)...);
+	}
+}
+
+template <typename FirstComponentT, typename ...ComponentTs>
+template <typename FuncT>
+inline void ComponentView<FirstComponentT, ComponentTs...>::parallelEach(const FuncT& func)
+{
+	size_t count = m_componentStorage.getPool<FirstComponentT>().size();
+	size_t batchSize = JobSystem::getBatchSize(count, sizeof(FirstComponentT));
+	JobSystem::parallelFor(count, batchSize, [this, &func](size_t begin, size_t end) {
+		eachInRange(begin, end, func);
+	});
+}
+
+template <typename FirstComponentT, typename ...ComponentTs>
+template <typename OutputT, typename FuncT>
+inline std::vector<OutputT> ComponentView<FirstComponentT, ComponentTs...>::parallelCollect(const FuncT& func)
+{
+	size_t count = m_componentStorage.getPool<FirstComponentT>().size();
+	size_t batchSize = JobSystem::getBatchSize(count, sizeof(FirstComponentT));
+	std::vector<std::vector<OutputT>> chunkOutputs((count + batchSize - 1) / batchSize);
+	JobSystem::parallelFor(count, batchSize, [this, &func, &chunkOutputs, batchSize](size_t begin, size_t end) {
+		std::vector<OutputT>& output = chunkOutputs[begin / batchSize];
+		eachInRange(begin, end, [&func, &output](FirstComponentT& first, ComponentTs&... rest) {
+			func(output, first, rest...);
+		});
+	});
+
+	// Merge the outputs in chunk order
+	std::vector<OutputT> merged;
+	for (std::vector<OutputT>& output : chunkOutputs)
+		merged.insert(merged.end(), std::make_move_iterator(output.begin()), std::make_move_iterator(output.end()));
+
+	return merged;
+}
+
+template <typename FirstComponentT, typename ...ComponentTs>
+template <typename FuncT>
+inline void ComponentView<FirstComponentT, ComponentTs...>::eachInRange(size_t begin, size_t end, FuncT&& func)
+{
+	ComponentPool<FirstComponentT>& firstPool = m_componentStorage.getPool<FirstComponentT>();
+	for (size_t i = begin; i < end; ++i) {
+		size_t entityIndex = firstPool.getEntityIndex(i);
+		if (!matches(entityIndex))
+			continue;
+
+		func(firstPool[i], m_componentStorage.getPool<ComponentTs>().get(entityIndex)...);
+	}
+}
+
+template <typename FirstComponentT, typename ...ComponentTs>
+inline bool ComponentView<FirstComponentT, ComponentTs...>::matches(size_t entityIndex) const
+{
+	// Every entity in the first pool has the first component, so single
+	// component views never need to check the mask.
+	if (sizeof...(ComponentTs) == 0)
+		return true;
+
+	return m_entities[entityIndex].hasComponents(s_kComponentMask);
+}
@@ -1,28 +1,19 @@
 #include "Entity.h"
 
-#include "EntityEventListener.h"
+#include "EntityEvent.h"
 
 #include <glm\glm.hpp>
 
 #include "Log.h"
 
-Entity::Entity(std::vector<EntityEventListener*>& eventListeners)
+Entity::Entity(ComponentStorage& componentStorage, size_t index, EntityEventQueue& eventQueue)
 	: m_componentMask{ 0 }
-	, m_eventListeners{ eventListeners }
-	, transform{}
-	, physics{}
-	, model{}
-	, vehicleMovement{}
-	, input{}
-	, inputMap{}
-	, camera{}
-	, pickup{}
-	, playerStats{}
-	, snakeTail{}
-	, basicCameraMovement{}
-	, terrain{}
-	, terrainFollow{}
-	, simpleWorldSpaceMovement{}
+	, m_index{ index }
+	, m_generation{ 1 }
+	, m_isAlive{ true }
+	, m_nextFree{ 0 }
+	, m_componentStorage{ componentStorage }
+	, m_eventQueue{ eventQueue }
 {
 }
 
@@ -30,7 +21,14 @@ void Entity::destroy()
 {
 	triggerPreRemoveComponentsEvent(m_componentMask);
 
+	m_componentStorage.removeComponents(m_index, m_componentMask);
 	m_componentMask = 0;
+
+	// Invalidate all handles to this entity
+	++m_generation;
+	if (m_generation == 0)
+		m_generation = 1;
+	m_isAlive = false;
 }
 
 bool Entity::operator==(const Entity& rhs) const
@@ -38,6 +36,29 @@ bool Entity::operator==(const Entity& rhs) const
 	return this == &rhs;
 }
 
+size_t Entity::getIndex() const
+{
+	return m_index;
+}
+
+EntityHandle Entity::getHandle() const
+{
+	EntityHandle handle;
+	handle.index = static_cast<uint32_t>(m_index);
+	handle.generation = m_generation;
+	return handle;
+}
+
+bool Entity::isAlive() const
+{
+	return m_isAlive;
+}
+
+size_t Entity::getComponentMask() const
+{
+	return m_componentMask;
+}
+
 bool Entity::hasComponents(size_t componentMask) const
 {
 	return (m_componentMask & componentMask) == componentMask;
@@ -65,29 +86,38 @@ bool Entity::matchesAny(size_t lhscomponentMask, size_t rhscomponentMask)
 
 void Entity::triggerPostAddComponentsEvent(size_t componentMask)
 {
-	for (auto eventListener : m_eventListeners) {
-		eventListener->onPostAddComponents(*this, componentMask);
-	}
+	m_eventQueue.recordAddComponents(getHandle(), componentMask);
 }
 
 void Entity::triggerPreRemoveComponentsEvent(size_t componentMask)
 {
-	for (auto eventListener : m_eventListeners) {
-		eventListener->onPreRemoveComponents(*this, componentMask);
-	}
+	m_eventQueue.recordRemoveComponents(getHandle(), componentMask);
 }
 
 void Entity::addComponents(size_t componentMask)
 {
-	m_componentMask |= componentMask;
+	// Only construct, and raise events for, components the entity doesn't
+	// already have
+	size_t addedMask = componentMask & ~m_componentMask;
+	if (addedMask == 0)
+		return;
+
+	m_componentStorage.addComponents(m_index, addedMask);
+	m_componentMask |= addedMask;
 
-	triggerPostAddComponentsEvent(componentMask);
+	triggerPostAddComponentsEvent(addedMask);
 }
 
 void Entity::removeComponents(size_t componentMask)
 {
-	triggerPreRemoveComponentsEvent(componentMask);
-	m_componentMask &= (~componentMask);
+	// Only destroy, and raise events for, components the entity has
+	size_t removedMask = componentMask & m_componentMask;
+	if (removedMask == 0)
+		return;
+
+	triggerPreRemoveComponentsEvent(removedMask);
+	m_componentStorage.removeComponents(m_index, removedMask);
+	m_componentMask &= ~removedMask;
 }
 
 size_t Entity::assembleComponentMask(size_t componentMask)
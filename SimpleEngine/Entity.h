@@ -1,65 +1,79 @@
 #pragma once
 
-#include "InputComponent.h"
-#include "ModelComponent.h"
-#include "VehicleMovementComponent.h"
-#include "InputMapComponent.h"
-#include "PhysicsComponent.h"
-#include "TransformComponent.h"
-#include "CameraComponent.h"
-#include "PickupComponent.h"
-#include "PlayerStatsComponent.h"
-#include "SnakeTailComponent.h"
-#include "BasicCameraMovementComponent.h"
-#include "Terrain.h"
-#include "TerrainFollowComponent.h"
-#include "SimpleWorldSpaceMoveComponent.h"
-
-#include <vector>
-
-class EntityEventListener;
- 
-enum ComponentType {
-	COMPONENT_TRANSFORM = 1 << 0,
-	COMPONENT_PHYSICS = 1 << 1,
-	COMPONENT_MODEL = 1 << 2,
-	COMPONENT_CAMERA = 1 << 3,
-	COMPONENT_VEHICLE_MOVEMENT = 1 << 4,
-	COMPONENT_INPUT = 1 << 5,
-	COMPONENT_INPUT_MAP = 1 << 6,
-	COMPONENT_PICKUP = 1 << 7,
-	COMPONENT_PLAYERSTATS = 1 << 8,
-	COMPONENT_SNAKETAIL = 1 << 9,
-	COMPONENT_BASIC_CAMERA_MOVEMENT = 1 << 10,
-	COMPONENT_TERRAIN = 1 << 11,
-	COMPONENT_TERRAIN_FOLLOW = 1 << 12,
-	COMPONENT_SIMPLE_WORLD_SPACE_MOVE_COMPONENT = 1 << 13
-};
+#include "ComponentStorage.h"
+#include "EntityHandle.h"
+
+class EntityEventQueue;
+
+template <typename T, size_t kBlockSize>
+class ChunkedArena;
 
 class Entity {
 	// The scene will handle all entity creation and destruction
 	friend class Scene;
+	template <typename T, size_t kBlockSize>
+	friend class ChunkedArena;
 
 public:
-	TransformComponent transform;
-	PhysicsComponent physics;
-	ModelComponent model;
-	VehicleMovementComponent vehicleMovement;
-	InputComponent input;
-	InputMapComponent inputMap;
-	CameraComponent camera;
-	PickupComponent pickup;
-	PlayerStatsComponent playerStats;
-	SnakeTailComponent snakeTail;
-	BasicCameraMovementComponent basicCameraMovement;
-	TerrainComponent terrain;
-	TerrainFollowComponent terrainFollow;
-	SimpleWorldSpcaeMoveComponent simpleWorldSpaceMovement;
+	// Component accessors.
+	// The components live in the scenes component storage, so the
+	// returned references are only valid until components are next
+	// added to or removed from the scene.
+	// The entity must have the component being accessed.
+	TransformComponent& transform();
+	const TransformComponent& transform() const;
+	PhysicsComponent& physics();
+	const PhysicsComponent& physics() const;
+	ModelComponent& model();
+	const ModelComponent& model() const;
+	VehicleMovementComponent& vehicleMovement();
+	const VehicleMovementComponent& vehicleMovement() const;
+	InputComponent& input();
+	const InputComponent& input() const;
+	InputMapComponent& inputMap();
+	const InputMapComponent& inputMap() const;
+	CameraComponent& camera();
+	const CameraComponent& camera() const;
+	PickupComponent& pickup();
+	const PickupComponent& pickup() const;
+	PlayerStatsComponent& playerStats();
+	const PlayerStatsComponent& playerStats() const;
+	SnakeTailComponent& snakeTail();
+	const SnakeTailComponent& snakeTail() const;
+	BasicCameraMovementComponent& basicCameraMovement();
+	const BasicCameraMovementComponent& basicCameraMovement() const;
+	TerrainComponent& terrain();
+	const TerrainComponent& terrain() const;
+	TerrainFollowComponent& terrainFollow();
+	const TerrainFollowComponent& terrainFollow() const;
+	SimpleWorldSpcaeMoveComponent& simpleWorldSpaceMovement();
+	const SimpleWorldSpcaeMoveComponent& simpleWorldSpaceMovement() const;
+	LightComponent& light();
+	const LightComponent& light() const;
+
+	// Returns the entities component of the specified type
+	template <typename ComponentT>
+	ComponentT& getComponent();
+	template <typename ComponentT>
+	const ComponentT& getComponent() const;
+
+	// Returns the index of the entity in the scene
+	size_t getIndex() const;
+
+	// Returns a handle that can be safely held onto, even after this
+	// entity is destroyed.
+	EntityHandle getHandle() const;
+
+	// Returns true if the entity hasn't been destroyed
+	bool isAlive() const;
+
+	// Returns the mask of all the components the entity has
+	size_t getComponentMask() const;
 
 	Entity(Entity&&) = default;
 	Entity(const Entity&) = delete;
 	Entity& operator=(const Entity&) = delete;
-	Entity& operator=(Entity&&) = default;
+	Entity& operator=(Entity&&) = delete;
 
 	// Overload equality to check identity equivalence
 	bool operator==(const Entity& rhs) const;
@@ -126,19 +140,39 @@ public:
 	// mask are present in the entity.
 	static bool matchesAny(size_t lhsComponentMask, size_t rhsComponentMask);
 
+	// Queue component events for the scene to dispatch to its listeners
 	void triggerPostAddComponentsEvent(size_t componentMask);
 	void triggerPreRemoveComponentsEvent(size_t componentMask);
 
 private:
-	Entity(std::vector<EntityEventListener*>& eventListeners);
+	Entity(ComponentStorage& componentStorage, size_t index, EntityEventQueue& eventQueue);
 
 	// Destroys to entity
 	void destroy();
 
 	size_t m_componentMask;
-	std::vector<EntityEventListener*>& m_eventListeners;
+	size_t m_index;
+	uint32_t m_generation;
+	bool m_isAlive;
+	size_t m_nextFree; // Next destroyed entity in the scenes free list
+	ComponentStorage& m_componentStorage;
+	EntityEventQueue& m_eventQueue;
 };
 
+template <typename ComponentT>
+inline ComponentT& Entity::getComponent()
+{
+	assert(hasComponents(ComponentTraits<ComponentT>::s_kMask));
+	return m_componentStorage.get<ComponentT>(m_index);
+}
+
+template <typename ComponentT>
+inline const ComponentT& Entity::getComponent() const
+{
+	assert(hasComponents(ComponentTraits<ComponentT>::s_kMask));
+	return m_componentStorage.get<ComponentT>(m_index);
+}
+
 template<typename ...ComponentTs>
 inline bool Entity::hasComponents(size_t first, ComponentTs... rest) const
 {
@@ -182,3 +216,153 @@ inline bool Entity::matchesAny(size_t componentMask, size_t first, ComponentTs .
 {
 	return matchesAny(componentMask, first) || matchesAny(componentMask, rest...);
 }
+
+inline TransformComponent& Entity::transform()
+{
+	return getComponent<TransformComponent>();
+}
+
+inline const TransformComponent& Entity::transform() const
+{
+	return getComponent<TransformComponent>();
+}
+
+inline PhysicsComponent& Entity::physics()
+{
+	return getComponent<PhysicsComponent>();
+}
+
+inline const PhysicsComponent& Entity::physics() const
+{
+	return getComponent<PhysicsComponent>();
+}
+
+inline ModelComponent& Entity::model()
+{
+	return getComponent<ModelComponent>();
+}
+
+inline const ModelComponent& Entity::model() const
+{
+	return getComponent<ModelComponent>();
+}
+
+inline VehicleMovementComponent& Entity::vehicleMovement()
+{
+	return getComponent<VehicleMovementComponent>();
+}
+
+inline const VehicleMovementComponent& Entity::vehicleMovement() const
+{
+	return getComponent<VehicleMovementComponent>();
+}
+
+inline InputComponent& Entity::input()
+{
+	return getComponent<InputComponent>();
+}
+
+inline const InputComponent& Entity::input() const
+{
+	return getComponent<InputComponent>();
+}
+
+inline InputMapComponent& Entity::inputMap()
+{
+	return getComponent<InputMapComponent>();
+}
+
+inline const InputMapComponent& Entity::inputMap() const
+{
+	return getComponent<InputMapComponent>();
+}
+
+inline CameraComponent& Entity::camera()
+{
+	return getComponent<CameraComponent>();
+}
+
+inline const CameraComponent& Entity::camera() const
+{
+	return getComponent<CameraComponent>();
+}
+
+inline PickupComponent& Entity::pickup()
+{
+	return getComponent<PickupComponent>();
+}
+
+inline const PickupComponent& Entity::pickup() const
+{
+	return getComponent<PickupComponent>();
+}
+
+inline PlayerStatsComponent& Entity::playerStats()
+{
+	return getComponent<PlayerStatsComponent>();
+}
+
+inline const PlayerStatsComponent& Entity::playerStats() const
+{
+	return getComponent<PlayerStatsComponent>();
+}
+
+inline SnakeTailComponent& Entity::snakeTail()
+{
+	return getComponent<SnakeTailComponent>();
+}
+
+inline const SnakeTailComponent& Entity::snakeTail() const
+{
+	return getComponent<SnakeTailComponent>();
+}
+
+inline BasicCameraMovementComponent& Entity::basicCameraMovement()
+{
+	return getComponent<BasicCameraMovementComponent>();
+}
+
+inline const BasicCameraMovementComponent& Entity::basicCameraMovement() const
+{
+	return getComponent<BasicCameraMovementComponent>();
+}
+
+inline TerrainComponent& Entity::terrain()
+{
+	return getComponent<TerrainComponent>();
+}
+
+inline const TerrainComponent& Entity::terrain() const
+{
+	return getComponent<TerrainComponent>();
+}
+
+inline TerrainFollowComponent& Entity::terrainFollow()
+{
+	return getComponent<TerrainFollowComponent>();
+}
+
+inline const TerrainFollowComponent& Entity::terrainFollow() const
+{
+	return getComponent<TerrainFollowComponent>();
+}
+
+inline SimpleWorldSpcaeMoveComponent& Entity::simpleWorldSpaceMovement()
+{
+	return getComponent<SimpleWorldSpcaeMoveComponent>();
+}
+
+inline const SimpleWorldSpcaeMoveComponent& Entity::simpleWorldSpaceMovement() const
+{
+	return getComponent<SimpleWorldSpcaeMoveComponent>();
+}
+
+inline LightComponent& Entity::light()
+{
+	return getComponent<LightComponent>();
+}
+
+inline const LightComponent& Entity::light() const
+{
+	return getComponent<LightComponent>();
+}
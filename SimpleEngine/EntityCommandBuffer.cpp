@@ -0,0 +1,114 @@
+#include "EntityCommandBuffer.h"
+
+#include "Entity.h"
+#include "Scene.h"
+
+CommandEntity EntityCommandBuffer::createEntity(size_t componentMask)
+{
+	CommandEntity target{ EntityHandle{} };
+	target.createdIdx = m_creations.size();
+	m_creations.push_back({ componentMask, false });
+	return target;
+}
+
+void EntityCommandBuffer::destroyEntity(const CommandEntity& target)
+{
+	if (target.createdIdx != CommandEntity::s_kNotCreated)
+		m_creations[target.createdIdx].isDestroyed = true;
+	else
+		getChange(target.handle).isDestroyed = true;
+}
+
+void EntityCommandBuffer::addComponents(const CommandEntity& target, size_t componentMask)
+{
+	if (target.createdIdx != CommandEntity::s_kNotCreated) {
+		m_creations[target.createdIdx].componentMask |= componentMask;
+	} else {
+		PendingChange& change = getChange(target.handle);
+		change.addMask |= componentMask;
+		change.removeMask &= ~componentMask;
+	}
+}
+
+void EntityCommandBuffer::removeComponents(const CommandEntity& target, size_t componentMask)
+{
+	if (target.createdIdx != CommandEntity::s_kNotCreated) {
+		m_creations[target.createdIdx].componentMask &= ~componentMask;
+	} else {
+		PendingChange& change = getChange(target.handle);
+		change.removeMask |= componentMask;
+		change.addMask &= ~componentMask;
+	}
+}
+
+void EntityCommandBuffer::initialize(const CommandEntity& target, std::function<void(Entity&)> func)
+{
+	m_initializers.push_back({ target, std::move(func) });
+}
+
+void EntityCommandBuffer::playback(Scene& scene)
+{
+	// Destroy and change existing entities first, so created entities can
+	// reuse the freed slots.
+	for (const PendingChange& change : m_changes) {
+		Entity* entity = scene.getEntity(change.handle);
+		if (!entity)
+			continue;
+
+		if (change.isDestroyed) {
+			scene.destroyEntity(*entity);
+			continue;
+		}
+
+		size_t removeMask = change.removeMask & entity->getComponentMask();
+		if (removeMask)
+			entity->removeComponents(removeMask);
+
+		size_t addMask = change.addMask & ~entity->getComponentMask();
+		if (addMask)
+			entity->addComponents(addMask);
+	}
+
+	std::vector<Entity*> createdEntities;
+	createdEntities.reserve(m_creations.size());
+	for (const PendingCreation& creation : m_creations) {
+		if (creation.isDestroyed)
+			createdEntities.push_back(nullptr);
+		else
+			createdEntities.push_back(&scene.createEntity(creation.componentMask));
+	}
+
+	for (PendingInitializer& initializer : m_initializers) {
+		const CommandEntity& target = initializer.target;
+		Entity* entity;
+		if (target.createdIdx != CommandEntity::s_kNotCreated)
+			entity = createdEntities[target.createdIdx];
+		else
+			entity = scene.getEntity(target.handle);
+
+		if (entity)
+			initializer.func(*entity);
+	}
+
+	m_changes.clear();
+	m_changeIndices.clear();
+	m_creations.clear();
+	m_initializers.clear();
+}
+
+bool EntityCommandBuffer::isEmpty() const
+{
+	return m_changes.empty() && m_creations.empty() && m_initializers.empty();
+}
+
+EntityCommandBuffer::PendingChange& EntityCommandBuffer::getChange(const EntityHandle& handle)
+{
+	auto changeIt = m_changeIndices.find(handle.index);
+	if (changeIt != m_changeIndices.end() && m_changes[changeIt->second].handle == handle)
+		return m_changes[changeIt->second];
+
+	m_changeIndices[handle.index] = m_changes.size();
+	m_changes.push_back({});
+	m_changes.back().handle = handle;
+	return m_changes.back();
+}
@@ -0,0 +1,93 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Records structural changes to a scene so they can
+//                be applied together at a sync point.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include "EntityHandle.h"
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+class Entity;
+class Scene;
+
+// Refers to the target of a command.
+// Either an entity that already exists in the scene, or an entity
+// created earlier in the same command buffer.
+struct CommandEntity {
+	static const size_t s_kNotCreated = static_cast<size_t>(-1);
+
+	CommandEntity(const EntityHandle& handle) : handle{ handle } {}
+
+	EntityHandle handle;
+	size_t createdIdx = s_kNotCreated; // Index of the creation command
+};
+
+// Systems record entity creation, destruction and component adds /
+// removes here instead of changing the scene while it is being
+// iterated.
+// Changes are coalesced per entity as they are recorded, so when the
+// buffer is played back each entity changes its components at most once
+// and listeners see a single event for each kind of change.
+// Because of this, removing and re-adding a component in the same
+// buffer keeps the components existing value.
+class EntityCommandBuffer {
+public:
+	// Records the creation of an entity with the specified components.
+	// The returned target can be used by later commands in this buffer.
+	CommandEntity createEntity(size_t componentMask);
+
+	// Records the destruction of an entity.
+	// Any other changes to the entity in this buffer are dropped.
+	void destroyEntity(const CommandEntity&);
+
+	void addComponents(const CommandEntity&, size_t componentMask);
+	void removeComponents(const CommandEntity&, size_t componentMask);
+
+	// Records a function that will be called on the entity once all the
+	// structural changes have been applied.
+	// Used to set up the components of created entities.
+	void initialize(const CommandEntity&, std::function<void(Entity&)> func);
+
+	// Applies all the recorded changes to the scene and clears the buffer
+	void playback(Scene&);
+
+	bool isEmpty() const;
+
+private:
+	struct PendingChange {
+		EntityHandle handle;
+		size_t addMask = 0;
+		size_t removeMask = 0;
+		bool isDestroyed = false;
+	};
+
+	struct PendingCreation {
+		size_t componentMask;
+		bool isDestroyed;
+	};
+
+	struct PendingInitializer {
+		CommandEntity target;
+		std::function<void(Entity&)> func;
+	};
+
+	PendingChange& getChange(const EntityHandle&);
+
+	std::vector<PendingChange> m_changes; // Changes to existing entities in the order they were first recorded
+	std::unordered_map<uint32_t, size_t> m_changeIndices; // Entity index -> position in m_changes
+	std::vector<PendingCreation> m_creations;
+	std::vector<PendingInitializer> m_initializers;
+};
@@ -0,0 +1,45 @@
+#include "EntityEvent.h"
+
+void EntityEventQueue::recordCreation(const EntityHandle& entity)
+{
+	getEvent(entity).isCreated = true;
+}
+
+void EntityEventQueue::recordDestruction(const EntityHandle& entity)
+{
+	getEvent(entity).isDestroyed = true;
+}
+
+void EntityEventQueue::recordAddComponents(const EntityHandle& entity, size_t componentMask)
+{
+	getEvent(entity).addedComponents |= componentMask;
+}
+
+void EntityEventQueue::recordRemoveComponents(const EntityHandle& entity, size_t componentMask)
+{
+	getEvent(entity).removedComponents |= componentMask;
+}
+
+void EntityEventQueue::takeEvents(std::vector<EntityEvent>& outEvents)
+{
+	outEvents.clear();
+	outEvents.swap(m_events);
+	m_eventIndices.clear();
+}
+
+bool EntityEventQueue::isEmpty() const
+{
+	return m_events.empty();
+}
+
+EntityEvent& EntityEventQueue::getEvent(const EntityHandle& entity)
+{
+	auto eventIt = m_eventIndices.find(entity.index);
+	if (eventIt != m_eventIndices.end() && m_events[eventIt->second].entity == entity)
+		return m_events[eventIt->second];
+
+	m_eventIndices[entity.index] = m_events.size();
+	m_events.push_back({});
+	m_events.back().entity = entity;
+	return m_events.back();
+}
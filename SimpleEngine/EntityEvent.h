@@ -0,0 +1,52 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Structural changes to entities, queued up so they
+//                can be dispatched to listeners in batches.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include "EntityHandle.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Everything that happened to one entity since the last dispatch.
+// The handle is the entity as it was when the changes were made, the
+// entity may since have been destroyed.
+struct EntityEvent {
+	EntityHandle entity;
+	size_t addedComponents = 0;
+	size_t removedComponents = 0;
+	bool isCreated = false;
+	bool isDestroyed = false;
+};
+
+// Collects entity events between dispatches.
+// Changes to the same entity are merged into a single event.
+class EntityEventQueue {
+public:
+	void recordCreation(const EntityHandle&);
+	void recordDestruction(const EntityHandle&);
+	void recordAddComponents(const EntityHandle&, size_t componentMask);
+	void recordRemoveComponents(const EntityHandle&, size_t componentMask);
+
+	// Moves all the queued events into outEvents and empties the queue
+	void takeEvents(std::vector<EntityEvent>& outEvents);
+
+	bool isEmpty() const;
+
+private:
+	EntityEvent& getEvent(const EntityHandle&);
+
+	std::vector<EntityEvent> m_events;
+	std::unordered_map<uint32_t, size_t> m_eventIndices; // Entity index -> position in m_events
+};
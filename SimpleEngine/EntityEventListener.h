@@ -1,19 +1,23 @@
 #pragma once
 
-class Entity;
+#include "EntityEvent.h"
 
 class EntityEventListener {
 public:
-	// Triggers just after the components in the component mask have been added
-	virtual void onPostAddComponents(Entity& entity, size_t componentMaskToAdded) = 0;
-	// Triggers just before the components in the component mask are removed
-	virtual void onPreRemoveComponents(Entity& entity, size_t componentMaskToRemove) = 0;
-	// Triggered when an entity is created in the scene.
-	// This event will fire after the entity has been fully initialized.
-	virtual void onEntityCreation(Entity& entity) = 0;
-	// Triggered when an entity is destroyed in the scene.
-	// The event will fire just before the entity is actually destroyed,
-	// so the state of the entity will still be valid when this event
-	// fires.
-	virtual void onEntityDestruction(Entity& entity) = 0;
-};
\ No newline at end of file
+	virtual ~EntityEventListener() {}
+
+	// Triggered when the scene dispatches its queued entity events.
+	// Only events that added or removed a component in the listeners
+	// interest mask are passed on, and the listener is only called if
+	// there is at least one.
+	// Entities are created / destroyed and have components added /
+	// removed before their events are dispatched, so listeners should
+	// look at the current state of the entity rather than replaying
+	// the changes.
+	virtual void onEntityEvents(const EntityEvent* events, size_t numEvents) = 0;
+
+	// Triggered by Scene::updateWorldMatrices with the indices of the
+	// entities whose world matrix was rebuilt, if the listeners interest
+	// mask includes transforms.
+	virtual void onWorldMatricesChanged(const size_t* /*entityIndices*/, size_t /*numEntities*/) {}
+};
@@ -0,0 +1,33 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : A weak reference to an entity in a scene.
+//                Handles stay safe to hold after the entity is
+//                destroyed and its slot is reused.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <cstdint>
+
+// An entity slot index paired with the generation of the entity that
+// occupied the slot when the handle was created.
+// The scene bumps a slots generation every time the entity in it is
+// destroyed, so a handle to a destroyed entity will never resolve to
+// the entity that later reuses the slot.
+// Default constructed handles are null and never resolve to an entity.
+struct EntityHandle {
+	uint32_t index = 0;
+	uint32_t generation = 0; // Generation 0 is reserved for null handles
+
+	bool isNull() const { return generation == 0; }
+	bool operator==(const EntityHandle& rhs) const { return index == rhs.index && generation == rhs.generation; }
+	bool operator!=(const EntityHandle& rhs) const { return !(*this == rhs); }
+};
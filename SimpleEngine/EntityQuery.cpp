@@ -0,0 +1,82 @@
+#include "EntityQuery.h"
+
+#include "Entity.h"
+#include "Scene.h"
+
+const size_t EntityQuery::s_kNotMatching;
+
+EntityQuery::EntityQuery(Scene& scene, size_t componentMask)
+	: m_scene{ scene }
+	, m_componentMask{ componentMask }
+{
+	// Pick up any matching entities that already exist
+	for (size_t i = 0; i < m_scene.getEntityCount(); ++i) {
+		Entity& entity = m_scene.getEntity(i);
+		if (entity.isAlive() && entity.hasComponents(m_componentMask))
+			add(entity);
+	}
+
+	m_scene.registerEntityEventListener(this, m_componentMask);
+}
+
+EntityQuery::~EntityQuery()
+{
+	m_scene.removeEntityEventListener(this);
+}
+
+size_t EntityQuery::size() const
+{
+	return m_entities.size();
+}
+
+Entity& EntityQuery::getEntity(size_t i) const
+{
+	return *m_entities[i];
+}
+
+bool EntityQuery::contains(const Entity& entity) const
+{
+	size_t entityIndex = entity.getIndex();
+	return entityIndex < m_positions.size() && m_positions[entityIndex] != s_kNotMatching;
+}
+
+size_t EntityQuery::getComponentMask() const
+{
+	return m_componentMask;
+}
+
+void EntityQuery::onEntityEvents(const EntityEvent* events, size_t numEvents)
+{
+	for (size_t i = 0; i < numEvents; ++i) {
+		// Match against the current state of the slot, it may have been
+		// destroyed or reused since the event was queued.
+		Entity& entity = m_scene.getEntity(events[i].entity.index);
+		bool isMatching = entity.isAlive() && entity.hasComponents(m_componentMask);
+		if (isMatching && !contains(entity))
+			add(entity);
+		else if (!isMatching && contains(entity))
+			remove(entity);
+	}
+}
+
+void EntityQuery::add(Entity& entity)
+{
+	size_t entityIndex = entity.getIndex();
+	if (entityIndex >= m_positions.size())
+		m_positions.resize(entityIndex + 1, s_kNotMatching);
+
+	m_positions[entityIndex] = m_entities.size();
+	m_entities.push_back(&entity);
+}
+
+void EntityQuery::remove(Entity& entity)
+{
+	// Swap the last entity into the removed entities position
+	size_t position = m_positions[entity.getIndex()];
+	Entity* lastEntity = m_entities.back();
+	m_entities[position] = lastEntity;
+	m_positions[lastEntity->getIndex()] = position;
+
+	m_entities.pop_back();
+	m_positions[entity.getIndex()] = s_kNotMatching;
+}
@@ -0,0 +1,63 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : A cached list of all the entities in a scene that
+//                have a set of components.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include "EntityEventListener.h"
+
+#include <vector>
+
+class Scene;
+class Entity;
+
+// Tracks every entity in the scene that has ALL the components in the
+// queries component mask.
+// The matching set is kept up to date through the scenes entity events,
+// so iterating a query never has to visit entities that don't match.
+// Changes to the scene show up in the query once the scene next
+// dispatches its entity events.
+class EntityQuery : public EntityEventListener {
+public:
+	EntityQuery(Scene&, size_t componentMask);
+	~EntityQuery();
+	EntityQuery(const EntityQuery&) = delete;
+	EntityQuery& operator=(const EntityQuery&) = delete;
+
+	// Returns the number of matching entities
+	size_t size() const;
+
+	// Returns the matching entity at the specified position.
+	// Positions are not stable, entities can be reordered when an entity
+	// stops matching the query.
+	Entity& getEntity(size_t i) const;
+
+	// Returns true if the entity is in the matching set
+	bool contains(const Entity&) const;
+
+	size_t getComponentMask() const;
+
+	// Inherited via EntityEventListener
+	void onEntityEvents(const EntityEvent* events, size_t numEvents) override;
+
+private:
+	static const size_t s_kNotMatching = static_cast<size_t>(-1);
+
+	void add(Entity&);
+	void remove(Entity&);
+
+	Scene& m_scene;
+	size_t m_componentMask;
+	std::vector<Entity*> m_entities;
+	std::vector<size_t> m_positions; // Entity index -> position in m_entities
+};
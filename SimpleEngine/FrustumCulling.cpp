@@ -0,0 +1,107 @@
+#include "FrustumCulling.h"
+
+#include "Mesh.h"
+
+#include <algorithm>
+
+// SSE2 is always available on x64 and is MSVCs default for x86
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define FRUSTUM_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+void FrustumCulling::Spheres::clear()
+{
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	radius.clear();
+}
+
+size_t FrustumCulling::Spheres::size() const
+{
+	return radius.size();
+}
+
+void FrustumCulling::Spheres::push_back(const glm::vec3& center, float sphereRadius)
+{
+	centerX.push_back(center.x);
+	centerY.push_back(center.y);
+	centerZ.push_back(center.z);
+	radius.push_back(sphereRadius);
+}
+
+FrustumCulling::Frustum FrustumCulling::makeFrustum(const glm::mat4& viewProjection)
+{
+	// Each plane is the sum or difference of the last row and another row
+	// of the matrix (Gribb and Hartmann)
+	glm::mat4 rows = glm::transpose(viewProjection);
+	Frustum frustum;
+	frustum.planes[0] = rows[3] + rows[0]; // Left
+	frustum.planes[1] = rows[3] - rows[0]; // Right
+	frustum.planes[2] = rows[3] + rows[1]; // Bottom
+	frustum.planes[3] = rows[3] - rows[1]; // Top
+	frustum.planes[4] = rows[3] + rows[2]; // Near
+	frustum.planes[5] = rows[3] - rows[2]; // Far
+
+	// Normalize so plane distances are in world units, to compare against
+	// sphere radii
+	for (glm::vec4& plane : frustum.planes)
+		plane /= glm::length(glm::vec3(plane));
+
+	return frustum;
+}
+
+void FrustumCulling::pushWorldSphere(Spheres& spheres, const MeshBounds& bounds, const glm::mat4& transform)
+{
+	// The radius scales with the largest axis scale
+	glm::vec3 center = glm::vec3(transform * glm::vec4(bounds.center, 1));
+	float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) });
+	spheres.push_back(center, bounds.radius * scale);
+}
+
+size_t FrustumCulling::cullSpheres(const Frustum& frustum, const Spheres& spheres, std::vector<uint8_t>& outIsVisible)
+{
+	size_t numSpheres = spheres.size();
+	outIsVisible.resize(numSpheres);
+	size_t numVisible = 0;
+	size_t i = 0;
+
+	// A sphere is culled if it is entirely behind any plane.
+	// Tests are written as "is culled" so NaN radii stay visible.
+#ifdef FRUSTUM_CULLING_SSE
+	for (; i + 4 <= numSpheres; i += 4) {
+		__m128 centerX = _mm_loadu_ps(&spheres.centerX[i]);
+		__m128 centerY = _mm_loadu_ps(&spheres.centerY[i]);
+		__m128 centerZ = _mm_loadu_ps(&spheres.centerZ[i]);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+
+		__m128 isCulled = _mm_setzero_ps();
+		for (const glm::vec4& plane : frustum.planes) {
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), centerX), _mm_mul_ps(_mm_set1_ps(plane.y), centerY)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), centerZ), _mm_set1_ps(plane.w)));
+			isCulled = _mm_or_ps(isCulled, _mm_cmplt_ps(distance, negRadius));
+		}
+
+		int culledMask = _mm_movemask_ps(isCulled);
+		for (int lane = 0; lane < 4; ++lane) {
+			uint8_t isVisible = (culledMask >> lane & 1) == 0;
+			outIsVisible[i + lane] = isVisible;
+			numVisible += isVisible;
+		}
+	}
+#endif
+
+	for (; i < numSpheres; ++i) {
+		glm::vec3 center{ spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i] };
+		bool isCulled = false;
+		for (const glm::vec4& plane : frustum.planes)
+			isCulled |= glm::dot(glm::vec3(plane), center) + plane.w < -spheres.radius[i];
+
+		outIsVisible[i] = !isCulled;
+		numVisible += !isCulled;
+	}
+
+	return numVisible;
+}
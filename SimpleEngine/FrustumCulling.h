@@ -0,0 +1,57 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Tests batches of bounding spheres against a view
+//                frustum with SIMD.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <glm\glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct MeshBounds;
+
+// Spheres are stored as a structure of arrays, so 4 spheres can be tested
+// against a plane at once.
+namespace FrustumCulling {
+	// The 6 planes of a view frustum, with normals facing inwards.
+	// Each plane is (normal, distance), so a point p is inside a plane if
+	// dot(normal, p) + distance >= 0.
+	struct Frustum {
+		std::array<glm::vec4, 6> planes;
+	};
+
+	struct Spheres {
+		void clear();
+		size_t size() const;
+
+		void push_back(const glm::vec3& center, float radius);
+
+		std::vector<float> centerX, centerY, centerZ, radius;
+	};
+
+	// Returns the frustum of a view projection matrix
+	Frustum makeFrustum(const glm::mat4& viewProjection);
+
+	// Adds the world space bounding sphere of a mesh with the given
+	// transform
+	void pushWorldSphere(Spheres&, const MeshBounds&, const glm::mat4& transform);
+
+	// Tests every sphere against the frustum.
+	// Writes 1 to outIsVisible for each sphere that is at least partly
+	// inside the frustum, and 0 otherwise.
+	// Spheres with an infinite radius are always visible.
+	// Returns the number of visible spheres.
+	size_t cullSpheres(const Frustum&, const Spheres&, std::vector<uint8_t>& outIsVisible);
+}
@@ -17,9 +17,12 @@
 
 #include <glm\glm.hpp>
 #include <glm\gtc\matrix_transform.hpp>
+#include <glm\gtc\quaternion.hpp>
 #include <glm\gtc\type_ptr.hpp>
 #include <glm\gtx\euler_angles.hpp>
 
+#include <cmath>
+
 namespace GLMUtils {
 	// Limits a vector to the specified magnitude
 	template <typename VecT>
@@ -37,10 +40,29 @@ namespace GLMUtils {
 		return glm::yawPitchRoll(eulerAngles.y, eulerAngles.x, eulerAngles.z);
 	}
 
+	// Returns the same rotation as eulerToMat as a quaternion
+	inline glm::quat eulerToQuat(const glm::vec3& eulerAngles)
+	{
+		return glm::angleAxis(eulerAngles.y, glm::vec3{ 0, 1, 0 })
+		     * glm::angleAxis(eulerAngles.x, glm::vec3{ 1, 0, 0 })
+		     * glm::angleAxis(eulerAngles.z, glm::vec3{ 0, 0, 1 });
+	}
+
+	// Returns euler angles giving the same rotation as the quaternion, the
+	// inverse of eulerToQuat
+	inline glm::vec3 quatToEuler(const glm::quat& rotation)
+	{
+		glm::mat3 matrix = glm::mat3_cast(rotation);
+		float pitch = std::asin(glm::clamp(-matrix[2][1], -1.0f, 1.0f));
+		float yaw = std::atan2(matrix[2][0], matrix[2][2]);
+		float roll = std::atan2(matrix[0][1], matrix[1][1]);
+		return glm::vec3{ pitch, yaw, roll };
+	}
+
 	inline glm::mat4 transformToMat(const TransformComponent& transform)
 	{
 		return glm::translate(glm::mat4{}, transform.position)
-		     * eulerToMat(transform.eulerAngles)
+		     * glm::mat4_cast(transform.rotation)
 		     * glm::scale(glm::mat4{}, transform.scale);
 	}
 }
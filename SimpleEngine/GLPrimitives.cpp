@@ -299,7 +299,10 @@ const Mesh& GLPrimitives::getQuadMesh()
 	static const Mesh mesh{
 		0,
 		GLUtils::bufferMeshData(vertices, indices),
-		static_cast<GLsizei>(indices.size())
+		static_cast<GLsizei>(indices.size()),
+		GLUtils::calculateMeshBounds(vertices),
+		{}, // No levels of detail
+		0
 	};
 
 	return mesh;
@@ -311,6 +314,7 @@ const ModelComponent& GLPrimitives::getQuadModel()
 	static ModelComponent model;
 
 	if (!isLoaded) {
+		model.assetType = MODEL_ASSET_QUAD;
 		model.rootNode.meshIDs.push_back(0);
 		model.meshes.push_back(getQuadMesh());
 
@@ -336,7 +340,10 @@ const Mesh& GLPrimitives::getSphereMesh()
 	static const Mesh mesh{
 		0, // Use the first material on the model
 		GLUtils::bufferMeshData(vertices, indices),
-		static_cast<GLsizei>(indices.size())
+		static_cast<GLsizei>(indices.size()),
+		GLUtils::calculateMeshBounds(vertices),
+		{}, // No levels of detail
+		0
 	};
 
 	return mesh;
@@ -348,6 +355,7 @@ const ModelComponent& GLPrimitives::getSphereModel()
 	static ModelComponent model;
 
 	if (!isLoaded) {
+		model.assetType = MODEL_ASSET_SPHERE;
 		model.rootNode.meshIDs.push_back(0);
 		model.meshes.push_back(getSphereMesh());
 
@@ -373,7 +381,10 @@ const Mesh& GLPrimitives::getCylinderMesh()
 	static const Mesh mesh{
 		0, // Use the first material on the model
 		GLUtils::bufferMeshData(vertices, indices),
-		static_cast<GLsizei>(indices.size())
+		static_cast<GLsizei>(indices.size()),
+		GLUtils::calculateMeshBounds(vertices),
+		{}, // No levels of detail
+		0
 	};
 
 	return mesh;
@@ -385,6 +396,7 @@ const ModelComponent& GLPrimitives::getCylinderModel()
 	static ModelComponent model;
 
 	if (!isLoaded) {
+		model.assetType = MODEL_ASSET_CYLINDER;
 		model.rootNode.meshIDs.push_back(0);
 		model.meshes.push_back(getCylinderMesh());
 
@@ -410,7 +422,10 @@ const Mesh& GLPrimitives::getPyramidMesh()
 	static const Mesh mesh{
 		0,
 		GLUtils::bufferMeshData(vertices, indices),
-		static_cast<GLsizei>(indices.size())
+		static_cast<GLsizei>(indices.size()),
+		GLUtils::calculateMeshBounds(vertices),
+		{}, // No levels of detail
+		0
 	};
 
 	return mesh;
@@ -422,6 +437,7 @@ const ModelComponent& GLPrimitives::getPyramidModel()
 	static ModelComponent model;
 
 	if (!isLoaded) {
+		model.assetType = MODEL_ASSET_PYRAMID;
 		model.rootNode.meshIDs.push_back(0);
 		model.meshes.push_back(getPyramidMesh());
 
@@ -447,7 +463,10 @@ const Mesh& GLPrimitives::getCubeMesh()
 	static const Mesh mesh{
 		0, // Use the first material on the model
 		GLUtils::bufferMeshData(vertices, indices),
-		static_cast<GLsizei>(indices.size())
+		static_cast<GLsizei>(indices.size()),
+		GLUtils::calculateMeshBounds(vertices),
+		{}, // No levels of detail
+		0
 	};
 
 	return mesh;
@@ -459,6 +478,7 @@ const ModelComponent& GLPrimitives::getCubeModel()
 	static ModelComponent model;
 
 	if (!isLoaded) {
+		model.assetType = MODEL_ASSET_CUBE;
 		model.rootNode.meshIDs.push_back(0);
 		model.meshes.push_back(getCubeMesh());
 
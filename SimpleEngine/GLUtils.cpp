@@ -18,6 +18,7 @@
 #include "ShaderHelper.h"
 #include "VertexFormat.h"
 #include "Shader.h"
+#include "Profiler.h"
 #include "stb_image.h"
 
 #include <GLFW\glfw3.h>
@@ -25,6 +26,8 @@
 #include <gli\gli.hpp>
 
 #include "Log.h"
+#include <algorithm>
+#include <cmath>
 #include <unordered_map>
 #include <string>
 #include <sstream>
@@ -43,7 +46,7 @@ void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 	glViewport(0, 0, width, height);
 }
 
-GLFWwindow* GLUtils::initOpenGL()
+GLFWwindow* GLUtils::initOpenGL(bool isVisible)
 {
 	glfwSetErrorCallback(errorCallback);
 
@@ -54,6 +57,7 @@ GLFWwindow* GLUtils::initOpenGL()
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, isVisible ? GLFW_TRUE : GLFW_FALSE);
 	GLFWwindow* glContext = glfwCreateWindow(1400, 800, "Doge-otron 2017", nullptr, nullptr);
 	if (!glContext)
 	{
@@ -76,7 +80,7 @@ GLFWwindow* GLUtils::initOpenGL()
 	}
 
 	// Configure glContext
-	glfwSwapInterval(1);
+	glfwSwapInterval(isVisible ? 1 : 0);
 	glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 	glEnable(GL_DEPTH_TEST);
 
@@ -205,6 +209,32 @@ void GLUtils::createTessellatedQuadData(GLsizei numVertsX, GLsizei numVertsZ, fl
 	}
 }
 
+MeshBounds GLUtils::calculateMeshBounds(const std::vector<VertexFormat>& vertices)
+{
+	MeshBounds bounds;
+	if (vertices.empty())
+		return bounds;
+
+	bounds.min = vertices[0].position;
+	bounds.max = vertices[0].position;
+	for (const VertexFormat& vertex : vertices) {
+		bounds.min = glm::min(bounds.min, vertex.position);
+		bounds.max = glm::max(bounds.max, vertex.position);
+	}
+
+	// Centering the sphere on the box is tighter than a centroid for
+	// meshes with unevenly spread vertices
+	bounds.center = (bounds.min + bounds.max) / 2.0f;
+	float radiusSquared = 0;
+	for (const VertexFormat& vertex : vertices) {
+		glm::vec3 offset = vertex.position - bounds.center;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	bounds.radius = std::sqrt(radiusSquared);
+
+	return bounds;
+}
+
 GLuint GLUtils::bufferMeshData(const std::vector<VertexFormat>& vertices, const std::vector<GLuint>& indices)
 {
 	GLuint VAO;
@@ -238,6 +268,8 @@ GLuint GLUtils::bufferMeshData(const std::vector<VertexFormat>& vertices, const
 
 Texture GLUtils::loadTexture(const std::string& path, bool sRGB, bool generateMipmaps)
 {
+	PROFILE_SCOPE_CATEGORY("GLUtils::loadTexture", "Assets");
+
 	// Cached textures that have already been loaded
 	static std::unordered_map<std::string, Texture> s_loadedTextures;
 
@@ -310,6 +342,8 @@ Texture GLUtils::loadTexture(const std::string& path, bool sRGB, bool generateMi
 // TODO: Combine with load textures for easier changability
 Texture GLUtils::loadCubeMapFaces(const std::vector<std::string>& facePaths)
 {
+	PROFILE_SCOPE_CATEGORY("GLUtils::loadCubeMapFaces", "Assets");
+
 	// Cached textures that have already been loaded
 	static std::unordered_map<std::string, Texture> s_loadedTextures;
 
@@ -376,6 +410,8 @@ Texture GLUtils::loadCubeMapFaces(const std::vector<std::string>& facePaths)
 
 Texture GLUtils::loadDDSTexture(const std::string& path)
 {
+	PROFILE_SCOPE_CATEGORY("GLUtils::loadDDSTexture", "Assets");
+
 	Texture finalTexture{};
 
 	gli::texture texture = gli::load(path);
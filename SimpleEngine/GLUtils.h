@@ -23,13 +23,16 @@
 #include <string>
 
 struct VertexFormat;
+struct MeshBounds;
 struct GLFWwindow;
 class Scene;
 class InputSystem;
 
 namespace GLUtils {
-	// Initializes the window, opengl context and opengl function pointers
-	GLFWwindow* initOpenGL();
+	// Initializes the window, opengl context and opengl function pointers.
+	// Hidden windows don't wait for vsync, so they can be used to run the
+	// engine headless i.e. for benchmarks.
+	GLFWwindow* initOpenGL(bool isVisible = true);
 
 	// Returns a handler to the default shader.
 	// This function will build the shader if it is not already built.
@@ -67,6 +70,9 @@ namespace GLUtils {
 	// Helper function for creating a tesselated quad
 	void createTessellatedQuadData(GLsizei numVertsX, GLsizei numVertsZ, float width, float height, std::vector<VertexFormat>& vertices, std::vector<GLuint>& indices);
 
+	// Returns the axis aligned box and sphere that bound the vertices
+	MeshBounds calculateMeshBounds(const std::vector<VertexFormat>& vertices);
+
 	// Buffers vertex and index data to the GPU.
 	// Returns a handler the the VAO associated with the vertices / indices.
 	GLuint bufferMeshData(const std::vector<VertexFormat>& vertices, const std::vector<GLuint>& indices);
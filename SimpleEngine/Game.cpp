@@ -4,6 +4,7 @@
 #include "ScreenManager.h"
 #include "Clock.h"
 #include "GameplayScreen.h"
+#include "JobSystem.h"
 
 #include <GLFW\glfw3.h>
 
@@ -21,12 +22,21 @@ void Game::init()
 	// Init combined Window and OpenGL context.
 	g_window = GLUtils::initOpenGL();
 
+	// Start the worker threads
+	JobSystem::init();
+
 	// Preload models and textures
 	Game::preloadModelsAndTextures();
 
 	ScreenManager::switchScreen(std::unique_ptr<Screen>(new GameplayScreen));
 }
 
+void Game::initHeadless()
+{
+	g_window = GLUtils::initOpenGL(false);
+	JobSystem::init();
+}
+
 // Load game specific models and textures into GPU memory here
 void Game::preloadModelsAndTextures()
 {
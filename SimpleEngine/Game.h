@@ -4,6 +4,10 @@ struct GLFWwindow;
 
 namespace Game {
 	void init();
+
+	// Creates a hidden window and starts the job system without creating
+	// a screen, so screens can be run headless i.e. for benchmarks.
+	void initHeadless();
 	GLFWwindow* getWindowContext();
 	void preloadModelsAndTextures();
 	void executeOneFrame();
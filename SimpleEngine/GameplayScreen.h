@@ -1,8 +1,10 @@
 #pragma once
 
 #include "Screen.h"
+#include <memory>
 #include <vector>
 class Entity;
+class SpatialIndex;
 class GameplayScreen : public Screen
 {
 public:
@@ -10,5 +12,6 @@ public:
 	~GameplayScreen() override;
 private:
 	std::vector<Entity*> m_playerList;
+	std::unique_ptr<SpatialIndex> m_spatialIndex;
 };
 
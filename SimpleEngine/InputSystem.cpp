@@ -24,9 +24,10 @@
 #include <glm\gtc\matrix_transform.hpp>
 
 InputSystem::InputSystem(Scene& scene)
-	: System{ scene }
+	: System{ scene, COMPONENT_INPUT | COMPONENT_INPUT_MAP }
+	, m_modelQuery{ scene, COMPONENT_MODEL }
 {
-
+	setComponentAccess(COMPONENT_INPUT_MAP, COMPONENT_INPUT | COMPONENT_MODEL);
 }
 
 void InputSystem::beginFrame()
@@ -51,51 +52,64 @@ void InputSystem::beginFrame()
 	lastMousePos = mousePos;
 }
 
-void InputSystem::update(Entity& entity)
+void InputSystem::update()
+{
+	for (size_t i = 0; i < m_modelQuery.size(); ++i)
+		updateMaterialDebugControls(m_modelQuery.getEntity(i));
+
+	System::update();
+}
+
+void InputSystem::updateMaterialDebugControls(Entity& entity)
 {
 	GLFWwindow* window = Game::getWindowContext();
 
 	// DEBUG!!!
 	if (entity.hasComponents(COMPONENT_MODEL)) {
 		if (glfwGetKey(window, GLFW_KEY_KP_MULTIPLY) == GLFW_PRESS) {
-			for (size_t i = 0; i < entity.model.materials.size(); ++i) {
-				entity.model.materials.at(i).shaderParams.metallicness = clamp(entity.model.materials.at(i).shaderParams.metallicness + 0.01f, 0.001f, 1.0f);
+			for (size_t i = 0; i < entity.model().materials.size(); ++i) {
+				entity.model().materials.at(i).shaderParams.metallicness = clamp(entity.model().materials.at(i).shaderParams.metallicness + 0.01f, 0.001f, 1.0f);
 			}
 		}
 		if (glfwGetKey(window, GLFW_KEY_KP_DIVIDE) == GLFW_PRESS) {
-			for (size_t i = 0; i < entity.model.materials.size(); ++i) {
-				entity.model.materials.at(i).shaderParams.metallicness = clamp(entity.model.materials.at(i).shaderParams.metallicness - 0.01f, 0.001f, 1.0f);
+			for (size_t i = 0; i < entity.model().materials.size(); ++i) {
+				entity.model().materials.at(i).shaderParams.metallicness = clamp(entity.model().materials.at(i).shaderParams.metallicness - 0.01f, 0.001f, 1.0f);
 			}
 		}
 		if (glfwGetKey(window, GLFW_KEY_KP_ADD) == GLFW_PRESS) {
-			for (size_t i = 0; i < entity.model.materials.size(); ++i) {
-				entity.model.materials.at(i).shaderParams.glossiness = clamp(entity.model.materials.at(i).shaderParams.glossiness + 0.01f, 0.0001f, 1.0f);
+			for (size_t i = 0; i < entity.model().materials.size(); ++i) {
+				entity.model().materials.at(i).shaderParams.glossiness = clamp(entity.model().materials.at(i).shaderParams.glossiness + 0.01f, 0.0001f, 1.0f);
 			}
 		}
 		if (glfwGetKey(window, GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS) {
-			for (size_t i = 0; i < entity.model.materials.size(); ++i) {
-				entity.model.materials.at(i).shaderParams.glossiness = clamp(entity.model.materials.at(i).shaderParams.glossiness - 0.01f, 0.0001f, 1.0f);
+			for (size_t i = 0; i < entity.model().materials.size(); ++i) {
+				entity.model().materials.at(i).shaderParams.glossiness = clamp(entity.model().materials.at(i).shaderParams.glossiness - 0.01f, 0.0001f, 1.0f);
 			}
 		}
 		if (glfwGetKey(window, GLFW_KEY_PAGE_UP) == GLFW_PRESS) {
-			for (size_t i = 0; i < entity.model.materials.size(); ++i) {
-				entity.model.materials.at(i).shaderParams.specBias = clamp(entity.model.materials.at(i).shaderParams.specBias + 0.01f, 0.0f, 0.96f);
+			for (size_t i = 0; i < entity.model().materials.size(); ++i) {
+				entity.model().materials.at(i).shaderParams.specBias = clamp(entity.model().materials.at(i).shaderParams.specBias + 0.01f, 0.0f, 0.96f);
 			}
 		}
 		if (glfwGetKey(window, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS) {
-			for (size_t i = 0; i < entity.model.materials.size(); ++i) {
-				entity.model.materials.at(i).shaderParams.specBias = clamp(entity.model.materials.at(i).shaderParams.specBias - 0.01f, 0.0f, 0.9599f);
+			for (size_t i = 0; i < entity.model().materials.size(); ++i) {
+				entity.model().materials.at(i).shaderParams.specBias = clamp(entity.model().materials.at(i).shaderParams.specBias - 0.01f, 0.0f, 0.9599f);
 			}
 		}
 	}
+}
+
+void InputSystem::update(Entity& entity)
+{
+	GLFWwindow* window = Game::getWindowContext();
 
 	// Filter input receivers
 	const size_t kInputReceiverMask = COMPONENT_INPUT | COMPONENT_INPUT_MAP;
 	if (!entity.hasComponents(kInputReceiverMask))
 		return;
 
-	InputComponent& input = entity.input;
-	InputMapComponent& inputMap = entity.inputMap;
+	InputComponent& input = entity.input();
+	InputMapComponent& inputMap = entity.inputMap();
 	int gamepadIdx = inputMap.gamepadIdx;
 
 	// Update input from axes
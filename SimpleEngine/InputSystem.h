@@ -28,6 +28,9 @@ class InputSystem : public System {
 public:
 	InputSystem(Scene& scene);
 
+	// Updates all input receivers and the debug material controls
+	void update() override;
+
 	// Updates the entity with input
 	void update(Entity&) override;
 
@@ -36,5 +39,9 @@ public:
 	void endFrame() override {};
 
 private:
+	// DEBUG: Tweaks an entities material parameters from the keyboard
+	void updateMaterialDebugControls(Entity&);
+
 	glm::vec2 m_mouseDelta;
+	EntityQuery m_modelQuery;
 };
\ No newline at end of file
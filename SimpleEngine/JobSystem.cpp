@@ -0,0 +1,247 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+	struct Job {
+		std::function<void()> func;
+		JobCounter* counter;
+		const JobCounter* dependency;
+	};
+
+	// Each thread pushes and pops jobs at the back of its own queue,
+	// other threads steal from the front.
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue>> g_queues; // Queue 0 is shared by threads outside the pool
+	std::vector<std::thread> g_workers;
+	std::atomic<bool> g_isRunning{ false };
+	std::atomic<size_t> g_numQueuedJobs{ 0 }; // Not counting parked jobs
+	const size_t g_kCacheLineSize = 64;
+	const size_t g_kBatchesPerThread = 4;
+	const size_t g_kMinBatchSize = 64;
+
+	// Jobs waiting on a dependency are parked here, out of the queues,
+	// until a job finishing takes a counter to zero
+	std::mutex g_parkedMutex;
+	std::vector<Job> g_parkedJobs;
+	std::atomic<size_t> g_numParkedJobs{ 0 };
+
+	std::mutex g_sleepMutex;
+	std::condition_variable g_wakeCondition;
+	thread_local size_t t_queueIdx = 0;
+
+	void pushJob(Job&& job)
+	{
+		WorkQueue& queue = *g_queues[t_queueIdx];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(std::move(job));
+		}
+		++g_numQueuedJobs;
+
+		// Take the sleep lock so a worker can't miss the wake up between
+		// checking for jobs and going to sleep.
+		{
+			std::lock_guard<std::mutex> lock(g_sleepMutex);
+		}
+		g_wakeCondition.notify_one();
+	}
+
+	// Parks the job until its dependency is done, or queues it if the
+	// dependency is already done
+	void parkOrPushJob(Job&& job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(g_parkedMutex);
+
+			// Count the job as parked before checking the dependency, so
+			// a job finishing the dependency at the same time sees it
+			++g_numParkedJobs;
+			if (!job.dependency->isDone()) {
+				g_parkedJobs.push_back(std::move(job));
+				return;
+			}
+			--g_numParkedJobs;
+		}
+
+		pushJob(std::move(job));
+	}
+
+	// Queues the parked jobs whose dependencies are now done
+	void releaseParkedJobs()
+	{
+		if (g_numParkedJobs == 0)
+			return;
+
+		std::vector<Job> readyJobs;
+		{
+			std::lock_guard<std::mutex> lock(g_parkedMutex);
+			auto readyBegin = std::stable_partition(g_parkedJobs.begin(), g_parkedJobs.end(), [](const Job& job) {
+				return !job.dependency->isDone();
+			});
+			std::move(readyBegin, g_parkedJobs.end(), std::back_inserter(readyJobs));
+			g_parkedJobs.erase(readyBegin, g_parkedJobs.end());
+			g_numParkedJobs -= readyJobs.size();
+		}
+
+		for (Job& job : readyJobs)
+			pushJob(std::move(job));
+	}
+
+	bool popJob(Job& outJob)
+	{
+		WorkQueue& queue = *g_queues[t_queueIdx];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+			return false;
+
+		outJob = std::move(queue.jobs.back());
+		queue.jobs.pop_back();
+		return true;
+	}
+
+	bool stealJob(Job& outJob)
+	{
+		size_t numQueues = g_queues.size();
+		for (size_t offset = 1; offset < numQueues; ++offset) {
+			WorkQueue& victim = *g_queues[(t_queueIdx + offset) % numQueues];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (victim.jobs.empty())
+				continue;
+
+			outJob = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			return true;
+		}
+
+		return false;
+	}
+
+	void workerMain(size_t queueIdx)
+	{
+		t_queueIdx = queueIdx;
+		while (g_isRunning) {
+			if (JobSystem::tryRunJob())
+				continue;
+
+			std::unique_lock<std::mutex> lock(g_sleepMutex);
+			g_wakeCondition.wait(lock, []() {
+				return g_numQueuedJobs > 0 || !g_isRunning;
+			});
+		}
+	}
+}
+
+void JobSystem::init(size_t numWorkers)
+{
+	assert(!g_isRunning);
+
+	if (numWorkers == 0) {
+		size_t numHardwareThreads = std::thread::hardware_concurrency();
+		numWorkers = numHardwareThreads > 1 ? numHardwareThreads - 1 : 1;
+	}
+
+	g_queues.clear();
+	for (size_t i = 0; i < numWorkers + 1; ++i)
+		g_queues.push_back(std::make_unique<WorkQueue>());
+
+	g_isRunning = true;
+	for (size_t i = 0; i < numWorkers; ++i)
+		g_workers.emplace_back(workerMain, i + 1);
+}
+
+void JobSystem::shutdown()
+{
+	if (!g_isRunning)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(g_sleepMutex);
+		g_isRunning = false;
+	}
+	g_wakeCondition.notify_all();
+
+	for (std::thread& worker : g_workers)
+		worker.join();
+
+	g_workers.clear();
+	g_queues.clear();
+	g_numQueuedJobs = 0;
+	g_parkedJobs.clear();
+	g_numParkedJobs = 0;
+}
+
+size_t JobSystem::getWorkerCount()
+{
+	return g_workers.size();
+}
+
+size_t JobSystem::getThreadIndex()
+{
+	return t_queueIdx;
+}
+
+void JobSystem::run(std::function<void()> job, JobCounter* counter, const JobCounter* dependency)
+{
+	if (!g_isRunning) {
+		assert(!dependency || dependency->isDone());
+		job();
+		return;
+	}
+
+	if (counter)
+		++counter->count;
+
+	if (dependency)
+		parkOrPushJob(Job{ std::move(job), counter, dependency });
+	else
+		pushJob(Job{ std::move(job), counter, dependency });
+}
+
+bool JobSystem::tryRunJob()
+{
+	if (g_numQueuedJobs == 0)
+		return false;
+
+	Job job;
+	if (!popJob(job) && !stealJob(job))
+		return false;
+	--g_numQueuedJobs;
+
+	// Only jobs whose dependency is done are queued
+	job.func();
+	if (job.counter && --job.counter->count == 0)
+		releaseParkedJobs();
+
+	return true;
+}
+
+void JobSystem::wait(const JobCounter& counter)
+{
+	while (!counter.isDone()) {
+		if (!tryRunJob())
+			std::this_thread::yield();
+	}
+}
+
+size_t JobSystem::getBatchSize(size_t count, size_t elementSize)
+{
+	size_t numThreads = getWorkerCount() + 1;
+	size_t batchSize = std::max(count / (numThreads * g_kBatchesPerThread), g_kMinBatchSize);
+
+	// Round up to a whole number of cache lines
+	size_t elementsPerLine = std::max<size_t>(g_kCacheLineSize / std::max<size_t>(elementSize, 1), 1);
+	return ((batchSize + elementsPerLine - 1) / elementsPerLine) * elementsPerLine;
+}
@@ -0,0 +1,109 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : A fixed pool of worker threads that share work
+//                through work stealing.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+// Tracks a group of jobs.
+// The count is incremented when a job is run with the counter and
+// decremented when that job finishes.
+struct JobCounter {
+	std::atomic<size_t> count{ 0 };
+
+	// Returns true once all the jobs run with this counter have finished
+	bool isDone() const { return count.load() == 0; }
+};
+
+namespace JobSystem {
+	// Starts the worker threads.
+	// By default one worker is created for each hardware thread other
+	// than the main thread.
+	void init(size_t numWorkers = 0);
+
+	// Finishes any running jobs and joins the worker threads.
+	// Jobs still waiting in the queues are discarded.
+	void shutdown();
+
+	// Returns the number of worker threads, not counting the main thread
+	size_t getWorkerCount();
+
+	// Returns the index of the calling thread.
+	// Workers are numbered from 1, the main thread (and any other thread
+	// outside the pool) is 0.
+	size_t getThreadIndex();
+
+	// Queues a job.
+	// If a counter is supplied, it is incremented now and decremented
+	// once the job has finished.
+	// If a dependency is supplied the job won't start until the
+	// dependency counter reaches zero. Until then it is parked outside
+	// the queues, so threads don't pick it up and put it back.
+	// Jobs are run immediately on the calling thread if the job system
+	// hasn't been initialized.
+	void run(std::function<void()> job, JobCounter* counter = nullptr, const JobCounter* dependency = nullptr);
+
+	// Runs one queued job on the calling thread.
+	// Returns false if there were no jobs ready to run.
+	bool tryRunJob();
+
+	// Blocks until the counter reaches zero.
+	// The calling thread runs queued jobs while it waits.
+	void wait(const JobCounter& counter);
+
+	// Calls func(begin, end) over batches of the range [0, count) in
+	// parallel and waits for all the batches to finish.
+	template <typename FuncT>
+	void parallelFor(size_t count, size_t batchSize, const FuncT& func);
+
+	// Same as above, picking a batch size that gives each thread a few
+	// batches to balance the load.
+	template <typename FuncT>
+	void parallelFor(size_t count, const FuncT& func);
+
+	// Returns a parallelFor batch size for an array of elements that
+	// gives each thread a few batches, while keeping batches large enough
+	// to cover whole cache lines so threads don't share lines.
+	size_t getBatchSize(size_t count, size_t elementSize);
+}
+
+template <typename FuncT>
+inline void JobSystem::parallelFor(size_t count, size_t batchSize, const FuncT& func)
+{
+	if (count == 0)
+		return;
+
+	batchSize = std::max<size_t>(batchSize, 1);
+
+	// The calling thread runs the last batch itself rather than idling
+	JobCounter counter;
+	size_t lastBegin = ((count - 1) / batchSize) * batchSize;
+	for (size_t begin = 0; begin < lastBegin; begin += batchSize) {
+		size_t end = begin + batchSize;
+		run([&func, begin, end]() {
+			func(begin, end);
+		}, &counter);
+	}
+	func(lastBegin, count);
+
+	wait(counter);
+}
+
+template <typename FuncT>
+inline void JobSystem::parallelFor(size_t count, const FuncT& func)
+{
+	parallelFor(count, getBatchSize(count, 1), func);
+}
@@ -0,0 +1,117 @@
+#include "JobSystemBenchmark.h"
+
+#include "Entity.h"
+#include "JobSystem.h"
+#include "Log.h"
+#include "Scene.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace {
+	using BenchClock = std::chrono::high_resolution_clock;
+
+	double secondsSince(BenchClock::time_point start)
+	{
+		return std::chrono::duration<double>(BenchClock::now() - start).count();
+	}
+
+	// Time to queue and run a large number of empty jobs
+	double measureJobOverhead(size_t numJobs)
+	{
+		JobCounter counter;
+		BenchClock::time_point start = BenchClock::now();
+		for (size_t i = 0; i < numJobs; ++i)
+			JobSystem::run([]() {}, &counter);
+		JobSystem::wait(counter);
+
+		return secondsSince(start) / numJobs;
+	}
+
+	// Time to run a fixed amount of floating point work through parallelFor
+	double measureParallelFor(std::vector<float>& data)
+	{
+		BenchClock::time_point start = BenchClock::now();
+		JobSystem::parallelFor(data.size(), [&data](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				float x = static_cast<float>(i);
+				for (int j = 0; j < 64; ++j)
+					x = std::sqrt(x * x + 1.0f) * 0.999f;
+				data[i] = x;
+			}
+		});
+
+		return secondsSince(start);
+	}
+
+	// Returns true if parallelCollect gives the same outputs, in the same
+	// order, as a serial pass over the view
+	bool checkParallelCollect(Scene& scene)
+	{
+		auto view = scene.view<PhysicsComponent, TransformComponent>();
+		std::vector<float> expected;
+		view.each([&expected](const PhysicsComponent& physics, const TransformComponent& transform) {
+			if (physics.velocity.x > 0)
+				expected.push_back(transform.position.x);
+		});
+
+		std::vector<float> collected = view.parallelCollect<float>([](std::vector<float>& output, const PhysicsComponent& physics, const TransformComponent& transform) {
+			if (physics.velocity.x > 0)
+				output.push_back(transform.position.x);
+		});
+		return collected == expected;
+	}
+}
+
+void JobSystemBenchmark::run()
+{
+	const size_t kNumEmptyJobs = 200000;
+	const size_t kNumElements = 1 << 20;
+	const size_t kThreadCounts[] = { 1, 2, 4, 8, 16 };
+
+	bool wasRunning = JobSystem::getWorkerCount() > 0;
+	JobSystem::shutdown();
+
+	g_log << "Job system benchmark (" << std::thread::hardware_concurrency() << " hardware threads)\n";
+
+	std::vector<float> data(kNumElements);
+
+	// Entities the view skips are mixed in, so chunks output different
+	// amounts
+	Scene scene;
+	for (size_t i = 0; i < kNumElements / 4; ++i) {
+		Entity& entity = (i % 3 == 0) ? scene.createEntity(COMPONENT_TRANSFORM) : scene.createEntity(COMPONENT_TRANSFORM, COMPONENT_PHYSICS);
+		entity.transform().position.x = static_cast<float>(i);
+		if (entity.hasComponents(COMPONENT_PHYSICS))
+			entity.physics().velocity = glm::vec3((i % 5 == 0) ? 0.0f : 1.0f, 0, 0);
+	}
+
+	double singleThreadTime = 0;
+	for (size_t numThreads : kThreadCounts) {
+		if (numThreads > 1)
+			JobSystem::init(numThreads - 1);
+
+		// Warm up the workers before timing
+		measureParallelFor(data);
+
+		double overhead = measureJobOverhead(kNumEmptyJobs);
+		double parallelForTime = measureParallelFor(data);
+		if (numThreads == 1)
+			singleThreadTime = parallelForTime;
+
+		// With a single thread there are no workers so jobs run inline,
+		// giving the baseline cost of the work itself.
+		g_log << "  " << numThreads << " threads: "
+		      << overhead * 1e9 << " ns per job, parallelFor "
+		      << parallelForTime * 1e3 << " ms ("
+		      << singleThreadTime / parallelForTime << "x), parallelCollect "
+		      << (checkParallelCollect(scene) ? "matches" : "DIFFERS FROM") << " serial order\n";
+
+		JobSystem::shutdown();
+	}
+
+	if (wasRunning)
+		JobSystem::init();
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace JobSystemBenchmark {
+	// Measures the scheduling overhead per job and how parallelFor
+	// scales with the number of threads.
+	// Also checks ComponentView::parallelCollect merges its outputs in
+	// the same order at every thread count.
+	// Results are written to the log.
+	void run();
+}
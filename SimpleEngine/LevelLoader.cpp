@@ -177,16 +177,21 @@ void TranslateCharLevel(const NDArray<char, MaxMapWidth, MaxMapHeight> charLevel
 				NDArray<char, 20, 20> track;
 				if (isStraight)
 				{	//straightline
-					en.model = ModelUtils::loadModel("Assets/Models/Track/straightUp.obj");
+					en.model() = ModelUtils::loadModel("Assets/Models/Track/straightUp.obj");
 					track = straightTrack;
 				}
 				else
 				{
 					//curved piece
-					en.model = ModelUtils::loadModel("Assets/Models/Track/curve1.obj");
+					en.model() = ModelUtils::loadModel("Assets/Models/Track/curve1.obj");
 					track = curveTrack;
 				}
 				
+				// Track pieces never move, so draw them from the static geometry.
+				// They also hide whatever is under the track.
+				en.model().isStatic = true;
+				en.model().isOccluder = true;
+
 				// make object here and put in an vector
 				//set its position and scale
 				
@@ -195,10 +200,10 @@ void TranslateCharLevel(const NDArray<char, MaxMapWidth, MaxMapHeight> charLevel
 					rotation -= 360;
 				}
 				
-				en.transform.position = glm::vec3(j * (fscale * 50.0f), -10 * fscale, (i * (fscale * 50.0f)));
+				en.transform().position = glm::vec3(j * (fscale * 50.0f), -10 * fscale, (i * (fscale * 50.0f)));
 
-				en.transform.eulerAngles = glm::vec3(270 * 3.14159/180, rotation * 3.14159/180, 0);
-				en.transform.scale = glm::vec3(fscale, fscale, fscale);
+				en.transform().setEulerAngles(glm::vec3(270 * 3.14159/180, rotation * 3.14159/180, 0));
+				en.transform().scale = glm::vec3(fscale, fscale, fscale);
 
 				for (int i = 0; i < 19; i++)
 				{
@@ -211,28 +216,28 @@ void TranslateCharLevel(const NDArray<char, MaxMapWidth, MaxMapHeight> charLevel
 								continue;
 							}
 							Entity& pickup = Prefabs::createSphere(scene);			
-							pickup.transform.position.x = (-45.0f +  10.0f * i);
-							pickup.transform.position.z = (-45.0f +  10.0f * j * 0.5f);
+							pickup.transform().position.x = (-45.0f +  10.0f * i);
+							pickup.transform().position.z = (-45.0f +  10.0f * j * 0.5f);
 							
 							if(isStraight)
 							{
 								glm::mat4 rot = glm::rotate({}, (rotation - 90) * 3.14159f / 180.0f, glm::vec3(0, 1, 0));
-								pickup.transform.position = rot * glm::vec4(pickup.transform.position, 1.0f);
+								pickup.transform().position = rot * glm::vec4(pickup.transform().position, 1.0f);
 							}
 							else
 							{
 								glm::mat4 rot = glm::rotate({}, (rotation - 180) * 3.14159f / 180.0f, glm::vec3(0, 1, 0));
-								pickup.transform.position = rot * glm::vec4(pickup.transform.position, 1.0f);
+								pickup.transform().position = rot * glm::vec4(pickup.transform().position, 1.0f);
 							}
 
-							pickup.transform.position += en.transform.position;
-							pickup.transform.position.y = 0;
+							pickup.transform().position += en.transform().position;
+							pickup.transform().position.y = 0;
 							pickup.addComponents(COMPONENT_PICKUP);
 						}
 					}
 				}
 				//Entity& pickup = Prefabs::createSphere(scene, pickupTransform);
-				//pickup.transform.position = glm::vec3(-25 + j * 2, 0.5f, i * 2);
+				//pickup.transform().position = glm::vec3(-25 + j * 2, 0.5f, i * 2);
 				//pickup.addComponents(COMPONENT_PICKUP);
 			}
 		}
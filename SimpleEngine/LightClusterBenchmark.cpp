@@ -0,0 +1,136 @@
+#include "LightClusterBenchmark.h"
+
+#include "LightClusters.h"
+#include "Log.h"
+
+#include <glm\gtc\matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+	using BenchClock = std::chrono::high_resolution_clock;
+
+	const float g_kLandscapeSize = 400;
+	const size_t g_kLightCounts[] = { 1000, 4000, 16000 };
+	const size_t g_kNumSamplePoints = 10000;
+	const int g_kNumRuns = 20;
+
+	double secondsSince(BenchClock::time_point start)
+	{
+		return std::chrono::duration<double>(BenchClock::now() - start).count();
+	}
+
+	// Returns the fastest of several runs, to skip runs that were
+	// interrupted
+	template <typename FuncT>
+	double timeBestOf(int numRuns, FuncT func)
+	{
+		double bestTime = 0;
+		for (int i = 0; i < numRuns; ++i) {
+			BenchClock::time_point start = BenchClock::now();
+			func();
+			double time = secondsSince(start);
+			if (i == 0 || time < bestTime)
+				bestTime = time;
+		}
+		return bestTime;
+	}
+
+	// Two thirds point lights, the rest spotlights shining down
+	std::vector<ClusterLight> makeLights(size_t numLights, std::mt19937& generator)
+	{
+		std::uniform_real_distribution<float> positionDistribution(-g_kLandscapeSize / 2, g_kLandscapeSize / 2);
+		std::uniform_real_distribution<float> heightDistribution(1, 10);
+		std::uniform_real_distribution<float> rangeDistribution(5, 20);
+		std::uniform_real_distribution<float> coneDistribution(glm::radians(15.0f), glm::radians(60.0f));
+		std::uniform_real_distribution<float> tiltDistribution(-0.5f, 0.5f);
+
+		std::vector<ClusterLight> lights(numLights);
+		for (size_t i = 0; i < numLights; ++i) {
+			ClusterLight& light = lights[i];
+			light.position = glm::vec3(positionDistribution(generator), heightDistribution(generator), positionDistribution(generator));
+			light.range = rangeDistribution(generator);
+			light.color = glm::vec3(1, 1, 1);
+			light.cosConeAngle = -1;
+			light.direction = glm::vec3(0, 0, -1);
+			light.padding = 0;
+			if (i % 3 == 2) {
+				light.cosConeAngle = std::cos(coneDistribution(generator));
+				light.direction = glm::normalize(glm::vec3(tiltDistribution(generator), -1, tiltDistribution(generator)));
+			}
+		}
+		return lights;
+	}
+
+	bool isLitBy(const ClusterLight& light, const glm::vec3& point)
+	{
+		glm::vec3 displacement = point - light.position;
+		float distance = glm::length(displacement);
+		if (distance >= light.range)
+			return false;
+		return light.cosConeAngle <= -1 || distance == 0 || glm::dot(displacement / distance, light.direction) > light.cosConeAngle;
+	}
+}
+
+void LightClusterBenchmark::run()
+{
+	g_log << "Light cluster benchmark\n";
+	g_log << "  " << LightClusters::s_kNumTilesX << "x" << LightClusters::s_kNumTilesY << "x" << LightClusters::s_kNumSlices << " clusters\n";
+
+	// Look across the landscape from just above the lights
+	glm::mat4 view = glm::lookAt(glm::vec3(0, 15, g_kLandscapeSize / 2), glm::vec3(0, 5, 0), glm::vec3(0, 1, 0));
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.01f, 10000.0f);
+	glm::mat4 viewProjection = projection * view;
+
+	std::mt19937 generator(1);
+	LightClusters clusters;
+	for (size_t numLights : g_kLightCounts) {
+		std::vector<ClusterLight> lights = makeLights(numLights, generator);
+
+		double buildTime = timeBestOf(g_kNumRuns, [&]() {
+			clusters.build(lights, view, projection);
+		});
+
+		size_t numFilledClusters = 0;
+		uint32_t maxClusterLights = 0;
+		for (const LightClusters::Cluster& cluster : clusters.getClusters()) {
+			numFilledClusters += cluster.numLights > 0;
+			maxClusterLights = std::max(maxClusterLights, cluster.numLights);
+		}
+
+		// Sample points around the lights that are in view, and check
+		// every light reaching them is in their cluster
+		std::uniform_int_distribution<size_t> lightDistribution(0, numLights - 1);
+		std::uniform_real_distribution<float> offsetDistribution(-1, 1);
+		size_t numSamples = 0;
+		size_t numShadedLights = 0;
+		size_t numMissedLights = 0;
+		const std::vector<uint32_t>& lightIndices = clusters.getLightIndices();
+		while (numSamples < g_kNumSamplePoints) {
+			const ClusterLight& nearLight = lights[lightDistribution(generator)];
+			glm::vec3 point = nearLight.position + glm::vec3(offsetDistribution(generator), offsetDistribution(generator), offsetDistribution(generator)) * nearLight.range;
+			glm::vec4 clipPosition = viewProjection * glm::vec4(point, 1);
+			if (clipPosition.w <= 0 || std::abs(clipPosition.x) > clipPosition.w || std::abs(clipPosition.y) > clipPosition.w || std::abs(clipPosition.z) > clipPosition.w)
+				continue;
+			++numSamples;
+
+			const LightClusters::Cluster& cluster = clusters.getClusters()[clusters.findCluster(glm::vec3(view * glm::vec4(point, 1)))];
+			const uint32_t* clusterLights = lightIndices.data() + cluster.firstLight;
+			numShadedLights += cluster.numLights;
+			for (uint32_t i = 0; i < numLights; ++i) {
+				if (isLitBy(lights[i], point) && std::find(clusterLights, clusterLights + cluster.numLights, i) == clusterLights + cluster.numLights)
+					++numMissedLights;
+			}
+		}
+
+		g_log << "  " << numLights << " lights: assign " << buildTime * 1000 << " ms, "
+		      << lightIndices.size() << " cluster entries, " << numFilledClusters << " clusters lit, at most "
+		      << maxClusterLights << " lights in a cluster\n";
+		g_log << "    " << static_cast<double>(numShadedLights) / numSamples << " lights shaded per point near a light, against "
+		      << numLights << " without clusters, " << numMissedLights << " lights missed\n";
+	}
+}
@@ -0,0 +1,28 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Times assigning large numbers of lights to the light
+//                clusters.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+// Scatters point lights and spotlights over a landscape, seen from a low
+// camera, and for each light count:
+//  - times assigning the lights to clusters on the job system
+//  - reports how many lights the clusters hold, against shading every
+//    light for every fragment
+//  - checks points lit by a light always find it in their cluster
+// The clusters make no GL calls, so no window is needed.
+namespace LightClusterBenchmark {
+	// Results are written to the log.
+	// The job system should be initialized first.
+	void run();
+}
@@ -0,0 +1,271 @@
+#include "LightClusters.h"
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+using glm::mat4;
+using glm::vec3;
+using glm::vec4;
+
+namespace {
+	// Slices are spaced exponentially between these depths, so clusters
+	// stay roughly as deep as they are wide.
+	// The first slice also covers everything closer than the minimum and
+	// the last everything further than the maximum.
+	const float g_kMinSliceDepth = 1.0f;
+	const float g_kMaxSliceDepth = 1000.0f;
+
+	const float g_kPi = 3.14159265f;
+
+	// Returns the sphere (center, radius) bounding a spotlights cone.
+	// Narrow cones fit in the sphere through their tip and the rim of
+	// their cap, wide ones in the sphere around their cap.
+	vec4 boundSpotlight(const vec3& position, const vec3& direction, float range, float coneAngle)
+	{
+		if (coneAngle >= g_kPi / 2)
+			return vec4(position, range);
+
+		float cosAngle = std::cos(coneAngle);
+		if (coneAngle > g_kPi / 4)
+			return vec4(position + direction * (range * cosAngle), range * std::sin(coneAngle));
+
+		float radius = range / (2 * cosAngle);
+		return vec4(position + direction * radius, radius);
+	}
+
+	int tileFromNDC(float ndc, int numTiles)
+	{
+		int tile = static_cast<int>(std::floor((ndc + 1) * 0.5f * numTiles));
+		return std::min(std::max(tile, 0), numTiles - 1);
+	}
+}
+
+const size_t LightClusters::s_kNoLimit;
+
+LightClusters::LightClusters(size_t maxLightIndices)
+	: m_xScale{ 1 }
+	, m_yScale{ 1 }
+	, m_nearDepth{ 0.01f }
+	, m_farDepth{ 1000.0f }
+	, m_maxLightIndices{ maxLightIndices }
+	, m_numTrimmedLightIndices{ 0 }
+	, m_slices(s_kNumSlices)
+	, m_clusters(s_kNumClusters, Cluster{ 0, 0 })
+{
+	m_depthSliceScale = (s_kNumSlices - 1) / std::log(g_kMaxSliceDepth / g_kMinSliceDepth);
+	m_depthSliceBias = 1 - std::log(g_kMinSliceDepth) * m_depthSliceScale;
+}
+
+void LightClusters::build(const std::vector<ClusterLight>& lights, const mat4& view, const mat4& projection)
+{
+	PROFILE_SCOPE_CATEGORY("LightClusters::build", "Render");
+
+	// Read the frustum back out of the projection
+	m_xScale = projection[0][0];
+	m_yScale = projection[1][1];
+	m_nearDepth = projection[3][2] / (projection[2][2] - 1);
+	m_farDepth = projection[3][2] / (projection[2][2] + 1);
+
+	// Bound each light in view space and find the slices it reaches
+	m_viewLights.resize(lights.size());
+	JobSystem::parallelFor(lights.size(), JobSystem::getBatchSize(lights.size(), sizeof(ViewLight)), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			const ClusterLight& light = lights[i];
+			vec4 bounds = vec4(light.position, light.range);
+			if (light.cosConeAngle > -1)
+				bounds = boundSpotlight(light.position, light.direction, light.range, std::acos(light.cosConeAngle));
+
+			ViewLight& viewLight = m_viewLights[i];
+			viewLight.center = vec3(view * vec4(vec3(bounds), 1));
+			viewLight.center.z = -viewLight.center.z;
+			viewLight.radius = bounds.w;
+
+			float minDepth = viewLight.center.z - viewLight.radius;
+			float maxDepth = viewLight.center.z + viewLight.radius;
+			if (maxDepth < m_nearDepth || minDepth > m_farDepth) {
+				viewLight.firstSlice = 0;
+				viewLight.lastSlice = -1;
+				continue;
+			}
+			viewLight.firstSlice = getSlice(minDepth);
+			viewLight.lastSlice = getSlice(maxDepth);
+		}
+	});
+
+	// Each slice only reads the lights and writes its own clusters
+	JobSystem::parallelFor(s_kNumSlices, 1, [this](size_t begin, size_t end) {
+		for (size_t slice = begin; slice < end; ++slice)
+			buildSlice(static_cast<int>(slice));
+	});
+
+	// Join the slices light lists, offsetting their clusters to match.
+	// Once the list is full, clusters are cut short to the lights that
+	// made it in.
+	const size_t kNumClustersPerSlice = s_kNumTilesX * s_kNumTilesY;
+	m_lightIndices.clear();
+	m_numTrimmedLightIndices = 0;
+	for (int slice = 0; slice < s_kNumSlices; ++slice) {
+		uint32_t sliceOffset = static_cast<uint32_t>(m_lightIndices.size());
+		const std::vector<uint32_t>& sliceIndices = m_slices[slice].lightIndices;
+		size_t numKept = std::min(sliceIndices.size(), m_maxLightIndices - m_lightIndices.size());
+		for (size_t i = 0; i < kNumClustersPerSlice; ++i) {
+			Cluster& cluster = m_clusters[slice * kNumClustersPerSlice + i];
+			if (cluster.firstLight + cluster.numLights > numKept)
+				cluster.numLights = static_cast<uint32_t>(numKept - std::min<size_t>(cluster.firstLight, numKept));
+			cluster.firstLight += sliceOffset;
+		}
+
+		m_lightIndices.insert(m_lightIndices.end(), sliceIndices.begin(), sliceIndices.begin() + numKept);
+		m_numTrimmedLightIndices += sliceIndices.size() - numKept;
+	}
+}
+
+size_t LightClusters::getClusterIndex(int tileX, int tileY, int slice)
+{
+	return (static_cast<size_t>(slice) * s_kNumTilesY + tileY) * s_kNumTilesX + tileX;
+}
+
+size_t LightClusters::findCluster(const vec3& viewPosition) const
+{
+	float depth = std::max(-viewPosition.z, m_nearDepth);
+	int tileX = tileFromNDC(viewPosition.x * m_xScale / depth, s_kNumTilesX);
+	int tileY = tileFromNDC(viewPosition.y * m_yScale / depth, s_kNumTilesY);
+	return getClusterIndex(tileX, tileY, getSlice(depth));
+}
+
+const std::vector<LightClusters::Cluster>& LightClusters::getClusters() const
+{
+	return m_clusters;
+}
+
+const std::vector<uint32_t>& LightClusters::getLightIndices() const
+{
+	return m_lightIndices;
+}
+
+size_t LightClusters::getNumTrimmedLightIndices() const
+{
+	return m_numTrimmedLightIndices;
+}
+
+float LightClusters::getDepthSliceScale() const
+{
+	return m_depthSliceScale;
+}
+
+float LightClusters::getDepthSliceBias() const
+{
+	return m_depthSliceBias;
+}
+
+int LightClusters::getSlice(float depth) const
+{
+	// Depths at or behind the camera are in the first slice
+	if (depth <= 0)
+		return 0;
+
+	float slice = std::floor(std::log(depth) * m_depthSliceScale + m_depthSliceBias);
+	return static_cast<int>(std::min(std::max(slice, 0.0f), static_cast<float>(s_kNumSlices - 1)));
+}
+
+float LightClusters::getSliceStart(int slice) const
+{
+	if (slice <= 0)
+		return m_nearDepth;
+	if (slice >= s_kNumSlices)
+		return m_farDepth;
+
+	return std::exp((slice - m_depthSliceBias) / m_depthSliceScale);
+}
+
+bool LightClusters::getTileRange(const ViewLight& light, float minDepth, float maxDepth, int& outMinX, int& outMaxX, int& outMinY, int& outMaxY) const
+{
+	// The projected edges of the sphere are furthest out where it is
+	// closest to the camera, on the side of the view it is on
+	vec3 minCorner = light.center - light.radius;
+	vec3 maxCorner = light.center + light.radius;
+	float minX = minCorner.x * m_xScale / (minCorner.x < 0 ? minDepth : maxDepth);
+	float maxX = maxCorner.x * m_xScale / (maxCorner.x > 0 ? minDepth : maxDepth);
+	float minY = minCorner.y * m_yScale / (minCorner.y < 0 ? minDepth : maxDepth);
+	float maxY = maxCorner.y * m_yScale / (maxCorner.y > 0 ? minDepth : maxDepth);
+	if (maxX < -1 || minX > 1 || maxY < -1 || minY > 1)
+		return false;
+
+	outMinX = tileFromNDC(minX, s_kNumTilesX);
+	outMaxX = tileFromNDC(maxX, s_kNumTilesX);
+	outMinY = tileFromNDC(minY, s_kNumTilesY);
+	outMaxY = tileFromNDC(maxY, s_kNumTilesY);
+	return true;
+}
+
+void LightClusters::buildSlice(int slice)
+{
+	const size_t kNumClustersPerSlice = s_kNumTilesX * s_kNumTilesY;
+	Slice& sliceLights = m_slices[slice];
+	sliceLights.entries.clear();
+
+	float sliceNear = getSliceStart(slice);
+	float sliceFar = getSliceStart(slice + 1);
+	for (size_t lightIdx = 0; lightIdx < m_viewLights.size(); ++lightIdx) {
+		const ViewLight& light = m_viewLights[lightIdx];
+		if (slice < light.firstSlice || slice > light.lastSlice)
+			continue;
+
+		// Only the part of the sphere within the slice can touch its
+		// clusters
+		float minDepth = std::max(sliceNear, light.center.z - light.radius);
+		float maxDepth = std::min(sliceFar, light.center.z + light.radius);
+		int minTileX, maxTileX, minTileY, maxTileY;
+		if (!getTileRange(light, minDepth, maxDepth, minTileX, maxTileX, minTileY, maxTileY))
+			continue;
+
+		// Test the sphere against the box around each clusters frustum
+		float radiusSquared = light.radius * light.radius;
+		float depthDistance = std::max(std::max(sliceNear - light.center.z, light.center.z - sliceFar), 0.0f);
+		for (int tileY = minTileY; tileY <= maxTileY; ++tileY) {
+			float tileBottom = -1 + 2.0f * tileY / s_kNumTilesY;
+			float tileTop = -1 + 2.0f * (tileY + 1) / s_kNumTilesY;
+			float boxMinY = std::min(tileBottom * sliceNear, tileBottom * sliceFar) / m_yScale;
+			float boxMaxY = std::max(tileTop * sliceNear, tileTop * sliceFar) / m_yScale;
+			float yDistance = std::max(std::max(boxMinY - light.center.y, light.center.y - boxMaxY), 0.0f);
+
+			for (int tileX = minTileX; tileX <= maxTileX; ++tileX) {
+				float tileLeft = -1 + 2.0f * tileX / s_kNumTilesX;
+				float tileRight = -1 + 2.0f * (tileX + 1) / s_kNumTilesX;
+				float boxMinX = std::min(tileLeft * sliceNear, tileLeft * sliceFar) / m_xScale;
+				float boxMaxX = std::max(tileRight * sliceNear, tileRight * sliceFar) / m_xScale;
+				float xDistance = std::max(std::max(boxMinX - light.center.x, light.center.x - boxMaxX), 0.0f);
+
+				if (xDistance * xDistance + yDistance * yDistance + depthDistance * depthDistance <= radiusSquared) {
+					uint32_t tile = static_cast<uint32_t>(tileY * s_kNumTilesX + tileX);
+					sliceLights.entries.emplace_back(tile, static_cast<uint32_t>(lightIdx));
+				}
+			}
+		}
+	}
+
+	// Counting sort the lights by tile, keeping them in light order
+	Cluster* clusters = &m_clusters[slice * kNumClustersPerSlice];
+	for (size_t i = 0; i < kNumClustersPerSlice; ++i)
+		clusters[i] = { 0, 0 };
+	for (const auto& entry : sliceLights.entries)
+		++clusters[entry.first].numLights;
+
+	uint32_t offset = 0;
+	for (size_t i = 0; i < kNumClustersPerSlice; ++i) {
+		clusters[i].firstLight = offset;
+		offset += clusters[i].numLights;
+	}
+
+	// The counts are rebuilt as the lights are placed
+	sliceLights.lightIndices.resize(sliceLights.entries.size());
+	for (size_t i = 0; i < kNumClustersPerSlice; ++i)
+		clusters[i].numLights = 0;
+	for (const auto& entry : sliceLights.entries) {
+		Cluster& cluster = clusters[entry.first];
+		sliceLights.lightIndices[cluster.firstLight + cluster.numLights++] = entry.second;
+	}
+}
@@ -0,0 +1,125 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Splits the view frustum into a grid of clusters and
+//                lists the lights that reach each one, so fragments
+//                only shade the lights near them.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <glm\glm.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// A light in world space.
+// Laid out as the three vec4 texels each light takes on the GPU.
+struct ClusterLight {
+	glm::vec3 position;
+	float range;
+	glm::vec3 color;
+	float cosConeAngle; // -1 for point lights
+	glm::vec3 direction;
+	float padding;
+};
+
+// The frustum is split into screen tiles, and each tile into slices
+// that get exponentially deeper away from the camera.
+// Every frame each light is bounded by a sphere, and added to the list
+// of every cluster the sphere touches. Slices are filled in parallel on
+// the job system.
+// No GL calls are made, so it can run on any thread.
+class LightClusters {
+public:
+	static const int s_kNumTilesX = 16;
+	static const int s_kNumTilesY = 9;
+	static const int s_kNumSlices = 24;
+	static const int s_kNumClusters = s_kNumTilesX * s_kNumTilesY * s_kNumSlices;
+	static const size_t s_kNoLimit = static_cast<size_t>(-1);
+
+	// The range of a clusters lights in the light index list
+	struct Cluster {
+		uint32_t firstLight;
+		uint32_t numLights;
+	};
+
+	// The light index list is kept to at most maxLightIndices, so it
+	// fits in a buffer of that size
+	LightClusters(size_t maxLightIndices = s_kNoLimit);
+
+	// Assigns the lights to the clusters of the frustum seen through the
+	// view and projection.
+	// The projection must be a symmetric perspective projection.
+	// The lights are only read during the build.
+	// If the light index list would be too long, the furthest slices
+	// clusters lose their lights first.
+	void build(const std::vector<ClusterLight>& lights, const glm::mat4& view, const glm::mat4& projection);
+
+	// Clusters are ordered by slice, then tile row, then tile column
+	static size_t getClusterIndex(int tileX, int tileY, int slice);
+
+	// Returns the cluster a view space position falls in, found the same
+	// way the shaders find it
+	size_t findCluster(const glm::vec3& viewPosition) const;
+
+	const std::vector<Cluster>& getClusters() const;
+	const std::vector<uint32_t>& getLightIndices() const;
+
+	// Returns how many light indices the last build left out to keep
+	// within the maximum
+	size_t getNumTrimmedLightIndices() const;
+
+	// The slice at a view depth is floor(log(depth) * scale + bias),
+	// clamped to the slices
+	float getDepthSliceScale() const;
+	float getDepthSliceBias() const;
+
+private:
+	// A lights bounding sphere in view space, with z flipped to be the
+	// depth in front of the camera
+	struct ViewLight {
+		glm::vec3 center;
+		float radius;
+		int firstSlice;
+		int lastSlice; // Less than the first slice if the light can't be seen
+	};
+
+	// The lights added to a slice, as (tile, light) pairs, and the light
+	// index list the slice builds from them
+	struct Slice {
+		std::vector<std::pair<uint32_t, uint32_t>> entries;
+		std::vector<uint32_t> lightIndices;
+	};
+
+	int getSlice(float depth) const;
+	float getSliceStart(int slice) const;
+
+	// Returns false if the sphere is outside the frustum between the
+	// depths, otherwise outputs the tiles the sphere may cover
+	bool getTileRange(const ViewLight&, float minDepth, float maxDepth, int& outMinX, int& outMaxX, int& outMinY, int& outMaxY) const;
+
+	// Fills one slices clusters, with indices local to the slice
+	void buildSlice(int slice);
+
+	float m_xScale;
+	float m_yScale;
+	float m_nearDepth;
+	float m_farDepth;
+	float m_depthSliceScale;
+	float m_depthSliceBias;
+	size_t m_maxLightIndices;
+	size_t m_numTrimmedLightIndices;
+	std::vector<ViewLight> m_viewLights;
+	std::vector<Slice> m_slices;
+	std::vector<Cluster> m_clusters;
+	std::vector<uint32_t> m_lightIndices;
+};
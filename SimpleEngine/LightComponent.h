@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm\glm.hpp>
+
+enum LightType {
+	LIGHT_POINT,
+	LIGHT_SPOT
+};
+
+// A light that shines on everything within its range.
+// Lights are positioned by their entities world matrix.
+struct LightComponent {
+	LightType type;
+	glm::vec3 color;
+	float range; // The light fades to nothing at this distance
+
+	// Spotlights only.
+	// The direction is in the entities local space, and the cone angle
+	// is in radians from the direction to the edge of the cone.
+	glm::vec3 direction;
+	float coneAngle;
+};
@@ -34,6 +34,7 @@ struct Material {
 	std::vector<Texture> heightMaps;
 	std::vector<Texture> displacementMaps;
 	bool willDrawDepth;
+	bool willBlend = false; // Alpha blended and drawn back to front after opaque materials
 	glm::vec3 debugColor;
 	float heightMapScale;
 };
\ No newline at end of file
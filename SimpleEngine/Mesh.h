@@ -15,20 +15,55 @@
 #pragma once
 
 #include <glad\glad.h>
+#include <glm\glm.hpp>
 
+#include <limits>
 #include <vector>
 
+// Bounding volumes of a meshes vertices, in the meshes local space.
+// Defaults to infinite bounds, which are never culled.
+struct MeshBounds {
+	glm::vec3 min{ -std::numeric_limits<float>::infinity() };
+	glm::vec3 max{ std::numeric_limits<float>::infinity() };
+	glm::vec3 center{ 0, 0, 0 };
+	float radius = std::numeric_limits<float>::infinity();
+};
+
+// A models triangles on the CPU, for occlusion culling.
+// Occluders only need to cover what the model hides, so they can be much
+// coarser than the models meshes.
+struct OccluderMesh {
+	std::vector<glm::vec3> positions; // In the models local space
+	std::vector<unsigned int> indices;
+};
+
+// A range of a meshes index buffer that draws one level of detail
+struct MeshLOD {
+	GLuint firstIndex;
+	GLsizei numIndices;
+};
+
 struct Mesh {
+	static const int s_kMaxLODs = 4;
+
 	unsigned int materialIndex;
 	GLuint VAO;
-	GLsizei numIndices;
+	GLsizei numIndices; // Of the full detail mesh, at the start of the index buffer
+	MeshBounds bounds;
+
+	// Levels of detail from the full mesh down to the coarsest, which
+	// share the vertex buffer.
+	// Meshes without any are always drawn at full detail.
+	MeshLOD lods[s_kMaxLODs];
+	int numLODs = 0;
 };
 
 // A tree structure of mesh nodes.
-// Mesh nodes only contain mesh ids and child nodes.
+// Mesh nodes only contain mesh ids, a transform and child nodes.
 // The actual meshes can be access by indexing into the
 // corosponding model components mesh array using the meshID.
 struct MeshNode {
+	glm::mat4 transform; // Relative to the parent node
 	std::vector<unsigned int> meshIDs;
 	std::vector<MeshNode> childNodes;
 };
\ No newline at end of file
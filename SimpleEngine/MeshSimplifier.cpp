@@ -0,0 +1,312 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+
+namespace {
+	// Stops a triangle flipping over, or becoming close to a sliver, when
+	// a vertex collapses
+	const double g_kMinNormalAlignment = 0.2;
+
+	// The sum of squared distances to a set of planes, as the upper half
+	// of a symmetric 4x4 matrix.
+	// Planes are weighted by the area of their triangle, and the total
+	// weight is kept so the error can be averaged.
+	struct Quadric {
+		double a2, ab, ac, ad;
+		double b2, bc, bd;
+		double c2, cd;
+		double d2;
+		double weight;
+	};
+
+	Quadric makePlaneQuadric(const glm::dvec3& normal, double distance, double weight)
+	{
+		double a = normal.x, b = normal.y, c = normal.z, d = distance;
+		return {
+			a * a * weight, a * b * weight, a * c * weight, a * d * weight,
+			b * b * weight, b * c * weight, b * d * weight,
+			c * c * weight, c * d * weight,
+			d * d * weight,
+			weight
+		};
+	}
+
+	void addQuadric(Quadric& quadric, const Quadric& other)
+	{
+		quadric.a2 += other.a2; quadric.ab += other.ab; quadric.ac += other.ac; quadric.ad += other.ad;
+		quadric.b2 += other.b2; quadric.bc += other.bc; quadric.bd += other.bd;
+		quadric.c2 += other.c2; quadric.cd += other.cd;
+		quadric.d2 += other.d2;
+		quadric.weight += other.weight;
+	}
+
+	// Returns the mean squared distance from the point to the planes
+	double getError(const Quadric& quadric, const glm::dvec3& p)
+	{
+		if (quadric.weight <= 0)
+			return 0;
+
+		double error = quadric.a2 * p.x * p.x + 2 * quadric.ab * p.x * p.y + 2 * quadric.ac * p.x * p.z + 2 * quadric.ad * p.x
+		             + quadric.b2 * p.y * p.y + 2 * quadric.bc * p.y * p.z + 2 * quadric.bd * p.y
+		             + quadric.c2 * p.z * p.z + 2 * quadric.cd * p.z
+		             + quadric.d2;
+		return std::max(error, 0.0) / quadric.weight;
+	}
+
+	struct Collapse {
+		double error;
+		uint32_t from;
+		uint32_t to;
+	};
+
+	uint64_t makeEdgeKey(uint32_t a, uint32_t b)
+	{
+		return a < b ? static_cast<uint64_t>(a) << 32 | b : static_cast<uint64_t>(b) << 32 | a;
+	}
+
+	// Returns true if moving a vertex from one position to another keeps
+	// every triangle around it facing the same way
+	bool isCollapseValid(uint32_t from, uint32_t to, const std::vector<uint32_t>& triangles, const std::vector<uint32_t>& adjacentTriangles,
+	                     const std::vector<glm::dvec3>& positions)
+	{
+		for (uint32_t triangleIdx : adjacentTriangles) {
+			const uint32_t* corners = &triangles[triangleIdx * 3];
+			if (corners[0] == to || corners[1] == to || corners[2] == to)
+				continue;
+
+			// Rotate the triangle so the moving vertex is first
+			int k = corners[0] == from ? 0 : (corners[1] == from ? 1 : 2);
+			const glm::dvec3& p1 = positions[corners[(k + 1) % 3]];
+			const glm::dvec3& p2 = positions[corners[(k + 2) % 3]];
+			glm::dvec3 normalBefore = glm::cross(p1 - positions[from], p2 - positions[from]);
+			glm::dvec3 normalAfter = glm::cross(p1 - positions[to], p2 - positions[to]);
+			double lengths = glm::length(normalBefore) * glm::length(normalAfter);
+			if (lengths <= 0 || glm::dot(normalBefore, normalAfter) < g_kMinNormalAlignment * lengths)
+				return false;
+		}
+		return true;
+	}
+}
+
+std::vector<unsigned int> MeshSimplifier::simplify(const std::vector<VertexFormat>& vertices, const std::vector<unsigned int>& indices,
+                                                   size_t targetNumIndices, float maxError, float* outError)
+{
+	if (outError)
+		*outError = 0;
+	if (indices.size() <= targetNumIndices || indices.size() % 3 != 0)
+		return indices;
+
+	// Weld vertices that share a position, each unique position is a
+	// point of the simplified surface
+	std::vector<uint32_t> sortedVertices(vertices.size());
+	std::iota(sortedVertices.begin(), sortedVertices.end(), 0);
+	auto isPositionLess = [&vertices](uint32_t lhs, uint32_t rhs) {
+		const glm::vec3& a = vertices[lhs].position;
+		const glm::vec3& b = vertices[rhs].position;
+		return a.x != b.x ? a.x < b.x : (a.y != b.y ? a.y < b.y : a.z < b.z);
+	};
+	std::sort(sortedVertices.begin(), sortedVertices.end(), isPositionLess);
+
+	std::vector<uint32_t> vertexPoints(vertices.size());  // Vertex -> welded point
+	std::vector<uint32_t> pointVertexOffsets;              // Point -> first of its vertices in sortedVertices
+	std::vector<glm::dvec3> positions;
+	for (size_t i = 0; i < sortedVertices.size(); ++i) {
+		if (i == 0 || isPositionLess(sortedVertices[i - 1], sortedVertices[i])) {
+			pointVertexOffsets.push_back(static_cast<uint32_t>(i));
+			positions.push_back(glm::dvec3(vertices[sortedVertices[i]].position));
+		}
+		vertexPoints[sortedVertices[i]] = static_cast<uint32_t>(positions.size() - 1);
+	}
+	pointVertexOffsets.push_back(static_cast<uint32_t>(sortedVertices.size()));
+	size_t numPoints = positions.size();
+
+	// Each triangle as welded points, skipping triangles that are
+	// degenerate once welded
+	size_t numTriangles = indices.size() / 3;
+	std::vector<uint32_t> triangles(indices.size());
+	std::vector<uint8_t> isTriangleAlive(numTriangles, 1);
+	size_t numAliveTriangles = 0;
+	std::vector<Quadric> quadrics(numPoints, Quadric{});
+	for (size_t i = 0; i < numTriangles; ++i) {
+		uint32_t a = triangles[i * 3] = vertexPoints[indices[i * 3]];
+		uint32_t b = triangles[i * 3 + 1] = vertexPoints[indices[i * 3 + 1]];
+		uint32_t c = triangles[i * 3 + 2] = vertexPoints[indices[i * 3 + 2]];
+		glm::dvec3 normal = glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
+		double doubleArea = glm::length(normal);
+		if (a == b || b == c || c == a || doubleArea <= 0) {
+			isTriangleAlive[i] = 0;
+			continue;
+		}
+		++numAliveTriangles;
+
+		normal /= doubleArea;
+		Quadric plane = makePlaneQuadric(normal, -glm::dot(normal, positions[a]), doubleArea * 0.5);
+		addQuadric(quadrics[a], plane);
+		addQuadric(quadrics[b], plane);
+		addQuadric(quadrics[c], plane);
+	}
+
+	// Lock the points on open borders and non manifold edges, which are
+	// used by other than two triangles
+	std::vector<uint64_t> edges;
+	for (size_t i = 0; i < numTriangles; ++i) {
+		if (!isTriangleAlive[i])
+			continue;
+		for (int k = 0; k < 3; ++k)
+			edges.push_back(makeEdgeKey(triangles[i * 3 + k], triangles[i * 3 + (k + 1) % 3]));
+	}
+	std::sort(edges.begin(), edges.end());
+
+	std::vector<uint8_t> isLocked(numPoints, 0);
+	for (size_t i = 0; i < edges.size();) {
+		size_t count = 1;
+		while (i + count < edges.size() && edges[i + count] == edges[i])
+			++count;
+		if (count != 2) {
+			isLocked[edges[i] >> 32] = 1;
+			isLocked[edges[i] & 0xFFFFFFFF] = 1;
+		}
+		i += count;
+	}
+
+	// Collapse in passes. Each pass collapses the cheapest edges first,
+	// and only touches each point once so the adjacency stays valid.
+	double maxSquaredError = static_cast<double>(maxError) * maxError;
+	double largestError = 0;
+	size_t targetNumTriangles = targetNumIndices / 3;
+	std::vector<uint32_t> adjacencyOffsets(numPoints + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<uint8_t> isTouched(numPoints);
+	std::vector<uint32_t> fillOffsets;
+	std::vector<uint32_t> pointAdjacency;
+	while (numAliveTriangles > targetNumTriangles) {
+		// Build the triangles around each point
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (size_t i = 0; i < numTriangles; ++i) {
+			if (isTriangleAlive[i]) {
+				for (int k = 0; k < 3; ++k)
+					++adjacencyOffsets[triangles[i * 3 + k] + 1];
+			}
+		}
+		std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+		adjacency.resize(adjacencyOffsets.back());
+		fillOffsets.assign(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < numTriangles; ++i) {
+			if (isTriangleAlive[i]) {
+				for (int k = 0; k < 3; ++k)
+					adjacency[fillOffsets[triangles[i * 3 + k]]++] = static_cast<uint32_t>(i);
+			}
+		}
+
+		// Find the cheapest direction to collapse each edge
+		edges.clear();
+		for (size_t i = 0; i < numTriangles; ++i) {
+			if (!isTriangleAlive[i])
+				continue;
+			for (int k = 0; k < 3; ++k)
+				edges.push_back(makeEdgeKey(triangles[i * 3 + k], triangles[i * 3 + (k + 1) % 3]));
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		collapses.clear();
+		for (uint64_t edge : edges) {
+			uint32_t a = static_cast<uint32_t>(edge >> 32);
+			uint32_t b = static_cast<uint32_t>(edge & 0xFFFFFFFF);
+			Quadric quadric = quadrics[a];
+			addQuadric(quadric, quadrics[b]);
+
+			Collapse collapse = { std::numeric_limits<double>::infinity(), 0, 0 };
+			if (!isLocked[a])
+				collapse = { getError(quadric, positions[b]), a, b };
+			if (!isLocked[b]) {
+				double error = getError(quadric, positions[a]);
+				if (error < collapse.error)
+					collapse = { error, b, a };
+			}
+			if (collapse.error <= maxSquaredError)
+				collapses.push_back(collapse);
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) {
+			return lhs.error < rhs.error;
+		});
+
+		std::fill(isTouched.begin(), isTouched.end(), 0);
+		size_t numCollapsed = 0;
+		for (const Collapse& collapse : collapses) {
+			if (numAliveTriangles <= targetNumTriangles)
+				break;
+			if (isTouched[collapse.from] || isTouched[collapse.to])
+				continue;
+
+			pointAdjacency.assign(adjacency.begin() + adjacencyOffsets[collapse.from], adjacency.begin() + adjacencyOffsets[collapse.from + 1]);
+			if (!isCollapseValid(collapse.from, collapse.to, triangles, pointAdjacency, positions))
+				continue;
+
+			// Move the triangles onto the point, removing the ones that
+			// shared the collapsed edge
+			for (uint32_t triangleIdx : pointAdjacency) {
+				uint32_t* corners = &triangles[triangleIdx * 3];
+				for (int k = 0; k < 3; ++k) {
+					isTouched[corners[k]] = 1;
+					if (corners[k] == collapse.from)
+						corners[k] = collapse.to;
+				}
+				if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0]) {
+					isTriangleAlive[triangleIdx] = 0;
+					--numAliveTriangles;
+				}
+			}
+			for (uint32_t i = adjacencyOffsets[collapse.to]; i < adjacencyOffsets[collapse.to + 1]; ++i) {
+				const uint32_t* corners = &triangles[adjacency[i] * 3];
+				for (int k = 0; k < 3; ++k)
+					isTouched[corners[k]] = 1;
+			}
+
+			addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+			largestError = std::max(largestError, collapse.error);
+			++numCollapsed;
+		}
+
+		if (numCollapsed == 0)
+			break;
+	}
+
+	// Pick a vertex for each corner of the remaining triangles, keeping
+	// the original vertex where its point didn't move
+	std::vector<unsigned int> simplified;
+	simplified.reserve(numAliveTriangles * 3);
+	for (size_t i = 0; i < numTriangles; ++i) {
+		if (!isTriangleAlive[i])
+			continue;
+
+		for (int k = 0; k < 3; ++k) {
+			uint32_t vertex = indices[i * 3 + k];
+			uint32_t point = triangles[i * 3 + k];
+			if (vertexPoints[vertex] != point) {
+				const VertexFormat& original = vertices[vertex];
+				float closestDifference = std::numeric_limits<float>::infinity();
+				for (uint32_t j = pointVertexOffsets[point]; j < pointVertexOffsets[point + 1]; ++j) {
+					const VertexFormat& candidate = vertices[sortedVertices[j]];
+					glm::vec3 normalOffset = candidate.normal - original.normal;
+					glm::vec2 texCoordOffset = candidate.texCoord - original.texCoord;
+					float difference = glm::dot(normalOffset, normalOffset) + glm::dot(texCoordOffset, texCoordOffset);
+					if (difference < closestDifference) {
+						closestDifference = difference;
+						vertex = sortedVertices[j];
+					}
+				}
+			}
+			simplified.push_back(vertex);
+		}
+	}
+
+	if (outError)
+		*outError = static_cast<float>(std::sqrt(largestError));
+	return simplified;
+}
@@ -0,0 +1,36 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Simplifies triangle meshes by quadric error edge
+//                collapse, for building levels of detail.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include "VertexFormat.h"
+
+#include <vector>
+
+// Vertices are only ever collapsed onto other vertices, so simplified
+// meshes index the same vertex buffer as the mesh they came from.
+// Vertices are welded by position first, so meshes whose faces don't
+// share vertices (i.e. flat shaded OBJ files) still simplify. Where a
+// vertex is collapsed onto a position with several vertices, the one
+// with the closest normal and texture coordinate is used.
+// Open borders are kept in place, so simplifying never opens holes.
+namespace MeshSimplifier {
+	// Collapses the edges that add the least error until at most
+	// targetNumIndices indices are left, or no edge can be collapsed
+	// without moving the surface by more than maxError.
+	// Returns the simplified triangle list, and sets outError to the
+	// largest error of any collapse, as an estimated distance.
+	std::vector<unsigned int> simplify(const std::vector<VertexFormat>& vertices, const std::vector<unsigned int>& indices,
+	                                   size_t targetNumIndices, float maxError, float* outError = nullptr);
+}
@@ -1,14 +1,57 @@
 #pragma once
 
+#include "BlockArena.h"
 #include "Mesh.h"
 #include "Material.h"
 
+#include <memory>
+#include <string>
 #include <vector>
 
+// The asset a models GPU data was built from.
+// Saved in scene snapshots so the model can be rebuilt on load.
+enum ModelAssetType {
+	MODEL_ASSET_NONE,
+	MODEL_ASSET_QUAD,
+	MODEL_ASSET_SPHERE,
+	MODEL_ASSET_CYLINDER,
+	MODEL_ASSET_PYRAMID,
+	MODEL_ASSET_CUBE,
+	MODEL_ASSET_FILE,    // Asset path is the model file
+	MODEL_ASSET_SKYBOX,  // Asset paths are the cube map faces
+	MODEL_ASSET_TERRAIN  // Rebuilt from the entities terrain component
+};
+
 struct ModelComponent {
+	// Models created by the scene keep their mesh and material arrays in
+	// the scenes component arena.
+	// Other models, and copies of scene models, use the heap.
+	explicit ModelComponent(BlockArena* arena = nullptr)
+		: meshes(ArenaAllocator<Mesh>(arena))
+		, materials(ArenaAllocator<Material>(arena))
+	{
+	}
+
 	// The root node of the models scene tree.
-	// Not currently used.
+	// Models with an empty tree (i.e. primitives) draw every mesh with
+	// the models transform.
 	MeshNode rootNode;
-	std::vector<Mesh> meshes;
-	std::vector<Material> materials;
+	ArenaVector<Mesh> meshes;
+	ArenaVector<Material> materials;
+
+	// Static models are drawn from shared GPU buffers with indirect multi
+	// draws, when supported.
+	// A static models meshes, materials and transform must not change.
+	bool isStatic = false;
+
+	// Occluders are rasterized into the occlusion buffer each frame, to
+	// cull the draws they hide.
+	// Only models that cover a lot of the screen, like the terrain, are
+	// worth making occluders. Models loaded from files and terrain share
+	// their occluder mesh between copies.
+	bool isOccluder = false;
+	std::shared_ptr<const OccluderMesh> occluder; // Null if the model has none
+
+	ModelAssetType assetType = MODEL_ASSET_NONE;
+	std::vector<std::string> assetPaths;
 };
\ No newline at end of file
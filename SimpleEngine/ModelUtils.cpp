@@ -5,6 +5,8 @@
 #include "VertexFormat.h"
 #include "Texture.h"
 #include "GLUtils.h"
+#include "MeshSimplifier.h"
+#include "Profiler.h"
 
 #include <assimp\Importer.hpp>
 #include <assimp\scene.h>
@@ -13,6 +15,15 @@
 #include "Log.h"
 #include <unordered_map>
 
+namespace {
+	// The furthest each level of detail can move the surface of a mesh,
+	// relative to the meshes bounding radius
+	const float g_kLODMaxErrors[Mesh::s_kMaxLODs - 1] = { 0.01f, 0.03f, 0.08f };
+
+	// Meshes with fewer indices aren't worth simplifying further
+	const size_t g_kMinLODIndices = 3 * 64;
+}
+
 // Checks all material textures of a given type and loads the textures if they're not loaded yet.
 // The required info is returned as a Texture struct.
 std::vector<Texture> loadMaterialTextures(const aiMaterial* mat, aiTextureType type, const std::string& textureDir)
@@ -158,8 +169,31 @@ Mesh processMesh(const aiMesh* _aiMesh, const aiScene* scene)
 
 	Mesh mesh;
 	mesh.materialIndex = _aiMesh->mMaterialIndex;
-	mesh.VAO = GLUtils::bufferMeshData(vertices, indices);
 	mesh.numIndices = static_cast<GLsizei>(indices.size());
+	mesh.bounds = GLUtils::calculateMeshBounds(vertices);
+
+	// Build each level of detail from the last with half its triangles,
+	// and append their indices after the full mesh
+	std::vector<GLuint> allIndices = indices;
+	mesh.lods[0] = { 0, mesh.numIndices };
+	mesh.numLODs = 1;
+	for (int lod = 1; lod < Mesh::s_kMaxLODs; ++lod) {
+		const std::vector<GLuint> lastIndices(allIndices.begin() + mesh.lods[lod - 1].firstIndex, allIndices.end());
+		if (lastIndices.size() / 2 < g_kMinLODIndices)
+			break;
+
+		float maxError = g_kLODMaxErrors[lod - 1] * mesh.bounds.radius;
+		std::vector<GLuint> lodIndices = MeshSimplifier::simplify(vertices, lastIndices, lastIndices.size() / 2, maxError);
+
+		// Stop once the mesh can't lose many more triangles
+		if (lodIndices.size() > lastIndices.size() * 3 / 4)
+			break;
+
+		mesh.lods[lod] = { static_cast<GLuint>(allIndices.size()), static_cast<GLsizei>(lodIndices.size()) };
+		mesh.numLODs = lod + 1;
+		allIndices.insert(allIndices.end(), lodIndices.begin(), lodIndices.end());
+	}
+	mesh.VAO = GLUtils::bufferMeshData(vertices, allIndices);
 
 	// Return a mesh object created from the extracted mesh data
 	return mesh;
@@ -168,6 +202,13 @@ Mesh processMesh(const aiMesh* _aiMesh, const aiScene* scene)
 // Processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
 void processNode(const aiNode* _aiNode, const aiScene* scene, MeshNode& outNode) 
 {
+	// Assimp matrices are row major
+	const aiMatrix4x4& nodeTransform = _aiNode->mTransformation;
+	for (int row = 0; row < 4; ++row) {
+		for (int col = 0; col < 4; ++col)
+			outNode.transform[col][row] = nodeTransform[row][col];
+	}
+
 	// Link each mesh located at the current node
 	for (GLuint i = 0; i < _aiNode->mNumMeshes; i++)
 	{
@@ -184,8 +225,36 @@ void processNode(const aiNode* _aiNode, const aiScene* scene, MeshNode& outNode)
 	}
 }
 
+// Flattens the meshes under a node into one occluder mesh in the models space
+void addNodeToOccluder(const MeshNode& node, const aiScene* scene, const glm::mat4& parentTransform, OccluderMesh& occluder)
+{
+	glm::mat4 transform = parentTransform * node.transform;
+	for (unsigned int meshID : node.meshIDs) {
+		const aiMesh* _aiMesh = scene->mMeshes[meshID];
+		unsigned int firstVertex = static_cast<unsigned int>(occluder.positions.size());
+		for (GLuint i = 0; i < _aiMesh->mNumVertices; ++i) {
+			const aiVector3D& position = _aiMesh->mVertices[i];
+			occluder.positions.push_back(glm::vec3(transform * glm::vec4(position.x, position.y, position.z, 1)));
+		}
+
+		// Points and lines are left in triangulated meshes, but hide nothing
+		for (GLuint i = 0; i < _aiMesh->mNumFaces; ++i) {
+			const aiFace& face = _aiMesh->mFaces[i];
+			if (face.mNumIndices != 3)
+				continue;
+			for (GLuint j = 0; j < 3; ++j)
+				occluder.indices.push_back(firstVertex + face.mIndices[j]);
+		}
+	}
+
+	for (const MeshNode& childNode : node.childNodes)
+		addNodeToOccluder(childNode, scene, transform, occluder);
+}
+
 ModelComponent ModelUtils::loadModel(const std::string& path)
 {
+	PROFILE_SCOPE_CATEGORY("ModelUtils::loadModel", "Assets");
+
 	static std::unordered_map<std::string, ModelComponent> s_modelsLoaded;	// Stores all the models loaded so far, optimization to make sure models aren't loaded more than once.
 
 	// A model with the same filepath has already been loaded, return a copy. (optimization)
@@ -193,6 +262,8 @@ ModelComponent ModelUtils::loadModel(const std::string& path)
 		return s_modelsLoaded.at(path);
 
 	ModelComponent model;
+	model.assetType = MODEL_ASSET_FILE;
+	model.assetPaths.push_back(path);
 
 	Assimp::Importer s_importer;
 	const aiScene* scene = s_importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
@@ -217,6 +288,11 @@ ModelComponent ModelUtils::loadModel(const std::string& path)
 	// Recursively construct the models scene graph hierachy
 	processNode(scene->mRootNode, scene, model.rootNode);
 
+	// Keep the triangles on the CPU in case the model is made an occluder
+	auto occluder = std::make_shared<OccluderMesh>();
+	addNodeToOccluder(model.rootNode, scene, glm::mat4(), *occluder);
+	model.occluder = occluder;
+
 	s_modelsLoaded.insert(std::make_pair(path, model));
 	return model;
 }
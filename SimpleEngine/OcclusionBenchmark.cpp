@@ -0,0 +1,192 @@
+#include "OcclusionBenchmark.h"
+
+#include "AABBTree.h"
+#include "Log.h"
+#include "Mesh.h"
+#include "OcclusionBuffer.h"
+
+#include <glm\gtc\matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+	using BenchClock = std::chrono::high_resolution_clock;
+
+	const int g_kNumHillCells = 64;     // Cells along each side of the heightfield
+	const float g_kLandscapeSize = 400;
+	const float g_kHillHeight = 20;
+	const int g_kNumWalls = 8;
+	const size_t g_kNumBoxes = 10000;
+	const int g_kNumRuns = 20;
+
+	double secondsSince(BenchClock::time_point start)
+	{
+		return std::chrono::duration<double>(BenchClock::now() - start).count();
+	}
+
+	// Returns the fastest of several runs, to skip runs that were
+	// interrupted
+	template <typename FuncT>
+	double timeBestOf(int numRuns, FuncT func)
+	{
+		double bestTime = 0;
+		for (int i = 0; i < numRuns; ++i) {
+			BenchClock::time_point start = BenchClock::now();
+			func();
+			double time = secondsSince(start);
+			if (i == 0 || time < bestTime)
+				bestTime = time;
+		}
+		return bestTime;
+	}
+
+	float getHillHeight(float x, float z)
+	{
+		return (std::sin(x * 0.05f) * std::cos(z * 0.04f) + 1) * 0.5f * g_kHillHeight;
+	}
+
+	OccluderMesh makeHills()
+	{
+		OccluderMesh hills;
+		float cellSize = g_kLandscapeSize / g_kNumHillCells;
+		for (int r = 0; r <= g_kNumHillCells; ++r) {
+			for (int c = 0; c <= g_kNumHillCells; ++c) {
+				float x = c * cellSize - g_kLandscapeSize / 2;
+				float z = r * cellSize - g_kLandscapeSize / 2;
+				hills.positions.push_back({ x, getHillHeight(x, z), z });
+			}
+		}
+
+		for (int r = 0; r < g_kNumHillCells; ++r) {
+			for (int c = 0; c < g_kNumHillCells; ++c) {
+				unsigned int topLeft = r * (g_kNumHillCells + 1) + c;
+				unsigned int bottomLeft = topLeft + g_kNumHillCells + 1;
+				hills.indices.insert(hills.indices.end(), { topLeft, bottomLeft, bottomLeft + 1, topLeft, bottomLeft + 1, topLeft + 1 });
+			}
+		}
+		return hills;
+	}
+
+	// A unit cube, scaled into walls by its transform
+	OccluderMesh makeCube()
+	{
+		OccluderMesh cube;
+		for (int i = 0; i < 8; ++i)
+			cube.positions.push_back({ (i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f });
+		cube.indices = {
+			0, 1, 3, 0, 3, 2,  4, 6, 7, 4, 7, 5,
+			0, 4, 5, 0, 5, 1,  2, 3, 7, 2, 7, 6,
+			0, 2, 6, 0, 6, 4,  1, 5, 7, 1, 7, 3
+		};
+		return cube;
+	}
+
+	const char* getKernelName(OcclusionBuffer::Kernel kernel)
+	{
+		switch (kernel) {
+		case OcclusionBuffer::KERNEL_SSE:
+			return "SSE";
+		case OcclusionBuffer::KERNEL_AVX2:
+			return "AVX2";
+		default:
+			return "Scalar";
+		}
+	}
+}
+
+void OcclusionBenchmark::run()
+{
+	g_log << "Occlusion buffer benchmark\n";
+
+	OccluderMesh hills = makeHills();
+	OccluderMesh cube = makeCube();
+	std::vector<glm::mat4> wallTransforms;
+	for (int i = 0; i < g_kNumWalls; ++i) {
+		glm::vec3 position((i - g_kNumWalls / 2) * 30.0f, g_kHillHeight, -60.0f - i * 10.0f);
+		wallTransforms.push_back(glm::scale(glm::translate(glm::mat4(), position), glm::vec3(20, 2 * g_kHillHeight, 2)));
+	}
+
+	// Look across the landscape from just above the hills
+	glm::mat4 view = glm::lookAt(glm::vec3(0, g_kHillHeight + 2, g_kLandscapeSize / 2), glm::vec3(0, g_kHillHeight, 0), glm::vec3(0, 1, 0));
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.01f, 10000.0f);
+	glm::mat4 viewProjection = projection * view;
+
+	OcclusionBuffer buffer;
+	auto addOccluders = [&]() {
+		buffer.begin(viewProjection);
+		buffer.addOccluder(hills, glm::mat4());
+		for (const glm::mat4& wallTransform : wallTransforms)
+			buffer.addOccluder(cube, wallTransform);
+	};
+
+	double binTime = timeBestOf(g_kNumRuns, addOccluders);
+	g_log << "  " << buffer.getWidth() << "x" << buffer.getHeight() << " buffer, " << hills.indices.size() / 3 + g_kNumWalls * 12
+	      << " occluder triangles, " << buffer.getTriangleCount() << " binned: transform, clip and bin " << binTime * 1000 << " ms\n";
+
+	// Rasterize with the scalar kernel first, to check the others against
+	buffer.setKernel(OcclusionBuffer::KERNEL_SCALAR);
+	addOccluders();
+	buffer.rasterize();
+	std::vector<float> expected;
+	for (int y = 0; y < buffer.getHeight(); ++y) {
+		for (int x = 0; x < buffer.getWidth(); ++x)
+			expected.push_back(buffer.getDepth(x, y));
+	}
+
+	double scalarTime = 0;
+	const OcclusionBuffer::Kernel kKernels[] = { OcclusionBuffer::KERNEL_SCALAR, OcclusionBuffer::KERNEL_SSE, OcclusionBuffer::KERNEL_AVX2 };
+	for (OcclusionBuffer::Kernel kernel : kKernels) {
+		if (!OcclusionBuffer::isKernelSupported(kernel)) {
+			g_log << "  " << getKernelName(kernel) << ": not supported\n";
+			continue;
+		}
+
+		// Binning is undone by begin, so time both and take binning off
+		buffer.setKernel(kernel);
+		double singleThreadTime = timeBestOf(g_kNumRuns, [&]() {
+			addOccluders();
+			for (size_t i = 0; i < buffer.getTileCount(); ++i)
+				buffer.rasterizeTile(i);
+		}) - binTime;
+		double jobsTime = timeBestOf(g_kNumRuns, [&]() {
+			addOccluders();
+			buffer.rasterize();
+		}) - binTime;
+		if (kernel == OcclusionBuffer::KERNEL_SCALAR)
+			scalarTime = singleThreadTime;
+
+		size_t numMismatched = 0;
+		for (int y = 0; y < buffer.getHeight(); ++y) {
+			for (int x = 0; x < buffer.getWidth(); ++x)
+				numMismatched += buffer.getDepth(x, y) != expected[y * buffer.getWidth() + x];
+		}
+
+		g_log << "  " << getKernelName(kernel) << ": " << singleThreadTime * 1000 << " ms on one thread ("
+		      << scalarTime / singleThreadTime << "x scalar), " << jobsTime * 1000 << " ms on the job system, "
+		      << numMismatched << " pixels differ from scalar\n";
+	}
+
+	// Scatter boxes over the landscape, sitting on the hills
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<float> positionDistribution(-g_kLandscapeSize / 2, g_kLandscapeSize / 2);
+	std::uniform_real_distribution<float> sizeDistribution(1, 4);
+	std::vector<AABB> boxes;
+	for (size_t i = 0; i < g_kNumBoxes; ++i) {
+		float x = positionDistribution(generator);
+		float z = positionDistribution(generator);
+		glm::vec3 min(x, getHillHeight(x, z), z);
+		boxes.push_back({ min, min + glm::vec3(sizeDistribution(generator)) });
+	}
+
+	size_t numVisible = 0;
+	double testTime = timeBestOf(g_kNumRuns, [&]() {
+		numVisible = 0;
+		for (const AABB& box : boxes)
+			numVisible += buffer.isVisible(box, glm::mat4());
+	});
+	g_log << "  " << g_kNumBoxes << " box tests: " << testTime / g_kNumBoxes * 1e9 << " ns per box, "
+	      << numVisible << " visible, " << g_kNumBoxes - numVisible << " occluded\n";
+}
@@ -0,0 +1,28 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Times the occlusion buffer kernels and box tests on a
+//                generated hilly landscape.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+// Rasterizes a heightfield of hills and a row of walls, seen from a low
+// camera, and times:
+//  - transforming, clipping and binning the occluders
+//  - rasterizing the tiles with each kernel, on one thread and on the
+//    job system, checking each kernel matches the scalar kernel
+//  - testing boxes scattered over the landscape against the buffer
+// The buffer makes no GL calls, so no window is needed.
+namespace OcclusionBenchmark {
+	// Results are written to the log.
+	// The job system should be initialized first.
+	void run();
+}
@@ -0,0 +1,457 @@
+#include "OcclusionBuffer.h"
+
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "TransformBatch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+// SSE2 is always available on x64 and is MSVCs default for x86
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define OCCLUSION_BUFFER_SSE
+#include <xmmintrin.h>
+#endif
+
+// MSVC allows AVX2 intrinsics without compiling the whole file for AVX2,
+// other compilers only allow them when the file targets AVX2
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__AVX2__)
+#define OCCLUSION_BUFFER_AVX2
+#include <immintrin.h>
+#endif
+
+const int OcclusionBuffer::s_kTileWidth;
+const int OcclusionBuffer::s_kTileHeight;
+const int OcclusionBuffer::s_kBlockSize;
+
+namespace {
+	// The near, left, right, bottom and top clip planes.
+	// A clip space vertex v is inside a plane if dot(plane, v) >= 0.
+	const glm::vec4 g_kClipPlanes[] = {
+		{ 0, 0, 1, 1 },
+		{ 1, 0, 0, 1 },
+		{ -1, 0, 0, 1 },
+		{ 0, 1, 0, 1 },
+		{ 0, -1, 0, 1 }
+	};
+	const size_t g_kNumClipPlanes = sizeof(g_kClipPlanes) / sizeof(g_kClipPlanes[0]);
+
+	// A triangle clipped by every plane gains at most one vertex per plane
+	const size_t g_kMaxClippedVertices = 3 + g_kNumClipPlanes;
+
+	unsigned int getOutcode(const glm::vec4& vertex)
+	{
+		unsigned int outcode = 0;
+		for (size_t i = 0; i < g_kNumClipPlanes; ++i) {
+			if (glm::dot(g_kClipPlanes[i], vertex) < 0)
+				outcode |= 1 << i;
+		}
+		return outcode;
+	}
+
+	// Clips a convex polygon against a plane.
+	// Returns the number of vertices written to outVertices.
+	size_t clipPolygon(const glm::vec4* vertices, size_t numVertices, const glm::vec4& plane, glm::vec4* outVertices)
+	{
+		size_t numOut = 0;
+		for (size_t i = 0; i < numVertices; ++i) {
+			const glm::vec4& current = vertices[i];
+			const glm::vec4& next = vertices[(i + 1) % numVertices];
+			float currentDistance = glm::dot(plane, current);
+			float nextDistance = glm::dot(plane, next);
+
+			if (currentDistance >= 0)
+				outVertices[numOut++] = current;
+			if ((currentDistance >= 0) != (nextDistance >= 0))
+				outVertices[numOut++] = glm::mix(current, next, currentDistance / (currentDistance - nextDistance));
+		}
+		return numOut;
+	}
+}
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+	: m_numTilesX{ (std::max(width, 1) + s_kTileWidth - 1) / s_kTileWidth }
+	, m_numTilesY{ (std::max(height, 1) + s_kTileHeight - 1) / s_kTileHeight }
+{
+	m_width = m_numTilesX * s_kTileWidth;
+	m_height = m_numTilesY * s_kTileHeight;
+	m_numBlocksX = m_width / s_kBlockSize;
+	m_depth.resize(m_width * m_height, 0.0f);
+	m_blockDepth.resize(m_numBlocksX * (m_height / s_kBlockSize), 0.0f);
+	m_tileBins.resize(m_numTilesX * m_numTilesY);
+
+	if (isKernelSupported(KERNEL_AVX2))
+		m_kernel = KERNEL_AVX2;
+	else if (isKernelSupported(KERNEL_SSE))
+		m_kernel = KERNEL_SSE;
+	else
+		m_kernel = KERNEL_SCALAR;
+}
+
+void OcclusionBuffer::begin(const glm::mat4& viewProjection)
+{
+	m_viewProjection = viewProjection;
+	std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+	std::fill(m_blockDepth.begin(), m_blockDepth.end(), 0.0f);
+	m_triangles.clear();
+	for (auto& tileBin : m_tileBins)
+		tileBin.clear();
+}
+
+void OcclusionBuffer::addOccluder(const OccluderMesh& occluder, const glm::mat4& transform)
+{
+	glm::mat4 modelViewProjection = m_viewProjection * transform;
+	m_clipVertices.resize(occluder.positions.size());
+	for (size_t i = 0; i < occluder.positions.size(); ++i)
+		m_clipVertices[i] = modelViewProjection * glm::vec4(occluder.positions[i], 1);
+
+	for (size_t i = 0; i + 2 < occluder.indices.size(); i += 3) {
+		glm::vec4 triangle[3] = {
+			m_clipVertices[occluder.indices[i]],
+			m_clipVertices[occluder.indices[i + 1]],
+			m_clipVertices[occluder.indices[i + 2]]
+		};
+		clipAndBin(triangle, 3);
+	}
+}
+
+void OcclusionBuffer::rasterizeTile(size_t tileIdx)
+{
+	int tileX = static_cast<int>(tileIdx % m_numTilesX) * s_kTileWidth;
+	int tileY = static_cast<int>(tileIdx / m_numTilesX) * s_kTileHeight;
+	int tileMaxX = tileX + s_kTileWidth - 1;
+	int tileMaxY = tileY + s_kTileHeight - 1;
+
+	for (uint32_t triangleIdx : m_tileBins[tileIdx]) {
+		const Triangle& triangle = m_triangles[triangleIdx];
+		int minX = std::max(triangle.minX, tileX);
+		int minY = std::max(triangle.minY, tileY);
+		int maxX = std::min(triangle.maxX, tileMaxX);
+		int maxY = std::min(triangle.maxY, tileMaxY);
+
+		switch (m_kernel) {
+		case KERNEL_AVX2:
+			rasterizeAVX2(triangle, minX, minY, maxX, maxY);
+			break;
+		case KERNEL_SSE:
+			rasterizeSSE(triangle, minX, minY, maxX, maxY);
+			break;
+		default:
+			rasterizeScalar(triangle, minX, minY, maxX, maxY);
+			break;
+		}
+	}
+
+	// Keep the furthest depth of each block in the tile
+	for (int blockY = tileY; blockY < tileY + s_kTileHeight; blockY += s_kBlockSize) {
+		for (int blockX = tileX; blockX < tileX + s_kTileWidth; blockX += s_kBlockSize) {
+			float furthestDepth = std::numeric_limits<float>::infinity();
+			for (int y = blockY; y < blockY + s_kBlockSize; ++y) {
+				const float* row = &m_depth[y * m_width];
+				for (int x = blockX; x < blockX + s_kBlockSize; ++x)
+					furthestDepth = std::min(furthestDepth, row[x]);
+			}
+			m_blockDepth[(blockY / s_kBlockSize) * m_numBlocksX + blockX / s_kBlockSize] = furthestDepth;
+		}
+	}
+}
+
+void OcclusionBuffer::rasterize()
+{
+	JobSystem::parallelFor(getTileCount(), 1, [this](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			rasterizeTile(i);
+	});
+}
+
+bool OcclusionBuffer::isVisible(const AABB& box, const glm::mat4& transform) const
+{
+	// Find the screen rectangle and closest depth of the boxes corners
+	glm::mat4 modelViewProjection = m_viewProjection * transform;
+	glm::vec2 screenMin(std::numeric_limits<float>::infinity());
+	glm::vec2 screenMax(-std::numeric_limits<float>::infinity());
+	float closestDepth = 0;
+	for (int i = 0; i < 8; ++i) {
+		glm::vec3 corner((i & 1) ? box.max.x : box.min.x,
+		                 (i & 2) ? box.max.y : box.min.y,
+		                 (i & 4) ? box.max.z : box.min.z);
+		glm::vec4 clip = modelViewProjection * glm::vec4(corner, 1);
+		if (clip.z < -clip.w)
+			return true;
+
+		float inverseW = 1 / clip.w;
+		glm::vec2 screen((clip.x * inverseW * 0.5f + 0.5f) * m_width, (clip.y * inverseW * 0.5f + 0.5f) * m_height);
+		screenMin = glm::min(screenMin, screen);
+		screenMax = glm::max(screenMax, screen);
+		closestDepth = std::max(closestDepth, inverseW);
+	}
+
+	// Boxes off the screen are left to frustum culling
+	if (screenMax.x < 0 || screenMax.y < 0 || screenMin.x >= m_width || screenMin.y >= m_height)
+		return true;
+
+	int minBlockX = std::max(0, static_cast<int>(screenMin.x)) / s_kBlockSize;
+	int minBlockY = std::max(0, static_cast<int>(screenMin.y)) / s_kBlockSize;
+	int maxBlockX = std::min(m_width - 1, static_cast<int>(screenMax.x)) / s_kBlockSize;
+	int maxBlockY = std::min(m_height - 1, static_cast<int>(screenMax.y)) / s_kBlockSize;
+	for (int blockY = minBlockY; blockY <= maxBlockY; ++blockY) {
+		const float* blockRow = &m_blockDepth[blockY * m_numBlocksX];
+		for (int blockX = minBlockX; blockX <= maxBlockX; ++blockX) {
+			if (closestDepth >= blockRow[blockX])
+				return true;
+		}
+	}
+
+	return false;
+}
+
+void OcclusionBuffer::setKernel(Kernel kernel)
+{
+	assert(isKernelSupported(kernel));
+	m_kernel = kernel;
+}
+
+bool OcclusionBuffer::isKernelSupported(Kernel kernel)
+{
+	switch (kernel) {
+	case KERNEL_SCALAR:
+		return true;
+	case KERNEL_SSE:
+#ifdef OCCLUSION_BUFFER_SSE
+		return true;
+#else
+		return false;
+#endif
+	case KERNEL_AVX2:
+#ifdef OCCLUSION_BUFFER_AVX2
+		return TransformBatch::isAVX2Supported();
+#else
+		return false;
+#endif
+	default:
+		return false;
+	}
+}
+
+int OcclusionBuffer::getWidth() const
+{
+	return m_width;
+}
+
+int OcclusionBuffer::getHeight() const
+{
+	return m_height;
+}
+
+size_t OcclusionBuffer::getTileCount() const
+{
+	return m_tileBins.size();
+}
+
+size_t OcclusionBuffer::getTriangleCount() const
+{
+	return m_triangles.size();
+}
+
+float OcclusionBuffer::getDepth(int x, int y) const
+{
+	return m_depth[y * m_width + x];
+}
+
+void OcclusionBuffer::clipAndBin(const glm::vec4* vertices, size_t numVertices)
+{
+	unsigned int outcodeAnd = ~0u;
+	unsigned int outcodeOr = 0;
+	for (size_t i = 0; i < numVertices; ++i) {
+		unsigned int outcode = getOutcode(vertices[i]);
+		outcodeAnd &= outcode;
+		outcodeOr |= outcode;
+	}
+
+	// Entirely outside one of the planes
+	if (outcodeAnd != 0)
+		return;
+
+	// Only clip against the planes the triangle crosses
+	glm::vec4 polygons[2][g_kMaxClippedVertices];
+	std::copy(vertices, vertices + numVertices, polygons[0]);
+	size_t numPolygonVertices = numVertices;
+	int current = 0;
+	for (size_t i = 0; i < g_kNumClipPlanes && numPolygonVertices >= 3; ++i) {
+		if (outcodeOr & (1 << i)) {
+			numPolygonVertices = clipPolygon(polygons[current], numPolygonVertices, g_kClipPlanes[i], polygons[1 - current]);
+			current = 1 - current;
+		}
+	}
+	if (numPolygonVertices < 3)
+		return;
+
+	// Project to the screen, then bin the polygon as a fan of triangles
+	glm::vec2 screen[g_kMaxClippedVertices];
+	float depths[g_kMaxClippedVertices];
+	for (size_t i = 0; i < numPolygonVertices; ++i) {
+		const glm::vec4& clip = polygons[current][i];
+		float inverseW = 1 / clip.w;
+		screen[i] = { (clip.x * inverseW * 0.5f + 0.5f) * m_width, (clip.y * inverseW * 0.5f + 0.5f) * m_height };
+		depths[i] = inverseW;
+	}
+
+	for (size_t i = 1; i + 1 < numPolygonVertices; ++i) {
+		glm::vec2 triangleScreen[3] = { screen[0], screen[i], screen[i + 1] };
+		float triangleDepths[3] = { depths[0], depths[i], depths[i + 1] };
+		bin(triangleScreen, triangleDepths);
+	}
+}
+
+void OcclusionBuffer::bin(const glm::vec2* screen, const float* depths)
+{
+	// Wind the triangle counter clockwise, so the edge functions are
+	// positive inside it
+	int v1 = 1;
+	int v2 = 2;
+	float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+	if (area < 0) {
+		std::swap(v1, v2);
+		area = -area;
+	}
+	if (!(area > 0))
+		return;
+
+	const glm::vec2& p0 = screen[0];
+	const glm::vec2& p1 = screen[v1];
+	const glm::vec2& p2 = screen[v2];
+
+	Triangle triangle;
+	const glm::vec2* edges[3][2] = { { &p0, &p1 }, { &p1, &p2 }, { &p2, &p0 } };
+	for (int i = 0; i < 3; ++i) {
+		const glm::vec2& a = *edges[i][0];
+		const glm::vec2& b = *edges[i][1];
+		triangle.edgeA[i] = a.y - b.y;
+		triangle.edgeB[i] = b.x - a.x;
+		triangle.edgeC[i] = -(triangle.edgeA[i] * a.x + triangle.edgeB[i] * a.y);
+	}
+
+	float depth0 = depths[0];
+	float depth1 = depths[v1] - depth0;
+	float depth2 = depths[v2] - depth0;
+	triangle.depthA = (depth1 * (p2.y - p0.y) - depth2 * (p1.y - p0.y)) / area;
+	triangle.depthB = (depth2 * (p1.x - p0.x) - depth1 * (p2.x - p0.x)) / area;
+	triangle.depthC = depth0 - triangle.depthA * p0.x - triangle.depthB * p0.y;
+
+	// Pixels are sampled at their centres
+	glm::vec2 screenMin = glm::min(p0, glm::min(p1, p2));
+	glm::vec2 screenMax = glm::max(p0, glm::max(p1, p2));
+	triangle.minX = std::max(0, static_cast<int>(std::floor(screenMin.x)));
+	triangle.minY = std::max(0, static_cast<int>(std::floor(screenMin.y)));
+	triangle.maxX = std::min(m_width - 1, static_cast<int>(std::floor(screenMax.x)));
+	triangle.maxY = std::min(m_height - 1, static_cast<int>(std::floor(screenMax.y)));
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		return;
+
+	uint32_t triangleIdx = static_cast<uint32_t>(m_triangles.size());
+	m_triangles.push_back(triangle);
+	for (int tileY = triangle.minY / s_kTileHeight; tileY <= triangle.maxY / s_kTileHeight; ++tileY) {
+		for (int tileX = triangle.minX / s_kTileWidth; tileX <= triangle.maxX / s_kTileWidth; ++tileX)
+			m_tileBins[tileY * m_numTilesX + tileX].push_back(triangleIdx);
+	}
+}
+
+void OcclusionBuffer::rasterizeScalar(const Triangle& triangle, int minX, int minY, int maxX, int maxY)
+{
+	for (int y = minY; y <= maxY; ++y) {
+		float pixelY = y + 0.5f;
+		float rowEdges[3];
+		for (int i = 0; i < 3; ++i)
+			rowEdges[i] = triangle.edgeB[i] * pixelY + triangle.edgeC[i];
+		float rowDepth = triangle.depthB * pixelY + triangle.depthC;
+
+		float* row = &m_depth[y * m_width];
+		for (int x = minX; x <= maxX; ++x) {
+			float pixelX = x + 0.5f;
+			if (triangle.edgeA[0] * pixelX + rowEdges[0] >= 0
+			 && triangle.edgeA[1] * pixelX + rowEdges[1] >= 0
+			 && triangle.edgeA[2] * pixelX + rowEdges[2] >= 0)
+				row[x] = std::max(row[x], triangle.depthA * pixelX + rowDepth);
+		}
+	}
+}
+
+// The SIMD kernels start at the group of pixels containing minX.
+// Tiles are a whole number of groups wide, so groups never cross into
+// another tile, and the pixels outside the triangle fail the edge tests.
+// Pixels outside the triangle get a depth of 0, which never replaces the
+// current depth.
+
+void OcclusionBuffer::rasterizeSSE(const Triangle& triangle, int minX, int minY, int maxX, int maxY)
+{
+#ifdef OCCLUSION_BUFFER_SSE
+	const __m128 kZero = _mm_setzero_ps();
+	const __m128 kPixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	__m128 edgeA[3];
+	for (int i = 0; i < 3; ++i)
+		edgeA[i] = _mm_set1_ps(triangle.edgeA[i]);
+	__m128 depthA = _mm_set1_ps(triangle.depthA);
+
+	int startX = minX & ~3;
+	for (int y = minY; y <= maxY; ++y) {
+		float pixelY = y + 0.5f;
+		__m128 rowEdges[3];
+		for (int i = 0; i < 3; ++i)
+			rowEdges[i] = _mm_set1_ps(triangle.edgeB[i] * pixelY + triangle.edgeC[i]);
+		__m128 rowDepth = _mm_set1_ps(triangle.depthB * pixelY + triangle.depthC);
+
+		float* row = &m_depth[y * m_width];
+		for (int x = startX; x <= maxX; x += 4) {
+			__m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), kPixelOffsets);
+			__m128 isInside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], pixelX), rowEdges[0]), kZero);
+			isInside = _mm_and_ps(isInside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], pixelX), rowEdges[1]), kZero));
+			isInside = _mm_and_ps(isInside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], pixelX), rowEdges[2]), kZero));
+			if (_mm_movemask_ps(isInside) == 0)
+				continue;
+
+			__m128 depth = _mm_and_ps(isInside, _mm_add_ps(_mm_mul_ps(depthA, pixelX), rowDepth));
+			_mm_storeu_ps(row + x, _mm_max_ps(_mm_loadu_ps(row + x), depth));
+		}
+	}
+#else
+	assert(false);
+#endif
+}
+
+void OcclusionBuffer::rasterizeAVX2(const Triangle& triangle, int minX, int minY, int maxX, int maxY)
+{
+#ifdef OCCLUSION_BUFFER_AVX2
+	const __m256 kZero = _mm256_setzero_ps();
+	const __m256 kPixelOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+	__m256 edgeA[3];
+	for (int i = 0; i < 3; ++i)
+		edgeA[i] = _mm256_set1_ps(triangle.edgeA[i]);
+	__m256 depthA = _mm256_set1_ps(triangle.depthA);
+
+	int startX = minX & ~7;
+	for (int y = minY; y <= maxY; ++y) {
+		float pixelY = y + 0.5f;
+		__m256 rowEdges[3];
+		for (int i = 0; i < 3; ++i)
+			rowEdges[i] = _mm256_set1_ps(triangle.edgeB[i] * pixelY + triangle.edgeC[i]);
+		__m256 rowDepth = _mm256_set1_ps(triangle.depthB * pixelY + triangle.depthC);
+
+		float* row = &m_depth[y * m_width];
+		for (int x = startX; x <= maxX; x += 8) {
+			__m256 pixelX = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), kPixelOffsets);
+			__m256 isInside = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA[0], pixelX), rowEdges[0]), kZero, _CMP_GE_OQ);
+			isInside = _mm256_and_ps(isInside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA[1], pixelX), rowEdges[1]), kZero, _CMP_GE_OQ));
+			isInside = _mm256_and_ps(isInside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA[2], pixelX), rowEdges[2]), kZero, _CMP_GE_OQ));
+			if (_mm256_movemask_ps(isInside) == 0)
+				continue;
+
+			__m256 depth = _mm256_and_ps(isInside, _mm256_add_ps(_mm256_mul_ps(depthA, pixelX), rowDepth));
+			_mm256_storeu_ps(row + x, _mm256_max_ps(_mm256_loadu_ps(row + x), depth));
+		}
+	}
+#else
+	assert(false);
+#endif
+}
@@ -0,0 +1,117 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : A low resolution depth buffer rasterized on the CPU
+//                from occluder meshes, for culling hidden draws.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include "AABBTree.h"
+
+#include <glm\glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct OccluderMesh;
+
+// Each frame the occluders are transformed, clipped and binned into
+// screen tiles, then each tile is rasterized on its own, so tiles can be
+// rasterized in parallel.
+// The buffer stores 1 / w rather than z / w, since it is linear in
+// screen space and keeps its precision far from the camera. Larger
+// values are closer, and the buffer is cleared to 0.
+// Each tile keeps the furthest depth of every 8x8 block of pixels, so
+// bounding boxes are only tested against a few blocks.
+// No GL calls are made, so it can run on any thread.
+class OcclusionBuffer {
+public:
+	enum Kernel {
+		KERNEL_SCALAR,
+		KERNEL_SSE,  // 4 pixels at a time
+		KERNEL_AVX2  // 8 pixels at a time
+	};
+
+	static const int s_kTileWidth = 64;
+	static const int s_kTileHeight = 32;
+	static const int s_kBlockSize = 8;
+
+	// The size is rounded up to whole tiles
+	OcclusionBuffer(int width = 256, int height = 128);
+
+	// Clears the buffer and the binned occluders, ready for a new frame
+	// seen through the view projection
+	void begin(const glm::mat4& viewProjection);
+
+	// Transforms, clips and bins an occluders triangles.
+	// Triangles are rasterized from both sides, since occluders like the
+	// terrain aren't closed.
+	// Must not be called while tiles are being rasterized.
+	void addOccluder(const OccluderMesh&, const glm::mat4& transform);
+
+	// Rasterizes the triangles binned to one tile and builds its blocks.
+	// Different tiles can be rasterized at the same time.
+	void rasterizeTile(size_t tileIdx);
+
+	// Rasterizes every tile in parallel on the job system
+	void rasterize();
+
+	// Returns false if the box, transformed by transform, is entirely
+	// behind the rasterized occluders.
+	// Boxes that cross the near plane are always visible.
+	bool isVisible(const AABB& box, const glm::mat4& transform) const;
+
+	// Sets the kernel used to rasterize tiles.
+	// Defaults to the fastest the CPU supports.
+	void setKernel(Kernel);
+	static bool isKernelSupported(Kernel);
+
+	int getWidth() const;
+	int getHeight() const;
+	size_t getTileCount() const;
+	size_t getTriangleCount() const;
+
+	// Returns the rasterized depth of a pixel
+	float getDepth(int x, int y) const;
+
+private:
+	// A screen space triangle, ready for rasterizing.
+	// Each edge function is edgeA * x + edgeB * y + edgeC, and is
+	// positive inside the triangle, depth is found the same way.
+	struct Triangle {
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		float depthA;
+		float depthB;
+		float depthC;
+		int minX, minY, maxX, maxY; // Pixels covered, inclusive
+	};
+
+	void clipAndBin(const glm::vec4* vertices, size_t numVertices);
+	void bin(const glm::vec2* screen, const float* depths);
+	void rasterizeScalar(const Triangle&, int minX, int minY, int maxX, int maxY);
+	void rasterizeSSE(const Triangle&, int minX, int minY, int maxX, int maxY);
+	void rasterizeAVX2(const Triangle&, int minX, int minY, int maxX, int maxY);
+
+	int m_width;
+	int m_height;
+	int m_numTilesX;
+	int m_numTilesY;
+	int m_numBlocksX;
+	Kernel m_kernel;
+	glm::mat4 m_viewProjection;
+	std::vector<float> m_depth;                   // Row major
+	std::vector<float> m_blockDepth;              // The furthest depth in each block
+	std::vector<Triangle> m_triangles;
+	std::vector<std::vector<uint32_t>> m_tileBins; // Tile -> triangles that overlap it
+	std::vector<glm::vec4> m_clipVertices;         // Scratch for the occluder being added
+};
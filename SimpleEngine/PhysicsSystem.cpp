@@ -3,22 +3,25 @@
 #include "PhysicsSystem.h"
 
 #include "Clock.h"
+#include "Scene.h"
 
 PhysicsSystem::PhysicsSystem(Scene& scene)
 	: System{ scene }
 {
+	setComponentAccess(0, COMPONENT_PHYSICS | COMPONENT_TRANSFORM);
+	setRequiresMainThread(false);
 }
 
-void PhysicsSystem::update(Entity& entity)
+void PhysicsSystem::update()
 {
-	if (!entity.hasComponents(COMPONENT_PHYSICS, COMPONENT_TRANSFORM))
-		return;
+	float deltaTime = Clock::getDeltaTime();
+	m_scene.view<PhysicsComponent, TransformComponent>().parallelEach([deltaTime](PhysicsComponent& physics, TransformComponent& transform) {
+		float defaultDrag = 0.1f;
+		physics.velocity += (physics.acceleration - physics.velocity * defaultDrag) * deltaTime;
+		transform.position += physics.velocity * deltaTime;
 
-	float defaultDrag = 0.1f;
-	entity.physics.velocity += (entity.physics.acceleration - entity.physics.velocity * defaultDrag) * Clock::getDeltaTime();
-	entity.transform.position += entity.physics.velocity * Clock::getDeltaTime();
-
-	entity.physics.acceleration = { 0, 0, 0 };
+		physics.acceleration = { 0, 0, 0 };
+	});
 
 	//RenderSystem::drawDebugArrow(entity.lookAt[3], entity.physics.velocity, glm::length(entity.physics.velocity), { 0, 1, 0 });
 	//RenderSystem::drawDebugArrow(glm::vec3(entity.lookAt[3]) + entity.physics.velocity, entity.physics.acceleration, glm::length(entity.physics.acceleration));
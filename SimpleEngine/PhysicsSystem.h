@@ -9,7 +9,9 @@ class PhysicsSystem : public System {
 public:
 	PhysicsSystem(Scene&);
 
-	void update(Entity&) override;
+	// Integrates the velocity and position of all entities with
+	// physics and transform components.
+	void update() override;
 
 	void beginFrame() override {};
 	void endFrame() override {};
@@ -6,12 +6,14 @@
 #include "Clock.h"
 #include "PrimitivePrefabs.h"
 
-#include <iostream>
-
 PickupSystem::PickupSystem(Scene& scene, std::vector<Entity*>& playerList)
-	: System{ scene }
+	: System{ scene, COMPONENT_PICKUP | COMPONENT_TRANSFORM }
 	, m_playerList{playerList}
 {
+	// Tails are spawned through the command buffer, so this system
+	// doesn't change the scenes structure during its update.
+	setComponentAccess(COMPONENT_TRANSFORM, COMPONENT_PICKUP | COMPONENT_TRANSFORM | COMPONENT_PLAYERSTATS);
+	setRequiresMainThread(false);
 }
 
 void PickupSystem::update(Entity& entity)
@@ -19,37 +21,40 @@ void PickupSystem::update(Entity& entity)
 	if (!entity.hasComponents(COMPONENT_PICKUP, COMPONENT_TRANSFORM))
 		return;
 	// The pick up can be picked up
-	if (entity.pickup.isActive)
+	if (entity.pickup().isActive)
 	{
-		entity.transform.eulerAngles.y += 2 * Clock::getDeltaTime();
+		entity.transform().rotation = glm::angleAxis(2 * Clock::getDeltaTime(), glm::vec3{ 0, 1, 0 }) * entity.transform().rotation;
 
 		// Checks if a player and the pickup collide
 		for (int i = 0; i < m_playerList.size(); ++i)
 		{
 
-			if (m_playerList[i]->transform.position.x >= entity.transform.position.x - 2 && m_playerList[i]->transform.position.x <= entity.transform.position.x + 2)
+			if (m_playerList[i]->transform().position.x >= entity.transform().position.x - 2 && m_playerList[i]->transform().position.x <= entity.transform().position.x + 2)
 			{
-				if (m_playerList[i]->transform.position.z >= entity.transform.position.z - 2 && m_playerList[i]->transform.position.z <= entity.transform.position.z + 2)
+				if (m_playerList[i]->transform().position.z >= entity.transform().position.z - 2 && m_playerList[i]->transform().position.z <= entity.transform().position.z + 2)
 				{
-					m_playerList[i]->playerStats.numOfTails += 1;
-					entity.pickup.isActive = false;
-					entity.pickup.respawnTimeStamp = glfwGetTime();
+					m_playerList[i]->playerStats().numOfTails += 1;
+					entity.pickup().isActive = false;
+					entity.pickup().respawnTimeStamp = glfwGetTime();
 
-					// Spawn a tail for the player
+					// Spawn a tail for the player once the update has finished
 					TransformComponent snakeTailTransform{};
-					Entity& snakeTail = Prefabs::createCube(m_scene, snakeTailTransform);
-					snakeTail.transform.position = m_playerList[i]->transform.position;
-					snakeTail.addComponents(COMPONENT_SNAKETAIL, COMPONENT_PHYSICS);
-					snakeTail.snakeTail.entityToFollow = m_playerList[i];
-					if(snakeTail.snakeTail.entityToFollow != NULL)
-						std::cout << snakeTail.snakeTail.entityToFollow;
+					snakeTailTransform.position = m_playerList[i]->transform().position;
+					EntityHandle player = m_playerList[i]->getHandle();
+					EntityCommandBuffer& commands = m_scene.getCommandBuffer();
+					CommandEntity snakeTail = commands.createEntity(COMPONENT_MODEL | COMPONENT_TRANSFORM | COMPONENT_SNAKETAIL
+					                                                | COMPONENT_PHYSICS | COMPONENT_VEHICLE_MOVEMENT);
+					commands.initialize(snakeTail, [snakeTailTransform, player](Entity& entity) {
+						Prefabs::initCube(entity, snakeTailTransform);
+						entity.snakeTail().entityToFollow = player;
+					});
 				}
 			}
 		}
 	}
 	// The pick up is respawning
-	else if (glfwGetTime() >=  entity.pickup.respawnTimeStamp + entity.pickup.respawnTimeOffset)
+	else if (glfwGetTime() >=  entity.pickup().respawnTimeStamp + entity.pickup().respawnTimeOffset)
 	{
-		entity.pickup.isActive = true;
+		entity.pickup().isActive = true;
 	}
 }
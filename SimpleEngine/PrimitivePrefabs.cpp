@@ -25,16 +25,16 @@ namespace Prefabs {
 	{
 		Entity& entity = scene.createEntity(COMPONENT_MODEL | COMPONENT_TRANSFORM);
 
-		entity.transform = transform;
+		entity.transform() = transform;
 
 
-		entity.model = GLPrimitives::getQuadModel();
-		entity.model.materials.at(0).shaderParams.glossiness = 0.0f;
-		entity.model.materials.at(0).shaderParams.metallicness = 0.0f;
-		entity.model.materials.at(0).shaderParams.specBias = 0;
+		entity.model() = GLPrimitives::getQuadModel();
+		entity.model().materials.at(0).shaderParams.glossiness = 0.0f;
+		entity.model().materials.at(0).shaderParams.metallicness = 0.0f;
+		entity.model().materials.at(0).shaderParams.specBias = 0;
 
 		// Replace default texture
-		entity.model.materials.at(0).colorMaps.at(0) = GLUtils::loadTexture("Assets/Textures/dessert-floor.png");
+		entity.model().materials.at(0).colorMaps.at(0) = GLUtils::loadTexture("Assets/Textures/dessert-floor.png");
 
 		return entity;
 	}
@@ -43,9 +43,9 @@ namespace Prefabs {
 	{
 		Entity& entity = scene.createEntity(COMPONENT_MODEL | COMPONENT_TRANSFORM);
 
-		entity.transform = transform;
+		entity.transform() = transform;
 
-		entity.model = GLPrimitives::getSphereModel();
+		entity.model() = GLPrimitives::getSphereModel();
 
 		return entity;
 	}
@@ -54,12 +54,12 @@ namespace Prefabs {
 	{
 		Entity& entity = scene.createEntity(COMPONENT_MODEL | COMPONENT_TRANSFORM);
 
-		entity.transform = transform;
-		entity.transform.scale.x *= radius;
-		entity.transform.scale.y *= height;
-		entity.transform.scale.z *= radius;
+		entity.transform() = transform;
+		entity.transform().scale.x *= radius;
+		entity.transform().scale.y *= height;
+		entity.transform().scale.z *= radius;
 
-		entity.model = GLPrimitives::getCylinderModel();
+		entity.model() = GLPrimitives::getCylinderModel();
 
 		return entity;
 	}
@@ -68,9 +68,9 @@ namespace Prefabs {
 	{
 		Entity& entity = scene.createEntity(COMPONENT_MODEL | COMPONENT_TRANSFORM);
 
-		entity.transform = transform;
+		entity.transform() = transform;
 
-		entity.model = GLPrimitives::getPyramidModel();
+		entity.model() = GLPrimitives::getPyramidModel();
 
 		return entity;
 	}
@@ -79,18 +79,23 @@ namespace Prefabs {
 	{
 		Entity& entity = scene.createEntity(COMPONENT_MODEL | COMPONENT_TRANSFORM);
 
-		entity.transform = transform;
-
-		entity.model = GLPrimitives::getCubeModel();
+		initCube(entity, transform);
 
 		return entity;
 	}
 
+	void initCube(Entity& entity, const TransformComponent& transform)
+	{
+		entity.transform() = transform;
+
+		entity.model() = GLPrimitives::getCubeModel();
+	}
+
 	Entity& createCamera(Scene& scene, const glm::vec3& pos, const glm::vec3& center, const glm::vec3& up)
 	{
 		Entity& entity = scene.createEntity(COMPONENT_CAMERA, COMPONENT_TRANSFORM);
 
-		entity.camera.setLookAt(pos, center, up);
+		entity.camera().setLookAt(pos, center, up);
 
 		return entity;
 	}
@@ -99,24 +104,63 @@ namespace Prefabs {
 	{
 		Entity& entity = scene.createEntity(COMPONENT_MODEL);
 
-		entity.model = GLPrimitives::getCubeModel();
-
-		// Replace default material
-		entity.model.materials.at(0) = {};
-		entity.model.materials.at(0).shader = &GLUtils::getSkyboxShader();
-		entity.model.materials.at(0).colorMaps.push_back(GLUtils::loadCubeMapFaces(faceFilenames));
-		entity.model.materials.at(0).willDrawDepth = false;
+		initSkybox(entity, faceFilenames);
 
 		return entity;
 	}
 
+	void initSkybox(Entity& entity, const std::vector<std::string>& faceFilenames)
+	{
+		entity.model() = GLPrimitives::getCubeModel();
+		entity.model().assetType = MODEL_ASSET_SKYBOX;
+		entity.model().assetPaths = faceFilenames;
+
+		// Replace default material
+		entity.model().materials.at(0) = {};
+		entity.model().materials.at(0).shader = &GLUtils::getSkyboxShader();
+		entity.model().materials.at(0).colorMaps.push_back(GLUtils::loadCubeMapFaces(faceFilenames));
+		entity.model().materials.at(0).willDrawDepth = false;
+	}
+
 	Entity& createModel(Scene& scene, const std::string& path, const TransformComponent& transform)
 	{
 		Entity& entity = scene.createEntity(COMPONENT_MODEL | COMPONENT_TRANSFORM);
 
-		entity.model = ModelUtils::loadModel(path);
+		entity.model() = ModelUtils::loadModel(path);
+
+		entity.transform() = transform;
+
+		return entity;
+	}
+
+	Entity& createPointLight(Scene& scene, const glm::vec3& position, const glm::vec3& color, float range)
+	{
+		Entity& entity = scene.createEntity(COMPONENT_LIGHT | COMPONENT_TRANSFORM);
+
+		entity.transform().position = position;
+
+		LightComponent& light = entity.light();
+		light.type = LIGHT_POINT;
+		light.color = color;
+		light.range = range;
+		light.direction = vec3(0, 0, -1);
+		light.coneAngle = 0;
+
+		return entity;
+	}
+
+	Entity& createSpotlight(Scene& scene, const glm::vec3& position, const glm::vec3& direction, const glm::vec3& color, float range, float coneAngle)
+	{
+		Entity& entity = scene.createEntity(COMPONENT_LIGHT | COMPONENT_TRANSFORM);
+
+		entity.transform().position = position;
 
-		entity.transform = transform;
+		LightComponent& light = entity.light();
+		light.type = LIGHT_SPOT;
+		light.color = color;
+		light.range = range;
+		light.direction = normalize(direction);
+		light.coneAngle = coneAngle;
 
 		return entity;
 	}
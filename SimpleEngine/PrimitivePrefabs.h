@@ -47,6 +47,10 @@ namespace Prefabs {
 	// Creates a pyramid
 	Entity& createCube(Scene&, const TransformComponent& transform = {});
 
+	// Sets up the components of an existing entity as a cube.
+	// The entity must already have model and transform components.
+	void initCube(Entity&, const TransformComponent& transform = {});
+
 	// Creates a camera.
 	// This camera needs to be set as active on the render in order to be rendered from.
 	Entity& createCamera(Scene&, const glm::vec3& pos, const glm::vec3& center, const glm::vec3& up = glm::vec3{ 0, 1, 0 });
@@ -55,7 +59,19 @@ namespace Prefabs {
 	// Can be used to set the environment map for the renderer.
 	Entity& createSkybox(Scene&, const std::vector<std::string>& faceFilenames);
 
+	// Sets up the model of an existing entity as a skybox.
+	// The entity must already have a model component.
+	void initSkybox(Entity&, const std::vector<std::string>& faceFilenames);
+
 	// Creates an entity from a 3D model file.
 	// The entity returned is a simple entity with only a model and a lookAt component.
 	Entity& createModel(Scene&, const std::string& path, const TransformComponent& transform = {});
+
+	// Creates a point light, which lights everything within its range
+	Entity& createPointLight(Scene&, const glm::vec3& position, const glm::vec3& color, float range);
+
+	// Creates a spotlight shining along the direction.
+	// The cone angle is in radians from the direction to the edge of the
+	// cone.
+	Entity& createSpotlight(Scene&, const glm::vec3& position, const glm::vec3& direction, const glm::vec3& color, float range, float coneAngle);
 }
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "Profiler.h"
+
+#ifdef PROFILING_ENABLED
+
+#include "JobSystem.h"
+#include "Log.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+	const size_t g_kEventsPerChunk = 1 << 14;
+	const size_t g_kMaxChunksPerThread = 256;
+
+	struct ProfileEvent {
+		const char* name;
+		const char* category;
+		uint64_t startTime;
+		uint64_t endTime;
+	};
+
+	// Events recorded by one thread.
+	// Only the owning thread writes events. Other threads may read any
+	// event below the published count, since each chunk is allocated
+	// before the count that covers it is published.
+	struct ThreadBuffer {
+		std::unique_ptr<ProfileEvent[]> chunks[g_kMaxChunksPerThread];
+		std::atomic<size_t> count{ 0 };
+		size_t captureBegin = 0; // Events in the last capture, guarded by g_buffersMutex
+		size_t captureEnd = 0;
+		size_t jobThreadIndex;
+	};
+
+	std::atomic<bool> g_isCapturing{ false };
+	std::atomic<size_t> g_numDroppedEvents{ 0 };
+	uint64_t g_captureStartTime = 0;
+
+	// Buffers are never freed, so threads can exit during a capture
+	std::mutex g_buffersMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+
+	thread_local ThreadBuffer* t_buffer = nullptr;
+
+	ThreadBuffer& getThreadBuffer()
+	{
+		if (!t_buffer) {
+			std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+			buffer->jobThreadIndex = JobSystem::getThreadIndex();
+			t_buffer = buffer.get();
+
+			std::lock_guard<std::mutex> lock(g_buffersMutex);
+			g_buffers.push_back(std::move(buffer));
+		}
+
+		return *t_buffer;
+	}
+
+	void writeEscaped(std::ostream& out, const char* str)
+	{
+		for (; *str; ++str) {
+			if (*str == '"' || *str == '\\')
+				out << '\\';
+			out << *str;
+		}
+	}
+}
+
+void Profiler::beginCapture()
+{
+	std::lock_guard<std::mutex> lock(g_buffersMutex);
+
+	// Skip over events from previous captures
+	for (auto& buffer : g_buffers)
+		buffer->captureBegin = buffer->count.load(std::memory_order_acquire);
+
+	g_numDroppedEvents = 0;
+	g_captureStartTime = now();
+	g_isCapturing = true;
+}
+
+void Profiler::endCapture()
+{
+	g_isCapturing = false;
+
+	std::lock_guard<std::mutex> lock(g_buffersMutex);
+	for (auto& buffer : g_buffers)
+		buffer->captureEnd = buffer->count.load(std::memory_order_acquire);
+}
+
+bool Profiler::isCapturing()
+{
+	return g_isCapturing.load(std::memory_order_relaxed);
+}
+
+bool Profiler::writeChromeTrace(const std::string& path)
+{
+	std::ofstream file(path);
+	if (!file) {
+		g_log << "WARNING: Failed to open profiler trace file " << path << "\n";
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(g_buffersMutex);
+
+	file << "{\"traceEvents\":[\n";
+	bool isFirstEvent = true;
+	for (size_t threadID = 0; threadID < g_buffers.size(); ++threadID) {
+		ThreadBuffer& buffer = *g_buffers[threadID];
+
+		// Threads created after the capture ended have no events in it
+		size_t captureEnd = isCapturing() ? buffer.count.load(std::memory_order_acquire) : buffer.captureEnd;
+		if (captureEnd <= buffer.captureBegin)
+			continue;
+
+		if (!isFirstEvent)
+			file << ",\n";
+		isFirstEvent = false;
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << threadID << ",\"args\":{\"name\":\"";
+		if (buffer.jobThreadIndex == 0)
+			file << "Main thread";
+		else
+			file << "Worker " << buffer.jobThreadIndex;
+		file << "\"}}";
+
+		for (size_t i = buffer.captureBegin; i < captureEnd; ++i) {
+			const ProfileEvent& event = buffer.chunks[i / g_kEventsPerChunk][i % g_kEventsPerChunk];
+			if (event.startTime < g_captureStartTime)
+				continue;
+
+			// Chrome traces are in microseconds
+			file << ",\n{\"name\":\"";
+			writeEscaped(file, event.name);
+			file << "\",\"cat\":\"";
+			writeEscaped(file, event.category);
+			file << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << threadID
+			     << ",\"ts\":" << (event.startTime - g_captureStartTime) / 1000.0
+			     << ",\"dur\":" << (event.endTime - event.startTime) / 1000.0 << "}";
+		}
+	}
+	file << "\n]}\n";
+
+	if (g_numDroppedEvents > 0)
+		g_log << "WARNING: The profiler dropped " << g_numDroppedEvents.load() << " events after running out of space\n";
+
+	return file.good();
+}
+
+uint64_t Profiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::recordEvent(const char* name, const char* category, uint64_t startTime, uint64_t endTime)
+{
+	if (!isCapturing())
+		return;
+
+	ThreadBuffer& buffer = getThreadBuffer();
+	size_t eventIdx = buffer.count.load(std::memory_order_relaxed);
+	size_t chunkIdx = eventIdx / g_kEventsPerChunk;
+	if (chunkIdx >= g_kMaxChunksPerThread) {
+		++g_numDroppedEvents;
+		return;
+	}
+
+	if (!buffer.chunks[chunkIdx])
+		buffer.chunks[chunkIdx].reset(new ProfileEvent[g_kEventsPerChunk]);
+	buffer.chunks[chunkIdx][eventIdx % g_kEventsPerChunk] = { name, category, startTime, endTime };
+
+	// Publish the event to the exporting thread
+	buffer.count.store(eventIdx + 1, std::memory_order_release);
+}
+
+#endif
@@ -0,0 +1,93 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : A lightweight CPU profiler that records timed scopes
+//                and exports them as a Chrome trace.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+// Profiling is compiled into debug builds.
+// Define PROFILING_ENABLED to profile other builds, otherwise the
+// profiling macros compile to nothing.
+#if !defined(NDEBUG) && !defined(PROFILING_ENABLED)
+#define PROFILING_ENABLED
+#endif
+
+#ifdef PROFILING_ENABLED
+
+#include <cstdint>
+#include <string>
+
+// Each thread records events into its own buffer, so recording never
+// takes a lock or waits on another thread.
+namespace Profiler {
+	// Starts recording events
+	void beginCapture();
+
+	// Stops recording events
+	void endCapture();
+
+	// Returns true while events are being recorded
+	bool isCapturing();
+
+	// Writes the events recorded in the last capture as Chrome
+	// trace_event JSON, which can be opened with chrome://tracing.
+	// Returns false if the file couldn't be written.
+	bool writeChromeTrace(const std::string& path);
+
+	// Returns the profilers current time in nanoseconds
+	uint64_t now();
+
+	// Records a finished event on the calling thread.
+	// The name and category aren't copied, so they must outlive the
+	// capture i.e. string literals.
+	void recordEvent(const char* name, const char* category, uint64_t startTime, uint64_t endTime);
+}
+
+// Records the time from construction to destruction as an event.
+// Use through the PROFILE_SCOPE macros.
+class ProfileScope {
+public:
+	ProfileScope(const char* name, const char* category)
+		: m_name{ name }
+		, m_category{ category }
+		, m_startTime{ Profiler::isCapturing() ? Profiler::now() : 0 }
+	{
+	}
+
+	~ProfileScope()
+	{
+		if (m_startTime != 0)
+			Profiler::recordEvent(m_name, m_category, m_startTime, Profiler::now());
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* m_name;
+	const char* m_category;
+	uint64_t m_startTime; // 0 if the capture hadn't started
+};
+
+#define PROFILE_CONCAT_INNER(lhs, rhs) lhs##rhs
+#define PROFILE_CONCAT(lhs, rhs) PROFILE_CONCAT_INNER(lhs, rhs)
+
+// Profiles the rest of the enclosing scope
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__){ name, "Engine" }
+#define PROFILE_SCOPE_CATEGORY(name, category) ProfileScope PROFILE_CONCAT(profileScope, __LINE__){ name, category }
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_SCOPE_CATEGORY(name, category)
+
+#endif
@@ -0,0 +1,171 @@
+#include "RenderQueue.h"
+
+#include "Mesh.h"
+#include "OcclusionBuffer.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+	const int g_kPassBits = 2;
+	const int g_kShaderBits = 8;
+	const int g_kMaterialBits = 16;
+	const int g_kMeshBits = 14;
+	const int g_kDepthBits = 24;
+	static_assert(g_kPassBits + g_kShaderBits + g_kMaterialBits + g_kMeshBits + g_kDepthBits == 64, "Sort keys must use all 64 bits");
+
+	const int g_kRadixBits = 8;
+	const size_t g_kNumBuckets = 1 << g_kRadixBits;
+
+	uint64_t getLowBits(uint32_t value, int numBits)
+	{
+		return value & ((uint64_t(1) << numBits) - 1);
+	}
+
+	// The bit pattern of a positive float increases with its value, so its
+	// top bits can be sorted as an integer
+	uint32_t quantizeDepth(float depth)
+	{
+		uint32_t depthBits;
+		std::memcpy(&depthBits, &depth, sizeof(depthBits));
+		return depthBits >> (32 - g_kDepthBits);
+	}
+}
+
+uint64_t RenderQueue::makeSortKey(Pass pass, uint32_t shaderID, uint32_t materialID, uint32_t meshID, float depth)
+{
+	uint64_t key = static_cast<uint64_t>(pass);
+	uint64_t state = getLowBits(shaderID, g_kShaderBits);
+	state = (state << g_kMaterialBits) | getLowBits(materialID, g_kMaterialBits);
+	state = (state << g_kMeshBits) | getLowBits(meshID, g_kMeshBits);
+	uint64_t quantizedDepth = quantizeDepth(depth > 0 ? depth : 0);
+
+	// Blended draws must be drawn back to front to blend correctly, so
+	// depth goes before state and is inverted.
+	// Other draws group state first and go front to back within the same
+	// state, to reject more pixels with the depth test.
+	if (pass == PASS_BLENDED) {
+		key = (key << g_kDepthBits) | getLowBits(~static_cast<uint32_t>(quantizedDepth), g_kDepthBits);
+		key = (key << (64 - g_kPassBits - g_kDepthBits)) | state;
+	} else {
+		key = (key << (64 - g_kPassBits - g_kDepthBits)) | state;
+		key = (key << g_kDepthBits) | quantizedDepth;
+	}
+
+	return key;
+}
+
+RenderQueue::Pass RenderQueue::getPass(uint64_t sortKey)
+{
+	return static_cast<Pass>(sortKey >> (64 - g_kPassBits));
+}
+
+void RenderQueue::push(const DrawCall& drawCall, uint64_t sortKey)
+{
+	m_packets.push_back({ sortKey, static_cast<uint32_t>(m_drawCalls.size()) });
+	m_drawCalls.push_back(drawCall);
+}
+
+void RenderQueue::sort()
+{
+	// Least significant digit first radix sort, a byte at a time.
+	// Bytes that are the same in every key are skipped, which is most of
+	// them when there are only a few shaders and materials.
+	size_t numPackets = m_packets.size();
+	m_sortBuffer.resize(numPackets);
+	for (int shift = 0; shift < 64; shift += g_kRadixBits) {
+		size_t bucketOffsets[g_kNumBuckets] = {};
+		for (const DrawPacket& packet : m_packets)
+			++bucketOffsets[(packet.sortKey >> shift) & (g_kNumBuckets - 1)];
+
+		if (numPackets == 0 || bucketOffsets[(m_packets[0].sortKey >> shift) & (g_kNumBuckets - 1)] == numPackets)
+			continue;
+
+		size_t offset = 0;
+		for (size_t& bucketOffset : bucketOffsets) {
+			size_t count = bucketOffset;
+			bucketOffset = offset;
+			offset += count;
+		}
+
+		for (const DrawPacket& packet : m_packets)
+			m_sortBuffer[bucketOffsets[(packet.sortKey >> shift) & (g_kNumBuckets - 1)]++] = packet;
+		m_packets.swap(m_sortBuffer);
+	}
+}
+
+size_t RenderQueue::cull(const FrustumCulling::Frustum& frustum)
+{
+	m_spheres.clear();
+	for (const DrawPacket& packet : m_packets) {
+		const DrawCall& drawCall = m_drawCalls[packet.drawIdx];
+		if (getPass(packet.sortKey) == PASS_BACKGROUND)
+			m_spheres.push_back({}, std::numeric_limits<float>::infinity());
+		else
+			FrustumCulling::pushWorldSphere(m_spheres, drawCall.mesh->bounds, drawCall.transform);
+	}
+
+	size_t numVisible = FrustumCulling::cullSpheres(frustum, m_spheres, m_isVisible);
+	size_t numCulled = m_packets.size() - numVisible;
+	if (numCulled != 0)
+		removeHidden();
+
+	return numCulled;
+}
+
+size_t RenderQueue::cullOccluded(const OcclusionBuffer& occlusionBuffer)
+{
+	size_t numCulled = 0;
+	m_isVisible.resize(m_packets.size());
+	for (size_t i = 0; i < m_packets.size(); ++i) {
+		const DrawCall& drawCall = m_drawCalls[m_packets[i].drawIdx];
+		const MeshBounds& bounds = drawCall.mesh->bounds;
+		m_isVisible[i] = getPass(m_packets[i].sortKey) == PASS_BACKGROUND
+		              || std::isinf(bounds.radius)
+		              || occlusionBuffer.isVisible({ bounds.min, bounds.max }, drawCall.transform);
+		numCulled += !m_isVisible[i];
+	}
+
+	if (numCulled != 0)
+		removeHidden();
+
+	return numCulled;
+}
+
+void RenderQueue::removeHidden()
+{
+	// Only the packets are removed, draws are still indexed by packets
+	size_t numKept = 0;
+	for (size_t i = 0; i < m_packets.size(); ++i) {
+		if (m_isVisible[i])
+			m_packets[numKept++] = m_packets[i];
+	}
+	m_packets.resize(numKept);
+}
+
+void RenderQueue::clear()
+{
+	m_packets.clear();
+	m_drawCalls.clear();
+}
+
+size_t RenderQueue::size() const
+{
+	return m_packets.size();
+}
+
+bool RenderQueue::isEmpty() const
+{
+	return m_packets.empty();
+}
+
+const DrawCall& RenderQueue::getDrawCall(size_t i) const
+{
+	return m_drawCalls[m_packets[i].drawIdx];
+}
+
+uint64_t RenderQueue::getSortKey(size_t i) const
+{
+	return m_packets[i].sortKey;
+}
@@ -0,0 +1,105 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : A queue of draw calls, sorted so draws that share
+//                GPU state are submitted together.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include "FrustumCulling.h"
+
+#include <glad\glad.h>
+#include <glm\glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct Material;
+struct Mesh;
+class OcclusionBuffer;
+
+// A single mesh to draw.
+// The mesh and material aren't copied, so they must stay alive until the
+// queue is cleared.
+struct DrawCall {
+	glm::mat4 transform;
+	const Mesh* mesh;
+	const Material* material;
+	uint32_t materialID; // Draws with the same id have the same textures
+	GLuint firstIndex;   // The range of the meshes indices to draw, for its level of detail
+	GLsizei numIndices;
+};
+
+// Each draw is queued with a 64 bit sort key.
+// The keys are laid out so sorting them orders the draws by pass, then
+// opaque draws by shader, material and mesh and finally front to back,
+// and blended draws back to front.
+// Only a compact packet of the key and the draws index is moved when
+// sorting.
+class RenderQueue {
+public:
+	// Passes are drawn in order
+	enum Pass {
+		PASS_OPAQUE,     // Depth tested and written
+		PASS_BACKGROUND, // Depth tested but not written i.e. the skybox
+		PASS_BLENDED     // Alpha blended over everything else
+	};
+
+	// Returns the sort key for a draw.
+	// Ids only sort draws, so ids that don't fit their bits still draw
+	// correctly, just with less sharing of state.
+	// The depth must not be negative.
+	static uint64_t makeSortKey(Pass, uint32_t shaderID, uint32_t materialID, uint32_t meshID, float depth);
+
+	// Returns the pass a sort key was made for
+	static Pass getPass(uint64_t sortKey);
+
+	void push(const DrawCall&, uint64_t sortKey);
+
+	// Removes the draws whose bounds are outside the frustum.
+	// Background draws are never culled, since they are drawn around the
+	// camera.
+	// Returns the number of draws culled.
+	size_t cull(const FrustumCulling::Frustum&);
+
+	// Removes the draws whose bounds are hidden behind the occluders
+	// rasterized into the occlusion buffer.
+	// Background draws and unbounded draws are never culled.
+	// Returns the number of draws culled.
+	size_t cullOccluded(const OcclusionBuffer&);
+
+	// Sorts the queued draws by their keys with a radix sort.
+	// Draws with equal keys stay in the order they were queued.
+	void sort();
+
+	void clear();
+	size_t size() const;
+	bool isEmpty() const;
+
+	// Returns the draws in sort order, after sort() has been called
+	const DrawCall& getDrawCall(size_t i) const;
+	uint64_t getSortKey(size_t i) const;
+
+private:
+	struct DrawPacket {
+		uint64_t sortKey;
+		uint32_t drawIdx;
+	};
+
+	// Removes the packets that aren't marked visible in m_isVisible
+	void removeHidden();
+
+	std::vector<DrawPacket> m_packets;
+	std::vector<DrawPacket> m_sortBuffer;
+	std::vector<DrawCall> m_drawCalls;
+	FrustumCulling::Spheres m_spheres;
+	std::vector<uint8_t> m_isVisible;
+};
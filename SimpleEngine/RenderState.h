@@ -1,5 +1,7 @@
 #pragma once
 
+#include "CameraComponent.h"
+#include "FrustumCulling.h"
 #include "Texture.h"
 #include "RenderBuffer.h"
 #include "FrameBuffer.h"
@@ -7,23 +9,35 @@
 
 #include <GLFW\glfw3.h>
 #include <glad\glad.h>
+#include <glm\glm.hpp>
 
 #include <vector>
 
 class Entity;
+class UniformRingBuffer;
 
 struct RenderState {
 	GLFWwindow* glContext;
 	const Entity* cameraEntity;
+	CameraComponent camera; // The cameras view this frame, between the last two simulation steps
+	glm::mat4 projection;   // Set once per frame, with the view projection and its frustum
+	glm::mat4 viewProjection;
+	FrustumCulling::Frustum frustum;
 	GLuint radianceMap;
 	bool hasRadianceMap;
 	GLuint irradianceMap;
 	bool hasIrradianceMap;
-	GLuint uboUniforms;
+	UniformRingBuffer* uniformBuffer;
 	FrameBuffer sceneFramebuffer;
 	Texture sceneColorBuffer;
 	RenderBuffer sceneDepthStencilBuffer;
 	const Shader* postProcessShader;
-	GLuint uniformBindingPoint;
-	std::vector<const Entity*> spotlights;
+
+	// Texture buffers of the lights, each clusters range of the light
+	// index list, and the light index list
+	GLuint lightDataTexture;
+	GLuint lightClusterTexture;
+	GLuint lightIndexTexture;
+	glm::vec4 clusterScale;     // As in the frame uniforms
+	glm::uvec4 clusterGridSize;
 };
\ No newline at end of file
@@ -29,6 +29,13 @@
 #include "GLPrimitives.h"
 #include "Clock.h"
 #include "Shader.h"
+#include "StaticGeometry.h"
+#include "LightClusters.h"
+#include "Log.h"
+#include "OcclusionBuffer.h"
+#include "Profiler.h"
+#include "SpatialIndex.h"
+#include "UniformRingBuffer.h"
 
 #include <glad\glad.h>
 #include <GLFW\glfw3.h>
@@ -36,21 +43,71 @@
 #include <glm\gtc\type_ptr.hpp>
 #include <glm\gtx\euler_angles.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <functional>
 
 using glm::mat4;
 using glm::vec3;
 using glm::vec4;
 
+namespace {
+	const GLsizeiptr g_kUniformBufferSize = 4 * 1024 * 1024;
+	const float g_kFieldOfView = glm::radians(60.0f);
+
+	// The fraction of the screen height a mesh must cover less than to
+	// be drawn at each coarser LOD
+	const float g_kLODScreenSizes[Mesh::s_kMaxLODs - 1] = { 0.4f, 0.2f, 0.1f };
+
+	// How far past a switching size a mesh must be to change LOD, as a
+	// fraction of the size
+	const float g_kLODHysteresis = 0.1f;
+
+	// Creates a buffer, and a buffer texture of the format reading it
+	void createTextureBuffer(GLenum format, GLuint& outBuffer, GLuint& outTexture)
+	{
+		glGenBuffers(1, &outBuffer);
+		glBindBuffer(GL_TEXTURE_BUFFER, outBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+
+		glGenTextures(1, &outTexture);
+		glBindTexture(GL_TEXTURE_BUFFER, outTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, format, outBuffer);
+
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+
+	// Replaces a buffers contents.
+	// The old storage is orphaned rather than overwritten, as the GPU may
+	// still be reading last frames data.
+	void uploadTextureBuffer(GLuint buffer, const void* data, size_t size)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+		glBufferData(GL_TEXTURE_BUFFER, std::max(size, sizeof(glm::vec4)), nullptr, GL_STREAM_DRAW);
+		if (size > 0)
+			glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+	}
+}
+
 RenderState RenderSystem::s_renderState;
+RenderQueue RenderSystem::s_debugQueue;
+RenderQueue RenderSystem::s_staticDraws;
+std::deque<ModelComponent> RenderSystem::s_debugModels;
+std::unordered_map<RenderSystem::MaterialState, uint32_t, RenderSystem::MaterialStateHash> RenderSystem::s_materialIDs;
+RenderSystem::MaterialState RenderSystem::s_scratchMaterialState;
+std::vector<glm::mat4> RenderSystem::s_instanceTransforms;
+std::unordered_map<GLuint, GLuint> RenderSystem::s_instanceBuffers;
 
 RenderSystem::RenderSystem(Scene& scene)
-	: System{ scene }
+	: System{ scene, COMPONENT_MODEL }
 {
+	setComponentAccess(COMPONENT_MODEL | COMPONENT_TRANSFORM | COMPONENT_PICKUP | COMPONENT_CAMERA | COMPONENT_LIGHT, 0);
+
 	m_renderState.glContext = Game::getWindowContext();
-	m_renderState.uniformBindingPoint = 0;
 	m_renderState.hasIrradianceMap = false;
 	m_renderState.hasRadianceMap = false;
+	m_renderState.cameraEntity = nullptr;
 
 	// Set post processing shader
 	m_postProcessShaders.push_back(&GLUtils::getFullscreenQuadShader());
@@ -77,17 +134,60 @@ RenderSystem::RenderSystem(Scene& scene)
 	assert(glCheckFramebufferStatus(framebuffer.target) == GL_FRAMEBUFFER_COMPLETE);
 	glBindFramebuffer(framebuffer.target, 0);
 
-	// Create buffer for uniformBlock
-	glGenBuffers(1, &m_renderState.uboUniforms);
-	glBindBufferBase(GL_UNIFORM_BUFFER, m_renderState.uniformBindingPoint, m_renderState.uboUniforms);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(UniformBlockFormat), nullptr, GL_DYNAMIC_DRAW);
+	// Create the buffer the uniform blocks are streamed into
+	m_uniformBuffer = std::make_unique<UniformRingBuffer>(g_kUniformBufferSize);
+	m_renderState.uniformBuffer = m_uniformBuffer.get();
+
+	// Static models fall back to the render queue without indirect draws
+	if (StaticGeometry::isSupported())
+		m_staticGeometry = std::make_unique<StaticGeometry>();
+
+	m_occlusionBuffer = std::make_unique<OcclusionBuffer>();
+
+	// Lights are read by the shaders from texture buffers, each light
+	// taking three texels
+	createTextureBuffer(GL_RGBA32F, m_lightDataBuffer, m_renderState.lightDataTexture);
+	createTextureBuffer(GL_RG32UI, m_lightClusterBuffer, m_renderState.lightClusterTexture);
+	createTextureBuffer(GL_R32UI, m_lightIndexBuffer, m_renderState.lightIndexTexture);
+	m_renderState.clusterScale = vec4(0);
+	m_renderState.clusterGridSize = glm::uvec4(0);
+	// Both the lights and the light index list must fit in a texture
+	// buffer, which may be as small as 65536 texels
+	GLint maxTextureBufferTexels;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTextureBufferTexels);
+	m_maxLights = static_cast<size_t>(maxTextureBufferTexels) / (sizeof(ClusterLight) / sizeof(vec4));
+	m_lightClusters = std::make_unique<LightClusters>(static_cast<size_t>(maxTextureBufferTexels));
+	m_hasLightJob = false;
+
+	m_spatialIndex = nullptr;
+	m_frameIndex = 0;
+	m_numCulledModels = 0;
 
 	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 }
 
 RenderSystem::~RenderSystem()
 {
+	// The occlusion and light jobs use the buffers
+	JobSystem::wait(m_occlusionJob);
+	JobSystem::wait(m_lightJob);
+
 	glDeleteFramebuffers(1, &m_renderState.sceneFramebuffer.id);
+
+	GLuint lightTextures[] = { m_renderState.lightDataTexture, m_renderState.lightClusterTexture, m_renderState.lightIndexTexture };
+	GLuint lightBuffers[] = { m_lightDataBuffer, m_lightClusterBuffer, m_lightIndexBuffer };
+	glDeleteTextures(3, lightTextures);
+	glDeleteBuffers(3, lightBuffers);
+
+	// The buffer's name can be reused once it is deleted, so forget which
+	// vertex arrays read instances from it
+	GLuint instanceBuffer = m_uniformBuffer->getGPUHandle();
+	for (auto it = s_instanceBuffers.begin(); it != s_instanceBuffers.end();) {
+		if (it->second == instanceBuffer)
+			it = s_instanceBuffers.erase(it);
+		else
+			++it;
+	}
 }
 
 void RenderSystem::drawDebugArrow(const glm::vec3& base, const glm::vec3& tip,
@@ -117,22 +217,53 @@ void RenderSystem::drawDebugArrow(const glm::vec3& base, const glm::vec3& _direc
 
 	transform *= glm::scale({}, vec3(1, magnitude, 1));
 
-	ModelComponent& model = ModelUtils::loadModel("Assets/Models/red_arrow/red_arrow.obj");
-	for (size_t i = 0; i < model.materials.size(); ++i) {
-		model.materials.at(i).shader = &GLUtils::getDebugShader();
-		model.materials.at(i).debugColor = color;
-	}
-
 	// Can't render anything without a camera set
 	if (!s_renderState.cameraEntity) {
 		return;
 	}
 
-	renderModel(model, transform);
+	// Keep the model alive until the debug queue is drawn
+	s_debugModels.push_back(ModelUtils::loadModel("Assets/Models/red_arrow/red_arrow.obj"));
+	ModelComponent& model = s_debugModels.back();
+	for (size_t i = 0; i < model.materials.size(); ++i) {
+		model.materials.at(i).shader = &GLUtils::getDebugShader();
+		model.materials.at(i).debugColor = color;
+	}
+
+	queueModel(s_debugQueue, model, transform);
 }
 
 void RenderSystem::beginFrame()
 {
+	// Resolve the camera once per frame, in case it has been destroyed
+	m_renderState.cameraEntity = m_scene.getEntity(m_camera);
+
+	// Render between the last two simulation steps
+	float alpha = Clock::getInterpolationAlpha();
+	m_scene.updateWorldMatrices(alpha);
+	if (m_renderState.cameraEntity)
+		m_renderState.camera = m_scene.getInterpolatedCamera(*m_renderState.cameraEntity, alpha);
+
+	// Every view of the scene this frame shares these
+	m_renderState.projection = calculateProjection();
+	m_renderState.viewProjection = m_renderState.projection * m_renderState.camera.getView();
+	m_renderState.frustum = FrustumCulling::makeFrustum(m_renderState.viewProjection);
+
+	// The index was moved to the new world matrices above
+	++m_frameIndex;
+	m_numCulledModels = 0;
+	if (m_spatialIndex && m_renderState.cameraEntity)
+		findVisibleEntities();
+
+	startOcclusionJob();
+	startLightJob();
+
+	// Share this RenderSystems state with the static drawing functions
+	s_renderState = m_renderState;
+	m_renderQueue.clear();
+	if (m_staticGeometry)
+		m_staticGeometry->beginFrame();
+
 	glBindFramebuffer(m_renderState.sceneFramebuffer.target, m_renderState.sceneFramebuffer.id);
 
 	glDepthMask(GL_TRUE);
@@ -149,6 +280,23 @@ void RenderSystem::endFrame()
 	}
 	lastState = glfwGetKey(glfwGetCurrentContext(), GLFW_KEY_SPACE);
 
+	// Draw everything queued this frame, then the debug drawing.
+	// The occlusion buffer is only used once its job has finished.
+	const OcclusionBuffer* occlusionBuffer = nullptr;
+	if (!m_occluderDraws.empty()) {
+		JobSystem::wait(m_occlusionJob);
+		occlusionBuffer = m_occlusionBuffer.get();
+	}
+	if (m_staticGeometry)
+		m_staticGeometry->endFrame();
+	uploadLights();
+	m_stats = submit(m_renderQueue, m_staticGeometry.get(), occlusionBuffer);
+	m_stats.numCulledModels = m_numCulledModels;
+	submit(s_debugQueue);
+	s_debugQueue.clear();
+	s_debugModels.clear();
+	m_uniformBuffer->endFrame();
+
 	// Bind and clear the default framebuffer
 	glBindFramebuffer(m_renderState.sceneFramebuffer.target, 0);
 	glClear(GL_COLOR_BUFFER_BIT);
@@ -179,7 +327,7 @@ void RenderSystem::update(Entity& entity)
 
 	// If it is an non-active pickup do not render it
 	const size_t kPickup = COMPONENT_PICKUP;
-	if (entity.hasComponents(kPickup) && !entity.pickup.isActive)
+	if (entity.hasComponents(kPickup) && !entity.pickup().isActive)
 		return;
 
 	// Can't render anything without a camera set
@@ -187,18 +335,59 @@ void RenderSystem::update(Entity& entity)
 		return;
 	}
 
-	bool hasTransform = entity.hasComponents(COMPONENT_TRANSFORM);
+	const ModelComponent& model = entity.model();
+	if (model.isOccluder && model.occluder)
+		m_occluderEntities.push_back(entity.getHandle());
+
+	// Static models only need adding once, then they are drawn from the
+	// static geometry until they stop being updated
+	if (model.isStatic && m_staticGeometry && isOpaque(model)) {
+		if (!m_staticGeometry->keepModel(entity.getHandle())) {
+			s_staticDraws.clear();
+			queueModel(s_staticDraws, model, m_scene.getWorldMatrix(entity));
+			m_staticGeometry->addModel(entity.getHandle(), s_staticDraws);
+		}
+		return;
+	}
 
-	// Swap the current global render state with this RenderSystems state.
-	s_renderState = m_renderState;
+	// Skip models the spatial index didn't find in view.
+	// Only entities with a transform are indexed, the rest (i.e. the
+	// skybox) are always queued.
+	EntityHandle handle = entity.getHandle();
+	if (m_spatialIndex && entity.hasComponents(COMPONENT_TRANSFORM)
+	    && (handle.index >= m_entityVisibleFrames.size() || m_entityVisibleFrames[handle.index] != m_frameIndex)) {
+		++m_numCulledModels;
+		return;
+	}
+
+	// Keep the LODs an entity was drawn at while its slot isn't reused
+	if (handle.index >= m_entityLODs.size())
+		m_entityLODs.resize(handle.index + 1);
+	EntityLODs& entityLODs = m_entityLODs[handle.index];
+	if (entityLODs.generation != handle.generation || entityLODs.meshLODs.size() != model.meshes.size()) {
+		entityLODs.generation = handle.generation;
+		entityLODs.meshLODs.assign(model.meshes.size(), 0);
+	}
+
+	// Queue the current entities model, it is drawn in endFrame.
+	// Models without a transform (i.e. the skybox) are drawn at the origin.
+	queueModel(m_renderQueue, model, m_scene.getWorldMatrix(entity), entityLODs.meshLODs.data());
+}
+
+const RenderSystem::RenderStats& RenderSystem::getStats() const
+{
+	return m_stats;
+}
 
-	// Render the current entities model
-	renderModel(entity.model, GLMUtils::transformToMat(entity.transform));
+void RenderSystem::setCamera(const EntityHandle& camera)
+{
+	m_camera = camera;
+	m_renderState.cameraEntity = m_scene.getEntity(camera);
 }
 
-void RenderSystem::setCamera(const Entity* entity)
+void RenderSystem::setSpatialIndex(const SpatialIndex* spatialIndex)
 {
-	m_renderState.cameraEntity = entity;
+	m_spatialIndex = spatialIndex;
 }
 
 void RenderSystem::setRadianceMap(GLuint radianceMap)
@@ -213,135 +402,594 @@ void RenderSystem::setIrradianceMap(GLuint irradianceMap)
 	m_renderState.hasIrradianceMap = true;
 }
 
-void RenderSystem::renderModel(const ModelComponent& model, const glm::mat4& transform)
+bool RenderSystem::MaterialState::operator==(const MaterialState& rhs) const
 {
-	// Get Aspect ratio
-	int width, height;
-	GLFWwindow* glContext = Game::getWindowContext();
-	glfwGetFramebufferSize(glContext, &width, &height);
-	float aspectRatio = static_cast<float>(width) / height;
+	return shader == rhs.shader
+	    && textures == rhs.textures
+	    && heightMapScale == rhs.heightMapScale
+	    && debugColor == rhs.debugColor
+	    && metallicness == rhs.metallicness
+	    && glossiness == rhs.glossiness
+	    && specBias == rhs.specBias
+	    && discardTransparent == rhs.discardTransparent;
+}
 
-	// Get model, view and projection matrices
-	UniformBlockFormat uniformBlock;
-	
-	uniformBlock.model = transform;
-	uniformBlock.view = s_renderState.cameraEntity->camera.getView();
-	uniformBlock.projection = glm::perspective(glm::radians(60.0f), aspectRatio, 0.01f, 10000.0f);
-	uniformBlock.cameraPos = glm::vec4(s_renderState.cameraEntity->camera.getPosition(), 1.0f);
-
-	// Loop over all the meshes in the model
-	for (size_t i = 0; i < model.meshes.size(); ++i) {
-		const Mesh& mesh = model.meshes.at(i);
-		const Material& material = model.materials.at(mesh.materialIndex);
-
-		// Tell the gpu what shader to use
-		material.shader->use();
-
-		// Mostly here to ensure cubemaps don't draw on top of anything else
-		if (material.willDrawDepth) {
-			glDepthMask(GL_TRUE);
-			glDepthFunc(GL_LESS);
-		}
-		else {
-			glDepthMask(GL_FALSE);
-			glDepthFunc(GL_LEQUAL);
-		}
+size_t RenderSystem::MaterialStateHash::operator()(const MaterialState& state) const
+{
+	size_t hash = std::hash<const Shader*>()(state.shader);
+	hash = hash * 31 + std::hash<float>()(state.heightMapScale);
+	for (GLuint texture : state.textures)
+		hash = hash * 31 + texture;
+	for (int i = 0; i < 3; ++i)
+		hash = hash * 31 + std::hash<float>()(state.debugColor[i]);
+	hash = hash * 31 + std::hash<float>()(state.metallicness);
+	hash = hash * 31 + std::hash<float>()(state.glossiness);
+	hash = hash * 31 + std::hash<float>()(state.specBias);
+	hash = hash * 31 + state.discardTransparent;
+	return hash;
+}
 
-		// Tell the gpu what diffuse textures to use
-		// TODO: Send all textures to the GPU, not just 1
-		GLuint textureUnit = 0;
-		for (GLsizei j = 0; j < material.colorMaps.size(); ++j) {
-			const Texture& texture = material.colorMaps.at(j);
-			glActiveTexture(GL_TEXTURE0 + textureUnit);
-			glUniform1i(material.shader->getUniformLocation("texSampler" + toString(j)), textureUnit);
-			glBindTexture(texture.target, texture.id);
-			++textureUnit;
-		}
+uint32_t RenderSystem::getMaterialID(const Material& material)
+{
+	// Materials are copied into every model that uses them, so they are
+	// matched by the state they set rather than by address
+	MaterialState& state = s_scratchMaterialState;
+	state.shader = material.shader;
+	state.textures.clear();
+	state.textures.push_back(material.metallicnessMaps.empty() ? 0 : material.metallicnessMaps[0].id);
+	state.textures.push_back(material.heightMaps.empty() ? 0 : material.heightMaps[0].id);
+	state.textures.push_back(material.normalMaps.empty() ? 0 : material.normalMaps[0].id);
+	for (const Texture& colorMap : material.colorMaps)
+		state.textures.push_back(colorMap.id);
+	state.heightMapScale = material.heightMaps.empty() ? 0 : material.heightMapScale;
+	state.debugColor = material.shader == &GLUtils::getDebugShader() ? material.debugColor : glm::vec3{};
+	state.metallicness = material.shaderParams.metallicness;
+	state.glossiness = material.shaderParams.glossiness;
+	state.specBias = material.shaderParams.specBias;
+	state.discardTransparent = material.shaderParams.discardTransparent;
+
+	auto materialIt = s_materialIDs.find(state);
+	if (materialIt != s_materialIDs.end())
+		return materialIt->second;
+
+	uint32_t materialID = static_cast<uint32_t>(s_materialIDs.size());
+	s_materialIDs.emplace(state, materialID);
+	return materialID;
+}
 
-		for (GLsizei j = 0; j < material.metallicnessMaps.size(); ++j) {
-			const Texture& texture = material.metallicnessMaps.at(j);
-			glActiveTexture(GL_TEXTURE0 + textureUnit);
-			glUniform1i(material.shader->getUniformLocation("metallicnessSampler"), textureUnit);
-			glBindTexture(texture.target, texture.id);
-			++textureUnit;
+void RenderSystem::queueModel(RenderQueue& queue, const ModelComponent& model, const glm::mat4& transform, uint8_t* meshLODs)
+{
+	// Models without a node tree (i.e. primitives) draw every mesh with
+	// the models transform
+	if (model.rootNode.meshIDs.empty() && model.rootNode.childNodes.empty()) {
+		for (size_t i = 0; i < model.meshes.size(); ++i)
+			queueMesh(queue, model, model.meshes.at(i), transform, meshLODs ? &meshLODs[i] : nullptr);
+	} else {
+		queueNode(queue, model, model.rootNode, transform, meshLODs);
+	}
+}
 
-			// Just doing 1 specular texture currently
-			break;
-		}
+void RenderSystem::queueNode(RenderQueue& queue, const ModelComponent& model, const MeshNode& node, const glm::mat4& parentTransform, uint8_t* meshLODs)
+{
+	glm::mat4 transform = parentTransform * node.transform;
+	for (unsigned int meshID : node.meshIDs)
+		queueMesh(queue, model, model.meshes.at(meshID), transform, meshLODs ? &meshLODs[meshID] : nullptr);
 
-		for (GLsizei j = 0; j < material.heightMaps.size(); ++j) {
-			const Texture& texture = material.heightMaps.at(j);
-			glActiveTexture(GL_TEXTURE0 + textureUnit);
-			glUniform1i(material.shader->getUniformLocation("heightMapSampler"), textureUnit);
-			glUniform1f(material.shader->getUniformLocation("heightMapScale"), material.heightMapScale);
-			glBindTexture(texture.target, texture.id);
-			++textureUnit;
+	for (const MeshNode& childNode : node.childNodes)
+		queueNode(queue, model, childNode, transform, meshLODs);
+}
 
-			// Just doing 1 height map currently
-			break;
-		}
+void RenderSystem::queueMesh(RenderQueue& queue, const ModelComponent& model, const Mesh& mesh, const glm::mat4& transform, uint8_t* lod)
+{
+	const Material& material = model.materials.at(mesh.materialIndex);
+
+	RenderQueue::Pass pass = RenderQueue::PASS_OPAQUE;
+	if (material.willBlend)
+		pass = RenderQueue::PASS_BLENDED;
+	else if (!material.willDrawDepth)
+		pass = RenderQueue::PASS_BACKGROUND;
+
+	DrawCall drawCall;
+	drawCall.transform = transform;
+	drawCall.mesh = &mesh;
+	drawCall.material = &material;
+	drawCall.materialID = getMaterialID(material);
+
+	int drawLOD = 0;
+	if (lod) {
+		drawLOD = selectLOD(mesh, transform, *lod);
+		*lod = static_cast<uint8_t>(drawLOD);
+	}
+	if (mesh.numLODs > 0) {
+		drawCall.firstIndex = mesh.lods[drawLOD].firstIndex;
+		drawCall.numIndices = mesh.lods[drawLOD].numIndices;
+	} else {
+		drawCall.firstIndex = 0;
+		drawCall.numIndices = mesh.numIndices;
+	}
 
-		for (GLsizei j = 0; j < material.normalMaps.size(); ++j) {
-			const Texture& texture = material.normalMaps.at(j);
-			glActiveTexture(GL_TEXTURE0 + textureUnit);
-			glUniform1i(material.shader->getUniformLocation("normalMapSampler"), textureUnit);
-			glBindTexture(texture.target, texture.id);
-			++textureUnit;
+	// LODs of a mesh get their own mesh ids, so they sort next to each
+	// other and can be instanced
+	vec3 cameraPos = s_renderState.camera.getPosition();
+	float depth = glm::length(vec3(transform[3]) - cameraPos);
+	uint32_t meshID = mesh.VAO * Mesh::s_kMaxLODs + drawLOD;
+	queue.push(drawCall, RenderQueue::makeSortKey(pass, material.shader->getGPUHandle(), drawCall.materialID, meshID, depth));
+}
+
+int RenderSystem::selectLOD(const Mesh& mesh, const glm::mat4& transform, int lastLOD)
+{
+	if (mesh.numLODs <= 1 || std::isinf(mesh.bounds.radius))
+		return 0;
+
+	// Find the world bounding sphere, scaled by the largest axis scale
+	float scale = std::sqrt(std::max(glm::dot(transform[0], transform[0]), std::max(glm::dot(transform[1], transform[1]), glm::dot(transform[2], transform[2]))));
+	float radius = mesh.bounds.radius * scale;
+	vec3 center = vec3(transform * vec4(mesh.bounds.center, 1));
+	float distance = glm::length(center - s_renderState.camera.getPosition());
+	if (distance <= radius)
+		return 0;
+	float screenSize = radius / (distance * std::tan(g_kFieldOfView / 2));
+
+	int lod = std::min(lastLOD, mesh.numLODs - 1);
+	while (lod + 1 < mesh.numLODs && screenSize < g_kLODScreenSizes[lod] * (1 - g_kLODHysteresis))
+		++lod;
+	while (lod > 0 && screenSize > g_kLODScreenSizes[lod - 1] * (1 + g_kLODHysteresis))
+		--lod;
+	return lod;
+}
+
+RenderSystem::RenderStats RenderSystem::submit(RenderQueue& queue, StaticGeometry* staticGeometry, const OcclusionBuffer* occlusionBuffer)
+{
+	PROFILE_SCOPE_CATEGORY("RenderSystem::submit", "Render");
+
+	// Can't render anything without a camera set
+	RenderStats stats;
+	bool hasStaticDraws = staticGeometry && !staticGeometry->getBatches().empty();
+	if ((queue.isEmpty() && !hasStaticDraws) || !s_renderState.cameraEntity)
+		return stats;
+
+	// The view, projection and camera position are the same for every draw
+	FrameUniformFormat frameUniforms{};
+	frameUniforms.view = s_renderState.camera.getView();
+	frameUniforms.projection = s_renderState.projection;
+	frameUniforms.cameraPos = glm::vec4(s_renderState.camera.getPosition(), 1.0f);
+	frameUniforms.time = Clock::getTime();
+
+	// Cull before sorting, so culled draws aren't sorted
+	const FrustumCulling::Frustum& frustum = s_renderState.frustum;
+	stats.numCulledDraws = queue.cull(frustum);
+	if (occlusionBuffer)
+		stats.numOccludedDraws = queue.cullOccluded(*occlusionBuffer);
+	stats.numVisibleDraws = queue.size();
+	if (hasStaticDraws) {
+		size_t numOccludedStaticDraws = 0;
+		size_t numCulledStaticDraws = staticGeometry->cull(frustum, occlusionBuffer, &numOccludedStaticDraws);
+		stats.numCulledDraws += numCulledStaticDraws;
+		stats.numOccludedDraws += numOccludedStaticDraws;
+		stats.numVisibleDraws += staticGeometry->getNumDraws() - numCulledStaticDraws - numOccludedStaticDraws;
+	}
+
+	for (size_t i = 0; i < queue.size(); ++i) {
+		const DrawCall& drawCall = queue.getDrawCall(i);
+		stats.numTriangles += drawCall.numIndices / 3;
+		stats.numTrianglesSavedByLOD += (drawCall.mesh->numIndices - drawCall.numIndices) / 3;
+	}
 
-			// Just doing 1 normal map currently
-			break;
+	queue.sort();
+
+	// Fragments find their cluster of lights from these
+	frameUniforms.clusterScale = s_renderState.clusterScale;
+	frameUniforms.clusterGridSize = s_renderState.clusterGridSize;
+
+	UniformRingBuffer& uniformBuffer = *s_renderState.uniformBuffer;
+	GLintptr frameOffset = uniformBuffer.write(&frameUniforms, sizeof(FrameUniformFormat));
+	uniformBuffer.bind(FrameUniformFormat::s_kBindingPoint, frameOffset, sizeof(FrameUniformFormat));
+	bindLightBuffers();
+
+	if (hasStaticDraws)
+		submitStatic(*staticGeometry);
+
+	// Draws are sorted so state only needs to change when the pass,
+	// shader or material differs from the last draw
+	bool isFirstDraw = true;
+	RenderQueue::Pass boundPass = RenderQueue::PASS_OPAQUE;
+	const Shader* boundShader = nullptr;
+	uint32_t boundMaterialID = 0;
+	size_t numInstances;
+	for (size_t i = 0; i < queue.size(); i += numInstances) {
+		const DrawCall& drawCall = queue.getDrawCall(i);
+		const Material& material = *drawCall.material;
+		const Mesh& mesh = *drawCall.mesh;
+
+		RenderQueue::Pass pass = RenderQueue::getPass(queue.getSortKey(i));
+
+		// Draws next to each other in the queue with the same mesh and
+		// material are drawn together as instances
+		s_instanceTransforms.clear();
+		s_instanceTransforms.push_back(drawCall.transform);
+		for (numInstances = 1; i + numInstances < queue.size(); ++numInstances) {
+			const DrawCall& instance = queue.getDrawCall(i + numInstances);
+			bool isSameState = instance.mesh->VAO == mesh.VAO
+			                && instance.firstIndex == drawCall.firstIndex
+			                && instance.materialID == drawCall.materialID
+			                && instance.material->shader == material.shader
+			                && RenderQueue::getPass(queue.getSortKey(i + numInstances)) == pass;
+			if (!isSameState)
+				break;
+
+			s_instanceTransforms.push_back(instance.transform);
 		}
 
-		// Set environment map to use on GPU
-		if (s_renderState.hasRadianceMap) {
-			glActiveTexture(GL_TEXTURE0 + textureUnit);
-			glUniform1i(material.shader->getUniformLocation("radianceSampler"), textureUnit);
-			glBindTexture(GL_TEXTURE_CUBE_MAP, s_renderState.radianceMap);
-			++textureUnit;
+		if (isFirstDraw || pass != boundPass) {
+			setPassState(pass);
+			boundPass = pass;
 		}
-		if (s_renderState.hasIrradianceMap) {
-			glActiveTexture(GL_TEXTURE0 + textureUnit);
-			glUniform1i(material.shader->getUniformLocation("irradianceSampler"), textureUnit);
-			glBindTexture(GL_TEXTURE_CUBE_MAP, s_renderState.irradianceMap);
-			++textureUnit;
+
+		// Sampler uniforms belong to the shader, so a new shader needs its
+		// materials textures bound again
+		bool isNewShader = isFirstDraw || material.shader != boundShader;
+		if (isNewShader) {
+			material.shader->use();
+			bindUniformBlocks(*material.shader);
+			setLightSamplers(*material.shader);
+			boundShader = material.shader;
+		}
+
+		bool isNewMaterial = isFirstDraw || drawCall.materialID != boundMaterialID;
+		if (isNewShader || isNewMaterial) {
+			bindMaterial(material);
+			boundMaterialID = drawCall.materialID;
 		}
 
-		// Set shader parameters
-		uniformBlock.metallicness = material.shaderParams.metallicness;
-		uniformBlock.glossiness = material.shaderParams.glossiness;
-		uniformBlock.specBias = material.shaderParams.specBias;
-		uniformBlock.time = Clock::getTime();
-
-		// Set spotlights
-		uniformBlock.numSpotlights = std::min(static_cast<GLuint>(s_renderState.spotlights.size()), UniformBlockFormat::s_kMaxSpotlights);
-		//for (GLuint i = 0; i < uniformBlock.numSpotlights; ++i) {
-		//	const Entity* spotlightEntity = s_renderState.spotlights.at(i);
-		//	glm::vec4 spotlightDir = glm::vec4(s_renderState.spotlights.at(i)->spotlight.direction, 0);
-		//	// Transform to local coordinates of containing entity
-		//	glm::mat4 orientation = GLMUtils::eulerToMat(spotlightEntity->transform.eulerAngles);
-		//	spotlightDir = orientation * spotlightDir;
-		//	// Set spotlights in GPU uniform
-		//	uniformBlock.spotlightDirections.at(i) = spotlightDir;
-		//	uniformBlock.spotlightPositions.at(i) = glm::vec4(spotlightEntity->transform.position, 1);
-		//	uniformBlock.spotlightColors.at(i) = glm::vec4(spotlightEntity->spotlight.color, 1);
-		//}
-
-		// Send uniform data to the GPU
-		glUniformBlockBinding(material.shader->getGPUHandle(), material.shader->getUniformBlockIndex("UniformBlock"), s_renderState.uniformBindingPoint);
-		glBindBufferBase(GL_UNIFORM_BUFFER, s_renderState.uniformBindingPoint, s_renderState.uboUniforms);
-		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(UniformBlockFormat), &uniformBlock);
-		if (material.shader == &GLUtils::getDebugShader()) {
-			const glm::vec3& debugColor = material.debugColor;
-			glUniform3f(material.shader->getUniformLocation("debugColor"), debugColor.r, debugColor.g, debugColor.b);
+		// Material ids include the shader params, so the material block
+		// only needs writing when the id changes
+		if (isNewMaterial) {
+			MaterialUniformFormat materialUniforms{};
+			materialUniforms.metallicness = material.shaderParams.metallicness;
+			materialUniforms.glossiness = material.shaderParams.glossiness;
+			materialUniforms.specBias = material.shaderParams.specBias;
+			materialUniforms.discardTransparent = material.shaderParams.discardTransparent;
+			GLintptr materialOffset = uniformBuffer.write(&materialUniforms, sizeof(MaterialUniformFormat));
+			uniformBuffer.bind(MaterialUniformFormat::s_kBindingPoint, materialOffset, sizeof(MaterialUniformFormat));
 		}
+		isFirstDraw = false;
+
+		// Write the instance transforms, which the mesh reads as per
+		// instance vertex attributes starting from the base instance
+		GLintptr instanceOffset = uniformBuffer.write(s_instanceTransforms.data(), sizeof(mat4) * numInstances);
+		GLuint baseInstance = static_cast<GLuint>(instanceOffset / sizeof(mat4));
 
 		// Render the mesh
-		glBindVertexArray(mesh.VAO);
+		bindInstancedVertexArray(mesh.VAO, uniformBuffer.getGPUHandle());
+		GLsizei instanceCount = static_cast<GLsizei>(numInstances);
+		const GLvoid* firstIndexOffset = reinterpret_cast<const GLvoid*>(sizeof(GLuint) * drawCall.firstIndex);
 		if (material.shader->hasTessellationStage()) {
 			glPatchParameteri(GL_PATCH_VERTICES, 3);
-			glDrawElements(GL_PATCHES, mesh.numIndices, GL_UNSIGNED_INT, 0);
+			glDrawElementsInstancedBaseInstance(GL_PATCHES, drawCall.numIndices, GL_UNSIGNED_INT, firstIndexOffset, instanceCount, baseInstance);
 		}
 		else
-			glDrawElements(GL_TRIANGLES, mesh.numIndices, GL_UNSIGNED_INT, 0);
+			glDrawElementsInstancedBaseInstance(GL_TRIANGLES, drawCall.numIndices, GL_UNSIGNED_INT, firstIndexOffset, instanceCount, baseInstance);
+	}
+
+	// Restore the default state for anything drawn outside the queue
+	setPassState(RenderQueue::PASS_OPAQUE);
+	glBindVertexArray(0);
+
+	return stats;
+}
+
+glm::mat4 RenderSystem::calculateProjection()
+{
+	int width, height;
+	glfwGetFramebufferSize(Game::getWindowContext(), &width, &height);
+	float aspectRatio = static_cast<float>(width) / height;
+	return glm::perspective(g_kFieldOfView, aspectRatio, 0.01f, 10000.0f);
+}
+
+void RenderSystem::submitStatic(const StaticGeometry& staticGeometry)
+{
+	PROFILE_SCOPE_CATEGORY("RenderSystem::submitStatic", "Render");
+
+	// Static geometry is all opaque
+	setPassState(RenderQueue::PASS_OPAQUE);
+	staticGeometry.bind();
+
+	// One indirect multi draw per material
+	const Shader* boundShader = nullptr;
+	for (const StaticGeometry::Batch& batch : staticGeometry.getBatches()) {
+		if (batch.numVisibleCommands == 0)
+			continue;
+
+		const Material& material = staticGeometry.getMaterial(batch.materialID);
+		if (material.shader != boundShader) {
+			material.shader->use();
+			bindUniformBlocks(*material.shader);
+			setLightSamplers(*material.shader);
+			boundShader = material.shader;
+		}
+		bindMaterial(material);
+
+		MaterialUniformFormat materialUniforms{};
+		materialUniforms.metallicness = material.shaderParams.metallicness;
+		materialUniforms.glossiness = material.shaderParams.glossiness;
+		materialUniforms.specBias = material.shaderParams.specBias;
+		materialUniforms.discardTransparent = material.shaderParams.discardTransparent;
+		GLintptr materialOffset = s_renderState.uniformBuffer->write(&materialUniforms, sizeof(MaterialUniformFormat));
+		s_renderState.uniformBuffer->bind(MaterialUniformFormat::s_kBindingPoint, materialOffset, sizeof(MaterialUniformFormat));
+
+		GLenum mode = GL_TRIANGLES;
+		if (material.shader->hasTessellationStage()) {
+			glPatchParameteri(GL_PATCH_VERTICES, 3);
+			mode = GL_PATCHES;
+		}
+		glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(batch.commandsOffset), batch.numCommands, 0);
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+bool RenderSystem::isOpaque(const ModelComponent& model)
+{
+	for (const Material& material : model.materials) {
+		if (!material.willDrawDepth || material.willBlend)
+			return false;
+	}
+	return true;
+}
+
+void RenderSystem::setPassState(RenderQueue::Pass pass)
+{
+	switch (pass) {
+	case RenderQueue::PASS_OPAQUE:
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LESS);
+		glDisable(GL_BLEND);
+		break;
+
+	// Mostly here to ensure cubemaps don't draw on top of anything else
+	case RenderQueue::PASS_BACKGROUND:
+		glDepthMask(GL_FALSE);
+		glDepthFunc(GL_LEQUAL);
+		glDisable(GL_BLEND);
+		break;
+
+	case RenderQueue::PASS_BLENDED:
+		glDepthMask(GL_FALSE);
+		glDepthFunc(GL_LESS);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		break;
+	}
+}
+
+void RenderSystem::bindUniformBlocks(const Shader& shader)
+{
+	// Shaders only have the blocks their stages use
+	auto bindBlock = [&shader](const std::string& blockName, GLuint bindingPoint) {
+		GLuint blockIndex = shader.getUniformBlockIndex(blockName);
+		if (blockIndex != GL_INVALID_INDEX)
+			glUniformBlockBinding(shader.getGPUHandle(), blockIndex, bindingPoint);
+	};
+	bindBlock("FrameUniforms", FrameUniformFormat::s_kBindingPoint);
+	bindBlock("MaterialUniforms", MaterialUniformFormat::s_kBindingPoint);
+}
+
+void RenderSystem::bindLightBuffers()
+{
+	glActiveTexture(GL_TEXTURE0 + s_kLightDataTextureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, s_renderState.lightDataTexture);
+	glActiveTexture(GL_TEXTURE0 + s_kLightClusterTextureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, s_renderState.lightClusterTexture);
+	glActiveTexture(GL_TEXTURE0 + s_kLightIndexTextureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, s_renderState.lightIndexTexture);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void RenderSystem::setLightSamplers(const Shader& shader)
+{
+	// Samplers default to unit 0, where they would clash with the color
+	// map, so lit shaders must always have these set
+	glUniform1i(shader.getUniformLocation("lightDataSampler"), s_kLightDataTextureUnit);
+	glUniform1i(shader.getUniformLocation("lightClusterSampler"), s_kLightClusterTextureUnit);
+	glUniform1i(shader.getUniformLocation("lightIndexSampler"), s_kLightIndexTextureUnit);
+}
+
+void RenderSystem::bindInstancedVertexArray(GLuint VAO, GLuint instanceBuffer)
+{
+	glBindVertexArray(VAO);
+
+	// Point the vertex arrays instance attributes at the instance buffer
+	// the first time it is drawn from it
+	auto instanceBufferIt = s_instanceBuffers.find(VAO);
+	if (instanceBufferIt != s_instanceBuffers.end() && instanceBufferIt->second == instanceBuffer)
+		return;
+	s_instanceBuffers[VAO] = instanceBuffer;
+
+	// A mat4 attribute takes up one location per column
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	for (GLuint column = 0; column < 4; ++column) {
+		GLuint location = s_kInstanceTransformLocation + column;
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(mat4), reinterpret_cast<GLvoid*>(sizeof(vec4) * column));
+		glVertexAttribDivisor(location, 1);
+		glEnableVertexAttribArray(location);
+	}
+}
+
+void RenderSystem::bindMaterial(const Material& material)
+{
+	// Tell the gpu what diffuse textures to use
+	// TODO: Send all textures to the GPU, not just 1
+	GLuint textureUnit = 0;
+	for (GLsizei j = 0; j < material.colorMaps.size(); ++j) {
+		const Texture& texture = material.colorMaps.at(j);
+		glActiveTexture(GL_TEXTURE0 + textureUnit);
+		glUniform1i(material.shader->getUniformLocation("texSampler" + toString(j)), textureUnit);
+		glBindTexture(texture.target, texture.id);
+		++textureUnit;
 	}
-}
\ No newline at end of file
+
+	for (GLsizei j = 0; j < material.metallicnessMaps.size(); ++j) {
+		const Texture& texture = material.metallicnessMaps.at(j);
+		glActiveTexture(GL_TEXTURE0 + textureUnit);
+		glUniform1i(material.shader->getUniformLocation("metallicnessSampler"), textureUnit);
+		glBindTexture(texture.target, texture.id);
+		++textureUnit;
+
+		// Just doing 1 specular texture currently
+		break;
+	}
+
+	for (GLsizei j = 0; j < material.heightMaps.size(); ++j) {
+		const Texture& texture = material.heightMaps.at(j);
+		glActiveTexture(GL_TEXTURE0 + textureUnit);
+		glUniform1i(material.shader->getUniformLocation("heightMapSampler"), textureUnit);
+		glUniform1f(material.shader->getUniformLocation("heightMapScale"), material.heightMapScale);
+		glBindTexture(texture.target, texture.id);
+		++textureUnit;
+
+		// Just doing 1 height map currently
+		break;
+	}
+
+	for (GLsizei j = 0; j < material.normalMaps.size(); ++j) {
+		const Texture& texture = material.normalMaps.at(j);
+		glActiveTexture(GL_TEXTURE0 + textureUnit);
+		glUniform1i(material.shader->getUniformLocation("normalMapSampler"), textureUnit);
+		glBindTexture(texture.target, texture.id);
+		++textureUnit;
+
+		// Just doing 1 normal map currently
+		break;
+	}
+
+	// Set environment map to use on GPU
+	if (s_renderState.hasRadianceMap) {
+		glActiveTexture(GL_TEXTURE0 + textureUnit);
+		glUniform1i(material.shader->getUniformLocation("radianceSampler"), textureUnit);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, s_renderState.radianceMap);
+		++textureUnit;
+	}
+	if (s_renderState.hasIrradianceMap) {
+		glActiveTexture(GL_TEXTURE0 + textureUnit);
+		glUniform1i(material.shader->getUniformLocation("irradianceSampler"), textureUnit);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, s_renderState.irradianceMap);
+		++textureUnit;
+	}
+
+	if (material.shader == &GLUtils::getDebugShader()) {
+		const glm::vec3& debugColor = material.debugColor;
+		glUniform3f(material.shader->getUniformLocation("debugColor"), debugColor.r, debugColor.g, debugColor.b);
+	}
+}
+
+void RenderSystem::findVisibleEntities()
+{
+	PROFILE_SCOPE_CATEGORY("RenderSystem::findVisibleEntities", "Render");
+
+	m_visibleEntities.clear();
+	m_spatialIndex->queryFrustum(m_renderState.frustum, m_visibleEntities);
+
+	if (m_entityVisibleFrames.size() < m_scene.getEntityCount())
+		m_entityVisibleFrames.resize(m_scene.getEntityCount(), 0);
+	for (const Entity* entity : m_visibleEntities)
+		m_entityVisibleFrames[entity->getIndex()] = m_frameIndex;
+}
+
+void RenderSystem::startOcclusionJob()
+{
+	// Copy what the job needs, the entities may change while it runs
+	m_occluderDraws.clear();
+	if (m_renderState.cameraEntity) {
+		for (const EntityHandle& handle : m_occluderEntities) {
+			Entity* entity = m_scene.getEntity(handle);
+			if (entity && entity->hasComponents(COMPONENT_MODEL) && entity->model().isOccluder && entity->model().occluder)
+				m_occluderDraws.push_back({ entity->model().occluder, m_scene.getWorldMatrix(*entity) });
+		}
+	}
+	m_occluderEntities.clear();
+	if (m_occluderDraws.empty())
+		return;
+
+	// The buffer keeps the view projection it was rasterized with, so
+	// draws are tested against the same view
+	mat4 viewProjection = m_renderState.viewProjection;
+	JobSystem::run([this, viewProjection]() {
+		PROFILE_SCOPE_CATEGORY("RenderSystem::rasterizeOccluders", "Render");
+		m_occlusionBuffer->begin(viewProjection);
+		for (const OccluderDraw& occluderDraw : m_occluderDraws)
+			m_occlusionBuffer->addOccluder(*occluderDraw.mesh, occluderDraw.transform);
+		m_occlusionBuffer->rasterize();
+	}, &m_occlusionJob);
+}
+
+void RenderSystem::startLightJob()
+{
+	// Copy the lights into world space, the entities may change while
+	// the job runs
+	m_lights.clear();
+	m_hasLightJob = false;
+	if (!m_renderState.cameraEntity)
+		return;
+
+	m_scene.view<LightComponent>().eachWithEntity([this](Entity& entity, const LightComponent& light) {
+		const mat4& worldMatrix = m_scene.getWorldMatrix(entity);
+		ClusterLight clusterLight;
+		clusterLight.position = vec3(worldMatrix[3]);
+		clusterLight.range = light.range;
+		clusterLight.color = light.color;
+		clusterLight.cosConeAngle = -1;
+		clusterLight.direction = vec3(0, 0, -1);
+		clusterLight.padding = 0;
+		if (light.type == LIGHT_SPOT) {
+			clusterLight.cosConeAngle = std::cos(light.coneAngle);
+			clusterLight.direction = glm::normalize(vec3(worldMatrix * vec4(light.direction, 0)));
+		}
+		m_lights.push_back(clusterLight);
+	});
+
+	if (m_lights.size() > m_maxLights) {
+		static bool hasWarned = false;
+		if (!hasWarned)
+			g_log << "WARNING: Only " << m_maxLights << " of the " << m_lights.size() << " lights fit in the light buffer\n";
+		hasWarned = true;
+		m_lights.resize(m_maxLights);
+	}
+
+	mat4 view = m_renderState.camera.getView();
+	mat4 projection = m_renderState.projection;
+	JobSystem::run([this, view, projection]() {
+		m_lightClusters->build(m_lights, view, projection);
+	}, &m_lightJob);
+	m_hasLightJob = true;
+}
+
+void RenderSystem::uploadLights()
+{
+	if (!m_hasLightJob)
+		return;
+	JobSystem::wait(m_lightJob);
+
+	const std::vector<LightClusters::Cluster>& clusters = m_lightClusters->getClusters();
+	const std::vector<uint32_t>& lightIndices = m_lightClusters->getLightIndices();
+	if (m_lightClusters->getNumTrimmedLightIndices() > 0) {
+		static bool hasWarned = false;
+		if (!hasWarned)
+			g_log << "WARNING: " << m_lightClusters->getNumTrimmedLightIndices() << " cluster light indices didn't fit in the light index buffer\n";
+		hasWarned = true;
+	}
+	uploadTextureBuffer(m_lightDataBuffer, m_lights.data(), sizeof(ClusterLight) * m_lights.size());
+	uploadTextureBuffer(m_lightClusterBuffer, clusters.data(), sizeof(LightClusters::Cluster) * clusters.size());
+	uploadTextureBuffer(m_lightIndexBuffer, lightIndices.data(), sizeof(uint32_t) * lightIndices.size());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	// Tiles cover the whole framebuffer
+	int width, height;
+	glfwGetFramebufferSize(m_renderState.glContext, &width, &height);
+	s_renderState.clusterScale = vec4(
+		static_cast<float>(LightClusters::s_kNumTilesX) / width,
+		static_cast<float>(LightClusters::s_kNumTilesY) / height,
+		m_lightClusters->getDepthSliceScale(),
+		m_lightClusters->getDepthSliceBias());
+	s_renderState.clusterGridSize = glm::uvec4(LightClusters::s_kNumTilesX, LightClusters::s_kNumTilesY, LightClusters::s_kNumSlices, static_cast<GLuint>(m_lights.size()));
+}
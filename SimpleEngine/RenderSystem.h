@@ -13,23 +13,52 @@
 
 #pragma once
 
+#include "LightClusters.h"
+#include "RenderQueue.h"
 #include "RenderState.h"
 #include "EntityEventListener.h"
+#include "EntityHandle.h"
+#include "JobSystem.h"
 #include "System.h"
 
 #include <glad\glad.h>
 #include <glm\glm.hpp>
 
+#include <deque>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 class Scene;
 struct GLFWwindow;
 class Entity;
 struct ModelComponent;
+struct MeshNode;
+struct Mesh;
+struct Material;
 class Shader;
+class StaticGeometry;
+class SpatialIndex;
+class OcclusionBuffer;
+struct OccluderMesh;
+class UniformRingBuffer;
 
 class RenderSystem : public System {
 public:
+	// Draws in the last frame, not counting debug drawing
+	struct RenderStats {
+		size_t numVisibleDraws = 0;
+		size_t numCulledDraws = 0;   // Outside the view frustum
+		size_t numOccludedDraws = 0; // Hidden behind occluders
+		size_t numCulledModels = 0;  // Non-static models outside the view, skipped by the spatial index
+
+		// Triangles drawn from the render queue, and how many more would
+		// have been drawn without levels of detail.
+		// Static geometry is always drawn at full detail.
+		size_t numTriangles = 0;
+		size_t numTrianglesSavedByLOD = 0;
+	};
+
 	RenderSystem(Scene&);
 	~RenderSystem();
 	RenderSystem(const RenderSystem&) = delete;
@@ -49,17 +78,33 @@ public:
 
 	// Starts rendering the frame.
 	// Should be called before update.
+	// Starts rasterizing the occluders found by the last update, and
+	// assigning the lights to clusters, as jobs so they run alongside the
+	// updates of this frame.
 	void beginFrame() override;
 
-	// Renders an entity.
+	// Queues an entities meshes to be drawn, at a level of detail picked
+	// from how large they are on screen.
+	// Occluders are kept to be rasterized next frame, at the transform
+	// they have then.
 	void update(Entity&) override;
 
-	// Ends the frame.
+	// Sorts and draws the queued meshes, then ends the frame.
+	// The models queued this frame must not be changed or destroyed
+	// before this is called.
 	void endFrame() override;
 
+	// Returns the draw counts of the last frame
+	const RenderStats& getStats() const;
+
 	// Sets the current camera.
 	// Also sets the static debug camera for debug drawing.
-	void setCamera(const Entity*);
+	void setCamera(const EntityHandle&);
+
+	// Sets the spatial index used to skip non-static models outside the
+	// view, or null to queue every model and cull each draw.
+	// The index must be of this systems scene and outlive its use here.
+	void setSpatialIndex(const SpatialIndex*);
 
 	// Sets the radiance map for reflections
 	void setRadianceMap(GLuint radianceMap);
@@ -68,10 +113,132 @@ public:
 	void setIrradianceMap(GLuint irradianceMap);
 
 private:
-	static void renderModel(const ModelComponent&, const glm::mat4& transform);
+	// The first vertex attribute location of the instance transform
+	static const GLuint s_kInstanceTransformLocation = 4;
+
+	// The light buffers are bound to the last texture units for the
+	// whole frame, clear of the units materials use
+	static const GLuint s_kLightDataTextureUnit = 13;
+	static const GLuint s_kLightClusterTextureUnit = 14;
+	static const GLuint s_kLightIndexTextureUnit = 15;
+
+	// The shader, textures and uniforms a material sets.
+	// Materials that set the same state share a material id.
+	struct MaterialState {
+		const Shader* shader;
+		std::vector<GLuint> textures;
+		float heightMapScale;
+		glm::vec3 debugColor;
+		float metallicness;
+		float glossiness;
+		float specBias;
+		bool discardTransparent;
+
+		bool operator==(const MaterialState&) const;
+	};
+
+	struct MaterialStateHash {
+		size_t operator()(const MaterialState&) const;
+	};
+
+	// The LOD each mesh of an entity was last drawn at
+	struct EntityLODs {
+		uint32_t generation = 0;
+		std::vector<uint8_t> meshLODs;
+	};
+
+	static uint32_t getMaterialID(const Material&);
+
+	// Queues a models meshes.
+	// If meshLODs is given, meshes are drawn at the level of detail that
+	// suits their size on screen, starting from the LOD they were last
+	// drawn at, and meshLODs is updated with the LODs drawn.
+	// Otherwise every mesh is drawn at full detail.
+	static void queueModel(RenderQueue&, const ModelComponent&, const glm::mat4& transform, uint8_t* meshLODs = nullptr);
+	static void queueNode(RenderQueue&, const ModelComponent&, const MeshNode&, const glm::mat4& parentTransform, uint8_t* meshLODs);
+	static void queueMesh(RenderQueue&, const ModelComponent&, const Mesh&, const glm::mat4& transform, uint8_t* lod);
+
+	// Returns the LOD to draw a mesh at, from the fraction of the screen
+	// height its bounding sphere covers.
+	// A mesh only moves to another LOD once it is well past the size
+	// where the LODs switch, so it doesn't flicker between them.
+	static int selectLOD(const Mesh&, const glm::mat4& transform, int lastLOD);
+
+	// An occluder to rasterize, copied from its entity so the occlusion
+	// job doesn't read the scene
+	struct OccluderDraw {
+		std::shared_ptr<const OccluderMesh> mesh;
+		glm::mat4 transform;
+	};
+
+	// Culls, sorts and draws the queue, changing GPU state only between
+	// draws that need different state.
+	// Static geometry is culled and drawn first, if given.
+	// Draws hidden in the occlusion buffer are culled, if given.
+	static RenderStats submit(RenderQueue&, StaticGeometry* = nullptr, const OcclusionBuffer* = nullptr);
+	static glm::mat4 calculateProjection();
+	static void submitStatic(const StaticGeometry&);
+	static bool isOpaque(const ModelComponent&);
+	static void setPassState(RenderQueue::Pass);
+	static void bindUniformBlocks(const Shader&);
+
+	// Binds the frames light buffers, and points the shaders light
+	// samplers at them
+	static void bindLightBuffers();
+	static void setLightSamplers(const Shader&);
+
+	// Binds a vertex array, setting up its instance attributes to read
+	// from the instance buffer if they aren't already
+	static void bindInstancedVertexArray(GLuint VAO, GLuint instanceBuffer);
+	static void bindMaterial(const Material&);
+
+	// Marks the entities whose models the spatial index finds in the
+	// cameras view this frame
+	void findVisibleEntities();
+
+	// Queues a job to rasterize the occluders found by the last update
+	void startOcclusionJob();
+
+	// Collects the lights in world space and queues a job to assign them
+	// to the clusters of the cameras view
+	void startLightJob();
+
+	// Waits for the light job and copies the lights and their clusters
+	// into the light buffers
+	void uploadLights();
 
 	static RenderState s_renderState;
+	static RenderQueue s_debugQueue;
+	static RenderQueue s_staticDraws; // Scratch queue for the draws of a static model
+	static std::deque<ModelComponent> s_debugModels; // Debug models queued this frame
+	static std::unordered_map<MaterialState, uint32_t, MaterialStateHash> s_materialIDs;
+	static MaterialState s_scratchMaterialState;
+	static std::vector<glm::mat4> s_instanceTransforms;
+	static std::unordered_map<GLuint, GLuint> s_instanceBuffers; // The instance buffer each vertex array reads from
 	RenderState m_renderState;
+	RenderQueue m_renderQueue;
+	std::unique_ptr<UniformRingBuffer> m_uniformBuffer;
+	std::unique_ptr<StaticGeometry> m_staticGeometry; // Null if indirect draws aren't supported
+	std::unique_ptr<OcclusionBuffer> m_occlusionBuffer;
+	std::vector<EntityHandle> m_occluderEntities;     // Found by update, rasterized next frame
+	std::vector<OccluderDraw> m_occluderDraws;        // Read by the occlusion job
+	std::vector<EntityLODs> m_entityLODs;             // Entity index -> LODs
+	const SpatialIndex* m_spatialIndex;               // Null if every model is queued
+	std::vector<Entity*> m_visibleEntities;           // Scratch for the frustum query
+	std::vector<uint64_t> m_entityVisibleFrames;      // Entity index -> last frame its model was in view
+	uint64_t m_frameIndex;
+	size_t m_numCulledModels;
+	JobCounter m_occlusionJob;
+	std::unique_ptr<LightClusters> m_lightClusters;
+	std::vector<ClusterLight> m_lights;               // Read by the light job
+	JobCounter m_lightJob;
+	GLuint m_lightDataBuffer;
+	GLuint m_lightClusterBuffer;
+	GLuint m_lightIndexBuffer;
+	size_t m_maxLights;                               // Limited by the texture buffer size
+	bool m_hasLightJob;                               // Whether the light job was started this frame
+	RenderStats m_stats;
+	EntityHandle m_camera;
 	std::vector<const Shader*> m_postProcessShaders;
 	GLsizei m_curPostProcessShaderIdx;
 };
@@ -2,26 +2,33 @@
 
 #include "Entity.h"
 #include "EntityEventListener.h"
+#include "GLMUtils.h"
+#include "JobSystem.h"
+
+#include <glm\glm.hpp>
 
 #include <algorithm>
+#include <cassert>
+#include <type_traits>
 #include "Log.h"
 
+// Entities are released with their arena blocks without being destroyed
+static_assert(std::is_trivially_destructible<Entity>::value, "Entity must be trivially destructible");
+
 Scene* Scene::s_currentScene = nullptr;
 
 Entity& Scene::createEntity(size_t componentMask)
 {
 	Entity* newEntity;
 
-	auto freeMem = std::find_if(m_entities.begin(), m_entities.end(), [](const std::unique_ptr<Entity>& entity) {
-		return !entity->hasComponents();
-	});
-	if (freeMem != m_entities.end())
+	if (m_freeListHead != s_kNoFreeEntity) {
 		// Reuse destroyed entity memory
-		newEntity = freeMem->get();
-	else {
-		// Allocate memory for new entity
-		newEntity = new Entity(m_eventListeners);
-		m_entities.emplace_back(newEntity);
+		newEntity = &m_entities[m_freeListHead];
+		m_freeListHead = newEntity->m_nextFree;
+		newEntity->m_isAlive = true;
+	} else {
+		// Bump allocate a new entity from the arena
+		newEntity = &m_entities.emplaceBack(m_componentStorage, m_entities.size(), m_eventQueue);
 	}
 
 	newEntity->addComponents(componentMask);
@@ -32,13 +39,41 @@ Entity& Scene::createEntity(size_t componentMask)
 
 void Scene::destroyEntity(Entity& entity)
 {
+	if (!entity.isAlive()) {
+		g_log << "WARNING: Tried to destroy an Entity that was already destroyed\n";
+		return;
+	}
+
 	triggerEntityDestructionEvent(entity);
 	entity.destroy();
+
+	// Push the entity onto the free list for reuse
+	entity.m_nextFree = m_freeListHead;
+	m_freeListHead = entity.getIndex();
 }
 
 Entity& Scene::getEntity(size_t entityID)
 {
-	return *m_entities.at(entityID);
+	assert(entityID < m_entities.size());
+	return m_entities[entityID];
+}
+
+Entity* Scene::getEntity(const EntityHandle& handle)
+{
+	if (handle.index >= m_entities.size())
+		return nullptr;
+
+	Entity* entity = &m_entities[handle.index];
+	return entity->m_generation == handle.generation ? entity : nullptr;
+}
+
+const Entity* Scene::getEntity(const EntityHandle& handle) const
+{
+	if (handle.index >= m_entities.size())
+		return nullptr;
+
+	const Entity* entity = &m_entities[handle.index];
+	return entity->m_generation == handle.generation ? entity : nullptr;
 }
 
 size_t Scene::getEntityCount()
@@ -46,6 +81,189 @@ size_t Scene::getEntityCount()
 	return m_entities.size();
 }
 
+void Scene::restoreEntity(const EntityHandle& handle, size_t componentMask, bool isAlive)
+{
+	assert(handle.index == m_entities.size());
+
+	Entity& entity = m_entities.emplaceBack(m_componentStorage, m_entities.size(), m_eventQueue);
+	entity.m_generation = handle.generation;
+	entity.m_isAlive = isAlive;
+
+	if (isAlive) {
+		entity.m_componentMask = componentMask;
+		triggerEntityCreationEvent(entity);
+		entity.triggerPostAddComponentsEvent(componentMask);
+	} else {
+		// Push the entity onto the free list for reuse
+		entity.m_nextFree = m_freeListHead;
+		m_freeListHead = entity.getIndex();
+	}
+}
+
+EntityCommandBuffer& Scene::getCommandBuffer()
+{
+	size_t threadIdx = JobSystem::getThreadIndex();
+
+	std::lock_guard<std::mutex> lock(m_commandBuffersMutex);
+	if (threadIdx >= m_commandBuffers.size())
+		m_commandBuffers.resize(threadIdx + 1);
+	if (!m_commandBuffers[threadIdx])
+		m_commandBuffers[threadIdx] = std::make_unique<EntityCommandBuffer>();
+
+	return *m_commandBuffers[threadIdx];
+}
+
+void Scene::playbackCommands()
+{
+	// Play back in thread order so the main threads changes come first
+	for (auto& commandBuffer : m_commandBuffers) {
+		if (commandBuffer && !commandBuffer->isEmpty())
+			commandBuffer->playback(*this);
+	}
+}
+
+void Scene::storePreviousTransforms()
+{
+	++m_numTransformSteps;
+
+	ComponentPool<TransformComponent>& transforms = m_componentStorage.getPool<TransformComponent>();
+	if (m_previousTransforms.size() < m_entities.size())
+		m_previousTransforms.resize(m_entities.size());
+
+	for (size_t i = 0; i < transforms.size(); ++i) {
+		size_t entityIndex = transforms.getEntityIndex(i);
+		PreviousTransform& previous = m_previousTransforms[entityIndex];
+		previous.transform = transforms[i];
+		previous.step = m_numTransformSteps;
+		previous.generation = m_entities[entityIndex].m_generation;
+	}
+
+	ComponentPool<CameraComponent>& cameras = m_componentStorage.getPool<CameraComponent>();
+	if (m_previousCameras.size() < m_entities.size())
+		m_previousCameras.resize(m_entities.size());
+
+	for (size_t i = 0; i < cameras.size(); ++i) {
+		size_t entityIndex = cameras.getEntityIndex(i);
+		PreviousCamera& previous = m_previousCameras[entityIndex];
+		previous.camera = cameras[i];
+		previous.step = m_numTransformSteps;
+		previous.generation = m_entities[entityIndex].m_generation;
+	}
+}
+
+TransformComponent Scene::getInterpolatedTransform(const Entity& entity, float alpha) const
+{
+	const TransformComponent& current = entity.transform();
+	size_t entityIndex = entity.getIndex();
+	if (entityIndex >= m_previousTransforms.size())
+		return current;
+
+	const PreviousTransform& previousState = m_previousTransforms[entityIndex];
+	if (previousState.step != m_numTransformSteps || previousState.generation != entity.m_generation)
+		return current;
+
+	const TransformComponent& previous = previousState.transform;
+	TransformComponent interpolated;
+	interpolated.position = glm::mix(previous.position, current.position, alpha);
+	interpolated.rotation = current.rotation;
+	if (previous.rotation != current.rotation)
+		interpolated.rotation = glm::slerp(previous.rotation, current.rotation, alpha);
+	interpolated.scale = glm::mix(previous.scale, current.scale, alpha);
+	interpolated.parent = current.parent;
+	return interpolated;
+}
+
+CameraComponent Scene::getInterpolatedCamera(const Entity& entity, float alpha) const
+{
+	const CameraComponent& current = entity.camera();
+	size_t entityIndex = entity.getIndex();
+	if (entityIndex >= m_previousCameras.size())
+		return current;
+
+	const PreviousCamera& previousState = m_previousCameras[entityIndex];
+	if (previousState.step != m_numTransformSteps || previousState.generation != entity.m_generation)
+		return current;
+
+	const CameraComponent& previous = previousState.camera;
+	if (previous.getView() == current.getView())
+		return current;
+
+	// Slerp the orientations so the camera turns at a constant rate
+	auto getOrientation = [](const CameraComponent& camera) {
+		glm::vec3 up = glm::cross(camera.getRight(), camera.getForward());
+		return glm::quat_cast(glm::mat3(camera.getRight(), up, -camera.getForward()));
+	};
+	glm::quat orientation = glm::slerp(getOrientation(previous), getOrientation(current), alpha);
+	glm::vec3 position = glm::mix(previous.getPosition(), current.getPosition(), alpha);
+
+	CameraComponent interpolated;
+	interpolated.setLookAt(position, position + orientation * glm::vec3(0, 0, -1), orientation * glm::vec3(0, 1, 0));
+	return interpolated;
+}
+
+void Scene::updateWorldMatrices(float alpha)
+{
+	++m_numWorldMatrixUpdates;
+
+	ComponentPool<TransformComponent>& transforms = m_componentStorage.getPool<TransformComponent>();
+	if (m_cachedTransforms.size() < m_entities.size())
+		m_cachedTransforms.resize(m_entities.size());
+
+	// Find the transforms that changed since the last update.
+	// Comparing the transform is much cheaper than building its matrix.
+	m_changedTransforms.clear();
+	m_changedTransformIndices.clear();
+	for (size_t i = 0; i < transforms.size(); ++i) {
+		size_t entityIndex = transforms.getEntityIndex(i);
+		const Entity& entity = m_entities[entityIndex];
+		CachedTransform& cached = m_cachedTransforms[entityIndex];
+		TransformComponent local = getInterpolatedTransform(entity, alpha);
+		if (cached.generation != entity.m_generation || !isSameTransform(cached.local, local)) {
+			cached.local = local;
+			cached.generation = entity.m_generation;
+			cached.isLocalDirty = true;
+			m_changedTransforms.push_back(local.position, local.rotation, local.scale);
+			m_changedTransformIndices.push_back(entityIndex);
+		}
+	}
+
+	// Rebuild their local matrices together, so several can be built at
+	// once with SIMD
+	m_changedLocalMatrices.resize(m_changedTransforms.size());
+	TransformBatch::buildMatrices(m_changedTransforms, m_changedLocalMatrices.data());
+	for (size_t i = 0; i < m_changedTransformIndices.size(); ++i)
+		m_cachedTransforms[m_changedTransformIndices[i]].localMatrix = m_changedLocalMatrices[i];
+
+	// Then rebuild the world matrices below them
+	m_changedWorldMatrices.clear();
+	for (size_t i = 0; i < transforms.size(); ++i)
+		updateWorldMatrix(transforms.getEntityIndex(i));
+
+	if (m_changedWorldMatrices.empty())
+		return;
+
+	for (size_t i = 0; i < m_eventListeners.size(); ++i) {
+		ListenerRegistration registration = m_eventListeners[i];
+		if (Entity::matchesAny(registration.interestMask, COMPONENT_TRANSFORM))
+			registration.listener->onWorldMatricesChanged(m_changedWorldMatrices.data(), m_changedWorldMatrices.size());
+	}
+}
+
+const glm::mat4& Scene::getWorldMatrix(const Entity& entity) const
+{
+	static const glm::mat4 s_kIdentity;
+
+	size_t entityIndex = entity.getIndex();
+	if (entityIndex >= m_cachedTransforms.size())
+		return s_kIdentity;
+
+	const CachedTransform& cached = m_cachedTransforms[entityIndex];
+	if (cached.update != m_numWorldMatrixUpdates || cached.generation != entity.m_generation)
+		return s_kIdentity;
+
+	return cached.worldMatrix;
+}
+
 void Scene::makeSceneCurrent(Scene* scene)
 {
 	s_currentScene = scene;
@@ -56,10 +274,10 @@ Scene * Scene::getCurrentScene()
 	return s_currentScene;
 }
 
-void Scene::registerEntityEventListener(EntityEventListener* eventListener)
+void Scene::registerEntityEventListener(EntityEventListener* eventListener, size_t interestMask)
 {
 	if (eventListener) {
-		m_eventListeners.push_back(eventListener);
+		m_eventListeners.push_back({ eventListener, interestMask });
 	} else {
 		// TODO: Add logging here
 		g_log << "WARNING: Tried to register a nullptr as an Entity Event Listener\n";
@@ -68,7 +286,9 @@ void Scene::registerEntityEventListener(EntityEventListener* eventListener)
 
 void Scene::removeEntityEventListener(EntityEventListener* eventListener)
 {
-	auto removeIt = std::remove(m_eventListeners.begin(), m_eventListeners.end(), eventListener);
+	auto removeIt = std::remove_if(m_eventListeners.begin(), m_eventListeners.end(), [eventListener](const ListenerRegistration& registration) {
+		return registration.listener == eventListener;
+	});
 	if (removeIt != m_eventListeners.end())
 		m_eventListeners.erase(removeIt);
 	else {
@@ -77,16 +297,72 @@ void Scene::removeEntityEventListener(EntityEventListener* eventListener)
 	}
 }
 
-void Scene::triggerEntityCreationEvent(Entity& entity)
+void Scene::dispatchEntityEvents()
 {
-	for (auto eventListener : m_eventListeners) {
-		eventListener->onEntityCreation(entity);
+	// Take the events first, listeners may cause more events which will be
+	// sent on the next dispatch.
+	m_eventQueue.takeEvents(m_dispatchingEvents);
+	if (m_dispatchingEvents.empty())
+		return;
+
+	for (size_t i = 0; i < m_eventListeners.size(); ++i) {
+		ListenerRegistration registration = m_eventListeners[i];
+
+		m_listenerEvents.clear();
+		for (const EntityEvent& event : m_dispatchingEvents) {
+			if (Entity::matchesAny(event.addedComponents | event.removedComponents, registration.interestMask))
+				m_listenerEvents.push_back(event);
+		}
+
+		if (!m_listenerEvents.empty())
+			registration.listener->onEntityEvents(m_listenerEvents.data(), m_listenerEvents.size());
 	}
 }
 
-void Scene::triggerEntityDestructionEvent(Entity& entity)
+bool Scene::isSameTransform(const TransformComponent& lhs, const TransformComponent& rhs)
 {
-	for (auto eventListener : m_eventListeners) {
-		eventListener->onEntityDestruction(entity);
+	return lhs.position == rhs.position
+	    && lhs.rotation == rhs.rotation
+	    && lhs.scale == rhs.scale
+	    && lhs.parent == rhs.parent;
+}
+
+void Scene::updateWorldMatrix(size_t entityIndex)
+{
+	CachedTransform& cached = m_cachedTransforms[entityIndex];
+	if (cached.update == m_numWorldMatrixUpdates)
+		return;
+
+	// Marking the entity first also stops parent cycles from recursing
+	// forever, the entity that closes a cycle keeps its old world matrix
+	cached.update = m_numWorldMatrixUpdates;
+
+	const Entity* parent = getEntity(cached.local.parent);
+	const CachedTransform* parentCached = nullptr;
+	if (parent && parent->hasComponents(COMPONENT_TRANSFORM)) {
+		updateWorldMatrix(parent->getIndex());
+		parentCached = &m_cachedTransforms[parent->getIndex()];
 	}
+
+	// Only rebuild the world matrix if the local matrix or the parents
+	// world matrix has changed
+	uint64_t parentVersion = parentCached ? parentCached->worldVersion : 0;
+	if (!cached.isLocalDirty && cached.parentVersion == parentVersion)
+		return;
+
+	cached.worldMatrix = parentCached ? parentCached->worldMatrix * cached.localMatrix : cached.localMatrix;
+	cached.worldVersion = ++m_numWorldMatrixBuilds;
+	cached.parentVersion = parentVersion;
+	cached.isLocalDirty = false;
+	m_changedWorldMatrices.push_back(entityIndex);
+}
+
+void Scene::triggerEntityCreationEvent(Entity& entity)
+{
+	m_eventQueue.recordCreation(entity.getHandle());
+}
+
+void Scene::triggerEntityDestructionEvent(Entity& entity)
+{
+	m_eventQueue.recordDestruction(entity.getHandle());
 }
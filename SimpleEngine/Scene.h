@@ -15,33 +15,163 @@
 #pragma once
 
 #include "Entity.h"
+#include "ChunkedArena.h"
+#include "ComponentStorage.h"
+#include "ComponentView.h"
+#include "EntityCommandBuffer.h"
+#include "EntityEvent.h"
+#include "TransformBatch.h"
+
+#include <glm\glm.hpp>
 
 #include <vector>
 #include <memory>
+#include <mutex>
 
 class EntityEventListener;
 
 class Scene {
 public:
+	static const size_t s_kAllComponents = static_cast<size_t>(-1);
+
 	template<typename ...ComponentTs>
 	Entity& createEntity(size_t firstComponent, ComponentTs... rest);
 	Entity& createEntity(size_t componentType);
 	void destroyEntity(Entity&);
 	Entity& getEntity(size_t entityID);
+
+	// Returns the entity the handle refers to.
+	// Returns nullptr if that entity has since been destroyed.
+	Entity* getEntity(const EntityHandle&);
+	const Entity* getEntity(const EntityHandle&) const;
+
 	size_t getEntityCount();
+
+	// Recreates an entity slot saved in a scene snapshot, keeping its
+	// generation so saved handles still resolve.
+	// Slots must be restored in index order into a scene that has never
+	// had entities created in it.
+	// The entities components must be restored directly into the
+	// component pools.
+	void restoreEntity(const EntityHandle&, size_t componentMask, bool isAlive);
+
+	// Returns the packed array of all components of the specified type
+	// in the scene.
+	// Systems can iterate this directly to stream only the components
+	// they need.
+	template <typename ComponentT>
+	ComponentPool<ComponentT>& getComponents();
+
+	// Returns a view over all the entities that have every one of the
+	// specified components i.e.
+	// scene.view<TransformComponent, PhysicsComponent>().each(...)
+	template <typename ...ComponentTs>
+	ComponentView<ComponentTs...> view();
+	// Returns the command buffer for the calling thread.
+	// Systems should record structural changes here while the scene is
+	// being updated, rather than changing the scene directly.
+	EntityCommandBuffer& getCommandBuffer();
+
+	// Applies the changes recorded in every threads command buffer.
+	// Must only be called while no systems are updating.
+	void playbackCommands();
+
+	// Records every entities transform and camera as the previous
+	// simulation state.
+	// Should be called before each simulation step.
+	void storePreviousTransforms();
+
+	// Returns the entities transform blended from its previous simulation
+	// state to its current one by alpha.
+	// Entities that didn't have a transform at the last
+	// storePreviousTransforms use their current transform.
+	TransformComponent getInterpolatedTransform(const Entity&, float alpha) const;
+
+	// Returns the entities camera blended from its previous simulation
+	// state to its current one by alpha, in the same way as transforms.
+	CameraComponent getInterpolatedCamera(const Entity&, float alpha) const;
+
+	// Brings the cached world matrices of every entity with a transform up
+	// to date, using their transforms interpolated by alpha.
+	// Only entities whose transform changed, and the entities below them
+	// in the hierarchy, have their matrices rebuilt.
+	// Listeners interested in transforms are then told which entities
+	// world matrices changed.
+	// Must only be called while no systems are updating.
+	void updateWorldMatrices(float alpha);
+
+	// Returns the entities world matrix from the last updateWorldMatrices.
+	// Entities that had no transform at the time use the identity.
+	const glm::mat4& getWorldMatrix(const Entity&) const;
+
 	static void makeSceneCurrent(Scene* scene);
 	static Scene* getCurrentScene();
-	void registerEntityEventListener(EntityEventListener*);
+
+	// Registers a listener for entity events.
+	// The listener will only be sent events that add or remove
+	// components in the interest mask.
+	void registerEntityEventListener(EntityEventListener*, size_t interestMask = s_kAllComponents);
 	void removeEntityEventListener(EntityEventListener*);
 
+	// Sends all the entity events queued since the last dispatch to the
+	// interested listeners, with one call per listener.
+	// Must only be called while no systems are updating.
+	void dispatchEntityEvents();
+
 private:
-	// TODO: Change this to be a vector of 'observable' entities
-	// that can be observed robustly, even when a vector resize causes the
-	// entities to shift in memory.
-	std::vector<std::unique_ptr<Entity>> m_entities;
-	std::vector<EntityEventListener*> m_eventListeners;
+	static const size_t s_kNoFreeEntity = static_cast<size_t>(-1);
+
+	struct PreviousTransform {
+		TransformComponent transform;
+		uint64_t step = 0;       // Only valid if this is the current step
+		uint32_t generation = 0; // and the slot holds the same entity
+	};
+
+	struct PreviousCamera {
+		CameraComponent camera;
+		uint64_t step = 0;
+		uint32_t generation = 0;
+	};
+
+	struct CachedTransform {
+		TransformComponent local;   // The transform the local matrix was built from
+		glm::mat4 localMatrix;
+		glm::mat4 worldMatrix;
+		uint64_t worldVersion = 0;  // Unique to each world matrix built
+		uint64_t parentVersion = 0; // The parents world matrix this was built from, 0 if it has no parent
+		uint64_t update = 0;        // The last updateWorldMatrices this was brought up to date in
+		uint32_t generation = 0;    // Only valid if the slot holds the same entity
+		bool isLocalDirty = false;
+	};
+
+	struct ListenerRegistration {
+		EntityEventListener* listener;
+		size_t interestMask;
+	};
+
+	ComponentStorage m_componentStorage;
+	ChunkedArena<Entity> m_entities;
+	size_t m_freeListHead = s_kNoFreeEntity; // Most recently destroyed entity
+	std::vector<PreviousTransform> m_previousTransforms; // Entity index -> transform before the current step
+	std::vector<PreviousCamera> m_previousCameras;       // Entity index -> camera before the current step
+	uint64_t m_numTransformSteps = 0;
+	std::vector<CachedTransform> m_cachedTransforms; // Entity index -> matrices
+	uint64_t m_numWorldMatrixUpdates = 0;
+	uint64_t m_numWorldMatrixBuilds = 0;
+	TransformBatch::Transforms m_changedTransforms;  // Transforms whose local matrix is being rebuilt
+	std::vector<size_t> m_changedTransformIndices;   // Changed transform -> entity index
+	std::vector<glm::mat4> m_changedLocalMatrices;
+	std::vector<size_t> m_changedWorldMatrices;      // Entity indices whose world matrix was rebuilt
+	std::vector<ListenerRegistration> m_eventListeners;
+	EntityEventQueue m_eventQueue;
+	std::vector<EntityEvent> m_dispatchingEvents;
+	std::vector<EntityEvent> m_listenerEvents;
+	std::vector<std::unique_ptr<EntityCommandBuffer>> m_commandBuffers; // Job system thread index -> command buffer
+	std::mutex m_commandBuffersMutex;
 	static Scene* s_currentScene;
 
+	static bool isSameTransform(const TransformComponent&, const TransformComponent&);
+	void updateWorldMatrix(size_t entityIndex);
 	void triggerEntityCreationEvent(Entity&);
 	void triggerEntityDestructionEvent(Entity&);
 };
@@ -53,3 +183,15 @@ inline Entity& Scene::createEntity(size_t firstComponent, ComponentTs... rest)
 	Entity& entity = createEntity(componentMask);
 	return entity;
 }
+
+template <typename ComponentT>
+inline ComponentPool<ComponentT>& Scene::getComponents()
+{
+	return m_componentStorage.getPool<ComponentT>();
+}
+
+template <typename ...ComponentTs>
+inline ComponentView<ComponentTs...> Scene::view()
+{
+	return ComponentView<ComponentTs...>(m_componentStorage, m_entities);
+}
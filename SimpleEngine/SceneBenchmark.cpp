@@ -0,0 +1,472 @@
+#include "SceneBenchmark.h"
+
+#include "CameraSystem.h"
+#include "InputSystem.h"
+#include "Log.h"
+#include "PhysicsSystem.h"
+#include "PickupSystem.h"
+#include "RenderSystem.h"
+#include "Screen.h"
+#include "SimpleWorldSpaceMoveSystem.h"
+#include "SnakeTailSystem.h"
+#include "SpatialIndex.h"
+#include "StressScene.h"
+#include "TerrainFollowSystem.h"
+#include "VehicleMovementSystem.h"
+
+#include <glad\glad.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <typeinfo>
+
+namespace {
+	using BenchClock = std::chrono::high_resolution_clock;
+
+	const int g_kNumWarmupFrames = 30;
+	const std::string g_kResultsPath = "SceneBenchmarkResults.json";
+	const std::string g_kFrameName = "Frame";
+
+	// Times below this many milliseconds are too short to compare reliably
+	const double g_kMinComparableTime = 0.05;
+
+	double secondsSince(BenchClock::time_point start)
+	{
+		return std::chrono::duration<double>(BenchClock::now() - start).count();
+	}
+
+	// Frame times in milliseconds
+	struct TimeStats {
+		double mean = 0;
+		double p50 = 0;
+		double p99 = 0;
+	};
+
+	struct BenchmarkResults {
+		float scale = 0;
+		int numFrames = 0;
+		std::map<std::string, TimeStats> times; // Name -> times, "Frame" is the whole frame
+	};
+
+	struct Options {
+		float scale = 1;
+		int numFrames = 300;
+		unsigned seed = 1;
+		std::string baselinePath = "Benchmarks/SceneBenchmarkBaseline.json";
+		double threshold = 0.1;
+		bool willWriteBaseline = false;
+		bool isBaselineRequired = false;
+	};
+
+	// Runs the stress scene with the same systems as the gameplay screen
+	class StressScreen : public Screen {
+	public:
+		StressScreen(const StressScene::Settings& settings, unsigned seed)
+		{
+			Entity& camera = StressScene::create(m_scene, settings, seed, m_playerList);
+
+			m_activeSystems.push_back(std::make_unique<InputSystem>(m_scene));
+			m_activeSystems.push_back(std::make_unique<VehicleMovementSystem>(m_scene));
+			m_activeSystems.push_back(std::make_unique<PhysicsSystem>(m_scene));
+			m_activeSystems.push_back(std::make_unique<SnakeTailSystem>(m_scene));
+			m_activeSystems.push_back(std::make_unique<PickupSystem>(m_scene, m_playerList));
+			m_activeSystems.push_back(std::make_unique<TerrainFollowSystem>(m_scene));
+			m_activeSystems.push_back(std::make_unique<SimpleWorldSpaceMoveSystem>(m_scene));
+			m_activeSystems.push_back(std::make_unique<CameraSystem>(m_scene, m_playerList));
+
+			m_spatialIndex = std::make_unique<SpatialIndex>(m_scene);
+			auto renderSystem = std::make_unique<RenderSystem>(m_scene);
+			renderSystem->setCamera(camera.getHandle());
+			renderSystem->setSpatialIndex(m_spatialIndex.get());
+			m_frameSystems.push_back(std::move(renderSystem));
+		}
+
+		// Runs exactly one simulation step and one render, regardless of
+		// how long the last frame took
+		void runFrame()
+		{
+			m_scene.dispatchEntityEvents();
+			updateSimulationStep();
+			updateFrameSystems();
+		}
+
+		std::vector<const System*> getSystems() const
+		{
+			std::vector<const System*> systems;
+			for (auto& system : m_activeSystems)
+				systems.push_back(system.get());
+			for (auto& system : m_frameSystems)
+				systems.push_back(system.get());
+			return systems;
+		}
+
+	private:
+		std::vector<Entity*> m_playerList;
+		std::unique_ptr<SpatialIndex> m_spatialIndex;
+	};
+
+	std::string getSystemName(const System& system)
+	{
+		// MSVC prefixes type names with "class "
+		std::string name = typeid(system).name();
+		const std::string kClassPrefix = "class ";
+		if (name.compare(0, kClassPrefix.size(), kClassPrefix) == 0)
+			name.erase(0, kClassPrefix.size());
+		return name;
+	}
+
+	TimeStats calculateStats(std::vector<double> times)
+	{
+		TimeStats stats;
+		if (times.empty())
+			return stats;
+
+		std::sort(times.begin(), times.end());
+		for (double time : times)
+			stats.mean += time;
+		stats.mean /= times.size();
+
+		// Nearest rank percentiles
+		auto percentile = [&times](double fraction) {
+			size_t rank = static_cast<size_t>(std::ceil(fraction * times.size()));
+			return times[std::max<size_t>(rank, 1) - 1];
+		};
+		stats.p50 = percentile(0.5);
+		stats.p99 = percentile(0.99);
+
+		return stats;
+	}
+
+	bool parseOptions(const std::vector<std::string>& args, Options& options)
+	{
+		for (size_t i = 0; i < args.size(); ++i) {
+			const std::string& arg = args[i];
+			bool hasValue = i + 1 < args.size();
+			if (arg == "--write-baseline")
+				options.willWriteBaseline = true;
+			else if (arg == "--require-baseline")
+				options.isBaselineRequired = true;
+			else if (arg == "--scale" && hasValue)
+				options.scale = std::strtof(args[++i].c_str(), nullptr);
+			else if (arg == "--frames" && hasValue)
+				options.numFrames = std::atoi(args[++i].c_str());
+			else if (arg == "--seed" && hasValue)
+				options.seed = static_cast<unsigned>(std::strtoul(args[++i].c_str(), nullptr, 10));
+			else if (arg == "--baseline" && hasValue)
+				options.baselinePath = args[++i];
+			else if (arg == "--threshold" && hasValue)
+				options.threshold = std::strtod(args[++i].c_str(), nullptr);
+			else {
+				g_log << "WARNING: Unknown or incomplete scene benchmark option " << arg << "\n";
+				return false;
+			}
+		}
+
+		if (options.scale <= 0 || options.numFrames <= 0 || options.threshold < 0) {
+			g_log << "WARNING: Scene benchmark options are out of range\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool writeResults(const BenchmarkResults& results, const std::string& path)
+	{
+		std::ofstream file(path);
+		if (!file) {
+			g_log << "WARNING: Failed to open scene benchmark results file " << path << "\n";
+			return false;
+		}
+
+		file << "{\n";
+		file << "\t\"scale\": " << results.scale << ",\n";
+		file << "\t\"frames\": " << results.numFrames << ",\n";
+		file << "\t\"systems\": {";
+		bool isFirst = true;
+		for (auto& nameAndStats : results.times) {
+			const TimeStats& stats = nameAndStats.second;
+			file << (isFirst ? "\n" : ",\n");
+			file << "\t\t\"" << nameAndStats.first << "\": { \"mean\": " << stats.mean
+			     << ", \"p50\": " << stats.p50 << ", \"p99\": " << stats.p99 << " }";
+			isFirst = false;
+		}
+		file << "\n\t}\n}\n";
+
+		return file.good();
+	}
+
+	// Reads the JSON written by writeResults.
+	// Only handles objects, strings and numbers, which is all the results
+	// contain.
+	class ResultsReader {
+	public:
+		ResultsReader(const std::string& text)
+			: m_text{ text }
+			, m_pos{ 0 }
+		{
+		}
+
+		bool read(BenchmarkResults& outResults)
+		{
+			if (!expect('{'))
+				return false;
+
+			while (!tryExpect('}')) {
+				std::string key;
+				if (!readString(key) || !expect(':'))
+					return false;
+
+				if (key == "systems") {
+					if (!readSystems(outResults.times))
+						return false;
+				} else {
+					double value;
+					if (!readNumber(value))
+						return false;
+					if (key == "scale")
+						outResults.scale = static_cast<float>(value);
+					else if (key == "frames")
+						outResults.numFrames = static_cast<int>(value);
+				}
+
+				tryExpect(',');
+			}
+
+			return true;
+		}
+
+	private:
+		bool readSystems(std::map<std::string, TimeStats>& outTimes)
+		{
+			if (!expect('{'))
+				return false;
+
+			while (!tryExpect('}')) {
+				std::string name;
+				if (!readString(name) || !expect(':') || !expect('{'))
+					return false;
+
+				TimeStats& stats = outTimes[name];
+				while (!tryExpect('}')) {
+					std::string key;
+					double value;
+					if (!readString(key) || !expect(':') || !readNumber(value))
+						return false;
+					if (key == "mean")
+						stats.mean = value;
+					else if (key == "p50")
+						stats.p50 = value;
+					else if (key == "p99")
+						stats.p99 = value;
+					tryExpect(',');
+				}
+
+				tryExpect(',');
+			}
+
+			return true;
+		}
+
+		void skipWhitespace()
+		{
+			while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+				++m_pos;
+		}
+
+		bool tryExpect(char c)
+		{
+			skipWhitespace();
+			if (m_pos < m_text.size() && m_text[m_pos] == c) {
+				++m_pos;
+				return true;
+			}
+			return false;
+		}
+
+		bool expect(char c)
+		{
+			return tryExpect(c) || fail();
+		}
+
+		bool readString(std::string& outString)
+		{
+			if (!expect('"'))
+				return false;
+
+			size_t end = m_text.find('"', m_pos);
+			if (end == std::string::npos)
+				return fail();
+
+			outString = m_text.substr(m_pos, end - m_pos);
+			m_pos = end + 1;
+			return true;
+		}
+
+		bool readNumber(double& outNumber)
+		{
+			skipWhitespace();
+			const char* begin = m_text.c_str() + m_pos;
+			char* end;
+			outNumber = std::strtod(begin, &end);
+			if (end == begin)
+				return fail();
+
+			m_pos += end - begin;
+			return true;
+		}
+
+		bool fail()
+		{
+			// Stop at the first error, so the outer loops end
+			m_pos = m_text.size();
+			return false;
+		}
+
+		const std::string& m_text;
+		size_t m_pos;
+	};
+
+	bool readResults(const std::string& path, BenchmarkResults& outResults)
+	{
+		std::ifstream file(path);
+		if (!file)
+			return false;
+
+		std::stringstream text;
+		text << file.rdbuf();
+		return ResultsReader(text.str()).read(outResults);
+	}
+
+	// Returns true if the time is slower than the baseline by more than
+	// the threshold
+	bool isRegression(double time, double baselineTime, double threshold)
+	{
+		return time > g_kMinComparableTime && time > baselineTime * (1 + threshold);
+	}
+
+	// Returns the number of regressions against the baseline, counting
+	// times missing from the baseline if it is required.
+	// Means and medians are compared, 99th percentiles are too noisy to
+	// fail on.
+	size_t compareResults(const BenchmarkResults& results, const BenchmarkResults& baseline, const Options& options)
+	{
+		double threshold = options.threshold;
+		size_t numRegressions = 0;
+		for (auto& nameAndStats : results.times) {
+			auto baselineIt = baseline.times.find(nameAndStats.first);
+			if (baselineIt == baseline.times.end()) {
+				if (options.isBaselineRequired) {
+					g_log << "  MISSING " << nameAndStats.first << ": not in the baseline\n";
+					++numRegressions;
+				} else {
+					g_log << "  " << nameAndStats.first << ": not in the baseline\n";
+				}
+				continue;
+			}
+
+			const TimeStats& stats = nameAndStats.second;
+			const TimeStats& baselineStats = baselineIt->second;
+			if (isRegression(stats.mean, baselineStats.mean, threshold)
+			 || isRegression(stats.p50, baselineStats.p50, threshold)) {
+				g_log << "  REGRESSION " << nameAndStats.first << ": p50 " << stats.p50 << " ms (baseline "
+				      << baselineStats.p50 << " ms), mean " << stats.mean << " ms (baseline " << baselineStats.mean << " ms)\n";
+				++numRegressions;
+			}
+		}
+
+		return numRegressions;
+	}
+}
+
+int SceneBenchmark::run(const std::vector<std::string>& args)
+{
+	Options options;
+	if (!parseOptions(args, options))
+		return 1;
+
+	StressScene::Settings settings = StressScene::getScaledSettings(options.scale);
+	g_log << "Scene benchmark (scale " << options.scale << ", " << options.numFrames << " frames)\n";
+	g_log << "  " << settings.numTerrainFollowers << " terrain followers, " << settings.numPickups << " pickups, "
+	      << settings.numSnakes << " snakes with " << settings.snakeTailLength << " tail links\n";
+
+	BenchClock::time_point start = BenchClock::now();
+	StressScreen screen(settings, options.seed);
+	g_log << "  Built " << screen.getScene().getEntityCount() << " entities in " << secondsSince(start) * 1e3 << " ms\n";
+
+	for (int i = 0; i < g_kNumWarmupFrames; ++i)
+		screen.runFrame();
+	glFinish();
+
+	std::vector<const System*> systems = screen.getSystems();
+	std::vector<double> frameTimes;
+	std::vector<std::vector<double>> systemTimes(systems.size());
+	screen.setSystemTimingEnabled(true);
+	for (int i = 0; i < options.numFrames; ++i) {
+		screen.clearSystemTimes();
+		start = BenchClock::now();
+		screen.runFrame();
+
+		// Wait for the GPU, so a frames rendering isn't counted in later frames
+		glFinish();
+		frameTimes.push_back(secondsSince(start) * 1e3);
+
+		const std::unordered_map<const System*, double>& times = screen.getSystemTimes();
+		for (size_t j = 0; j < systems.size(); ++j) {
+			auto timeIt = times.find(systems[j]);
+			systemTimes[j].push_back(timeIt != times.end() ? timeIt->second * 1e3 : 0);
+		}
+	}
+	screen.setSystemTimingEnabled(false);
+
+	BenchmarkResults results;
+	results.scale = options.scale;
+	results.numFrames = options.numFrames;
+	results.times[g_kFrameName] = calculateStats(frameTimes);
+	for (size_t i = 0; i < systems.size(); ++i)
+		results.times[getSystemName(*systems[i])] = calculateStats(systemTimes[i]);
+
+	for (auto& nameAndStats : results.times) {
+		const TimeStats& stats = nameAndStats.second;
+		g_log << "  " << nameAndStats.first << ": mean " << stats.mean << " ms, p50 " << stats.p50
+		      << " ms, p99 " << stats.p99 << " ms\n";
+	}
+
+	if (options.willWriteBaseline) {
+		if (!writeResults(results, options.baselinePath))
+			return 1;
+		g_log << "  Wrote the baseline to " << options.baselinePath << "\n";
+		return 0;
+	}
+
+	writeResults(results, g_kResultsPath);
+
+	BenchmarkResults baseline;
+	if (!readResults(options.baselinePath, baseline)) {
+		g_log << "WARNING: Couldn't read the scene benchmark baseline " << options.baselinePath << "\n";
+		return options.isBaselineRequired ? 1 : 0;
+	}
+
+	// Times at different scales can't be compared
+	if (baseline.scale != results.scale) {
+		g_log << "WARNING: The baseline was recorded at scale " << baseline.scale
+		      << ", skipping the comparison\n";
+		return options.isBaselineRequired ? 1 : 0;
+	}
+
+	size_t numRegressions = compareResults(results, baseline, options);
+	if (numRegressions > 0) {
+		g_log << "  " << numRegressions << " regressions or missing times against the baseline (threshold "
+		      << options.threshold * 100 << "%)\n";
+		return 1;
+	}
+
+	g_log << "  No regressions beyond " << options.threshold * 100 << "% of the baseline\n";
+	return 0;
+}
@@ -0,0 +1,47 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Runs a procedurally generated stress scene through the
+//                full system pipeline and checks the frame times
+//                against a baseline.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Every frame runs one simulation step and one render of the stress scene,
+// so the results don't depend on the frame rate.
+// The mean, median and 99th percentile frame times are reported for the
+// whole frame and for each system.
+//
+// Options:
+//   --scale <n>        Multiplies the stress scenes entity counts (default 1)
+//   --frames <n>       Number of frames to time (default 300)
+//   --seed <n>         Seed for placing the stress scenes entities
+//   --baseline <path>  Baseline results to compare against
+//   --threshold <n>    Allowed slowdown before a time counts as a
+//                      regression, as a fraction (default 0.1)
+//   --write-baseline   Writes the results as the new baseline instead of
+//                      comparing against it
+//   --require-baseline Fails when the baseline can't be read, was recorded
+//                      at another scale, or is missing a time, instead of
+//                      only warning
+namespace SceneBenchmark {
+	// Runs the benchmark with the given options.
+	// The window and job system must already be initialized, see
+	// Game::initHeadless.
+	// Results are written to the log and to SceneBenchmarkResults.json.
+	// Returns 0 on success, or 1 if the benchmark failed, a time
+	// regressed against the baseline, or the baseline is required but
+	// has no time to compare against.
+	int run(const std::vector<std::string>& args);
+}
@@ -0,0 +1,629 @@
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include "SceneSnapshot.h"
+
+#include "GLPrimitives.h"
+#include "GLUtils.h"
+#include "Log.h"
+#include "ModelUtils.h"
+#include "PrimitivePrefabs.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "Terrain.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace {
+	const char g_kMagic[4] = { 'S', 'N', 'A', 'P' };
+
+	// Must be bumped whenever the file layout or the layout of a raw
+	// component changes.
+	const uint32_t g_kVersion = 7;
+
+	// Every block in the file starts on this alignment, so mapped data can
+	// be read in place.
+	const size_t g_kBlockAlignment = 16;
+
+	struct FileHeader {
+		char magic[4];
+		uint32_t version;
+		uint64_t fileSize;
+		uint64_t numEntities;
+		uint64_t numSections;
+		uint64_t entitiesOffset; // EntityRecord[numEntities]
+		uint64_t sectionsOffset; // SectionRecord[numSections]
+	};
+
+	// One entity slot, indexed by entity index
+	struct EntityRecord {
+		uint64_t componentMask;
+		uint32_t generation;
+		uint32_t isAlive;
+	};
+
+	// One component pool
+	struct SectionRecord {
+		uint64_t componentMask;
+		uint64_t elementSize;         // Size of each component or record
+		uint64_t count;
+		uint64_t entityIndicesOffset; // uint32_t[count], packed index -> entity index
+		uint64_t dataOffset;          // Components or records[count]
+	};
+
+	struct StringRecord {
+		uint64_t offset; // char[length]
+		uint64_t length;
+	};
+
+	struct ModelRecord {
+		uint64_t assetType;
+		uint64_t numAssetPaths;
+		uint64_t assetPathsOffset; // StringRecord[numAssetPaths]
+		uint64_t numMaterials;
+		uint64_t materialsOffset;  // MaterialRecord[numMaterials]
+		uint64_t isStatic;
+		uint64_t isOccluder;
+	};
+
+	// The material settings that are commonly changed after a model is
+	// built i.e. to give a primitive a solid color.
+	struct MaterialRecord {
+		int32_t shaderID; // Index into g_kShaders, or -1 for none
+		uint32_t willDrawDepth;
+		uint32_t willBlend;
+		ShaderParams shaderParams;
+		glm::vec3 debugColor;
+		float heightMapScale;
+	};
+
+	struct TerrainRecord {
+		glm::ivec2 heightMapDimensions;
+		float heightScale;
+		float size;
+		int32_t baseTessellation;
+		uint32_t padding;
+		uint64_t heightMapOffset; // float[dimensions.x * dimensions.y]
+	};
+
+	// The shaders a material can use, by saved shader id.
+	// New shaders must be added to the end.
+	using ShaderGetter = const Shader& (*)();
+	const ShaderGetter g_kShaders[] = {
+		&GLUtils::getDefaultShader,
+		&GLUtils::getMetalShader,
+		&GLUtils::getDebugShader,
+		&GLUtils::getSkyboxShader,
+		&GLUtils::getTerrainGrassGeoShader,
+		&GLUtils::getTerrainShader,
+	};
+
+	template <typename ...ComponentTs>
+	struct ComponentList {
+		static const size_t s_kSize = sizeof...(ComponentTs);
+	};
+
+	// Components saved as raw bytes.
+	// Terrain and model components own heap memory or GPU resources and
+	// have their own sections after these.
+	using RawComponents = ComponentList<
+		TransformComponent,
+		PhysicsComponent,
+		CameraComponent,
+		VehicleMovementComponent,
+		InputComponent,
+		InputMapComponent,
+		PickupComponent,
+		PlayerStatsComponent,
+		SnakeTailComponent,
+		BasicCameraMovementComponent,
+		TerrainFollowComponent,
+		SimpleWorldSpcaeMoveComponent,
+		LightComponent>;
+
+	const size_t g_kNumSections = RawComponents::s_kSize + 2;
+
+	// Builds the snapshot in memory so it can be written with one call
+	class SnapshotWriter {
+	public:
+		// Appends a block of bytes, returning its offset in the file
+		uint64_t write(const void* data, size_t size)
+		{
+			uint64_t offset = reserve(size);
+			if (size > 0)
+				std::memcpy(&m_buffer[offset], data, size);
+			return offset;
+		}
+
+		// Appends a zeroed block to be filled in later
+		uint64_t reserve(size_t size)
+		{
+			m_buffer.resize((m_buffer.size() + g_kBlockAlignment - 1) / g_kBlockAlignment * g_kBlockAlignment);
+			uint64_t offset = m_buffer.size();
+			m_buffer.resize(m_buffer.size() + size);
+			return offset;
+		}
+
+		// Overwrites part of a previously reserved block
+		void patch(uint64_t offset, const void* data, size_t size)
+		{
+			std::memcpy(&m_buffer[offset], data, size);
+		}
+
+		uint64_t size() const
+		{
+			return m_buffer.size();
+		}
+
+		bool writeToFile(const std::string& path) const
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(m_buffer.data(), m_buffer.size());
+			return file.good();
+		}
+
+	private:
+		std::vector<char> m_buffer;
+	};
+
+	// A read only view of a snapshot file.
+	// The file is memory mapped where possible, otherwise it is read into
+	// memory with one sequential read.
+	class SnapshotFile {
+	public:
+		SnapshotFile() = default;
+		SnapshotFile(const SnapshotFile&) = delete;
+		SnapshotFile& operator=(const SnapshotFile&) = delete;
+		~SnapshotFile();
+
+		bool open(const std::string& path);
+
+		// Returns the array of count elements at the offset.
+		// Returns nullptr if the array isn't within the file or isn't
+		// aligned.
+		template <typename T>
+		const T* get(uint64_t offset, uint64_t count = 1) const;
+
+	private:
+		const char* m_data = nullptr;
+		uint64_t m_size = 0;
+		std::unique_ptr<std::max_align_t[]> m_buffer;
+#ifdef _WIN32
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+		HANDLE m_mapping = nullptr;
+#endif
+	};
+
+	SnapshotFile::~SnapshotFile()
+	{
+#ifdef _WIN32
+		if (m_mapping) {
+			UnmapViewOfFile(m_data);
+			CloseHandle(m_mapping);
+		}
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+#endif
+	}
+
+	bool SnapshotFile::open(const std::string& path)
+	{
+#ifdef _WIN32
+		m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		LARGE_INTEGER fileSize;
+		if (m_file != INVALID_HANDLE_VALUE && GetFileSizeEx(m_file, &fileSize) && fileSize.QuadPart > 0) {
+			m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_mapping) {
+				m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+				if (m_data) {
+					m_size = static_cast<uint64_t>(fileSize.QuadPart);
+					return true;
+				}
+				CloseHandle(m_mapping);
+				m_mapping = nullptr;
+			}
+		}
+#endif
+
+		// Fall back to reading the whole file
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file)
+			return false;
+
+		std::streamoff fileSize = file.tellg();
+		if (fileSize <= 0)
+			return false;
+
+		size_t numBlocks = (static_cast<size_t>(fileSize) + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+		m_buffer.reset(new std::max_align_t[numBlocks]);
+		file.seekg(0);
+		if (!file.read(reinterpret_cast<char*>(m_buffer.get()), fileSize))
+			return false;
+
+		m_data = reinterpret_cast<const char*>(m_buffer.get());
+		m_size = static_cast<uint64_t>(fileSize);
+		return true;
+	}
+
+	template <typename T>
+	const T* SnapshotFile::get(uint64_t offset, uint64_t count) const
+	{
+		if (offset > m_size || count > (m_size - offset) / sizeof(T) || offset % alignof(T) != 0)
+			return nullptr;
+
+		return reinterpret_cast<const T*>(m_data + offset);
+	}
+
+	template <typename ComponentT>
+	uint64_t writeEntityIndices(SnapshotWriter& writer, const ComponentPool<ComponentT>& pool)
+	{
+		std::vector<uint32_t> entityIndices(pool.size());
+		for (size_t i = 0; i < pool.size(); ++i)
+			entityIndices[i] = static_cast<uint32_t>(pool.getEntityIndex(i));
+
+		return writer.write(entityIndices.data(), entityIndices.size() * sizeof(uint32_t));
+	}
+
+	// Returns the entity indices of a section, or nullptr if any of them
+	// aren't in the scene.
+	const uint32_t* getEntityIndices(const SnapshotFile& file, const SectionRecord& section, Scene& scene)
+	{
+		const uint32_t* entityIndices = file.get<uint32_t>(section.entityIndicesOffset, section.count);
+		if (!entityIndices)
+			return nullptr;
+
+		for (uint64_t i = 0; i < section.count; ++i) {
+			if (entityIndices[i] >= scene.getEntityCount() || !scene.getEntity(entityIndices[i]).hasComponents(section.componentMask))
+				return nullptr;
+		}
+
+		return entityIndices;
+	}
+
+	template <typename ComponentT>
+	SectionRecord writeRawPool(SnapshotWriter& writer, const ComponentPool<ComponentT>& pool)
+	{
+		static_assert(std::is_trivially_copyable<ComponentT>::value, "Raw snapshot components must be trivially copyable");
+
+		SectionRecord section = {};
+		section.componentMask = ComponentTraits<ComponentT>::s_kMask;
+		section.elementSize = sizeof(ComponentT);
+		section.count = pool.size();
+		section.entityIndicesOffset = writeEntityIndices(writer, pool);
+		section.dataOffset = writer.write(pool.size() > 0 ? &pool[0] : nullptr, pool.size() * sizeof(ComponentT));
+		return section;
+	}
+
+	template <typename ...ComponentTs>
+	void writeRawPools(SnapshotWriter& writer, Scene& scene, std::vector<SectionRecord>& sections, ComponentList<ComponentTs...>)
+	{
+		int expand[] = { 0, (sections.push_back(writeRawPool(writer, scene.getComponents<ComponentTs>())), 0)... };
+		(void)expand;
+	}
+
+	template <typename ComponentT>
+	bool readRawPool(const SnapshotFile& file, const SectionRecord& section, Scene& scene)
+	{
+		if (section.componentMask != ComponentTraits<ComponentT>::s_kMask || section.elementSize != sizeof(ComponentT))
+			return false;
+
+		const ComponentT* components = file.get<ComponentT>(section.dataOffset, section.count);
+		const uint32_t* entityIndices = getEntityIndices(file, section, scene);
+		if (!components || !entityIndices)
+			return false;
+
+		// The components are copied straight out of the file
+		scene.getComponents<ComponentT>().restore(components, entityIndices, static_cast<size_t>(section.count));
+		return true;
+	}
+
+	template <typename ...ComponentTs>
+	bool readRawPools(const SnapshotFile& file, const SectionRecord* sections, Scene& scene, ComponentList<ComponentTs...>)
+	{
+		size_t sectionIdx = 0;
+		bool isValid = true;
+		int expand[] = { 0, (isValid = isValid && readRawPool<ComponentTs>(file, sections[sectionIdx++], scene), 0)... };
+		(void)expand;
+		return isValid;
+	}
+
+	SectionRecord writeTerrains(SnapshotWriter& writer, const ComponentPool<TerrainComponent>& pool)
+	{
+		SectionRecord section = {};
+		section.componentMask = COMPONENT_TERRAIN;
+		section.elementSize = sizeof(TerrainRecord);
+		section.count = pool.size();
+		section.entityIndicesOffset = writeEntityIndices(writer, pool);
+		section.dataOffset = writer.reserve(pool.size() * sizeof(TerrainRecord));
+
+		for (size_t i = 0; i < pool.size(); ++i) {
+			const TerrainComponent& terrain = pool[i];
+
+			TerrainRecord record = {};
+			record.heightMapDimensions = terrain.heightMapDimensions;
+			record.heightScale = terrain.heightScale;
+			record.size = terrain.size;
+			record.baseTessellation = terrain.baseTessellation;
+			record.heightMapOffset = writer.write(terrain.heightMap.data(), terrain.heightMap.size() * sizeof(float));
+			writer.patch(section.dataOffset + i * sizeof(TerrainRecord), &record, sizeof(record));
+		}
+
+		return section;
+	}
+
+	bool readTerrains(const SnapshotFile& file, const SectionRecord& section, Scene& scene)
+	{
+		if (section.componentMask != COMPONENT_TERRAIN || section.elementSize != sizeof(TerrainRecord))
+			return false;
+
+		const TerrainRecord* records = file.get<TerrainRecord>(section.dataOffset, section.count);
+		const uint32_t* entityIndices = getEntityIndices(file, section, scene);
+		if (!records || !entityIndices)
+			return false;
+
+		ComponentPool<TerrainComponent>& pool = scene.getComponents<TerrainComponent>();
+		for (uint64_t i = 0; i < section.count; ++i) {
+			const TerrainRecord& record = records[i];
+			if (record.heightMapDimensions.x < 0 || record.heightMapDimensions.y < 0)
+				return false;
+
+			uint64_t numPixels = static_cast<uint64_t>(record.heightMapDimensions.x) * record.heightMapDimensions.y;
+			const float* heightMap = file.get<float>(record.heightMapOffset, numPixels);
+			if (!heightMap)
+				return false;
+
+			TerrainComponent& terrain = pool.add(entityIndices[i]);
+			terrain.heightMap.assign(heightMap, heightMap + numPixels);
+			terrain.heightMapDimensions = record.heightMapDimensions;
+			terrain.heightScale = record.heightScale;
+			terrain.size = record.size;
+			terrain.baseTessellation = record.baseTessellation;
+		}
+
+		return true;
+	}
+
+	int32_t getShaderID(const Shader* shader)
+	{
+		if (!shader)
+			return -1;
+
+		for (size_t i = 0; i < sizeof(g_kShaders) / sizeof(g_kShaders[0]); ++i) {
+			if (&g_kShaders[i]() == shader)
+				return static_cast<int32_t>(i);
+		}
+
+		g_log << "WARNING: Saved a material using a shader that can't be referenced by a scene snapshot\n";
+		return -1;
+	}
+
+	SectionRecord writeModels(SnapshotWriter& writer, const ComponentPool<ModelComponent>& pool)
+	{
+		SectionRecord section = {};
+		section.componentMask = COMPONENT_MODEL;
+		section.elementSize = sizeof(ModelRecord);
+		section.count = pool.size();
+		section.entityIndicesOffset = writeEntityIndices(writer, pool);
+		section.dataOffset = writer.reserve(pool.size() * sizeof(ModelRecord));
+
+		std::vector<StringRecord> assetPaths;
+		std::vector<MaterialRecord> materials;
+		for (size_t i = 0; i < pool.size(); ++i) {
+			const ModelComponent& model = pool[i];
+
+			assetPaths.clear();
+			for (const std::string& path : model.assetPaths)
+				assetPaths.push_back({ writer.write(path.data(), path.size()), path.size() });
+
+			materials.assign(model.materials.size(), MaterialRecord{});
+			for (size_t j = 0; j < model.materials.size(); ++j) {
+				const Material& material = model.materials[j];
+				materials[j].shaderID = getShaderID(material.shader);
+				materials[j].willDrawDepth = material.willDrawDepth;
+				materials[j].willBlend = material.willBlend;
+				materials[j].shaderParams = material.shaderParams;
+				materials[j].debugColor = material.debugColor;
+				materials[j].heightMapScale = material.heightMapScale;
+			}
+
+			ModelRecord record = {};
+			record.assetType = model.assetType;
+			record.numAssetPaths = assetPaths.size();
+			record.assetPathsOffset = writer.write(assetPaths.data(), assetPaths.size() * sizeof(StringRecord));
+			record.numMaterials = materials.size();
+			record.materialsOffset = writer.write(materials.data(), materials.size() * sizeof(MaterialRecord));
+			record.isStatic = model.isStatic;
+			record.isOccluder = model.isOccluder;
+			writer.patch(section.dataOffset + i * sizeof(ModelRecord), &record, sizeof(record));
+		}
+
+		return section;
+	}
+
+	// Rebuilds the models GPU data from the asset it was created from
+	void rebuildModel(Entity& entity, ModelAssetType assetType, const std::vector<std::string>& assetPaths)
+	{
+		switch (assetType) {
+		case MODEL_ASSET_QUAD:
+			entity.model() = GLPrimitives::getQuadModel();
+			break;
+		case MODEL_ASSET_SPHERE:
+			entity.model() = GLPrimitives::getSphereModel();
+			break;
+		case MODEL_ASSET_CYLINDER:
+			entity.model() = GLPrimitives::getCylinderModel();
+			break;
+		case MODEL_ASSET_PYRAMID:
+			entity.model() = GLPrimitives::getPyramidModel();
+			break;
+		case MODEL_ASSET_CUBE:
+			entity.model() = GLPrimitives::getCubeModel();
+			break;
+		case MODEL_ASSET_FILE:
+			if (assetPaths.size() == 1)
+				entity.model() = ModelUtils::loadModel(assetPaths[0]);
+			break;
+		case MODEL_ASSET_SKYBOX:
+			Prefabs::initSkybox(entity, assetPaths);
+			break;
+		case MODEL_ASSET_TERRAIN:
+			if (entity.hasComponents(COMPONENT_TERRAIN, COMPONENT_TRANSFORM))
+				TerrainUtils::buildTerrainModel(entity);
+			break;
+		default:
+			g_log << "WARNING: Loaded a model from a scene snapshot that has no asset to rebuild it from\n";
+			break;
+		}
+	}
+
+	bool readModels(const SnapshotFile& file, const SectionRecord& section, Scene& scene)
+	{
+		if (section.componentMask != COMPONENT_MODEL || section.elementSize != sizeof(ModelRecord))
+			return false;
+
+		const ModelRecord* records = file.get<ModelRecord>(section.dataOffset, section.count);
+		const uint32_t* entityIndices = getEntityIndices(file, section, scene);
+		if (!records || !entityIndices)
+			return false;
+
+		ComponentPool<ModelComponent>& pool = scene.getComponents<ModelComponent>();
+		std::vector<std::string> assetPaths;
+		for (uint64_t i = 0; i < section.count; ++i) {
+			const ModelRecord& record = records[i];
+			const StringRecord* pathRecords = file.get<StringRecord>(record.assetPathsOffset, record.numAssetPaths);
+			const MaterialRecord* materials = file.get<MaterialRecord>(record.materialsOffset, record.numMaterials);
+			if (!pathRecords || !materials)
+				return false;
+
+			assetPaths.clear();
+			for (uint64_t j = 0; j < record.numAssetPaths; ++j) {
+				const char* path = file.get<char>(pathRecords[j].offset, pathRecords[j].length);
+				if (!path)
+					return false;
+				assetPaths.emplace_back(path, static_cast<size_t>(pathRecords[j].length));
+			}
+
+			Entity& entity = scene.getEntity(entityIndices[i]);
+			pool.add(entity.getIndex());
+			rebuildModel(entity, static_cast<ModelAssetType>(record.assetType), assetPaths);
+
+			// Reapply the material settings over the assets defaults
+			ModelComponent& model = entity.model();
+			model.isStatic = record.isStatic != 0;
+			model.isOccluder = record.isOccluder != 0;
+			for (size_t j = 0; j < model.materials.size() && j < record.numMaterials; ++j) {
+				const MaterialRecord& materialRecord = materials[j];
+				Material& material = model.materials[j];
+				if (materialRecord.shaderID >= 0 && materialRecord.shaderID < static_cast<int32_t>(sizeof(g_kShaders) / sizeof(g_kShaders[0])))
+					material.shader = &g_kShaders[materialRecord.shaderID]();
+				material.willDrawDepth = materialRecord.willDrawDepth != 0;
+				material.willBlend = materialRecord.willBlend != 0;
+				material.shaderParams = materialRecord.shaderParams;
+				material.debugColor = materialRecord.debugColor;
+				material.heightMapScale = materialRecord.heightMapScale;
+			}
+		}
+
+		return true;
+	}
+}
+
+bool SceneSnapshot::save(Scene& scene, const std::string& path)
+{
+	PROFILE_SCOPE_CATEGORY("SceneSnapshot::save", "Assets");
+
+	SnapshotWriter writer;
+	uint64_t headerOffset = writer.reserve(sizeof(FileHeader));
+
+	std::vector<EntityRecord> entities(scene.getEntityCount());
+	std::memset(entities.data(), 0, entities.size() * sizeof(EntityRecord));
+	for (size_t i = 0; i < entities.size(); ++i) {
+		const Entity& entity = scene.getEntity(i);
+		entities[i].componentMask = entity.getComponentMask();
+		entities[i].generation = entity.getHandle().generation;
+		entities[i].isAlive = entity.isAlive();
+	}
+	uint64_t entitiesOffset = writer.write(entities.data(), entities.size() * sizeof(EntityRecord));
+
+	// Sections must be written in the order they are read
+	std::vector<SectionRecord> sections;
+	writeRawPools(writer, scene, sections, RawComponents{});
+	sections.push_back(writeTerrains(writer, scene.getComponents<TerrainComponent>()));
+	sections.push_back(writeModels(writer, scene.getComponents<ModelComponent>()));
+	assert(sections.size() == g_kNumSections);
+	uint64_t sectionsOffset = writer.write(sections.data(), sections.size() * sizeof(SectionRecord));
+
+	FileHeader header = {};
+	std::memcpy(header.magic, g_kMagic, sizeof(g_kMagic));
+	header.version = g_kVersion;
+	header.fileSize = writer.size();
+	header.numEntities = entities.size();
+	header.numSections = sections.size();
+	header.entitiesOffset = entitiesOffset;
+	header.sectionsOffset = sectionsOffset;
+	writer.patch(headerOffset, &header, sizeof(header));
+
+	if (!writer.writeToFile(path)) {
+		g_log << "WARNING: Failed to write scene snapshot " << path << "\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool SceneSnapshot::load(Scene& scene, const std::string& path)
+{
+	PROFILE_SCOPE_CATEGORY("SceneSnapshot::load", "Assets");
+
+	if (scene.getEntityCount() != 0) {
+		g_log << "WARNING: Tried to load a scene snapshot into a scene that already has entities\n";
+		return false;
+	}
+
+	SnapshotFile file;
+	if (!file.open(path)) {
+		g_log << "WARNING: Failed to open scene snapshot " << path << "\n";
+		return false;
+	}
+
+	const FileHeader* header = file.get<FileHeader>(0);
+	if (!header || std::memcmp(header->magic, g_kMagic, sizeof(g_kMagic)) != 0 || header->version != g_kVersion
+	 || !file.get<char>(0, header->fileSize) || header->numSections != g_kNumSections) {
+		g_log << "WARNING: Scene snapshot " << path << " is not a version " << g_kVersion << " snapshot\n";
+		return false;
+	}
+
+	const EntityRecord* entities = file.get<EntityRecord>(header->entitiesOffset, header->numEntities);
+	const SectionRecord* sections = file.get<SectionRecord>(header->sectionsOffset, header->numSections);
+	bool isValid = entities && sections;
+
+	if (isValid) {
+		for (uint64_t i = 0; i < header->numEntities; ++i) {
+			EntityHandle handle;
+			handle.index = static_cast<uint32_t>(i);
+			handle.generation = entities[i].generation;
+			scene.restoreEntity(handle, static_cast<size_t>(entities[i].componentMask), entities[i].isAlive != 0);
+		}
+
+		// Terrains must be restored before models, as terrain models are
+		// built from them.
+		isValid = readRawPools(file, sections, scene, RawComponents{})
+		       && readTerrains(file, sections[RawComponents::s_kSize], scene)
+		       && readModels(file, sections[RawComponents::s_kSize + 1], scene);
+	}
+
+	if (!isValid) {
+		g_log << "WARNING: Scene snapshot " << path << " is corrupt\n";
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,43 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Saves a fully built scene to a versioned binary
+//                snapshot and loads it back with a single sequential
+//                read.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <string>
+
+class Scene;
+
+// A snapshot stores every entity slot and the packed component arrays of
+// a scene.
+// Plain components are stored exactly as they are laid out in memory and
+// are copied into the scenes pools in one go.
+// Models are stored as references to the assets they were built from and
+// are rebuilt on load, since their GPU resources can't be saved.
+// All references in the file are offsets from the start of the file, so it
+// can be memory mapped and used in place.
+namespace SceneSnapshot {
+	// Writes the scene to a snapshot file.
+	// Returns false if the file couldn't be written.
+	bool save(Scene&, const std::string& path);
+
+	// Loads a snapshot into a scene that has never had entities created
+	// in it.
+	// Models are rebuilt from their assets, so an OpenGL context must be
+	// current.
+	// Returns false if the file is missing, corrupt or was saved by a
+	// different version.
+	// A scene that failed part way through loading should be discarded.
+	bool load(Scene&, const std::string& path);
+}
@@ -0,0 +1,115 @@
+#include "SceneSnapshotBenchmark.h"
+
+#include "GameplayScreen.h"
+#include "Log.h"
+#include "Scene.h"
+#include "SceneSnapshot.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace {
+	using BenchClock = std::chrono::high_resolution_clock;
+
+	double secondsSince(BenchClock::time_point start)
+	{
+		return std::chrono::duration<double>(BenchClock::now() - start).count();
+	}
+
+	// Returns the number of differences between the entity slots and plain
+	// components of the two scenes
+	size_t countDifferences(Scene& expected, Scene& actual)
+	{
+		if (expected.getEntityCount() != actual.getEntityCount())
+			return 1;
+
+		size_t numDifferences = 0;
+		for (size_t i = 0; i < expected.getEntityCount(); ++i) {
+			Entity& expectedEntity = expected.getEntity(i);
+			Entity& actualEntity = actual.getEntity(i);
+			if (expectedEntity.getHandle() != actualEntity.getHandle()
+			 || expectedEntity.isAlive() != actualEntity.isAlive()
+			 || expectedEntity.getComponentMask() != actualEntity.getComponentMask()) {
+				++numDifferences;
+				continue;
+			}
+
+			if (expectedEntity.hasComponents(COMPONENT_TRANSFORM)
+			 && std::memcmp(&expectedEntity.transform(), &actualEntity.transform(), sizeof(TransformComponent)) != 0)
+				++numDifferences;
+
+			if (expectedEntity.hasComponents(COMPONENT_MODEL)
+			 && (expectedEntity.model().meshes.size() != actualEntity.model().meshes.size()
+			  || expectedEntity.model().materials.size() != actualEntity.model().materials.size()))
+				++numDifferences;
+		}
+
+		return numDifferences;
+	}
+}
+
+void SceneSnapshotBenchmark::run()
+{
+	const int kNumRuns = 10;
+	const std::string kSnapshotPath = "SceneSnapshotBenchmark.snapshot";
+
+	g_log << "Scene snapshot benchmark\n";
+
+	// The first build pays for compiling shaders and decoding textures.
+	// Later builds reuse the cached GPU resources, like reloading a level.
+	BenchClock::time_point start = BenchClock::now();
+	std::unique_ptr<GameplayScreen> builtScreen = std::make_unique<GameplayScreen>();
+	double coldBuildTime = secondsSince(start);
+
+	double buildTime = 0;
+	for (int i = 0; i < kNumRuns; ++i) {
+		start = BenchClock::now();
+		GameplayScreen screen;
+		buildTime += secondsSince(start);
+	}
+	buildTime /= kNumRuns;
+
+	start = BenchClock::now();
+	bool isSaved = SceneSnapshot::save(builtScreen->getScene(), kSnapshotPath);
+	double saveTime = secondsSince(start);
+	if (!isSaved) {
+		g_log << "  Failed to save the snapshot\n";
+		return;
+	}
+
+	std::ifstream snapshotFile(kSnapshotPath, std::ios::binary | std::ios::ate);
+	std::streamoff snapshotSize = snapshotFile.tellg();
+	snapshotFile.close();
+
+	double loadTime = 0;
+	size_t numDifferences = 0;
+	for (int i = 0; i < kNumRuns; ++i) {
+		Scene scene;
+		start = BenchClock::now();
+		bool isLoaded = SceneSnapshot::load(scene, kSnapshotPath);
+		loadTime += secondsSince(start);
+		if (!isLoaded) {
+			g_log << "  Failed to load the snapshot\n";
+			return;
+		}
+
+		numDifferences += countDifferences(builtScreen->getScene(), scene);
+	}
+	loadTime /= kNumRuns;
+
+	// Building includes creating the screens systems, loading only
+	// creates the scene.
+	g_log << "  " << builtScreen->getScene().getEntityCount() << " entities, "
+	      << snapshotSize / 1024.0 << " KB snapshot\n";
+	g_log << "  Build (first): " << coldBuildTime * 1e3 << " ms\n";
+	g_log << "  Build: " << buildTime * 1e3 << " ms\n";
+	g_log << "  Save: " << saveTime * 1e3 << " ms\n";
+	g_log << "  Load: " << loadTime * 1e3 << " ms (" << buildTime / loadTime << "x faster than building)\n";
+	g_log << "  Round trip " << (numDifferences == 0 ? "matches" : "DOES NOT match") << " the built scene\n";
+
+	std::remove(kSnapshotPath.c_str());
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace SceneSnapshotBenchmark {
+	// Compares building the gameplay scene imperatively against loading
+	// it from a scene snapshot, and checks the loaded scene matches.
+	// An OpenGL context must be current.
+	// Results are written to the log.
+	void run();
+}
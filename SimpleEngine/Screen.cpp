@@ -1,18 +1,107 @@
 #include "Screen.h"
 
+#include "Clock.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <typeinfo>
+
+namespace {
+	using ScreenClock = std::chrono::high_resolution_clock;
+
+	double secondsSince(ScreenClock::time_point start)
+	{
+		return std::chrono::duration<double>(ScreenClock::now() - start).count();
+	}
+}
+
 void Screen::update()
 {
-	for (auto& system : m_activeSystems) {
-		system->beginFrame();
+	PROFILE_SCOPE("Screen::update");
+
+	// Bring queries up to date with changes made outside the update
+	m_scene.dispatchEntityEvents();
+
+	// Catch the simulation up to the current time in fixed steps
+	for (int step = 0; step < Clock::getNumSimulationSteps(); ++step)
+		updateSimulationStep();
+
+	// Render once, between the last two simulation steps
+	updateFrameSystems();
+}
+
+void Screen::updateSimulationStep()
+{
+	PROFILE_SCOPE("Simulation step");
+	m_scene.storePreviousTransforms();
+	updateSystems(m_activeSystems);
+}
+
+void Screen::updateFrameSystems()
+{
+	PROFILE_SCOPE("Render frame");
+	updateSystems(m_frameSystems);
+}
+
+void Screen::updateSystems(std::vector<std::unique_ptr<System>>& systems)
+{
+	{
+		PROFILE_SCOPE("beginFrame");
+		for (auto& system : systems) {
+			PROFILE_SCOPE_CATEGORY(typeid(*system).name(), "beginFrame");
+			ScreenClock::time_point start = ScreenClock::now();
+			system->beginFrame();
+			if (m_isTimingSystems)
+				m_systemTimes[system.get()] += secondsSince(start);
+		}
 	}
 
-	for (size_t i = 0; i < m_scene.getEntityCount(); ++i) {
-		for (auto& system : m_activeSystems) {
-			system->update(m_scene.getEntity(i));
+	// Independent systems update concurrently
+	{
+		PROFILE_SCOPE("update");
+		m_systemScheduler.update(systems, m_scene);
+		if (m_isTimingSystems) {
+			const std::vector<double>& updateTimes = m_systemScheduler.getUpdateTimes();
+			for (size_t i = 0; i < systems.size(); ++i)
+				m_systemTimes[systems[i].get()] += updateTimes[i];
 		}
 	}
 
-	for (auto& system : m_activeSystems) {
-		system->endFrame();
+	// Apply the structural changes recorded during the update
+	{
+		PROFILE_SCOPE("playbackCommands");
+		m_scene.playbackCommands();
+		m_scene.dispatchEntityEvents();
+	}
+
+	{
+		PROFILE_SCOPE("endFrame");
+		for (auto& system : systems) {
+			PROFILE_SCOPE_CATEGORY(typeid(*system).name(), "endFrame");
+			ScreenClock::time_point start = ScreenClock::now();
+			system->endFrame();
+			if (m_isTimingSystems)
+				m_systemTimes[system.get()] += secondsSince(start);
+		}
 	}
 }
+
+Scene& Screen::getScene()
+{
+	return m_scene;
+}
+
+void Screen::setSystemTimingEnabled(bool isEnabled)
+{
+	m_isTimingSystems = isEnabled;
+}
+
+const std::unordered_map<const System*, double>& Screen::getSystemTimes() const
+{
+	return m_systemTimes;
+}
+
+void Screen::clearSystemTimes()
+{
+	m_systemTimes.clear();
+}
@@ -2,9 +2,11 @@
 
 #include "Scene.h"
 #include "System.h"
+#include "SystemScheduler.h"
 
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 class Screen
 {
@@ -13,12 +15,39 @@ public:
 	Screen(const Screen&) = delete;
 	Screen& operator=(const Screen&) = delete;
 
+	// Runs this frames simulation steps, then the frame systems.
 	void update();
 
+	// Returns the scene updated by the screens systems
+	Scene& getScene();
+
+	// Starts or stops recording how long each system takes to update.
+	// Timing is off by default.
+	void setSystemTimingEnabled(bool isEnabled);
+
+	// Returns the seconds each system has spent in beginFrame, update and
+	// endFrame since the times were last cleared.
+	const std::unordered_map<const System*, double>& getSystemTimes() const;
+	void clearSystemTimes();
+
 protected:
 	Screen() {};
 
+	// Runs one fixed simulation step of the active systems
+	void updateSimulationStep();
+
+	// Runs the frame systems once
+	void updateFrameSystems();
+
 	Scene m_scene;
-	std::vector<std::unique_ptr<System>> m_activeSystems;
+	std::vector<std::unique_ptr<System>> m_activeSystems; // Updated every simulation step
+	std::vector<std::unique_ptr<System>> m_frameSystems;  // Updated once per rendered frame, after the simulation
+	SystemScheduler m_systemScheduler;
+
+private:
+	void updateSystems(std::vector<std::unique_ptr<System>>& systems);
+
+	bool m_isTimingSystems = false;
+	std::unordered_map<const System*, double> m_systemTimes;
 };
 
@@ -15,6 +15,7 @@
 
 #include "Log.h"
 #include "Shader.h"
+#include "Profiler.h"
 
 #include <fstream>
 #include <assert.h>
@@ -105,6 +106,8 @@ GLint validateProgram(GLuint programObjectId) {
 
 Shader compileAndLinkShaders(const std::string& vertexShaderFile, const std::string& fragmentShaderFile,
                              const char* tessCtrlShaderFile, const char* tessEvalShaderFile, const char* geometryShaderFile) {
+	PROFILE_SCOPE_CATEGORY("compileAndLinkShaders", "Shaders");
+
 	std::string vertexShaderSource = readShaderFileFromResource(vertexShaderFile);
 	std::string fragmentShaderSource = readShaderFileFromResource(fragmentShaderFile);
 
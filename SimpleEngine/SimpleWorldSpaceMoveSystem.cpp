@@ -10,18 +10,20 @@
 SimpleWorldSpaceMoveSystem::SimpleWorldSpaceMoveSystem(Scene& scene)
 	: System(scene)
 {
+	setComponentAccess(COMPONENT_SIMPLE_WORLD_SPACE_MOVE_COMPONENT | COMPONENT_INPUT, COMPONENT_TRANSFORM);
+	setRequiresMainThread(false);
 }
 
-void SimpleWorldSpaceMoveSystem::update(Entity& entity)
+void SimpleWorldSpaceMoveSystem::update()
 {
-	if (!entity.hasComponents(COMPONENT_SIMPLE_WORLD_SPACE_MOVE_COMPONENT, COMPONENT_INPUT))
-		return;
-
-	glm::vec3 axis = GLMUtils::limitVec(entity.input.axis, 1);
-	float moveSpeed = entity.simpleWorldSpaceMovement.moveSpeed;
-
-	entity.transform.position.x += axis.x * moveSpeed * Clock::getDeltaTime();
-	entity.transform.position.z -= axis.z * moveSpeed * Clock::getDeltaTime();
+	float deltaTime = Clock::getDeltaTime();
+	m_scene.view<SimpleWorldSpcaeMoveComponent, InputComponent, TransformComponent>().parallelEach([deltaTime](const SimpleWorldSpcaeMoveComponent& movement, const InputComponent& input, TransformComponent& transform) {
+		glm::vec3 axis = GLMUtils::limitVec(input.axis, 1);
+		float moveSpeed = movement.moveSpeed;
+
+		transform.position.x += axis.x * moveSpeed * deltaTime;
+		transform.position.z -= axis.z * moveSpeed * deltaTime;
+	});
 }
 
 void SimpleWorldSpaceMoveSystem::beginFrame()
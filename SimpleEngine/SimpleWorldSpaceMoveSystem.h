@@ -9,7 +9,7 @@ public:
 	SimpleWorldSpaceMoveSystem(Scene&);
 
 	// Inherited via System
-	virtual void update(Entity&) override;
+	virtual void update() override;
 	virtual void beginFrame() override;
 	virtual void endFrame() override;
 };
\ No newline at end of file
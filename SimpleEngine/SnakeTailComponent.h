@@ -1,9 +1,9 @@
 #pragma once
 
-#include <glm\glm.hpp>
+#include "EntityHandle.h"
 
-class Entity;
+#include <glm\glm.hpp>
 
 struct SnakeTailComponent {
-	Entity* entityToFollow; // The Entity the snake tail is following
-};
\ No newline at end of file
+	EntityHandle entityToFollow; // The Entity the snake tail is following
+};
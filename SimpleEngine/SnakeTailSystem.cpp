@@ -11,8 +11,11 @@
 #include <iostream>
 
 SnakeTailSystem::SnakeTailSystem(Scene& scene)
-	: System{ scene }
+	: System{ scene, COMPONENT_SNAKETAIL }
 {
+	setComponentAccess(COMPONENT_SNAKETAIL | COMPONENT_TRANSFORM | COMPONENT_VEHICLE_MOVEMENT, COMPONENT_PHYSICS);
+	setRequiresMainThread(false);
+	setParallelUpdate(true);
 }
 
 void SnakeTailSystem::update(Entity& entity)
@@ -20,6 +23,11 @@ void SnakeTailSystem::update(Entity& entity)
 	if (!entity.hasComponents(COMPONENT_SNAKETAIL))
 		return;
 
-	glm::vec3 acceleration = seekWithArrival(entity.snakeTail.entityToFollow->transform.position, entity.transform.position, entity.physics.velocity, entity.vehicleMovement.maxMoveSpeed);
+	// Stop following once the entity being followed is destroyed
+	const Entity* entityToFollow = m_scene.getEntity(entity.snakeTail().entityToFollow);
+	if (!entityToFollow)
+		return;
+
+	glm::vec3 acceleration = seekWithArrival(entityToFollow->transform().position, entity.transform().position, entity.physics().velocity, entity.vehicleMovement().maxMoveSpeed);
 	steer(entity, acceleration);
 }
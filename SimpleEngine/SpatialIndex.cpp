@@ -0,0 +1,229 @@
+#include "SpatialIndex.h"
+
+#include "Entity.h"
+#include "Mesh.h"
+#include "ModelComponent.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const int SpatialIndex::s_kNotIndexed;
+const int SpatialIndex::s_kUnbounded;
+
+namespace {
+	const size_t g_kIndexedComponents = COMPONENT_TRANSFORM | COMPONENT_MODEL;
+
+	// Grows the AABB to fit a meshes bounds with the given transform.
+	// Returns false if the mesh is unbounded.
+	bool addMeshAABB(const MeshBounds& bounds, const glm::mat4& transform, AABB& aabb)
+	{
+		if (std::isinf(bounds.radius))
+			return false;
+
+		// Transform the boxes centre and take the extent of the rotated
+		// box along each axis
+		glm::vec3 center = glm::vec3(transform * glm::vec4((bounds.min + bounds.max) * 0.5f, 1));
+		glm::vec3 extent = (bounds.max - bounds.min) * 0.5f;
+		glm::vec3 worldExtent;
+		for (int row = 0; row < 3; ++row) {
+			worldExtent[row] = std::abs(transform[0][row]) * extent.x
+			                 + std::abs(transform[1][row]) * extent.y
+			                 + std::abs(transform[2][row]) * extent.z;
+		}
+
+		aabb.min = glm::min(aabb.min, center - worldExtent);
+		aabb.max = glm::max(aabb.max, center + worldExtent);
+		return true;
+	}
+
+	bool addNodeAABB(const ModelComponent& model, const MeshNode& node, const glm::mat4& parentTransform, AABB& aabb)
+	{
+		glm::mat4 transform = parentTransform * node.transform;
+		for (unsigned int meshID : node.meshIDs) {
+			if (!addMeshAABB(model.meshes.at(meshID).bounds, transform, aabb))
+				return false;
+		}
+
+		for (const MeshNode& childNode : node.childNodes) {
+			if (!addNodeAABB(model, childNode, transform, aabb))
+				return false;
+		}
+
+		return true;
+	}
+}
+
+SpatialIndex::SpatialIndex(Scene& scene, float margin)
+	: m_scene{ scene }
+	, m_tree{ margin }
+{
+	// Pick up any entities that already exist
+	for (size_t i = 0; i < m_scene.getEntityCount(); ++i)
+		update(m_scene.getEntity(i));
+
+	m_scene.registerEntityEventListener(this, g_kIndexedComponents);
+}
+
+SpatialIndex::~SpatialIndex()
+{
+	m_scene.removeEntityEventListener(this);
+}
+
+void SpatialIndex::queryFrustum(const FrustumCulling::Frustum& frustum, std::vector<Entity*>& outEntities) const
+{
+	m_tree.queryFrustum(frustum, [&](size_t entityIndex) {
+		outEntities.push_back(&m_scene.getEntity(entityIndex));
+	});
+
+	for (size_t entityIndex : m_unboundedEntities)
+		outEntities.push_back(&m_scene.getEntity(entityIndex));
+}
+
+void SpatialIndex::queryAABB(const AABB& aabb, std::vector<Entity*>& outEntities) const
+{
+	m_tree.queryAABB(aabb, [&](size_t entityIndex) {
+		outEntities.push_back(&m_scene.getEntity(entityIndex));
+	});
+
+	for (size_t entityIndex : m_unboundedEntities)
+		outEntities.push_back(&m_scene.getEntity(entityIndex));
+}
+
+void SpatialIndex::querySphere(const glm::vec3& center, float radius, std::vector<Entity*>& outEntities) const
+{
+	m_tree.querySphere(center, radius, [&](size_t entityIndex) {
+		outEntities.push_back(&m_scene.getEntity(entityIndex));
+	});
+
+	for (size_t entityIndex : m_unboundedEntities)
+		outEntities.push_back(&m_scene.getEntity(entityIndex));
+}
+
+Entity* SpatialIndex::rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* outDistance) const
+{
+	// Only look for hits closer than the closest so far
+	Entity* closestEntity = nullptr;
+	float closestDistance = maxDistance;
+	m_tree.rayCast(origin, direction, maxDistance, [&](size_t entityIndex, float distance) {
+		if (distance <= closestDistance) {
+			closestEntity = &m_scene.getEntity(entityIndex);
+			closestDistance = distance;
+		}
+		return closestDistance;
+	});
+
+	if (closestEntity && outDistance)
+		*outDistance = closestDistance;
+	return closestEntity;
+}
+
+size_t SpatialIndex::size() const
+{
+	return m_tree.size() + m_unboundedEntities.size();
+}
+
+void SpatialIndex::rebuild()
+{
+	m_tree.rebuild();
+}
+
+const AABBTree& SpatialIndex::getTree() const
+{
+	return m_tree;
+}
+
+bool SpatialIndex::calculateModelAABB(const ModelComponent& model, const glm::mat4& transform, AABB& outAABB)
+{
+	const float kInfinity = std::numeric_limits<float>::infinity();
+	AABB aabb = { glm::vec3(kInfinity), glm::vec3(-kInfinity) };
+
+	// Models without a node tree (i.e. primitives) draw every mesh with
+	// the models transform
+	if (model.rootNode.meshIDs.empty() && model.rootNode.childNodes.empty()) {
+		for (size_t i = 0; i < model.meshes.size(); ++i) {
+			if (!addMeshAABB(model.meshes.at(i).bounds, transform, aabb))
+				return false;
+		}
+	} else if (!addNodeAABB(model, model.rootNode, transform, aabb)) {
+		return false;
+	}
+
+	// Models without any meshes are indexed by their position
+	if (aabb.min.x > aabb.max.x) {
+		glm::vec3 position = glm::vec3(transform[3]);
+		aabb = { position, position };
+	}
+
+	outAABB = aabb;
+	return true;
+}
+
+void SpatialIndex::onEntityEvents(const EntityEvent* events, size_t numEvents)
+{
+	// Update against the current state of the slot, it may have been
+	// destroyed or reused since the event was queued
+	for (size_t i = 0; i < numEvents; ++i)
+		update(m_scene.getEntity(events[i].entity.index));
+}
+
+void SpatialIndex::onWorldMatricesChanged(const size_t* entityIndices, size_t numEntities)
+{
+	// Entities that aren't indexed yet are added when their events are
+	// dispatched
+	for (size_t i = 0; i < numEntities; ++i) {
+		size_t entityIndex = entityIndices[i];
+		if (entityIndex < m_entries.size() && m_entries[entityIndex].proxyID != s_kNotIndexed)
+			update(m_scene.getEntity(entityIndex));
+	}
+}
+
+void SpatialIndex::update(Entity& entity)
+{
+	size_t entityIndex = entity.getIndex();
+	if (!entity.isAlive() || !entity.hasComponents(g_kIndexedComponents)) {
+		remove(entityIndex);
+		return;
+	}
+
+	if (entityIndex >= m_entries.size())
+		m_entries.resize(entityIndex + 1);
+	IndexEntry& entry = m_entries[entityIndex];
+
+	AABB aabb;
+	if (!calculateModelAABB(entity.model(), m_scene.getWorldMatrix(entity), aabb)) {
+		if (entry.proxyID != s_kUnbounded) {
+			remove(entityIndex);
+			entry.proxyID = s_kUnbounded;
+			m_unboundedEntities.push_back(entityIndex);
+		}
+		return;
+	}
+
+	glm::vec3 center = (aabb.min + aabb.max) * 0.5f;
+	if (entry.proxyID < 0) {
+		remove(entityIndex);
+		entry.proxyID = m_tree.createProxy(aabb, entityIndex);
+	} else {
+		m_tree.moveProxy(entry.proxyID, aabb, center - entry.center);
+	}
+	entry.center = center;
+}
+
+void SpatialIndex::remove(size_t entityIndex)
+{
+	if (entityIndex >= m_entries.size())
+		return;
+
+	IndexEntry& entry = m_entries[entityIndex];
+	if (entry.proxyID == s_kUnbounded) {
+		auto it = std::find(m_unboundedEntities.begin(), m_unboundedEntities.end(), entityIndex);
+		*it = m_unboundedEntities.back();
+		m_unboundedEntities.pop_back();
+	} else if (entry.proxyID >= 0) {
+		m_tree.destroyProxy(entry.proxyID);
+	}
+
+	entry.proxyID = s_kNotIndexed;
+}
@@ -0,0 +1,92 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Keeps the bounds of every model in a scene in an
+//                AABB tree, for fast spatial queries.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include "AABBTree.h"
+#include "EntityEventListener.h"
+#include "FrustumCulling.h"
+
+#include <glm\glm.hpp>
+
+#include <vector>
+
+class Scene;
+class Entity;
+struct ModelComponent;
+
+// Indexes every entity with a model and a transform by the world space
+// AABB of its model.
+// Entities are added and removed through the scenes entity events, and
+// moved when Scene::updateWorldMatrices rebuilds their world matrix, so
+// queries see the world matrices from the last update.
+// Models with unbounded meshes can't be placed in the tree, so they are
+// returned by every frustum, AABB and sphere query.
+class SpatialIndex : public EntityEventListener {
+public:
+	SpatialIndex(Scene&, float margin = 0.1f);
+	~SpatialIndex();
+	SpatialIndex(const SpatialIndex&) = delete;
+	SpatialIndex& operator=(const SpatialIndex&) = delete;
+
+	// Appends the entities whose bounds are at least partly inside the
+	// frustum to outEntities
+	void queryFrustum(const FrustumCulling::Frustum&, std::vector<Entity*>& outEntities) const;
+
+	// Appends the entities whose bounds overlap the AABB to outEntities
+	void queryAABB(const AABB&, std::vector<Entity*>& outEntities) const;
+
+	// Appends the entities whose bounds overlap the sphere to outEntities
+	void querySphere(const glm::vec3& center, float radius, std::vector<Entity*>& outEntities) const;
+
+	// Returns the entity with the closest bounds the ray hits within
+	// maxDistance, or nullptr if it hits none.
+	// Sets outDistance to how far along the ray the bounds are hit.
+	Entity* rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* outDistance = nullptr) const;
+
+	// Returns the number of indexed entities, including unbounded ones
+	size_t size() const;
+
+	// Rebuilds the tree from scratch, which gives a better tree than one
+	// built up by moving entities around
+	void rebuild();
+
+	const AABBTree& getTree() const;
+
+	// Returns the world space AABB of a model with the given transform.
+	// Returns false if any of its meshes are unbounded.
+	static bool calculateModelAABB(const ModelComponent&, const glm::mat4& transform, AABB& outAABB);
+
+	// Inherited via EntityEventListener
+	void onEntityEvents(const EntityEvent* events, size_t numEvents) override;
+	void onWorldMatricesChanged(const size_t* entityIndices, size_t numEntities) override;
+
+private:
+	static const int s_kNotIndexed = -2;
+	static const int s_kUnbounded = -3;
+
+	// Where an entity is in the index
+	struct IndexEntry {
+		int proxyID = s_kNotIndexed; // Or s_kUnbounded if it isn't in the tree
+		glm::vec3 center;            // Of its tight AABB, to find how far it moved
+	};
+
+	void update(Entity&);
+	void remove(size_t entityIndex);
+
+	Scene& m_scene;
+	AABBTree m_tree;
+	std::vector<IndexEntry> m_entries;      // Entity index -> place in the index
+	std::vector<size_t> m_unboundedEntities;
+};
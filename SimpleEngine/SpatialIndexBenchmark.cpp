@@ -0,0 +1,213 @@
+#include "SpatialIndexBenchmark.h"
+
+#include "AABBTree.h"
+#include "Entity.h"
+#include "FrustumCulling.h"
+#include "Log.h"
+#include "Mesh.h"
+#include "Scene.h"
+#include "SpatialIndex.h"
+
+#include <glm\gtc\matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+	using BenchClock = std::chrono::high_resolution_clock;
+
+	const size_t g_kSceneSizes[] = { 1000, 10000, 100000 };
+	const float g_kSpacing = 4;       // Average distance between cubes
+	const float g_kMoveDistance = 0.5f;
+	const float g_kQueryRadius = 10;
+	const int g_kNumSphereQueries = 100;
+	const int g_kNumRuns = 10;
+
+	double secondsSince(BenchClock::time_point start)
+	{
+		return std::chrono::duration<double>(BenchClock::now() - start).count();
+	}
+
+	// Returns the fastest of several runs, to skip runs that were
+	// interrupted
+	template <typename FuncT>
+	double timeBestOf(int numRuns, FuncT func)
+	{
+		double bestTime = 0;
+		for (int i = 0; i < numRuns; ++i) {
+			BenchClock::time_point start = BenchClock::now();
+			func();
+			double time = secondsSince(start);
+			if (i == 0 || time < bestTime)
+				bestTime = time;
+		}
+		return bestTime;
+	}
+
+	Mesh makeCubeMesh()
+	{
+		Mesh mesh = {};
+		mesh.bounds.min = glm::vec3(-0.5f);
+		mesh.bounds.max = glm::vec3(0.5f);
+		mesh.bounds.center = glm::vec3(0);
+		mesh.bounds.radius = std::sqrt(0.75f);
+		return mesh;
+	}
+
+	void logTree(const char* name, double time, const AABBTree& tree)
+	{
+		g_log << "    " << name << ": " << time * 1000 << " ms, height " << tree.getHeight()
+		      << ", area ratio " << tree.getAreaRatio() << "\n";
+	}
+
+	void runScene(size_t numCubes)
+	{
+		g_log << "  " << numCubes << " cubes\n";
+
+		float extent = g_kSpacing * std::cbrt(static_cast<float>(numCubes)) * 0.5f;
+		std::mt19937 generator(1);
+		std::uniform_real_distribution<float> positionDistribution(-extent, extent);
+		std::uniform_real_distribution<float> moveDistribution(-g_kMoveDistance, g_kMoveDistance);
+
+		Scene scene;
+		Mesh cubeMesh = makeCubeMesh();
+		std::vector<Entity*> cubes;
+		for (size_t i = 0; i < numCubes; ++i) {
+			Entity& cube = scene.createEntity(COMPONENT_TRANSFORM, COMPONENT_MODEL);
+			cube.transform().position = { positionDistribution(generator), positionDistribution(generator), positionDistribution(generator) };
+			cube.model().meshes.push_back(cubeMesh);
+			cubes.push_back(&cube);
+		}
+		scene.dispatchEntityEvents();
+		scene.updateWorldMatrices(1);
+
+		// Build the index by inserting every cube, then rebuild it
+		std::unique_ptr<SpatialIndex> index;
+		BenchClock::time_point start = BenchClock::now();
+		index = std::make_unique<SpatialIndex>(scene);
+		logTree("Insert", secondsSince(start), index->getTree());
+		start = BenchClock::now();
+		index->rebuild();
+		logTree("Rebuild", secondsSince(start), index->getTree());
+
+		// Look along z from the front of the volume
+		glm::mat4 view = glm::lookAt(glm::vec3(0, 0, extent), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, extent);
+		FrustumCulling::Frustum frustum = FrustumCulling::makeFrustum(projection * view);
+
+		std::vector<Entity*> visible;
+		double treeFrustumTime = timeBestOf(g_kNumRuns, [&]() {
+			visible.clear();
+			index->queryFrustum(frustum, visible);
+		});
+
+		// Linear culling builds every cubes world sphere, like the render
+		// queue does
+		FrustumCulling::Spheres spheres;
+		std::vector<uint8_t> isVisible;
+		size_t numVisible = 0;
+		double linearFrustumTime = timeBestOf(g_kNumRuns, [&]() {
+			spheres.clear();
+			for (Entity* cube : cubes)
+				FrustumCulling::pushWorldSphere(spheres, cube->model().meshes.at(0).bounds, scene.getWorldMatrix(*cube));
+			numVisible = FrustumCulling::cullSpheres(frustum, spheres, isVisible);
+		});
+		g_log << "    Frustum query: " << treeFrustumTime * 1000 << " ms (" << visible.size() << " found), linear "
+		      << linearFrustumTime * 1000 << " ms (" << numVisible << " found), " << linearFrustumTime / treeFrustumTime << "x\n";
+
+		std::vector<glm::vec3> queryCenters;
+		for (int i = 0; i < g_kNumSphereQueries; ++i)
+			queryCenters.push_back({ positionDistribution(generator), positionDistribution(generator), positionDistribution(generator) });
+
+		size_t numTreeFound = 0;
+		double treeSphereTime = timeBestOf(g_kNumRuns, [&]() {
+			numTreeFound = 0;
+			for (const glm::vec3& center : queryCenters) {
+				visible.clear();
+				index->querySphere(center, g_kQueryRadius, visible);
+				numTreeFound += visible.size();
+			}
+		});
+
+		size_t numLinearFound = 0;
+		double linearSphereTime = timeBestOf(g_kNumRuns, [&]() {
+			numLinearFound = 0;
+			for (const glm::vec3& center : queryCenters) {
+				for (Entity* cube : cubes) {
+					glm::vec3 offset = cube->transform().position - center;
+					float radius = g_kQueryRadius + cubeMesh.bounds.radius;
+					if (glm::dot(offset, offset) <= radius * radius)
+						++numLinearFound;
+				}
+			}
+		});
+		g_log << "    " << g_kNumSphereQueries << " sphere queries: " << treeSphereTime * 1000 << " ms (" << numTreeFound
+		      << " found), linear " << linearSphereTime * 1000 << " ms (" << numLinearFound << " found), "
+		      << linearSphereTime / treeSphereTime << "x\n";
+
+		// Move every cube a little, with and without the index listening
+		auto moveCubes = [&]() {
+			for (Entity* cube : cubes)
+				cube->transform().position += glm::vec3(moveDistribution(generator), moveDistribution(generator), moveDistribution(generator));
+		};
+		moveCubes();
+		start = BenchClock::now();
+		scene.updateWorldMatrices(1);
+		double indexedMoveTime = secondsSince(start);
+		const AABBTree& movedTree = index->getTree();
+		g_log << "    Move with index: " << indexedMoveTime * 1000 << " ms, height " << movedTree.getHeight()
+		      << ", area ratio " << movedTree.getAreaRatio() << "\n";
+
+		index.reset();
+		moveCubes();
+		start = BenchClock::now();
+		scene.updateWorldMatrices(1);
+		g_log << "    Move without index: " << secondsSince(start) * 1000 << " ms\n";
+
+		// Compare reinserting moved proxies against refitting the tree
+		std::vector<AABB> aabbs;
+		for (Entity* cube : cubes) {
+			AABB aabb;
+			SpatialIndex::calculateModelAABB(cube->model(), scene.getWorldMatrix(*cube), aabb);
+			aabbs.push_back(aabb);
+		}
+
+		AABBTree reinsertTree;
+		AABBTree refitTree;
+		std::vector<int> reinsertProxies;
+		std::vector<int> refitProxies;
+		for (size_t i = 0; i < aabbs.size(); ++i) {
+			reinsertProxies.push_back(reinsertTree.createProxy(aabbs[i], i));
+			refitProxies.push_back(refitTree.createProxy(aabbs[i], i));
+		}
+
+		std::vector<glm::vec3> displacements;
+		for (AABB& aabb : aabbs) {
+			glm::vec3 displacement(moveDistribution(generator), moveDistribution(generator), moveDistribution(generator));
+			aabb.min += displacement;
+			aabb.max += displacement;
+			displacements.push_back(displacement);
+		}
+
+		start = BenchClock::now();
+		for (size_t i = 0; i < aabbs.size(); ++i)
+			reinsertTree.moveProxy(reinsertProxies[i], aabbs[i], displacements[i]);
+		logTree("Reinsert moved proxies", secondsSince(start), reinsertTree);
+
+		start = BenchClock::now();
+		for (size_t i = 0; i < aabbs.size(); ++i)
+			refitTree.setProxyAABB(refitProxies[i], aabbs[i]);
+		refitTree.refit();
+		logTree("Refit moved proxies", secondsSince(start), refitTree);
+	}
+}
+
+void SpatialIndexBenchmark::run()
+{
+	g_log << "Spatial index benchmark\n";
+	for (size_t numCubes : g_kSceneSizes)
+		runScene(numCubes);
+}
@@ -0,0 +1,27 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Times building, maintaining and querying the spatial
+//                index against linear scans, as the scene grows.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+// Scatters 1000 to 100000 unit cubes through a volume that grows with
+// them, so the density stays the same, and times:
+//  - building the tree by insertion and by a top down rebuild
+//  - moving every cube a little by reinserting, and by refitting
+//  - frustum queries against culling every cubes bounding sphere
+//  - sphere queries against testing every cube
+// The cubes meshes have no GPU data, so no window is needed.
+namespace SpatialIndexBenchmark {
+	// Results are written to the log.
+	void run();
+}
@@ -0,0 +1,112 @@
+#include "StaticDrawBenchmark.h"
+
+#include "Entity.h"
+#include "Log.h"
+#include "PrimitivePrefabs.h"
+#include "RenderSystem.h"
+#include "Screen.h"
+#include "StaticGeometry.h"
+
+#include <glad\glad.h>
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+namespace {
+	using BenchClock = std::chrono::high_resolution_clock;
+
+	const int g_kNumWarmupFrames = 10;
+	const int g_kNumFrames = 100;
+	const float g_kTileSize = 10;
+
+	double secondsSince(BenchClock::time_point start)
+	{
+		return std::chrono::duration<double>(BenchClock::now() - start).count();
+	}
+
+	// A square level of flat track tiles, each with a pickup on it
+	class LevelScreen : public Screen {
+	public:
+		LevelScreen(size_t numMeshes, bool isStatic)
+		{
+			size_t numTiles = numMeshes / 2;
+			size_t tilesPerRow = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(numTiles))));
+			float levelSize = tilesPerRow * g_kTileSize;
+			Entity& camera = Prefabs::createCamera(m_scene, { levelSize / 2, levelSize / 4, -levelSize / 4 }, { levelSize / 2, 0, levelSize / 2 });
+
+			for (size_t i = 0; i < numTiles; ++i) {
+				TransformComponent tileTransform;
+				tileTransform.position = { (i % tilesPerRow) * g_kTileSize, 0, (i / tilesPerRow) * g_kTileSize };
+				tileTransform.scale = { g_kTileSize / 2, 0.5f, g_kTileSize / 2 };
+				Entity& tile = Prefabs::createCube(m_scene, tileTransform);
+				tile.model().isStatic = isStatic;
+
+				TransformComponent pickupTransform;
+				pickupTransform.position = tileTransform.position + glm::vec3{ 0, 1, 0 };
+				Entity& pickup = Prefabs::createSphere(m_scene, pickupTransform);
+				pickup.model().isStatic = isStatic;
+			}
+
+			auto renderSystem = std::make_unique<RenderSystem>(m_scene);
+			renderSystem->setCamera(camera.getHandle());
+			m_renderSystem = renderSystem.get();
+			m_frameSystems.push_back(std::move(renderSystem));
+		}
+
+		const RenderSystem::RenderStats& getRenderStats() const
+		{
+			return m_renderSystem->getStats();
+		}
+
+		// Renders a frame, returning the CPU time in seconds.
+		// Waits for the GPU afterwards, so frames don't queue up.
+		double renderFrame()
+		{
+			BenchClock::time_point start = BenchClock::now();
+			updateFrameSystems();
+			double time = secondsSince(start);
+			glFinish();
+			return time;
+		}
+
+	private:
+		RenderSystem* m_renderSystem;
+	};
+
+	// Returns the mean CPU time of a frame in milliseconds
+	double timeFrames(size_t numMeshes, bool isStatic, RenderSystem::RenderStats& outStats)
+	{
+		LevelScreen screen(numMeshes, isStatic);
+		for (int i = 0; i < g_kNumWarmupFrames; ++i)
+			screen.renderFrame();
+
+		double totalTime = 0;
+		for (int i = 0; i < g_kNumFrames; ++i)
+			totalTime += screen.renderFrame();
+		outStats = screen.getRenderStats();
+		return totalTime / g_kNumFrames * 1000;
+	}
+}
+
+void StaticDrawBenchmark::run()
+{
+	const size_t kNumMeshes[] = { 100, 1000, 10000, 100000 };
+
+	g_log << "Static draw benchmark (CPU milliseconds per frame)\n";
+	bool isSupported = StaticGeometry::isSupported();
+	if (!isSupported)
+		g_log << "WARNING: Indirect multi draws aren't supported, only timing the render queue\n";
+
+	for (size_t numMeshes : kNumMeshes) {
+		RenderSystem::RenderStats stats;
+		double queueTime = timeFrames(numMeshes, false, stats);
+		g_log << "  " << numMeshes << " meshes (" << stats.numVisibleDraws << " visible, "
+		      << stats.numCulledDraws << " culled): render queue " << queueTime << " ms";
+		if (isSupported) {
+			double staticTime = timeFrames(numMeshes, true, stats);
+			g_log << ", static geometry " << staticTime << " ms (" << queueTime / staticTime << "x)";
+		}
+		g_log << "\n";
+	}
+}
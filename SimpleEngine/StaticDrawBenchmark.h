@@ -0,0 +1,26 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Compares drawing static level geometry through the
+//                render queue against drawing it with indirect multi
+//                draws, as the level grows.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+// Builds grids of track tiles and pickups, like LevelLoader, from 100 to
+// 100000 meshes and times the CPU side of rendering them, once through
+// the render queue and once as static geometry.
+namespace StaticDrawBenchmark {
+	// The window and job system must already be initialized, see
+	// Game::initHeadless.
+	// Results are written to the log.
+	void run();
+}
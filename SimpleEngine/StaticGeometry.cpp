@@ -0,0 +1,311 @@
+#include "StaticGeometry.h"
+
+#include "Mesh.h"
+#include "OcclusionBuffer.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "VertexFormat.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+	const GLuint g_kInstanceTransformLocation = 4;
+	const GLsizeiptr g_kMinBufferSize = 1024 * 1024;
+}
+
+size_t StaticGeometry::EntityHandleHash::operator()(const EntityHandle& handle) const
+{
+	return std::hash<uint64_t>()(static_cast<uint64_t>(handle.generation) << 32 | handle.index);
+}
+
+StaticGeometry::StaticGeometry()
+	: m_vertexBuffer{ 0 }
+	, m_indexBuffer{ 0 }
+	, m_vertexCapacity{ 0 }
+	, m_indexCapacity{ 0 }
+	, m_numVertexBytes{ 0 }
+	, m_numIndexBytes{ 0 }
+	, m_frame{ 0 }
+	, m_isDirty{ false }
+	, m_numDraws{ 0 }
+{
+	glGenVertexArrays(1, &m_VAO);
+	glGenBuffers(1, &m_transformBuffer);
+	glGenBuffers(1, &m_commandBuffer);
+	reserve(m_vertexBuffer, m_vertexCapacity, g_kMinBufferSize);
+	reserve(m_indexBuffer, m_indexCapacity, g_kMinBufferSize);
+	setUpVertexArray();
+}
+
+StaticGeometry::~StaticGeometry()
+{
+	glDeleteVertexArrays(1, &m_VAO);
+	GLuint buffers[] = { m_vertexBuffer, m_indexBuffer, m_transformBuffer, m_commandBuffer };
+	glDeleteBuffers(4, buffers);
+}
+
+bool StaticGeometry::isSupported()
+{
+	return GLAD_GL_VERSION_4_3 != 0;
+}
+
+void StaticGeometry::beginFrame()
+{
+	++m_frame;
+}
+
+bool StaticGeometry::keepModel(const EntityHandle& entity)
+{
+	auto modelIt = m_models.find(entity);
+	if (modelIt == m_models.end())
+		return false;
+
+	modelIt->second.lastKeptFrame = m_frame;
+	return true;
+}
+
+void StaticGeometry::addModel(const EntityHandle& entity, const RenderQueue& draws)
+{
+	Model& model = m_models[entity];
+	model.draws.clear();
+	model.lastKeptFrame = m_frame;
+	for (size_t i = 0; i < draws.size(); ++i) {
+		const DrawCall& drawCall = draws.getDrawCall(i);
+		assert(drawCall.material->willDrawDepth && !drawCall.material->willBlend);
+
+		Draw draw;
+		draw.mesh = addMesh(drawCall.mesh->VAO, drawCall.mesh->numIndices);
+		draw.materialID = drawCall.materialID;
+		draw.transform = drawCall.transform;
+
+		FrustumCulling::Spheres sphere;
+		FrustumCulling::pushWorldSphere(sphere, drawCall.mesh->bounds, drawCall.transform);
+		draw.boundsCenter = { sphere.centerX[0], sphere.centerY[0], sphere.centerZ[0] };
+		draw.boundsRadius = sphere.radius[0];
+
+		model.draws.push_back(draw);
+
+		if (m_materials.find(drawCall.materialID) == m_materials.end())
+			m_materials.emplace(drawCall.materialID, *drawCall.material);
+	}
+
+	m_isDirty = true;
+}
+
+void StaticGeometry::endFrame()
+{
+	for (auto modelIt = m_models.begin(); modelIt != m_models.end();) {
+		if (modelIt->second.lastKeptFrame != m_frame) {
+			modelIt = m_models.erase(modelIt);
+			m_isDirty = true;
+		} else {
+			++modelIt;
+		}
+	}
+
+	if (m_isDirty)
+		rebuildCommands();
+}
+
+size_t StaticGeometry::cull(const FrustumCulling::Frustum& frustum, const OcclusionBuffer* occlusionBuffer, size_t* outNumOccluded)
+{
+	size_t numVisible = FrustumCulling::cullSpheres(frustum, m_spheres, m_isVisible);
+	size_t numFrustumCulled = m_spheres.size() - numVisible;
+
+	// Only the world bounding spheres are kept, so test the boxes around
+	// them
+	size_t numOccluded = 0;
+	if (occlusionBuffer) {
+		const glm::mat4 kIdentity(1);
+		for (size_t i = 0; i < m_isVisible.size(); ++i) {
+			float radius = m_spheres.radius[i];
+			if (!m_isVisible[i] || std::isinf(radius))
+				continue;
+
+			glm::vec3 center(m_spheres.centerX[i], m_spheres.centerY[i], m_spheres.centerZ[i]);
+			if (!occlusionBuffer->isVisible({ center - glm::vec3(radius), center + glm::vec3(radius) }, kIdentity)) {
+				m_isVisible[i] = 0;
+				++numOccluded;
+			}
+		}
+	}
+	if (outNumOccluded)
+		*outNumOccluded = numOccluded;
+
+	for (Batch& batch : m_batches) {
+		size_t firstCommand = batch.commandsOffset / sizeof(DrawCommand);
+		batch.numVisibleCommands = 0;
+		for (size_t i = firstCommand; i < firstCommand + batch.numCommands; ++i)
+			batch.numVisibleCommands += m_isVisible[i];
+	}
+
+	if (m_isVisible != m_uploadedIsVisible) {
+		for (size_t i = 0; i < m_commands.size(); ++i)
+			m_commands[i].instanceCount = m_isVisible[i];
+
+		// Orphan the old commands rather than waiting for the GPU to
+		// finish with them
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawCommand) * m_commands.size(), m_commands.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		m_uploadedIsVisible = m_isVisible;
+	}
+
+	return numFrustumCulled;
+}
+
+void StaticGeometry::bind() const
+{
+	glBindVertexArray(m_VAO);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+}
+
+const std::vector<StaticGeometry::Batch>& StaticGeometry::getBatches() const
+{
+	return m_batches;
+}
+
+const Material& StaticGeometry::getMaterial(uint32_t materialID) const
+{
+	return m_materials.at(materialID);
+}
+
+size_t StaticGeometry::getNumDraws() const
+{
+	return m_numDraws;
+}
+
+const StaticGeometry::MeshRange& StaticGeometry::addMesh(GLuint VAO, GLsizei numIndices)
+{
+	auto meshIt = m_meshRanges.find(VAO);
+	if (meshIt != m_meshRanges.end())
+		return meshIt->second;
+
+	// Find the meshes buffers through its vertex array
+	GLint sourceVertexBuffer, sourceIndexBuffer;
+	glBindVertexArray(VAO);
+	glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &sourceVertexBuffer);
+	glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &sourceIndexBuffer);
+	glBindVertexArray(0);
+
+	GLint numVertexBytes;
+	glBindBuffer(GL_COPY_READ_BUFFER, sourceVertexBuffer);
+	glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &numVertexBytes);
+	GLsizeiptr numIndexBytes = sizeof(GLuint) * numIndices;
+
+	reserve(m_vertexBuffer, m_vertexCapacity, m_numVertexBytes + numVertexBytes);
+	reserve(m_indexBuffer, m_indexCapacity, m_numIndexBytes + numIndexBytes);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, m_numVertexBytes, numVertexBytes);
+	glBindBuffer(GL_COPY_READ_BUFFER, sourceIndexBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, m_numIndexBytes, numIndexBytes);
+
+	MeshRange meshRange;
+	meshRange.firstIndex = static_cast<GLuint>(m_numIndexBytes / sizeof(GLuint));
+	meshRange.baseVertex = static_cast<GLint>(m_numVertexBytes / sizeof(VertexFormat));
+	meshRange.numIndices = numIndices;
+	m_numVertexBytes += numVertexBytes;
+	m_numIndexBytes += numIndexBytes;
+
+	return m_meshRanges.emplace(VAO, meshRange).first->second;
+}
+
+void StaticGeometry::reserve(GLuint& buffer, GLsizeiptr& capacity, GLsizeiptr numBytes)
+{
+	if (numBytes <= capacity)
+		return;
+
+	GLsizeiptr newCapacity = std::max({ numBytes, capacity * 2, g_kMinBufferSize });
+	GLuint newBuffer;
+	glGenBuffers(1, &newBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, newCapacity, nullptr, GL_STATIC_DRAW);
+
+	if (buffer) {
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity);
+		glDeleteBuffers(1, &buffer);
+	}
+
+	buffer = newBuffer;
+	capacity = newCapacity;
+	setUpVertexArray();
+}
+
+void StaticGeometry::setUpVertexArray()
+{
+	// Not set up until both buffers exist
+	if (!m_vertexBuffer || !m_indexBuffer)
+		return;
+
+	// Same layout as GLUtils::bufferMeshData
+	glBindVertexArray(m_VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexFormat), reinterpret_cast<GLvoid*>(offsetof(VertexFormat, position)));
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexFormat), reinterpret_cast<GLvoid*>(offsetof(VertexFormat, normal)));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexFormat), reinterpret_cast<GLvoid*>(offsetof(VertexFormat, texCoord)));
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(VertexFormat), reinterpret_cast<GLvoid*>(offsetof(VertexFormat, color)));
+	for (GLuint location = 0; location < 4; ++location)
+		glEnableVertexAttribArray(location);
+
+	// Each draws world matrix is read from its base instance
+	glBindBuffer(GL_ARRAY_BUFFER, m_transformBuffer);
+	for (GLuint column = 0; column < 4; ++column) {
+		GLuint location = g_kInstanceTransformLocation + column;
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), reinterpret_cast<GLvoid*>(sizeof(glm::vec4) * column));
+		glVertexAttribDivisor(location, 1);
+		glEnableVertexAttribArray(location);
+	}
+
+	glBindVertexArray(0);
+}
+
+void StaticGeometry::rebuildCommands()
+{
+	PROFILE_SCOPE_CATEGORY("StaticGeometry::rebuildCommands", "Render");
+
+	// Group the draws by material, the shader is part of the material
+	std::vector<const Draw*> draws;
+	for (const auto& model : m_models) {
+		for (const Draw& draw : model.second.draws)
+			draws.push_back(&draw);
+	}
+	std::stable_sort(draws.begin(), draws.end(), [this](const Draw* lhs, const Draw* rhs) {
+		const Shader* lhsShader = m_materials.at(lhs->materialID).shader;
+		const Shader* rhsShader = m_materials.at(rhs->materialID).shader;
+		if (lhsShader != rhsShader)
+			return lhsShader < rhsShader;
+		return lhs->materialID < rhs->materialID;
+	});
+
+	std::vector<glm::mat4> transforms(draws.size());
+	m_commands.resize(draws.size());
+	m_spheres.clear();
+	m_batches.clear();
+	for (size_t i = 0; i < draws.size(); ++i) {
+		const Draw& draw = *draws[i];
+		transforms[i] = draw.transform;
+		m_commands[i] = { static_cast<GLuint>(draw.mesh.numIndices), 1, draw.mesh.firstIndex, draw.mesh.baseVertex, static_cast<GLuint>(i) };
+		m_spheres.push_back(draw.boundsCenter, draw.boundsRadius);
+
+		if (m_batches.empty() || m_batches.back().materialID != draw.materialID)
+			m_batches.push_back({ draw.materialID, static_cast<GLintptr>(sizeof(DrawCommand) * i), 0, 0 });
+		++m_batches.back().numCommands;
+		++m_batches.back().numVisibleCommands;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_transformBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * transforms.size(), transforms.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawCommand) * m_commands.size(), m_commands.data(), GL_STREAM_DRAW);
+	m_uploadedIsVisible.assign(m_commands.size(), 1);
+
+	m_numDraws = draws.size();
+	m_isDirty = false;
+}
@@ -0,0 +1,153 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Keeps static models in shared GPU buffers, so they can
+//                be drawn with a few indirect multi draws.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include "EntityHandle.h"
+#include "FrustumCulling.h"
+#include "Material.h"
+
+#include <glad\glad.h>
+#include <glm\glm.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+class OcclusionBuffer;
+class RenderQueue;
+
+// Static meshes are copied into one vertex and index buffer, and each
+// draws world matrix into an instance buffer, once when it is added.
+// Draws are grouped by shader and material into batches, and a batch is
+// drawn with one glMultiDrawElementsIndirect. Each draws base instance
+// selects its world matrix, so the CPU cost of a frame doesn't grow with
+// the number of static meshes.
+// Models are kept while they are kept each frame, and their draws must
+// not change while they are kept.
+// Requires GL 4.3.
+class StaticGeometry {
+public:
+	// A range of draw commands that share a material
+	struct Batch {
+		uint32_t materialID;
+		GLintptr commandsOffset; // Into the draw indirect buffer
+		GLsizei numCommands;
+		GLsizei numVisibleCommands; // As of the last cull
+	};
+
+	StaticGeometry();
+	~StaticGeometry();
+	StaticGeometry(const StaticGeometry&) = delete;
+	StaticGeometry& operator=(const StaticGeometry&) = delete;
+
+	// Returns true if the GL context supports indirect multi draws
+	static bool isSupported();
+
+	// Starts a new frame of keeping models
+	void beginFrame();
+
+	// Keeps an entities model for this frame.
+	// Returns false if the model hasn't been added.
+	bool keepModel(const EntityHandle&);
+
+	// Adds the draws of an entities model.
+	// The draws must only use opaque materials.
+	void addModel(const EntityHandle&, const RenderQueue& draws);
+
+	// Removes the models that weren't kept this frame and rebuilds the
+	// draw commands if the models changed.
+	void endFrame();
+
+	// Culls the draws against the frustum, then against the occlusion
+	// buffer if one is given.
+	// Culled draws are drawn with no instances, and the draw commands are
+	// only uploaded again if the draws that are visible changed.
+	// Returns the number of draws outside the frustum, and sets
+	// outNumOccluded to the number of draws hidden by occluders.
+	size_t cull(const FrustumCulling::Frustum&, const OcclusionBuffer* = nullptr, size_t* outNumOccluded = nullptr);
+
+	// Binds the shared vertex array and the draw indirect buffer
+	void bind() const;
+
+	const std::vector<Batch>& getBatches() const;
+	const Material& getMaterial(uint32_t materialID) const;
+	size_t getNumDraws() const;
+
+private:
+	// Where a mesh was copied to in the shared buffers
+	struct MeshRange {
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLsizei numIndices;
+	};
+
+	struct Draw {
+		MeshRange mesh;
+		uint32_t materialID;
+		glm::mat4 transform;
+		glm::vec3 boundsCenter; // World space bounding sphere
+		float boundsRadius;
+	};
+
+	struct Model {
+		std::vector<Draw> draws;
+		size_t lastKeptFrame;
+	};
+
+	// Matches the layout glMultiDrawElementsIndirect reads
+	struct DrawCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	struct EntityHandleHash {
+		size_t operator()(const EntityHandle& handle) const;
+	};
+
+	// Copies a meshes vertices and indices into the shared buffers
+	const MeshRange& addMesh(GLuint VAO, GLsizei numIndices);
+
+	// Grows a buffer to fit at least numBytes, keeping its contents
+	void reserve(GLuint& buffer, GLsizeiptr& capacity, GLsizeiptr numBytes);
+
+	// Points the shared vertex arrays attributes at the shared buffers
+	void setUpVertexArray();
+
+	void rebuildCommands();
+
+	GLuint m_VAO;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	GLuint m_transformBuffer;
+	GLuint m_commandBuffer;
+	GLsizeiptr m_vertexCapacity;
+	GLsizeiptr m_indexCapacity;
+	GLsizeiptr m_numVertexBytes;
+	GLsizeiptr m_numIndexBytes;
+
+	size_t m_frame;
+	bool m_isDirty;
+	size_t m_numDraws;
+	std::unordered_map<EntityHandle, Model, EntityHandleHash> m_models;
+	std::unordered_map<GLuint, MeshRange> m_meshRanges; // Source VAO -> shared range
+	std::unordered_map<uint32_t, Material> m_materials; // Material id -> material
+	std::vector<Batch> m_batches;
+	std::vector<DrawCommand> m_commands;
+	FrustumCulling::Spheres m_spheres; // Bounds of each draw command
+	std::vector<uint8_t> m_isVisible;
+	std::vector<uint8_t> m_uploadedIsVisible; // Visibility of the commands on the GPU
+};
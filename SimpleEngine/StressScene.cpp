@@ -0,0 +1,107 @@
+#include "StressScene.h"
+
+#include "Entity.h"
+#include "PrimitivePrefabs.h"
+#include "Scene.h"
+#include "Terrain.h"
+
+#include <glm\glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+	const float g_kTerrainSize = 1000;
+
+	// Entities are spawned inside this distance from the centre, so the
+	// followers stay on the terrain for the length of a benchmark
+	const float g_kSpawnExtent = 400;
+
+	size_t scaleCount(size_t count, float scale)
+	{
+		return static_cast<size_t>(std::max(0.0f, std::round(count * scale)));
+	}
+}
+
+StressScene::Settings StressScene::getScaledSettings(float scale)
+{
+	// Snakes scale in both number and length, so the chains get longer
+	// as well as more numerous
+	float snakeScale = std::sqrt(scale);
+
+	Settings settings;
+	settings.numTerrainFollowers = scaleCount(100, scale);
+	settings.numPickups = scaleCount(1000, scale);
+	settings.numSnakes = std::max<size_t>(1, scaleCount(4, snakeScale));
+	settings.snakeTailLength = scaleCount(250, snakeScale);
+	return settings;
+}
+
+Entity& StressScene::create(Scene& scene, const Settings& settings, unsigned seed, std::vector<Entity*>& outPlayers)
+{
+	std::mt19937 generator(seed);
+	std::uniform_real_distribution<float> spawnDistribution(-g_kSpawnExtent, g_kSpawnExtent);
+	std::uniform_real_distribution<float> unitDistribution(-1, 1);
+	auto randomSpawnPos = [&](float height) {
+		return glm::vec3{ spawnDistribution(generator), height, spawnDistribution(generator) };
+	};
+
+	Entity& camera = Prefabs::createCamera(scene, { 0, 150, 150 }, { 0, 0, 0 });
+	Entity& terrain = Prefabs::createTerrain(scene, "Assets/Textures/Heightmaps/heightmap_2.png", g_kTerrainSize);
+
+	// Followers wander in a straight line, following the terrains height.
+	// They have no input map, so their input isn't overwritten.
+	for (size_t i = 0; i < settings.numTerrainFollowers; ++i) {
+		TransformComponent transform{};
+		transform.position = randomSpawnPos(100);
+		Entity& follower = Prefabs::createSphere(scene, transform);
+		follower.addComponents(COMPONENT_TERRAIN_FOLLOW, COMPONENT_SIMPLE_WORLD_SPACE_MOVE_COMPONENT, COMPONENT_INPUT);
+		follower.terrainFollow().terrainToFollow = terrain.getHandle();
+		follower.terrainFollow().followerHalfHeight = 1.0f;
+		follower.simpleWorldSpaceMovement().moveSpeed = 10;
+		follower.input() = {};
+		follower.input().axis = { unitDistribution(generator), 0, unitDistribution(generator) };
+	}
+
+	for (size_t i = 0; i < settings.numPickups; ++i) {
+		Entity& pickup = scene.createEntity(COMPONENT_MODEL | COMPONENT_TRANSFORM | COMPONENT_PICKUP);
+		TransformComponent transform{};
+		transform.position = randomSpawnPos(0);
+		transform.scale = glm::vec3(0.5f);
+		Prefabs::initCube(pickup, transform);
+		pickup.pickup().isActive = true;
+		pickup.pickup().respawnTimeStamp = 0;
+	}
+
+	// Snake heads hold their accelerator down with a fixed turn, so they
+	// drive in circles through the pickups
+	for (size_t i = 0; i < settings.numSnakes; ++i) {
+		TransformComponent transform{};
+		transform.position = randomSpawnPos(0);
+		Entity& head = Prefabs::createSphere(scene, transform);
+		head.addComponents(COMPONENT_INPUT, COMPONENT_VEHICLE_MOVEMENT, COMPONENT_PHYSICS, COMPONENT_PLAYERSTATS);
+		head.input() = {};
+		head.input().acceleratorDown = true;
+		head.input().turnAxis = 0.25f + 0.5f * (i % 2);
+		head.vehicleMovement() = {};
+		head.physics() = {};
+		head.playerStats().numOfTails = static_cast<int>(settings.snakeTailLength);
+		outPlayers.push_back(&head);
+
+		EntityHandle entityToFollow = head.getHandle();
+		for (size_t j = 0; j < settings.snakeTailLength; ++j) {
+			Entity& tail = scene.createEntity(COMPONENT_MODEL | COMPONENT_TRANSFORM | COMPONENT_SNAKETAIL
+			                                  | COMPONENT_PHYSICS | COMPONENT_VEHICLE_MOVEMENT);
+			TransformComponent tailTransform{};
+			tailTransform.position = transform.position;
+			Prefabs::initCube(tail, tailTransform);
+			tail.snakeTail().entityToFollow = entityToFollow;
+			tail.physics() = {};
+			tail.vehicleMovement() = {};
+			entityToFollow = tail.getHandle();
+		}
+	}
+
+	return camera;
+}
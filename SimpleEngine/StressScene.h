@@ -0,0 +1,46 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Procedurally generates scenes with large numbers of
+//                gameplay entities for benchmarking.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <vector>
+
+class Entity;
+class Scene;
+
+// Stress scenes are built from the same prefabs and components as the
+// gameplay scene, so they exercise the same systems.
+// Entities are placed from a seeded generator, so the same settings and
+// seed always give the same scene.
+namespace StressScene {
+	struct Settings {
+		size_t numTerrainFollowers;
+		size_t numPickups;
+		size_t numSnakes;
+		size_t snakeTailLength; // Tail links per snake
+	};
+
+	// Returns settings with entity counts proportional to the scale.
+	// A scale of 1 is around the size of a busy game, 10 and 100 push
+	// the entity counts up by orders of magnitude.
+	Settings getScaledSettings(float scale);
+
+	// Creates a terrain, a camera and the entities described by the
+	// settings in the scene.
+	// The snake heads drive themselves in circles and are output in
+	// outPlayers, for systems that track the players.
+	// An OpenGL context must be current.
+	// Returns the camera.
+	Entity& create(Scene&, const Settings&, unsigned seed, std::vector<Entity*>& outPlayers);
+}
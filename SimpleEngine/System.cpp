@@ -1,6 +1,88 @@
 #include "System.h"
 
+#include "JobSystem.h"
+
+#include <cassert>
+
 System::System(Scene& scene)
 	: m_scene{ scene }
 {
 }
+
+System::System(Scene& scene, size_t componentMask)
+	: m_scene{ scene }
+	, m_query{ std::make_unique<EntityQuery>(scene, componentMask) }
+{
+}
+
+void System::update()
+{
+	if (m_query && m_isParallelUpdate) {
+		size_t batchSize = JobSystem::getBatchSize(m_query->size(), sizeof(Entity*));
+		JobSystem::parallelFor(m_query->size(), batchSize, [this](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+				update(m_query->getEntity(i));
+		});
+		return;
+	}
+
+	if (m_query) {
+		// Queries only change when the scene dispatches its entity
+		// events, which never happens during an update
+		size_t numEntities = m_query->size();
+		for (size_t i = 0; i < numEntities; ++i) {
+			update(m_query->getEntity(i));
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < m_scene.getEntityCount(); ++i) {
+		update(m_scene.getEntity(i));
+	}
+}
+
+size_t System::getReadComponents() const
+{
+	return m_readComponents;
+}
+
+size_t System::getWriteComponents() const
+{
+	return m_writeComponents;
+}
+
+bool System::hasDeclaredComponentAccess() const
+{
+	return m_hasDeclaredComponentAccess;
+}
+
+bool System::requiresMainThread() const
+{
+	return m_requiresMainThread;
+}
+
+bool System::conflicts(const System& lhs, const System& rhs)
+{
+	size_t lhsAccess = lhs.m_readComponents | lhs.m_writeComponents;
+	size_t rhsAccess = rhs.m_readComponents | rhs.m_writeComponents;
+	return Entity::matchesAny(lhs.m_writeComponents, rhsAccess)
+	    || Entity::matchesAny(rhs.m_writeComponents, lhsAccess);
+}
+
+void System::setComponentAccess(size_t readComponents, size_t writeComponents)
+{
+	m_readComponents = readComponents;
+	m_writeComponents = writeComponents;
+	m_hasDeclaredComponentAccess = true;
+}
+
+void System::setRequiresMainThread(bool requiresMainThread)
+{
+	m_requiresMainThread = requiresMainThread;
+}
+
+void System::setParallelUpdate(bool isParallelUpdate)
+{
+	assert(m_query || !isParallelUpdate);
+	m_isParallelUpdate = isParallelUpdate;
+}
@@ -1,20 +1,84 @@
 #pragma once
 
 #include "Entity.h"
+#include "EntityQuery.h"
 #include "Scene.h"
 
+#include <memory>
+
 class System {
 public:
+	// Creates a system that updates every entity in the scene.
 	System(Scene& scene);
+
+	// Creates a system that only updates the entities that have all the
+	// components in the component mask.
+	System(Scene& scene, size_t componentMask);
 	System(const System&) = delete;
 	System& operator=(const System&) = delete;
 
-	virtual void update(Entity&) = 0;
+	// Updates all the entities the system is interested in.
+	// By default this calls update(Entity&) for each entity matching the
+	// systems query (or every entity if the system has no query), systems
+	// that only touch a few component types can override this to run a
+	// typed Scene::view over the packed component arrays instead.
+	virtual void update();
+
+	// Updates a single entity.
+	virtual void update(Entity&) {};
+
 	virtual void beginFrame() = 0;
 	virtual void endFrame() = 0;
 
 	virtual ~System() {};
 
+	// Returns the mask of components read during update()
+	size_t getReadComponents() const;
+
+	// Returns the mask of components written during update()
+	size_t getWriteComponents() const;
+
+	// Returns true if setComponentAccess has been called.
+	// Systems that haven't may change the scenes structure in update().
+	bool hasDeclaredComponentAccess() const;
+
+	// Returns true if update() must be called from the main thread
+	bool requiresMainThread() const;
+
+	// Returns true if the two systems can't update at the same time
+	// because one writes components the other accesses.
+	static bool conflicts(const System& lhs, const System& rhs);
+
 protected:
+	// Declares the components this system reads and writes in update().
+	// Systems that don't declare their access are assumed to read and
+	// write every component, so they never update alongside another
+	// system.
+	// Systems that create or destroy entities or add or remove components
+	// directly during update(), instead of through the scenes command
+	// buffer, must keep the default.
+	void setComponentAccess(size_t readComponents, size_t writeComponents);
+
+	// Systems that touch GL or GLFW must update on the main thread.
+	// Defaults to true.
+	void setRequiresMainThread(bool requiresMainThread);
+
+	// Splits the query's entities into chunks that are updated in
+	// parallel on the job system.
+	// Only valid for systems with a query, whose update(Entity&) only
+	// writes to the entity it is given.
+	// Defaults to false.
+	void setParallelUpdate(bool isParallelUpdate);
+
 	Scene& m_scene;
-};
\ No newline at end of file
+	std::unique_ptr<EntityQuery> m_query; // Null if the system updates every entity
+
+private:
+	static const size_t s_kAllComponents = static_cast<size_t>(-1);
+
+	size_t m_readComponents = s_kAllComponents;
+	size_t m_writeComponents = s_kAllComponents;
+	bool m_requiresMainThread = true;
+	bool m_isParallelUpdate = false;
+	bool m_hasDeclaredComponentAccess = false;
+};
@@ -0,0 +1,100 @@
+#include "SystemScheduler.h"
+
+#include "System.h"
+#include "JobSystem.h"
+#include "Scene.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <thread>
+#include <typeinfo>
+
+void SystemScheduler::update(std::vector<std::unique_ptr<System>>& systems, Scene& scene)
+{
+	buildGraph(systems);
+
+	size_t numSystems = systems.size();
+	std::vector<size_t> remainingDependencies = m_dependencyCounts;
+	std::unique_ptr<JobCounter[]> runningUpdates(new JobCounter[numSystems]);
+	std::vector<bool> started(numSystems, false);
+	std::vector<bool> finished(numSystems, false);
+	size_t numFinished = 0;
+	m_updateTimes.assign(numSystems, 0);
+
+	// Times a systems update, each system writes only its own slot
+	auto timedUpdate = [](System* system, double* updateTime) {
+		using SchedulerClock = std::chrono::high_resolution_clock;
+		SchedulerClock::time_point start = SchedulerClock::now();
+		system->update();
+		*updateTime = std::chrono::duration<double>(SchedulerClock::now() - start).count();
+	};
+
+	auto finish = [&](size_t systemIdx) {
+		finished[systemIdx] = true;
+		++numFinished;
+		for (size_t dependent : m_dependents[systemIdx])
+			--remainingDependencies[dependent];
+	};
+
+	while (numFinished < numSystems) {
+		bool madeProgress = false;
+
+		// Start every system that isn't waiting on another system.
+		// Dependents always come after the systems they depend on, so
+		// systems unblocked by a main thread update start in the same pass.
+		for (size_t i = 0; i < numSystems; ++i) {
+			if (started[i] || remainingDependencies[i] > 0)
+				continue;
+
+			started[i] = true;
+			madeProgress = true;
+			System* system = systems[i].get();
+			if (system->requiresMainThread()) {
+				PROFILE_SCOPE_CATEGORY(typeid(*system).name(), "update");
+				timedUpdate(system, &m_updateTimes[i]);
+				if (!system->hasDeclaredComponentAccess())
+					scene.dispatchEntityEvents();
+				finish(i);
+			} else {
+				double* updateTime = &m_updateTimes[i];
+				JobSystem::run([system, updateTime, timedUpdate]() {
+					PROFILE_SCOPE_CATEGORY(typeid(*system).name(), "update");
+					timedUpdate(system, updateTime);
+				}, &runningUpdates[i]);
+			}
+		}
+
+		// Collect finished worker updates
+		for (size_t i = 0; i < numSystems; ++i) {
+			if (started[i] && !finished[i] && runningUpdates[i].isDone()) {
+				finish(i);
+				madeProgress = true;
+			}
+		}
+
+		// Help out with queued jobs instead of idling
+		if (!madeProgress && !JobSystem::tryRunJob())
+			std::this_thread::yield();
+	}
+}
+
+const std::vector<double>& SystemScheduler::getUpdateTimes() const
+{
+	return m_updateTimes;
+}
+
+void SystemScheduler::buildGraph(const std::vector<std::unique_ptr<System>>& systems)
+{
+	size_t numSystems = systems.size();
+	m_dependents.assign(numSystems, {});
+	m_dependencyCounts.assign(numSystems, 0);
+
+	for (size_t i = 0; i < numSystems; ++i) {
+		for (size_t j = 0; j < i; ++j) {
+			if (System::conflicts(*systems[j], *systems[i])) {
+				m_dependents[j].push_back(i);
+				++m_dependencyCounts[i];
+			}
+		}
+	}
+}
@@ -0,0 +1,47 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Runs system updates concurrently where the systems
+//                don't access the same components.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+class Scene;
+class System;
+
+// Each frame the scheduler builds a dependency graph from the systems
+// declared component access.
+// A system depends on every earlier system it conflicts with, so the
+// results are the same as updating the systems in order.
+// Systems whose dependencies have finished are started straight away,
+// as jobs unless they require the main thread.
+// Systems that don't declare their component access may change the
+// scenes structure, so the scenes entity events are dispatched straight
+// after they update.
+class SystemScheduler {
+public:
+	// Calls update() on every system
+	void update(std::vector<std::unique_ptr<System>>& systems, Scene& scene);
+
+	// Returns the time in seconds each system spent in update() during
+	// the last call to update, indexed like the systems.
+	const std::vector<double>& getUpdateTimes() const;
+
+private:
+	void buildGraph(const std::vector<std::unique_ptr<System>>& systems);
+
+	std::vector<std::vector<size_t>> m_dependents; // System -> systems that must wait for it
+	std::vector<size_t> m_dependencyCounts;        // System -> number of systems it waits for
+	std::vector<double> m_updateTimes;             // System -> seconds spent in update()
+};
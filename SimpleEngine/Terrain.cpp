@@ -4,9 +4,13 @@
 #include "VertexFormat.h"
 #include "GLUtils.h"
 #include "Scene.h"
+#include "Profiler.h"
 
 #include "stb_image.h"
 
+#include <algorithm>
+#include <memory>
+
 using namespace glm;
 
 bool TerrainUtils::castPosToTerrainHeight(const Entity& terrainEntity, const vec3& entityPos, float& outHeight)
@@ -16,26 +20,26 @@ bool TerrainUtils::castPosToTerrainHeight(const Entity& terrainEntity, const vec
 		return false;
 
 	// Bilinear interpolation
-	int numPixelsX = terrainEntity.terrain.heightMapDimensions.x;
+	int numPixelsX = terrainEntity.terrain().heightMapDimensions.x;
 	float xBlend = glm::fract(texCoord.x);
 	float yBlend = glm::fract(texCoord.y);
 
 	// Blend top left and top right corners of the 2 by 2 pixel square
-	float heightTopLeft = terrainEntity.terrain.heightMap[glm::floor(texCoord.y) * numPixelsX + glm::floor(texCoord.x)];
-	float heightTopRight = terrainEntity.terrain.heightMap[glm::floor(texCoord.y) * numPixelsX + glm::ceil(texCoord.x)];
+	float heightTopLeft = terrainEntity.terrain().heightMap[glm::floor(texCoord.y) * numPixelsX + glm::floor(texCoord.x)];
+	float heightTopRight = terrainEntity.terrain().heightMap[glm::floor(texCoord.y) * numPixelsX + glm::ceil(texCoord.x)];
 	float heightTop = (1 - xBlend) * heightTopLeft + xBlend * heightTopRight;
 
 	// Blend bottom left and bottom right corners of the 2 by 2 pixel square
-	float heightBottomLeft = terrainEntity.terrain.heightMap[glm::ceil(texCoord.y) * numPixelsX + glm::floor(texCoord.x)];
-	float heightBottomRight = terrainEntity.terrain.heightMap[glm::ceil(texCoord.y) * numPixelsX + glm::ceil(texCoord.x)];
+	float heightBottomLeft = terrainEntity.terrain().heightMap[glm::ceil(texCoord.y) * numPixelsX + glm::floor(texCoord.x)];
+	float heightBottomRight = terrainEntity.terrain().heightMap[glm::ceil(texCoord.y) * numPixelsX + glm::ceil(texCoord.x)];
 	float heightBottom = (1 - xBlend) * heightBottomLeft + xBlend * heightBottomRight;
 
 	// Blend the two above results across the y component for final blend
 	float height = (1 - yBlend) * heightTop + yBlend * heightBottom;
 
 	// Scale and offset the height by the terrains offset and height scale
-	float heightScale = terrainEntity.terrain.heightScale;
-	float yOffset = terrainEntity.transform.position.y;
+	float heightScale = terrainEntity.terrain().heightScale;
+	float yOffset = terrainEntity.transform().position.y;
 	outHeight = height * heightScale + yOffset;
 
 	return true;
@@ -43,11 +47,11 @@ bool TerrainUtils::castPosToTerrainHeight(const Entity& terrainEntity, const vec
 
 bool TerrainUtils::castPosToHeightMapTexCoord(const Entity& terrainEntity, const vec3& entityPos, vec2& outTexCoord)
 {
-	float terrainExtent = terrainEntity.terrain.size / 2.0f;
-	float terrainSize = terrainEntity.terrain.size;
-	vec2 terrainPos = vec2{ terrainEntity.transform.position.x, terrainEntity.transform.position.z };
+	float terrainExtent = terrainEntity.terrain().size / 2.0f;
+	float terrainSize = terrainEntity.terrain().size;
+	vec2 terrainPos = vec2{ terrainEntity.transform().position.x, terrainEntity.transform().position.z };
 	vec2 terrainTopLeft = terrainPos - terrainExtent;
-	ivec2 numHeightMapPixels = terrainEntity.terrain.heightMapDimensions;
+	ivec2 numHeightMapPixels = terrainEntity.terrain().heightMapDimensions;
 	vec2 entityXZPos = vec2{ entityPos.x, entityPos.z };
 	vec2 normalizedTexCoords = (entityXZPos - terrainTopLeft) / terrainSize;
 
@@ -65,28 +69,50 @@ Entity& Prefabs::createTerrain(Scene& scene, const std::string& heightMapFile, f
 	const float heightScale = size * 0.1f;
 
 	// Create the terrain entity
-	Entity& terrain = scene.createEntity(COMPONENT_MODEL, COMPONENT_TRANSFORM);
-	terrain.transform.position = position;
-	terrain.terrain.heightScale = heightScale;
-	terrain.terrain.size = size;
+	Entity& terrain = scene.createEntity(COMPONENT_MODEL, COMPONENT_TRANSFORM, COMPONENT_TERRAIN);
+	terrain.transform().position = position;
+	terrain.terrain().heightScale = heightScale;
+	terrain.terrain().size = size;
 
 	// Read height map from file
 	int numPixelsX, numPixelsY, numChannels;
 	unsigned char* heightMapImg = stbi_load(heightMapFile.c_str(), &numPixelsX, &numPixelsY, &numChannels, 0);
-	terrain.terrain.heightMapDimensions = { numPixelsX, numPixelsY };
+	terrain.terrain().heightMapDimensions = { numPixelsX, numPixelsY };
 
 	// Convert to array of floats
-	terrain.terrain.heightMap = std::vector<float>(numPixelsX * numPixelsY);
-	std::vector<float>& heightMapData = terrain.terrain.heightMap;
+	terrain.terrain().heightMap = std::vector<float>(numPixelsX * numPixelsY);
+	std::vector<float>& heightMapData = terrain.terrain().heightMap;
 	for (GLsizei r = 0; r < numPixelsY; ++r) {
 		for (GLsizei c = 0; c < numPixelsX; ++c) {
 			heightMapData[r * numPixelsX + c] = heightMapImg[(r * numPixelsX + c) * numChannels] / 255.0f; // Ignore any extra channels by skipping over them
 		}
 	}
-	Texture heightMap = Texture::Texture2D(numPixelsX, numPixelsY, GL_RED, GL_FLOAT, heightMapData.data());
-
 	stbi_image_free(heightMapImg);
 
+	terrain.terrain().baseTessellation = baseTessellation;
+	TerrainUtils::buildTerrainModel(terrain);
+
+	// The terrain hides most of the level from low cameras
+	terrain.model().isOccluder = true;
+
+	return terrain;
+}
+
+void TerrainUtils::buildTerrainModel(Entity& terrainEntity)
+{
+	PROFILE_SCOPE_CATEGORY("TerrainUtils::buildTerrainModel", "Assets");
+
+	const TerrainComponent& terrain = terrainEntity.terrain();
+	const std::vector<float>& heightMapData = terrain.heightMap;
+	const GLsizei numPixelsX = terrain.heightMapDimensions.x;
+	const GLsizei numPixelsY = terrain.heightMapDimensions.y;
+	const GLsizei baseTessellation = terrain.baseTessellation;
+	const float size = terrain.size;
+	const float heightScale = terrain.heightScale;
+	const vec3 position = terrainEntity.transform().position;
+
+	Texture heightMap = Texture::Texture2D(numPixelsX, numPixelsY, GL_RED, GL_FLOAT, heightMapData.data());
+
 	// Create CPU tesselated quad for base tesselation level
 	GLsizei numVertsX, numVertsZ;
 	numVertsX = numVertsZ = baseTessellation + 1;
@@ -119,7 +145,7 @@ Entity& Prefabs::createTerrain(Scene& scene, const std::string& heightMapFile, f
 				for (int j = -1; j < 1; ++j) {
 					// Get corresponding cell verts
 					std::array<vec3, 4> cellVerts;
-					for (GLsizei k = 0; k < cellVerts.size(); ++k) {
+					for (GLsizei k = 0; k < static_cast<GLsizei>(cellVerts.size()); ++k) {
 						GLsizei pixelR = r + i + (k / 2);
 						GLsizei pixelC = c + j + (k % 2);
 						pixelR = pixelR >= 0 && pixelR < numPixelsY ? pixelR : r;
@@ -158,15 +184,71 @@ Entity& Prefabs::createTerrain(Scene& scene, const std::string& heightMapFile, f
 	Mesh mesh{
 		0, // Use the first material on the model
 		GLUtils::bufferMeshData(meshVertices, meshIndices),
-		static_cast<GLsizei>(meshIndices.size())
+		static_cast<GLsizei>(meshIndices.size()),
+		GLUtils::calculateMeshBounds(meshVertices),
+		{}, // No levels of detail
+		0
 	};
 
+	// The mesh is flat until it is displaced by the height map when
+	// tessellated, and grass grows up to a couple of units out of it
+	const float kGrassPadding = 2;
+	MeshBounds& bounds = mesh.bounds;
+	bounds.min -= vec3(kGrassPadding);
+	bounds.max += vec3(kGrassPadding, heightScale + kGrassPadding, kGrassPadding);
+	bounds.center = (bounds.min + bounds.max) / 2.0f;
+	bounds.radius = glm::length(bounds.max - bounds.center);
+
+	// Occlude with a coarse grid under the surface.
+	// Each grid vertex takes the lowest height of the cells around it, so
+	// the grid never rises above the terrain and hides nothing that should
+	// be visible.
+	const GLsizei kMaxOccluderCells = 32;
+	std::shared_ptr<OccluderMesh> occluder;
+	if (numPixelsX > 1 && numPixelsY > 1) {
+		occluder = std::make_shared<OccluderMesh>();
+		const GLsizei numCellsX = std::min(kMaxOccluderCells, numPixelsX - 1);
+		const GLsizei numCellsZ = std::min(kMaxOccluderCells, numPixelsY - 1);
+		for (GLsizei r = 0; r <= numCellsZ; ++r) {
+			GLsizei minPixelR = std::max(r - 1, 0) * (numPixelsY - 1) / numCellsZ;
+			GLsizei maxPixelR = (std::min(r + 1, numCellsZ) * (numPixelsY - 1) + numCellsZ - 1) / numCellsZ;
+			for (GLsizei c = 0; c <= numCellsX; ++c) {
+				GLsizei minPixelC = std::max(c - 1, 0) * (numPixelsX - 1) / numCellsX;
+				GLsizei maxPixelC = (std::min(c + 1, numCellsX) * (numPixelsX - 1) + numCellsX - 1) / numCellsX;
+
+				float minHeight = 1;
+				for (GLsizei pixelR = minPixelR; pixelR <= maxPixelR; ++pixelR) {
+					for (GLsizei pixelC = minPixelC; pixelC <= maxPixelC; ++pixelC)
+						minHeight = std::min(minHeight, heightMapData[pixelR * numPixelsX + pixelC]);
+				}
+
+				// The mesh is centred on the model, unlike heightMapIdxToVertPos
+				occluder->positions.push_back({ c * size / numCellsX - size / 2, minHeight * heightScale, r * size / numCellsZ - size / 2 });
+			}
+		}
+
+		for (GLsizei r = 0; r < numCellsZ; ++r) {
+			for (GLsizei c = 0; c < numCellsX; ++c) {
+				GLuint topLeft = r * (numCellsX + 1) + c;
+				GLuint bottomLeft = topLeft + numCellsX + 1;
+				occluder->indices.insert(occluder->indices.end(), { topLeft, bottomLeft, bottomLeft + 1, topLeft, bottomLeft + 1, topLeft + 1 });
+			}
+		}
+	}
+
 	// Fill model component with mesh data
-	terrain.model.rootNode.meshIDs.push_back(0);
-	terrain.model.rootNode.meshIDs.push_back(1);
-	terrain.model.meshes.push_back(mesh);
-	terrain.model.meshes.push_back(mesh);
-	terrain.model.meshes[1].materialIndex = 1;
+	ModelComponent& model = terrainEntity.model();
+	model.rootNode = {};
+	model.meshes.clear();
+	model.materials.clear();
+	model.assetType = MODEL_ASSET_TERRAIN;
+	model.assetPaths.clear();
+	model.rootNode.meshIDs.push_back(0);
+	model.rootNode.meshIDs.push_back(1);
+	model.meshes.push_back(mesh);
+	model.meshes.push_back(mesh);
+	model.meshes[1].materialIndex = 1;
+	model.occluder = occluder;
 
 	// Create terrain material component
 	Material terrainMaterial;
@@ -179,7 +261,7 @@ Entity& Prefabs::createTerrain(Scene& scene, const std::string& heightMapFile, f
 	terrainMaterial.shaderParams.metallicness = 0;
 	terrainMaterial.shaderParams.glossiness = 0;
 	terrainMaterial.shaderParams.specBias = 0;
-	terrain.model.materials.push_back(std::move(terrainMaterial));
+	model.materials.push_back(std::move(terrainMaterial));
 
 	// Create grass material component
 	Material grassMaterial;
@@ -193,7 +275,5 @@ Entity& Prefabs::createTerrain(Scene& scene, const std::string& heightMapFile, f
 	grassMaterial.shaderParams.glossiness = 0;
 	grassMaterial.shaderParams.specBias = 0;
 	grassMaterial.shaderParams.discardTransparent = true;
-	terrain.model.materials.push_back(std::move(grassMaterial));
-
-	return terrain;
+	model.materials.push_back(std::move(grassMaterial));
 }
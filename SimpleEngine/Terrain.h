@@ -13,6 +13,7 @@ struct TerrainComponent {
 	glm::ivec2 heightMapDimensions;
 	float heightScale;
 	float size;
+	GLsizei baseTessellation;
 };
 
 namespace TerrainUtils {
@@ -23,6 +24,10 @@ namespace TerrainUtils {
 	// Returns true if casting position to heightmap texture coordinate succeeded (position is above terrain).
 	// The texture coordinate is output the outTexCoord parameter
 	bool castPosToHeightMapTexCoord(const Entity& terrainEntity, const glm::vec3& entityPos, glm::vec2& outTexCoord);
+
+	// Builds the terrains meshes, textures and materials from its terrain
+	// component, replacing the contents of its model component.
+	void buildTerrainModel(Entity& terrainEntity);
 }
 
 namespace Prefabs {
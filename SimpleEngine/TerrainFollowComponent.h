@@ -1,8 +1,8 @@
 #pragma once
 
-class Entity;
+#include "EntityHandle.h"
 
 struct TerrainFollowComponent {
-	Entity* terrainToFollow;
+	EntityHandle terrainToFollow;
 	float followerHalfHeight;
-};
\ No newline at end of file
+};
@@ -8,20 +8,27 @@
 TerrainFollowSystem::TerrainFollowSystem(Scene& scene)
 	: System(scene)
 {
+	setComponentAccess(COMPONENT_TERRAIN_FOLLOW | COMPONENT_TERRAIN, COMPONENT_TRANSFORM);
+	setRequiresMainThread(false);
 }
 
-void TerrainFollowSystem::update(Entity& entity)
+void TerrainFollowSystem::update()
 {
-	if (!entity.hasComponents(COMPONENT_TERRAIN_FOLLOW, COMPONENT_TRANSFORM))
-		return;
+	float lerpAlpha = Clock::getDeltaTime() * 50.0f;
+	m_scene.view<TerrainFollowComponent, TransformComponent>().parallelEach([this, lerpAlpha](const TerrainFollowComponent& terrainFollow, TransformComponent& transform) {
+		// Skip followers whose terrain has been destroyed
+		const Entity* terrain = m_scene.getEntity(terrainFollow.terrainToFollow);
+		if (!terrain)
+			return;
 
-	float terrainHeight;
-	bool success = TerrainUtils::castPosToTerrainHeight(*entity.terrainFollow.terrainToFollow, entity.transform.position, terrainHeight);
-	if (success) {
-		float yPos = entity.transform.position.y;
-		float halfHeight = entity.terrainFollow.followerHalfHeight;
-		entity.transform.position.y = glm::lerp(yPos, terrainHeight + halfHeight, Clock::getDeltaTime() * 50.0f);
-	}
+		float terrainHeight;
+		bool success = TerrainUtils::castPosToTerrainHeight(*terrain, transform.position, terrainHeight);
+		if (success) {
+			float yPos = transform.position.y;
+			float halfHeight = terrainFollow.followerHalfHeight;
+			transform.position.y = glm::lerp(yPos, terrainHeight + halfHeight, lerpAlpha);
+		}
+	});
 }
 
 void TerrainFollowSystem::beginFrame()
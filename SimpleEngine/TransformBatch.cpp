@@ -0,0 +1,323 @@
+#include "TransformBatch.h"
+
+#include <cassert>
+
+// SSE2 is always available on x64 and is MSVCs default for x86.
+// MSVC allows AVX2 intrinsics without /arch:AVX2, other compilers need
+// AVX2 enabled for the whole file.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TRANSFORM_BATCH_SSE
+#include <xmmintrin.h>
+#endif
+
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__AVX2__)
+#define TRANSFORM_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && defined(TRANSFORM_BATCH_AVX2)
+#include <intrin.h>
+#endif
+
+namespace {
+	// Pointers to one element of every transform in the batch
+	struct TransformArrays {
+		TransformArrays(const TransformBatch::Transforms& transforms)
+			: positionX{ transforms.positionX.data() }
+			, positionY{ transforms.positionY.data() }
+			, positionZ{ transforms.positionZ.data() }
+			, rotationX{ transforms.rotationX.data() }
+			, rotationY{ transforms.rotationY.data() }
+			, rotationZ{ transforms.rotationZ.data() }
+			, rotationW{ transforms.rotationW.data() }
+			, scaleX{ transforms.scaleX.data() }
+			, scaleY{ transforms.scaleY.data() }
+			, scaleZ{ transforms.scaleZ.data() }
+		{
+		}
+
+		const float* positionX;
+		const float* positionY;
+		const float* positionZ;
+		const float* rotationX;
+		const float* rotationY;
+		const float* rotationZ;
+		const float* rotationW;
+		const float* scaleX;
+		const float* scaleY;
+		const float* scaleZ;
+	};
+
+	// Builds the matrices of transforms [begin, end) one at a time.
+	// Does the same arithmetic as the SIMD kernels, so the results match.
+	void buildScalar(const TransformArrays& in, size_t begin, size_t end, glm::mat4* outMatrices)
+	{
+		for (size_t i = begin; i < end; ++i) {
+			float x = in.rotationX[i];
+			float y = in.rotationY[i];
+			float z = in.rotationZ[i];
+			float w = in.rotationW[i];
+			float x2 = x + x;
+			float y2 = y + y;
+			float z2 = z + z;
+			float xx = x * x2, yy = y * y2, zz = z * z2;
+			float xy = x * y2, xz = x * z2, yz = y * z2;
+			float wx = w * x2, wy = w * y2, wz = w * z2;
+
+			float scaleX = in.scaleX[i];
+			float scaleY = in.scaleY[i];
+			float scaleZ = in.scaleZ[i];
+
+			glm::mat4& matrix = outMatrices[i];
+			matrix[0] = glm::vec4((1 - (yy + zz)) * scaleX, (xy + wz) * scaleX, (xz - wy) * scaleX, 0);
+			matrix[1] = glm::vec4((xy - wz) * scaleY, (1 - (xx + zz)) * scaleY, (yz + wx) * scaleY, 0);
+			matrix[2] = glm::vec4((xz + wy) * scaleZ, (yz - wx) * scaleZ, (1 - (xx + yy)) * scaleZ, 0);
+			matrix[3] = glm::vec4(in.positionX[i], in.positionY[i], in.positionZ[i], 1);
+		}
+	}
+
+#ifdef TRANSFORM_BATCH_SSE
+	// Builds the matrices of transforms [begin, end) 4 at a time.
+	// Returns the first transform that wasn't built.
+	size_t buildSSE(const TransformArrays& in, size_t begin, size_t end, glm::mat4* outMatrices)
+	{
+		const __m128 one = _mm_set1_ps(1);
+		const __m128 zero = _mm_setzero_ps();
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4) {
+			__m128 x = _mm_loadu_ps(in.rotationX + i);
+			__m128 y = _mm_loadu_ps(in.rotationY + i);
+			__m128 z = _mm_loadu_ps(in.rotationZ + i);
+			__m128 w = _mm_loadu_ps(in.rotationW + i);
+			__m128 x2 = _mm_add_ps(x, x);
+			__m128 y2 = _mm_add_ps(y, y);
+			__m128 z2 = _mm_add_ps(z, z);
+			__m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+			__m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+			__m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+			__m128 scaleX = _mm_loadu_ps(in.scaleX + i);
+			__m128 scaleY = _mm_loadu_ps(in.scaleY + i);
+			__m128 scaleZ = _mm_loadu_ps(in.scaleZ + i);
+
+			// Each register holds one matrix element of the 4 transforms
+			__m128 columns[4][4] = {
+				{ _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), scaleX),
+				  _mm_mul_ps(_mm_add_ps(xy, wz), scaleX),
+				  _mm_mul_ps(_mm_sub_ps(xz, wy), scaleX),
+				  zero },
+				{ _mm_mul_ps(_mm_sub_ps(xy, wz), scaleY),
+				  _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), scaleY),
+				  _mm_mul_ps(_mm_add_ps(yz, wx), scaleY),
+				  zero },
+				{ _mm_mul_ps(_mm_add_ps(xz, wy), scaleZ),
+				  _mm_mul_ps(_mm_sub_ps(yz, wx), scaleZ),
+				  _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), scaleZ),
+				  zero },
+				{ _mm_loadu_ps(in.positionX + i),
+				  _mm_loadu_ps(in.positionY + i),
+				  _mm_loadu_ps(in.positionZ + i),
+				  one },
+			};
+
+			// Transpose each column so each register holds the column of
+			// one matrix
+			for (int col = 0; col < 4; ++col) {
+				__m128* column = columns[col];
+				_MM_TRANSPOSE4_PS(column[0], column[1], column[2], column[3]);
+				for (int j = 0; j < 4; ++j)
+					_mm_storeu_ps(&outMatrices[i + j][col][0], column[j]);
+			}
+		}
+
+		return i;
+	}
+#endif
+
+#ifdef TRANSFORM_BATCH_AVX2
+	// Builds the matrices of transforms [begin, end) 8 at a time.
+	// Returns the first transform that wasn't built.
+	size_t buildAVX2(const TransformArrays& in, size_t begin, size_t end, glm::mat4* outMatrices)
+	{
+		const __m256 one = _mm256_set1_ps(1);
+		const __m256 zero = _mm256_setzero_ps();
+
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8) {
+			__m256 x = _mm256_loadu_ps(in.rotationX + i);
+			__m256 y = _mm256_loadu_ps(in.rotationY + i);
+			__m256 z = _mm256_loadu_ps(in.rotationZ + i);
+			__m256 w = _mm256_loadu_ps(in.rotationW + i);
+			__m256 x2 = _mm256_add_ps(x, x);
+			__m256 y2 = _mm256_add_ps(y, y);
+			__m256 z2 = _mm256_add_ps(z, z);
+			__m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+			__m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+			__m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+			__m256 scaleX = _mm256_loadu_ps(in.scaleX + i);
+			__m256 scaleY = _mm256_loadu_ps(in.scaleY + i);
+			__m256 scaleZ = _mm256_loadu_ps(in.scaleZ + i);
+
+			// Each register holds one matrix element of the 8 transforms
+			__m256 columns[4][4] = {
+				{ _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), scaleX),
+				  _mm256_mul_ps(_mm256_add_ps(xy, wz), scaleX),
+				  _mm256_mul_ps(_mm256_sub_ps(xz, wy), scaleX),
+				  zero },
+				{ _mm256_mul_ps(_mm256_sub_ps(xy, wz), scaleY),
+				  _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), scaleY),
+				  _mm256_mul_ps(_mm256_add_ps(yz, wx), scaleY),
+				  zero },
+				{ _mm256_mul_ps(_mm256_add_ps(xz, wy), scaleZ),
+				  _mm256_mul_ps(_mm256_sub_ps(yz, wx), scaleZ),
+				  _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), scaleZ),
+				  zero },
+				{ _mm256_loadu_ps(in.positionX + i),
+				  _mm256_loadu_ps(in.positionY + i),
+				  _mm256_loadu_ps(in.positionZ + i),
+				  one },
+			};
+
+			// Transpose each column within 128 bit lanes, giving the columns
+			// of matrices 0-3 in the low halves and 4-7 in the high halves
+			for (int col = 0; col < 4; ++col) {
+				const __m256* column = columns[col];
+				__m256 xy01 = _mm256_unpacklo_ps(column[0], column[1]);
+				__m256 xy23 = _mm256_unpackhi_ps(column[0], column[1]);
+				__m256 zw01 = _mm256_unpacklo_ps(column[2], column[3]);
+				__m256 zw23 = _mm256_unpackhi_ps(column[2], column[3]);
+				__m256 matrices[4] = {
+					_mm256_shuffle_ps(xy01, zw01, _MM_SHUFFLE(1, 0, 1, 0)),
+					_mm256_shuffle_ps(xy01, zw01, _MM_SHUFFLE(3, 2, 3, 2)),
+					_mm256_shuffle_ps(xy23, zw23, _MM_SHUFFLE(1, 0, 1, 0)),
+					_mm256_shuffle_ps(xy23, zw23, _MM_SHUFFLE(3, 2, 3, 2)),
+				};
+				for (int j = 0; j < 4; ++j) {
+					_mm_storeu_ps(&outMatrices[i + j][col][0], _mm256_castps256_ps128(matrices[j]));
+					_mm_storeu_ps(&outMatrices[i + j + 4][col][0], _mm256_extractf128_ps(matrices[j], 1));
+				}
+			}
+		}
+
+		return i;
+	}
+#endif
+
+	bool detectAVX2()
+	{
+#if defined(_MSC_VER) && defined(TRANSFORM_BATCH_AVX2)
+		// The OS must also save the AVX registers on context switches
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+		bool hasAVX = (info[2] & (1 << 28)) != 0;
+		if (!hasOSXSave || !hasAVX || (_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif defined(TRANSFORM_BATCH_AVX2)
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+}
+
+void TransformBatch::Transforms::clear()
+{
+	positionX.clear();
+	positionY.clear();
+	positionZ.clear();
+	rotationX.clear();
+	rotationY.clear();
+	rotationZ.clear();
+	rotationW.clear();
+	scaleX.clear();
+	scaleY.clear();
+	scaleZ.clear();
+}
+
+size_t TransformBatch::Transforms::size() const
+{
+	return positionX.size();
+}
+
+void TransformBatch::Transforms::push_back(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	positionX.push_back(position.x);
+	positionY.push_back(position.y);
+	positionZ.push_back(position.z);
+	rotationX.push_back(rotation.x);
+	rotationY.push_back(rotation.y);
+	rotationZ.push_back(rotation.z);
+	rotationW.push_back(rotation.w);
+	scaleX.push_back(scale.x);
+	scaleY.push_back(scale.y);
+	scaleZ.push_back(scale.z);
+}
+
+void TransformBatch::buildMatrices(const Transforms& transforms, glm::mat4* outMatrices)
+{
+	if (isAVX2Supported())
+		buildMatricesAVX2(transforms, outMatrices);
+	else if (isSSESupported())
+		buildMatricesSSE(transforms, outMatrices);
+	else
+		buildMatricesScalar(transforms, outMatrices);
+}
+
+void TransformBatch::buildMatricesScalar(const Transforms& transforms, glm::mat4* outMatrices)
+{
+	buildScalar(TransformArrays(transforms), 0, transforms.size(), outMatrices);
+}
+
+void TransformBatch::buildMatricesSSE(const Transforms& transforms, glm::mat4* outMatrices)
+{
+	assert(isSSESupported());
+
+	TransformArrays arrays(transforms);
+	size_t numBuilt = 0;
+#ifdef TRANSFORM_BATCH_SSE
+	numBuilt = buildSSE(arrays, 0, transforms.size(), outMatrices);
+#endif
+
+	// Finish the transforms left over from the last group of 4
+	buildScalar(arrays, numBuilt, transforms.size(), outMatrices);
+}
+
+void TransformBatch::buildMatricesAVX2(const Transforms& transforms, glm::mat4* outMatrices)
+{
+	assert(isAVX2Supported());
+
+	TransformArrays arrays(transforms);
+	size_t numBuilt = 0;
+#ifdef TRANSFORM_BATCH_AVX2
+	numBuilt = buildAVX2(arrays, 0, transforms.size(), outMatrices);
+#endif
+#ifdef TRANSFORM_BATCH_SSE
+	numBuilt = buildSSE(arrays, numBuilt, transforms.size(), outMatrices);
+#endif
+
+	// Finish the transforms left over from the last group of 4
+	buildScalar(arrays, numBuilt, transforms.size(), outMatrices);
+}
+
+bool TransformBatch::isSSESupported()
+{
+#ifdef TRANSFORM_BATCH_SSE
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool TransformBatch::isAVX2Supported()
+{
+	static const bool s_kIsSupported = detectAVX2();
+	return s_kIsSupported;
+}
@@ -0,0 +1,51 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : Builds transform matrices in batches with SIMD.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <glm\glm.hpp>
+#include <glm\gtc\quaternion.hpp>
+
+#include <vector>
+
+// Matrices are built as translate * rotate * scale, the same as
+// GLMUtils::transformToMat, from a quaternion rather than Euler angles so
+// no trig is needed.
+// Transforms are stored as a structure of arrays, so the SIMD kernels
+// can load the same element of 4 or 8 transforms at once.
+namespace TransformBatch {
+	struct Transforms {
+		void clear();
+		size_t size() const;
+
+		// Adds a transform to the end of the batch
+		void push_back(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+		std::vector<float> scaleX, scaleY, scaleZ;
+	};
+
+	// Builds a matrix for each transform in the batch with the fastest
+	// kernel the CPU supports.
+	// outMatrices must have room for transforms.size() matrices.
+	void buildMatrices(const Transforms&, glm::mat4* outMatrices);
+
+	// The individual kernels, exposed for benchmarking.
+	// The SSE and AVX2 kernels must only be called if supported.
+	void buildMatricesScalar(const Transforms&, glm::mat4* outMatrices);
+	void buildMatricesSSE(const Transforms&, glm::mat4* outMatrices);
+	void buildMatricesAVX2(const Transforms&, glm::mat4* outMatrices);
+	bool isSSESupported();
+	bool isAVX2Supported();
+}
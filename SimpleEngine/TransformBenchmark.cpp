@@ -0,0 +1,111 @@
+#include "TransformBenchmark.h"
+
+#include "GLMUtils.h"
+#include "Log.h"
+#include "TransformBatch.h"
+#include "TransformComponent.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+	using BenchClock = std::chrono::high_resolution_clock;
+
+	double secondsSince(BenchClock::time_point start)
+	{
+		return std::chrono::duration<double>(BenchClock::now() - start).count();
+	}
+
+	// Returns the largest difference between any element of the matrices
+	float maxDifference(const std::vector<glm::mat4>& expected, const std::vector<glm::mat4>& actual)
+	{
+		float difference = 0;
+		for (size_t i = 0; i < expected.size(); ++i) {
+			for (int col = 0; col < 4; ++col) {
+				for (int row = 0; row < 4; ++row)
+					difference = std::max(difference, std::abs(expected[i][col][row] - actual[i][col][row]));
+			}
+		}
+		return difference;
+	}
+
+	// Returns the fastest of several runs, to skip runs that were
+	// interrupted
+	template <typename FuncT>
+	double timeBestOf(int numRuns, FuncT func)
+	{
+		double bestTime = 0;
+		for (int i = 0; i < numRuns; ++i) {
+			BenchClock::time_point start = BenchClock::now();
+			func();
+			double time = secondsSince(start);
+			if (i == 0 || time < bestTime)
+				bestTime = time;
+		}
+		return bestTime;
+	}
+}
+
+void TransformBenchmark::run()
+{
+	const size_t kNumTransforms = 100000;
+	const int kNumRuns = 20;
+
+	g_log << "Transform benchmark (" << kNumTransforms << " transforms)\n";
+
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<float> positionDistribution(-500, 500);
+	std::uniform_real_distribution<float> angleDistribution(-3.14159f, 3.14159f);
+	std::uniform_real_distribution<float> scaleDistribution(0.5f, 2);
+	std::vector<TransformComponent> transforms(kNumTransforms);
+	for (TransformComponent& transform : transforms) {
+		transform.position = { positionDistribution(generator), positionDistribution(generator), positionDistribution(generator) };
+		transform.setEulerAngles({ angleDistribution(generator), angleDistribution(generator), angleDistribution(generator) });
+		transform.scale = { scaleDistribution(generator), scaleDistribution(generator), scaleDistribution(generator) };
+	}
+
+	std::vector<glm::mat4> expected(kNumTransforms);
+	double glmTime = timeBestOf(kNumRuns, [&]() {
+		for (size_t i = 0; i < kNumTransforms; ++i)
+			expected[i] = GLMUtils::transformToMat(transforms[i]);
+	});
+	g_log << "  transformToMat: " << glmTime / kNumTransforms * 1e9 << " ns per matrix\n";
+
+	// Rotations are already quaternions, so writing the batch is a copy
+	TransformBatch::Transforms batch;
+	double conversionTime = timeBestOf(kNumRuns, [&]() {
+		batch.clear();
+		for (const TransformComponent& transform : transforms)
+			batch.push_back(transform.position, transform.rotation, transform.scale);
+	});
+	g_log << "  Batch write: " << conversionTime / kNumTransforms * 1e9 << " ns per transform\n";
+
+	struct Kernel {
+		const char* name;
+		bool isSupported;
+		void (*build)(const TransformBatch::Transforms&, glm::mat4*);
+	};
+	const Kernel kKernels[] = {
+		{ "Scalar", true, &TransformBatch::buildMatricesScalar },
+		{ "SSE", TransformBatch::isSSESupported(), &TransformBatch::buildMatricesSSE },
+		{ "AVX2", TransformBatch::isAVX2Supported(), &TransformBatch::buildMatricesAVX2 },
+	};
+
+	std::vector<glm::mat4> matrices(kNumTransforms);
+	for (const Kernel& kernel : kKernels) {
+		if (!kernel.isSupported) {
+			g_log << "  " << kernel.name << ": not supported\n";
+			continue;
+		}
+
+		double time = timeBestOf(kNumRuns, [&]() {
+			kernel.build(batch, matrices.data());
+		});
+		g_log << "  " << kernel.name << ": " << time / kNumTransforms * 1e9 << " ns per matrix ("
+		      << glmTime / time << "x transformToMat, " << glmTime / (time + conversionTime)
+		      << "x including conversion), max error " << maxDifference(expected, matrices) << "\n";
+	}
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace TransformBenchmark {
+	// Compares building transform matrices one at a time with
+	// GLMUtils::transformToMat against each TransformBatch kernel, and
+	// checks the kernels give the same matrices.
+	// Results are written to the log.
+	void run();
+}
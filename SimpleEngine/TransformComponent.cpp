@@ -1,6 +1,19 @@
 #include "TransformComponent.h"
 
+#include "GLMUtils.h"
+
 TransformComponent::TransformComponent()
-	: scale{ glm::vec3{1.0f, 1.0f, 1.0f} }
+	: rotation{ 1, 0, 0, 0 }
+	, scale{ glm::vec3{1.0f, 1.0f, 1.0f} }
+{
+}
+
+void TransformComponent::setEulerAngles(const glm::vec3& eulerAngles)
+{
+	rotation = GLMUtils::eulerToQuat(eulerAngles);
+}
+
+glm::vec3 TransformComponent::getEulerAngles() const
 {
+	return GLMUtils::quatToEuler(rotation);
 }
@@ -1,11 +1,27 @@
 #pragma once
 
+#include "EntityHandle.h"
+
 #include <glm\glm.hpp>
+#include <glm\gtc\quaternion.hpp>
 
+// The position, rotation and scale are relative to the parent.
+// Entities without a parent, or whose parent has been destroyed or has no
+// transform, are relative to the world.
+// The rotation is kept as a quaternion, euler angles are converted when
+// they are set so building matrices doesn't need any trig.
 struct TransformComponent {
 	TransformComponent();
 
+	// Sets the rotation from euler angles in radians, applied as yaw (y)
+	// then pitch (x) then roll (z)
+	void setEulerAngles(const glm::vec3& eulerAngles);
+
+	// Returns euler angles giving the rotation, as set by setEulerAngles
+	glm::vec3 getEulerAngles() const;
+
 	glm::vec3 position;
-	glm::vec3 eulerAngles;
+	glm::quat rotation;
 	glm::vec3 scale;
+	EntityHandle parent;
 };
\ No newline at end of file
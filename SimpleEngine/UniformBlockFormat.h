@@ -6,10 +6,10 @@
 //
 // (c) 2017 Media Design School
 //
-// Description  : A struct containing model, view and projection matrices
-//                as well as camera position.
-//                Corresponds to an equivalent uniform buffer object on the
-//                GPU with same alignment.
+// Description  : The uniform blocks shared by the shaders, split by how
+//                often they change.
+//                Each corresponds to an equivalent uniform block on the
+//                GPU with the same std140 alignment.
 // Author       : Lance Chaney
 // Mail         : lance.cha7337@mediadesign.school.nz
 //
@@ -19,27 +19,28 @@
 #include <glad\glad.h>
 #include <glm\glm.hpp>
 
-#include <array>
+// Set once per frame.
+// Bound to the FrameUniforms block.
+struct FrameUniformFormat {
+	static const GLuint s_kBindingPoint = 0;
 
-// TODO: Split this up, and make offsets easy to access, so we can easily:
-// buffer constant projection matrix once,
-// View matrix, camera position and lights per frame,
-// and model matrix and shader parameters per object render call.
-// Could also batch render calls based on materials and only buffer separate view matrices per same object render call.
-struct UniformBlockFormat {
-	static const GLuint s_kMaxSpotlights = 8;
-
-	glm::mat4 model;
 	glm::mat4 view;
 	glm::mat4 projection;
 	glm::vec4 cameraPos;
-	std::array<glm::vec4, s_kMaxSpotlights> spotlightPositions;
-	std::array<glm::vec4, s_kMaxSpotlights> spotlightDirections;
-	std::array<glm::vec4, s_kMaxSpotlights> spotlightColors;
-	GLuint numSpotlights;
+	glm::vec4 clusterScale;     // Tiles per pixel in x and y, then the depth slice scale and bias
+	glm::uvec4 clusterGridSize; // Tiles in x and y, depth slices, and the number of lights
+	GLfloat time;
+	GLfloat padding[3]; // std140 rounds the block size up to a vec4
+};
+
+// Set when the material changes.
+// Bound to the MaterialUniforms block.
+struct MaterialUniformFormat {
+	static const GLuint s_kBindingPoint = 1;
+
 	GLfloat metallicness;
 	GLfloat glossiness;
 	GLfloat specBias;
-	GLfloat time;
-	GLboolean discardTransparent; // 1 Byte, needs to come last to avoid issues with std140 padding.
-};
\ No newline at end of file
+	GLuint discardTransparent; // std140 stores bools in 4 bytes
+};
+
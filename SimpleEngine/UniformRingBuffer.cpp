@@ -0,0 +1,130 @@
+#include "UniformRingBuffer.h"
+
+#include "Log.h"
+
+#include <glm\glm.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace {
+	const GLbitfield g_kPersistentMapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLint g_kMinAlignment = sizeof(glm::mat4);
+	const GLuint64 g_kFenceTimeout = 1000000000; // 1 second in nanoseconds
+}
+
+UniformRingBuffer::UniformRingBuffer(GLsizeiptr capacity)
+	: m_capacity{ capacity }
+	, m_mappedData{ nullptr }
+	, m_head{ 0 }
+	, m_numFreeBytes{ capacity }
+	, m_numFrameBytes{ 0 }
+{
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_alignment);
+	m_alignment = std::max(m_alignment, g_kMinAlignment);
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	if (GLAD_GL_VERSION_4_4) {
+		glBufferStorage(GL_UNIFORM_BUFFER, m_capacity, nullptr, g_kPersistentMapFlags);
+		m_mappedData = static_cast<char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, m_capacity, g_kPersistentMapFlags));
+		if (!m_mappedData)
+			g_log << "WARNING: Failed to persistently map the uniform buffer\n";
+	}
+	if (!m_mappedData)
+		glBufferData(GL_UNIFORM_BUFFER, m_capacity, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformRingBuffer::~UniformRingBuffer()
+{
+	for (const FrameFence& frameFence : m_frameFences)
+		glDeleteSync(frameFence.fence);
+
+	if (m_mappedData) {
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+	glDeleteBuffers(1, &m_buffer);
+}
+
+GLintptr UniformRingBuffer::write(const void* data, GLsizeiptr size)
+{
+	assert(size <= m_capacity);
+
+	GLintptr offset;
+	GLsizeiptr numUsedBytes;
+	while (true) {
+		// Start from the beginning when the buffer is empty, so any block
+		// that fits the buffer fits without wrapping
+		if (m_numFreeBytes == m_capacity)
+			m_head = 0;
+
+		// Blocks must start on an aligned offset, and can't wrap around the end
+		offset = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+		if (offset + size > m_capacity)
+			offset = 0;
+		numUsedBytes = offset >= m_head ? offset + size - m_head : m_capacity - m_head + size;
+		if (numUsedBytes <= m_numFreeBytes)
+			break;
+
+		// The GPU is behind by the whole buffer, so fence the current
+		// frame to be able to wait for its blocks too
+		if (m_frameFences.empty())
+			endFrame();
+		releaseOldestFrame();
+	}
+
+	if (m_mappedData) {
+		std::memcpy(m_mappedData + offset, data, size);
+	} else {
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	}
+
+	m_head = offset + size;
+	m_numFreeBytes -= numUsedBytes;
+	m_numFrameBytes += numUsedBytes;
+	return offset;
+}
+
+void UniformRingBuffer::bind(GLuint bindingPoint, GLintptr offset, GLsizeiptr size) const
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, m_buffer, offset, size);
+}
+
+void UniformRingBuffer::endFrame()
+{
+	if (m_numFrameBytes == 0)
+		return;
+
+	m_frameFences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), m_numFrameBytes });
+	m_numFrameBytes = 0;
+}
+
+GLuint UniformRingBuffer::getGPUHandle() const
+{
+	return m_buffer;
+}
+
+bool UniformRingBuffer::isPersistentlyMapped() const
+{
+	return m_mappedData != nullptr;
+}
+
+void UniformRingBuffer::releaseOldestFrame()
+{
+	FrameFence frameFence = m_frameFences.front();
+	m_frameFences.pop_front();
+
+	GLenum result = glClientWaitSync(frameFence.fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_kFenceTimeout);
+	while (result == GL_TIMEOUT_EXPIRED)
+		result = glClientWaitSync(frameFence.fence, 0, g_kFenceTimeout);
+	if (result == GL_WAIT_FAILED)
+		g_log << "WARNING: Failed to wait for the GPU to finish with the uniform buffer\n";
+
+	glDeleteSync(frameFence.fence);
+	m_numFreeBytes += frameFence.size;
+}
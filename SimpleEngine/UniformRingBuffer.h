@@ -0,0 +1,71 @@
+//
+// Bachelor of Software Engineering
+// Media Design School
+// Auckland
+// New Zealand
+//
+// (c) 2017 Media Design School
+//
+// Description  : A buffer that uniform blocks and instance data are
+//                streamed into each frame, without waiting on the GPU.
+// Author       : Lance Chaney
+// Mail         : lance.cha7337@mediadesign.school.nz
+//
+
+#pragma once
+
+#include <glad\glad.h>
+
+#include <deque>
+
+// Blocks are written one after the other, wrapping back to the start of
+// the buffer when they reach the end.
+// Each frame is fenced, so space is only reused once the GPU has finished
+// the frame that used it.
+// The buffer is persistently mapped when GL 4.4 is available, so a write
+// is a single copy into mapped memory. Otherwise each write is uploaded
+// with glBufferSubData.
+// Blocks are aligned to at least a mat4, so instance transforms can be
+// addressed by their instance index.
+class UniformRingBuffer {
+public:
+	UniformRingBuffer(GLsizeiptr capacity);
+	~UniformRingBuffer();
+	UniformRingBuffer(const UniformRingBuffer&) = delete;
+	UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+	// Copies a uniform block into the buffer.
+	// Returns the offset of the block, for binding with glBindBufferRange.
+	// The block must not be larger than the buffer.
+	GLintptr write(const void* data, GLsizeiptr size);
+
+	// Binds a block returned by write to a uniform binding point
+	void bind(GLuint bindingPoint, GLintptr offset, GLsizeiptr size) const;
+
+	// Returns a handle to the GPU buffer object
+	GLuint getGPUHandle() const;
+
+	// Fences the blocks written since the last call.
+	// Should be called after the draws that use them have been issued.
+	void endFrame();
+
+	bool isPersistentlyMapped() const;
+
+private:
+	struct FrameFence {
+		GLsync fence;
+		GLsizeiptr size; // Bytes freed when the fence is signaled
+	};
+
+	// Waits on the oldest frame still using the buffer
+	void releaseOldestFrame();
+
+	GLuint m_buffer;
+	GLsizeiptr m_capacity;
+	GLint m_alignment;
+	char* m_mappedData;
+	GLintptr m_head;
+	GLsizeiptr m_numFreeBytes;
+	GLsizeiptr m_numFrameBytes; // Bytes used since the last fence
+	std::deque<FrameFence> m_frameFences;
+};
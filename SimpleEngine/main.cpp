@@ -13,14 +13,145 @@
 //
 
 #include "Game.h"
+#include "GLUtils.h"
+#include "JobSystem.h"
+#include "JobSystemBenchmark.h"
+#include "LightClusterBenchmark.h"
 #include "Log.h"
+#include "OcclusionBenchmark.h"
+#include "Profiler.h"
+#include "SceneBenchmark.h"
+#include "SceneSnapshotBenchmark.h"
+#include "SpatialIndexBenchmark.h"
+#include "StaticDrawBenchmark.h"
+#include "TransformBenchmark.h"
 
 #include <GLFW\glfw3.h>
 
-int main()
+#include <string>
+#include <vector>
+
+namespace {
+	// What a benchmark needs started before it runs
+	enum BenchmarkSetup {
+		BENCHMARK_SETUP_NONE,
+		BENCHMARK_SETUP_JOBS,     // The job system
+		BENCHMARK_SETUP_WINDOW,   // The job system and a window for its OpenGL context
+		BENCHMARK_SETUP_HEADLESS, // The game in a hidden window, see Game::initHeadless
+	};
+
+	struct Benchmark {
+		const char* flag;
+		BenchmarkSetup setup;
+		int (*run)(const std::vector<std::string>& args); // Returns the exit code
+	};
+
+	const Benchmark g_kBenchmarks[] = {
+		// Run the job system microbenchmark
+		{ "--benchmark-jobs", BENCHMARK_SETUP_NONE, [](const std::vector<std::string>&) {
+			JobSystemBenchmark::run();
+			return 0;
+		} },
+
+		// Compare the transform matrix kernels
+		{ "--benchmark-transforms", BENCHMARK_SETUP_NONE, [](const std::vector<std::string>&) {
+			TransformBenchmark::run();
+			return 0;
+		} },
+
+		// Time the spatial index against linear scans
+		{ "--benchmark-spatial-index", BENCHMARK_SETUP_NONE, [](const std::vector<std::string>&) {
+			SpatialIndexBenchmark::run();
+			return 0;
+		} },
+
+		// Time the occlusion buffer kernels and box tests
+		{ "--benchmark-occlusion", BENCHMARK_SETUP_JOBS, [](const std::vector<std::string>&) {
+			OcclusionBenchmark::run();
+			return 0;
+		} },
+
+		// Time assigning thousands of lights to clusters
+		{ "--benchmark-lights", BENCHMARK_SETUP_JOBS, [](const std::vector<std::string>&) {
+			LightClusterBenchmark::run();
+			return 0;
+		} },
+
+		// Compare building the gameplay scene against loading a snapshot of it
+		{ "--benchmark-snapshot", BENCHMARK_SETUP_WINDOW, [](const std::vector<std::string>&) {
+			SceneSnapshotBenchmark::run();
+			return 0;
+		} },
+
+		// Time the full system pipeline on a generated stress scene and
+		// compare against the baseline.
+		// Returns non zero if the benchmark fails, so it can gate builds.
+		{ "--benchmark-scene", BENCHMARK_SETUP_HEADLESS, [](const std::vector<std::string>& args) {
+			return SceneBenchmark::run(args);
+		} },
+
+		// Compare the CPU cost of drawing static level geometry through the
+		// render queue and with indirect multi draws
+		{ "--benchmark-static-draws", BENCHMARK_SETUP_HEADLESS, [](const std::vector<std::string>&) {
+			StaticDrawBenchmark::run();
+			return 0;
+		} },
+	};
+
+	// Starts what the benchmark needs, runs it with the arguments after
+	// its flag, then shuts everything down again
+	int runBenchmark(const Benchmark& benchmark, const std::vector<std::string>& args)
+	{
+		g_log.setConsoleOut(true);
+
+		GLFWwindow* window = nullptr;
+		switch (benchmark.setup) {
+		case BENCHMARK_SETUP_JOBS:
+			JobSystem::init();
+			break;
+		case BENCHMARK_SETUP_WINDOW:
+			window = GLUtils::initOpenGL();
+			JobSystem::init();
+			break;
+		case BENCHMARK_SETUP_HEADLESS:
+			Game::initHeadless();
+			window = Game::getWindowContext();
+			break;
+		default:
+			break;
+		}
+
+		int result = benchmark.run(args);
+
+		JobSystem::shutdown();
+		if (window) {
+			glfwDestroyWindow(window);
+			glfwTerminate();
+		}
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
 {
 	g_log.setOutputFile("Log.txt");
 
+	// Benchmarks run in place of the game
+	if (argc > 1) {
+		for (const Benchmark& benchmark : g_kBenchmarks) {
+			if (std::string(argv[1]) == benchmark.flag)
+				return runBenchmark(benchmark, std::vector<std::string>(argv + 2, argv + argc));
+		}
+	}
+
+#ifdef PROFILING_ENABLED
+	// Profile the whole run, including loading, and write a Chrome trace
+	// on exit
+	bool isProfiling = argc > 1 && std::string(argv[1]) == "--profile";
+	if (isProfiling)
+		Profiler::beginCapture();
+#endif
+
 	Game::init();
 	GLFWwindow* window = Game::getWindowContext();
 
@@ -29,6 +160,14 @@ int main()
 		glfwPollEvents();
 	}
 
+#ifdef PROFILING_ENABLED
+	if (isProfiling) {
+		Profiler::endCapture();
+		Profiler::writeChromeTrace("Trace.json");
+	}
+#endif
+
+	JobSystem::shutdown();
 	glfwDestroyWindow(window);
 	glfwTerminate();
 }
\ No newline at end of file